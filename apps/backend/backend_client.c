@@ -396,8 +396,15 @@ clixon_stats_datastore_get(clixon_handle h,
         if (xml_stats(xt, &nr, &sz) < 0)
             goto done;
         cprintf(cb, "<datastore><name>%s</name><nr>%" PRIu64 "</nr>"
-                "<size>%zu</size></datastore>",
+                "<size>%zu</size>",
                 dbname, nr, sz);
+        /* Descendant index, see CLICON_XMLDB_DESCENDANT_INDEX */
+        if ((ret = xml_descendant_index_stats(xt, &nr, &sz)) < 0)
+            goto done;
+        if (ret == 1)
+            cprintf(cb, "<indexnr>%" PRIu64 "</indexnr><indexsize>%zu</indexsize>",
+                    nr, sz);
+        cprintf(cb, "</datastore>");
     }
  ok:
     retval = 0;
@@ -1458,6 +1465,10 @@ from_client_stats(clixon_handle h,
 {
     int        retval = -1;
     uint64_t   nr;
+    uint64_t   slabs;
+    uint64_t   hits;
+    uint64_t   misses;
+    size_t     sz;
     char      *str;
     int        modules = 0;
     yang_stmt *yspec0;
@@ -1479,6 +1490,23 @@ from_client_stats(clixon_handle h,
     nr=0;
     xml_stats_global(&nr);
     cprintf(cbret, "<xmlnr>%" PRIu64 "</xmlnr>", nr);
+    slabs = 0;
+    sz = 0;
+    xml_stats_slab(&slabs, NULL, &sz);
+    cprintf(cbret, "<xmlslabnr>%" PRIu64 "</xmlslabnr>", slabs);
+    cprintf(cbret, "<xmlslabsize>%zu</xmlslabsize>", sz);
+    nr = 0;
+    sz = 0;
+    clixon_string_intern_stats(&nr, &sz);
+    cprintf(cbret, "<internnr>%" PRIu64 "</internnr>", nr);
+    cprintf(cbret, "<internsize>%zu</internsize>", sz);
+    nr = 0;
+    hits = 0;
+    misses = 0;
+    xpath_cache_stats(&nr, &hits, &misses);
+    cprintf(cbret, "<xpathcachenr>%" PRIu64 "</xpathcachenr>", nr);
+    cprintf(cbret, "<xpathcachehit>%" PRIu64 "</xpathcachehit>", hits);
+    cprintf(cbret, "<xpathcachemiss>%" PRIu64 "</xpathcachemiss>", misses);
     nr=0;
     yang_stats_global(&nr);
     cprintf(cbret, "<yangnr>%" PRIu64 "</yangnr>", nr);
@@ -1938,6 +1966,9 @@ from_client_msg(clixon_handle        h,
             goto done;
         }
     }
+    /* Unload split subtrees above memory limit, see CLICON_XMLDB_MULTI_LAZY_MAX */
+    if (xmldb_lazy_evict(h) < 0)
+        goto done;
     // ok:
     retval = 0;
   done:
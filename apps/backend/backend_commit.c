@@ -84,15 +84,18 @@
  * @param[in]   h       Clixon handle
  * @param[in]   yspec   Yang spec
  * @param[in]   td      Transaction data
+ * @param[in]   diff    Source of td is valid, validate incrementally using diff
  * @param[out]  xret    Error XML tree. Free with xml_free after use
  * @retval      1       Validation OK       
  * @retval      0       Validation failed (with cbret set)
  * @retval     -1       Error
+ * @see CLICON_VALIDATE_INCREMENTAL
  */
 static int
 generic_validate(clixon_handle       h,
                  yang_stmt          *yspec,
                  transaction_data_t *td,
+                 int                 diff,
                  cxobj             **xret)
 {
     int        retval = -1;
@@ -102,7 +105,14 @@ generic_validate(clixon_handle       h,
     cbuf      *cb = NULL;
 
     /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0)
+    if (diff)
+        ret = xml_yang_validate_all_diff(h, td->td_target,
+                                         td->td_dvec, td->td_dlen,
+                                         td->td_avec, td->td_alen,
+                                         td->td_scvec, td->td_tcvec, td->td_clen, xret);
+    else
+        ret = xml_yang_validate_all_top(h, td->td_target, xret);
+    if (ret < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -134,34 +144,71 @@ generic_validate(clixon_handle       h,
     goto done;
 }
 
+/*! Reset flags in edited subtrees only, see XML_FLAG_EDITED
+ *
+ * @param[in]  x    XML node
+ * @param[in]  arg  Flags to reset
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     0    OK, continue
+ */
+static int
+xml_flag_reset_edited(cxobj *x,
+                      void  *arg)
+{
+    if (xml_parent(x) != NULL &&
+        xml_flag(x, XML_FLAG_EDITED) == 0)
+        return 2;
+    xml_flag_reset(x, (uint16_t)(intptr_t)arg);
+    return 0;
+}
+
 /*! Given a transaction src/target, compute diffs and set flags
  *
  * @param[in]  h       Clixon handle
  * @param[in]  td      Transaction data
+ * @param[in]  edited  Target edit marks are valid, only diff edited subtrees
  * @retval     0   OK
  * @retval    -1   Error
+ * @see xml_diff_edited
  */
 static int
 compute_diffs(clixon_handle       h,
-              transaction_data_t *td)
+              transaction_data_t *td,
+              int                 edited)
 {
     int    retval = -1;
     int    i;
     cxobj *xn;
+    int    ret;
 
-    /* Clear flags xpath for get */
-    xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-               (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    /* Clear flags xpath for get
+     * If edited, source is a copy from xmldb_get0 without MARK/CHANGE (not copied by
+     * xml_copy) and only its counterparts of edited subtrees are visited */
+    if (!edited)
+        xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                   (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
     /* 3. Compute differences */
-    if (xml_diff(td->td_src,
-                 td->td_target,
-                 &td->td_dvec,      /* removed: only in running */
-                 &td->td_dlen,
-                 &td->td_avec,      /* added: only in candidate */
-                 &td->td_alen,
-                 &td->td_scvec,     /* changed: original values */
-                 &td->td_tcvec,     /* changed: wanted values */
-                 &td->td_clen) < 0)
+    if (edited)
+        ret = xml_diff_edited(td->td_src,
+                              td->td_target,
+                              &td->td_dvec,      /* removed: only in running */
+                              &td->td_dlen,
+                              &td->td_avec,      /* added: only in candidate */
+                              &td->td_alen,
+                              &td->td_scvec,     /* changed: original values */
+                              &td->td_tcvec,     /* changed: wanted values */
+                              &td->td_clen);
+    else
+        ret = xml_diff(td->td_src,
+                       td->td_target,
+                       &td->td_dvec,      /* removed: only in running */
+                       &td->td_dlen,
+                       &td->td_avec,      /* added: only in candidate */
+                       &td->td_alen,
+                       &td->td_scvec,     /* changed: original values */
+                       &td->td_tcvec,     /* changed: wanted values */
+                       &td->td_clen);
+    if (ret < 0)
         goto done;
     if (clixon_debug_get() & CLIXON_DBG_DETAIL)
         transaction_dbg(h, CLIXON_DBG_DETAIL, td, __FUNCTION__);
@@ -357,7 +404,7 @@ startup_common(clixon_handle       h,
     /* Handcraft transition with with only add tree */
     td->td_target = xt;
     xt = NULL;
-    if (compute_diffs(h, td) < 0)
+    if (compute_diffs(h, td, 0) < 0)
         goto done;
     /* 4. Call plugin transaction start callbacks */
     if (plugin_transaction_begin_all(h, td) < 0)
@@ -366,7 +413,7 @@ startup_common(clixon_handle       h,
     /* 5. Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
     clixon_debug(CLIXON_DBG_BACKEND, "Validating startup %s", db);
-    if ((ret = generic_validate(h, yspec, td, &xret)) < 0)
+    if ((ret = generic_validate(h, yspec, td, 0, &xret)) < 0)
         goto done;
     if (ret == 0){
         if (clixon_xml2cbuf(cbret, xret, 0, 0, NULL, -1, 0) < 0)
@@ -565,15 +612,26 @@ validate_common(clixon_handle       h,
     int         retval = -1;
     yang_stmt  *yspec;
     int         ret;
+    int         edited;
+    uint64_t    lazyerr = xml_lazy_errors();
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clixon_err(OE_FATAL, 0, "No DB_SPEC");
         goto done;
     }
+    /* Only diff subtrees edited since db was equal to running, unless system-only
+     * config is added to the trees compared */
+    edited = xmldb_edited_get(h, db) &&
+        !clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG");
+    clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "%s diff %s", db, edited?"edited":"full");
     if (xmldb_cache_get(h, db) != NULL){
         if (xmldb_populate(h, db) < 0)
             goto done;
-        if (xmldb_write_cache2file(h, db) < 0)
+        /* Edits are already written by xmldb_put. With journal, edits are already in
+         * the journal, compacted at checkpoints */
+        if (!edited &&
+            !xmldb_journal_active(h, db) &&
+            xmldb_write_cache2file(h, db) < 0)
             goto done;
     }
     /* This is the state we are going to */
@@ -582,23 +640,34 @@ validate_common(clixon_handle       h,
     if (ret == 0)
         goto fail;
     /* Clear flags xpath for get */
-    xml_apply0(td->td_target, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-               (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    if (edited)
+        xml_apply0(td->td_target, CX_ELMNT, xml_flag_reset_edited,
+                   (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    else
+        xml_apply0(td->td_target, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                   (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
     /* 2. Parse xml trees
      * This is the state we are going from */
     if ((ret = xmldb_get0(h, "running", YB_MODULE, NULL, "/", 0, 0, &td->td_src, NULL, xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
-    if (compute_diffs(h, td) < 0)
+    if (compute_diffs(h, td, edited) < 0)
+        goto done;
+    /* Diff is incomplete if a split node could not be loaded, see CLICON_XMLDB_MULTI_LAZY */
+    if (xml_lazy_errors() != lazyerr){
+        clixon_err(OE_DB, 0, "%s: loading of split file failed", db);
         goto done;
+    }
     /* 4. Call plugin transaction start callbacks */
     if (plugin_transaction_begin_all(h, td) < 0)
         goto done;
 
     /* 5. Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, xret)) < 0)
+    if ((ret = generic_validate(h, yspec, td,
+                                clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL"),
+                                xret)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -1074,7 +1143,7 @@ from_client_restart_one(clixon_handle    h,
         goto fail;
     /* Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, &xerr)) < 0)
+    if ((ret = generic_validate(h, yspec, td, 0, &xerr)) < 0)
         goto done;
     if (ret == 0){
         if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
@@ -1174,6 +1243,10 @@ system_only_data_add(clixon_handle h,
     int    retval = -1;
     cxobj *x;
 
+    if (xmldb_cache_unshare(h, db) < 0)
+        goto done;
+    if (xmldb_edited_invalidate(h, db) < 0)
+        goto done;
     if ((x = xmldb_cache_get(h, db)) != NULL){
         if (xmldb_system_only_config(h, "/", NULL, &x) < 0)
             goto done;
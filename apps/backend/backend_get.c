@@ -433,6 +433,90 @@ get_nacm_and_reply(clixon_handle     h,
     return retval;
 }
 
+/*! Get config and reply from a read-only view of the datastore cache, without copying
+ *
+ * NACM, with-defaults and depth are applied when printing the reply
+ * @param[in]  h        Clixon handle
+ * @param[in]  db       Database name
+ * @param[in]  xpath    XPath point to object to get
+ * @param[in]  nsc      Namespace context of xpath
+ * @param[in]  username User name for NACM access
+ * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
+ * @param[in]  wdef     With-defaults parameter
+ * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @retval     1        OK, cbret set
+ * @retval     0        OK, no view possible, use a copy
+ * @retval    -1        Error
+ * @see get_nacm_and_reply  for the copy variant
+ */
+static int
+get_config_view(clixon_handle     h,
+                char             *db,
+                char             *xpath,
+                cvec             *nsc,
+                char             *username,
+                int32_t           depth,
+                withdefaults_type wdef,
+                cbuf             *cbret)
+{
+    int        retval = -1;
+    cxobj     *xnacm;
+    cxobj     *xt = NULL;
+    cxobj    **xvec = NULL;
+    size_t     xlen = 0;
+    cxobj     *xerr = NULL;
+    cbuf      *cbmsg = NULL;
+    nacm_view *nv = NULL;
+    int        permit = 1;
+    int        ret;
+
+    xnacm = clicon_nacm_cache(h);
+    if (xnacm != NULL && username == NULL)
+        goto noview;
+    if ((ret = xmldb_get_view(h, db, YB_MODULE, nsc, xpath?xpath:"/", &xt, &xvec, &xlen, &xerr)) < 0) {
+        if ((cbmsg = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbmsg, "Get %s datastore: %s", db, clixon_err_reason());
+        if (netconf_operation_failed(cbret, "application", cbuf_get(cbmsg)) < 0)
+            goto done;
+        goto ok;
+    }
+    if (ret == 0){
+        if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        goto ok;
+    }
+    if (xt == NULL)
+        goto noview;
+    if (xnacm != NULL &&
+        nacm_datanode_read_view(h, xt, username, xnacm, &nv, &permit) < 0)
+        goto done;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    /* Top level is data, so add 1 to depth if significant */
+    if (clixon_xml2cbuf_view(cbret, xt, NETCONF_OUTPUT_DATA, xvec, xlen,
+                             depth>0?depth+1:depth, wdef,
+                             nv?nacm_datanode_read_view_fn:NULL, nv, permit) < 0)
+        goto done;
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 1;
+ done:
+    if (nv)
+        nacm_view_free(nv);
+    if (xvec)
+        free(xvec);
+    if (xerr)
+        xml_free(xerr);
+    if (cbmsg)
+        cbuf_free(cbmsg);
+    return retval;
+ noview:
+    retval = 0;
+    goto done;
+}
+
 /*! Help function for parsing restconf query parameter and setting netconf attribute
  *
  * Parse and set a uint32 numeric value,
@@ -1035,6 +1119,11 @@ get_common(clixon_handle        h,
     /* Read configuration */
     switch (content){
     case CONTENT_CONFIG:    /* config data only */
+        /* Read-only view of the datastore cache if possible */
+        if ((ret = get_config_view(h, db, xpath, nsc, username, depth, wdef, cbret)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
         /* specific xpath. with-default gets masked in get_nacm_and_reply */
         if ((ret = xmldb_get0(h, db, YB_MODULE, nsc, xpath?xpath:"/", 1, WITHDEFAULTS_REPORT_ALL, &xret, NULL, &xerr)) < 0) {
             if ((cbmsg = cbuf_new()) == NULL){
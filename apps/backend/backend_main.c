@@ -128,6 +128,7 @@ backend_terminate(clixon_handle h)
     clixon_process_delete_all(h); 
 
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_pagination_free(h);
     
     if (pidfile)
@@ -439,6 +440,49 @@ backend_timer_setup(int   fd,
 }
 #endif /* DEBUG */
 
+/*! Periodic checkpoint of datastore journals
+ *
+ * Compact journals of all datastores into their datastore files and restart timer
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see CLICON_XMLDB_JOURNAL_CHECKPOINT
+ */
+static int
+backend_journal_timer(int   fd,
+                      void *arg)
+{
+    int            retval = -1;
+    clixon_handle  h = (clixon_handle)arg;
+    struct timeval now;
+    struct timeval t;
+    struct timeval t1 = {0, 0};
+    char         **keys = NULL;
+    size_t         klen;
+    int            i;
+
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++)
+        if (xmldb_journal_checkpoint(h, keys[i]) < 0)
+            goto done;
+    /* Initiate new timer */
+    t1.tv_sec = clicon_option_int(h, "CLICON_XMLDB_JOURNAL_CHECKPOINT");
+    gettimeofday(&now, NULL);
+    timeradd(&now, &t1, &t);
+    if (clixon_event_reg_timeout(t,
+                                 backend_journal_timer, /* this function */
+                                 h,                     /* clixon handle */
+                                 "backend journal checkpoint") < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
 /*! usage
  */
 static void
@@ -1119,6 +1163,10 @@ main(int    argc,
 #endif
     if (stream_timer_setup(0, h) < 0)
         goto done;
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") &&
+        clicon_option_int(h, "CLICON_XMLDB_JOURNAL_CHECKPOINT") > 0 &&
+        backend_journal_timer(0, h) < 0)
+        goto done;
     /* Just before event-loop, after socket bind/listen */
     if (netconf_monitoring_statistics_init(h) < 0)
         goto done;
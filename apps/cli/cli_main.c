@@ -188,6 +188,7 @@ cli_terminate(clixon_handle h)
     clixon_plugin_module_exit(h);
     /* Delete CLI syntax et al */
     cli_plugin_finish(h);
+    xpath_cache_exit();
 
     cli_history_save(h);
     cli_handle_exit(h);
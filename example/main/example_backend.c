@@ -73,7 +73,7 @@
 #include <clixon/clixon_backend.h>
 
 /* Command line options to be passed to getopt(3) */
-#define BACKEND_EXAMPLE_OPTS "a:m:M:n:o:O:rsS:x:iuUtV:"
+#define BACKEND_EXAMPLE_OPTS "a:m:M:n:o:O:rsS:x:iIuUtV:"
 
 /* Enabling this improves performance in tests, but there may trigger the "double XPath"
  * problem.
@@ -185,6 +185,13 @@ static int _general_upgrade = 0;
  */
 static int _transaction_log = 0;
 
+/*! Variable to control verification of explicit search indexes (for test)
+ *
+ * If set, validate fails if search indexes of source or target are inconsistent
+ * Start backend with -- -I
+ */
+static int _search_index_verify = 0;
+
 /*! Variable to trigger validation/commit errors (synthetic errors) for tests
  *
  * XPath to trigger validation error, ie if the XPath matches, then validate fails
@@ -213,6 +220,53 @@ main_begin(clixon_handle    h,
     return 0;
 }
 
+#ifdef XML_EXPLICIT_INDEX
+/*! Verify search indexes of a tree re-parsed from text syntax
+ *
+ * The text parser appends key leafs with pre-set bodies, so re-parsing the target
+ * exercises search index maintenance when a body with a value is appended
+ * @param[in]  h   Clixon handle
+ * @param[in]  xt  XML tree
+ * @retval     0   OK
+ * @retval    -1   Error or inconsistent index
+ */
+static int
+search_index_text_verify(clixon_handle h,
+                         cxobj        *xt)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cxobj *xt1 = NULL;
+    cxobj *xerr = NULL;
+    int    ret;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_text2cbuf(cb, xt, 0, 0, 0) < 0)
+        goto done;
+    if ((ret = clixon_text_syntax_parse_string(cbuf_get(cb), YB_MODULE_NEXT,
+                                               clicon_dbspec_yang(h), &xt1, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_XML, 0, "Text syntax re-parse failed");
+        goto done;
+    }
+    if (xml_search_index_verify(xt1) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xt1)
+        xml_free(xt1);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+#endif /* XML_EXPLICIT_INDEX */
+
 /*! This is called on validate (and commit). Check validity of candidate
  */
 int
@@ -229,6 +283,19 @@ main_validate(clixon_handle    h,
             return -1; /* induce fail */
         }
     }
+#ifdef XML_EXPLICIT_INDEX
+    if (_search_index_verify){
+        if (transaction_src(td) &&
+            xml_search_index_verify(transaction_src(td)) < 0)
+            return -1;
+        if (transaction_target(td) &&
+            xml_search_index_verify(transaction_target(td)) < 0)
+            return -1;
+        if (transaction_target(td) &&
+            search_index_text_verify(h, transaction_target(td)) < 0)
+            return -1;
+    }
+#endif
     return 0;
 }
 
@@ -1640,6 +1707,9 @@ clixon_plugin_init(clixon_handle h)
         case 'i': /* read state file on init not by request (requires -sS <file> */
             _state_file_cached = 1;
             break;
+        case 'I': /* verify search indexes */
+            _search_index_verify = 1;
+            break;
        case 'u': /* module-specific upgrade */
            _module_upgrade = 1;
            break;
@@ -49,21 +49,37 @@
 
 /*! Optimize special list key searches in XPath finds
  *
- * Identify xpaths that search for exactly a list key, eg: "y[k='3']" and then call
+ * Identify xpath steps that search for list keys, eg: "y[k='3']" and then call
  * binary search. This only works if "y" has proper yang binding and is sorted by system
- * Dont optimize on "hierarchical" lists such as: a/y[k='3'], where a is another list.
+ * Applies to every step, eg a/y[k='3'] where a is another list, to multiple keys in any order,
+ * to a prefix of keys, to explicit search indexes and to leaf-list values: z[.='4']
  */
 #define XPATH_LIST_OPTIMIZE
 
+/*! Cache parsed XPath trees in xpath_vec_ctx and xpath_first/xpath_vec
+ *
+ * Bounded LRU cache keyed by XPath string, the least recently used entry is evicted when
+ * the cache is full. See also xpath_compile for precompiled handles.
+ * Undefine to parse the XPath on every call
+ */
+#define XPATH_CACHE_SIZE 1024
+
 /*! Add explicit search indexes, so that binary search can be made for non-key list indexes
  *
  * This also applies if there are multiple keys and you want to search on only the second for 
  * example.
- * There may be some cases where the index vector is not updated, need to verify before 
- * enabling this completely.
+ * Index vectors are maintained when list entries or index leafs are added, removed, bound to
+ * yang or change value. Check consistency with xml_search_index_verify()
  */
 #define XML_EXPLICIT_INDEX
 
+/*! Compare list and leaf-list entries using cached normalized sort keys
+ *
+ * Key values are encoded once per entry so that xml_cmp can compare with memcmp.
+ * Disable to compare key values as cligen variables on every comparison
+ */
+#define XML_SORTKEY
+
 /*! Let state data be ordered-by system
  *
  * RFC 7950 is cryptic about this
@@ -237,6 +253,15 @@
  */
 #define OPTIMIZE_NO_PRESENCE_CONTAINER
 
+/*! Allocate XML objects from slabs instead of one malloc per object
+ *
+ * Objects of struct xml and struct xmlbody are allocated from aligned slabs of fixed size
+ * objects, freed objects are reused and empty slabs are released.
+ * Undefine to detect leaks of single XML objects with memory checkers such as valgrind
+ * see xml_new, xml_free, xml_stats_slab
+ */
+#define XML_SLAB
+
 /*! Fix startup mem issue of end callback: copy target db before writing to running
  *
  * diff may include default values, but these are removed before put.
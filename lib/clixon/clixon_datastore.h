@@ -56,6 +56,10 @@ struct db_elmnt {
                                  */
     int            de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
     int            de_volatile; /* Disable auto-sync of cache to disk on every update (ie xmldb_put) */
+    int            de_shared;   /* Cache tree is shared with other datastore(s) by xmldb_copy,
+                                 * copy before modifying, see xmldb_cache_unshare */
+    int            de_edited;   /* XML_FLAG_EDITED marks in cache are valid relative to running,
+                                 * see xmldb_edited_get */
 };
 typedef struct db_elmnt db_elmnt;
 
@@ -78,12 +82,20 @@ int xmldb_get0(clixon_handle h, const char *db, yang_bind yb,
                cxobj **xret, modstate_diff_t *msd, cxobj **xerr);
 int xmldb_get_cache(clixon_handle h, const char *db, yang_bind yb,
                     cxobj **xtp, modstate_diff_t *msdiff, cxobj **xerr);
+int xmldb_get_view(clixon_handle h, const char *db, yang_bind yb, cvec *nsc, const char *xpath,
+                   cxobj **xtp, cxobj ***xvecp, size_t *xlenp, cxobj **xerr);
 /* in clixon_datastore_write.[ch]: */
 int xmldb_put(clixon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret);
 int xmldb_dump(clixon_handle h, FILE *f, cxobj *xt, enum format_enum format, int pretty, withdefaults_type wdef, int multi, const char *multidb);
 int xmldb_write_cache2file(clixon_handle h, const char *db);
+/* in clixon_datastore_journal.[ch]: */
+int xmldb_journal_active(clixon_handle h, const char *db);
+int xmldb_journal_checkpoint(clixon_handle h, const char *db);
+/* in clixon_datastore_lazy.[ch]: */
+int xmldb_lazy_evict(clixon_handle h);
 
 int xmldb_copy(clixon_handle h, const char *from, const char *to);
+int xmldb_cache_unshare(clixon_handle h, const char *db);
 int xmldb_lock(clixon_handle h, const char *db, uint32_t id);
 int xmldb_unlock(clixon_handle h, const char *db);
 int xmldb_unlock_all(clixon_handle h, uint32_t id);
@@ -102,6 +114,8 @@ int xmldb_empty_get(clixon_handle h, const char *db);
 int xmldb_empty_set(clixon_handle h, const char *db, int value);
 int xmldb_volatile_get(clixon_handle h, const char   *db);
 int xmldb_volatile_set(clixon_handle h, const char *db, int value);
+int xmldb_edited_get(clixon_handle h, const char *db);
+int xmldb_edited_invalidate(clixon_handle h, const char *db);
 int xmldb_print(clixon_handle h, FILE *f);
 int xmldb_rename(clixon_handle h, const char *db, const char *newdb, const char *suffix);
 int xmldb_populate(clixon_handle h, const char *db);
@@ -38,6 +38,16 @@
 #ifndef _CLIXON_DIGEST_H_
 #define _CLIXON_DIGEST_H_
 
+/*
+ * Constants
+ */
+/* Length of binary SHA-256 digest, see clixon_digest_sha256 */
+#define CLIXON_DIGEST_LEN 32
+
+/*
+ * Prototypes
+ */
 int clixon_digest_hex(const char *string, char **hexstrp);
+int clixon_digest_sha256(const void *buf, size_t len, uint8_t *md);
 
 #endif /* _CLIXON_DIGEST_H_ */
@@ -39,11 +39,21 @@
 #ifndef _CLIXON_FILE_H_
 #define _CLIXON_FILE_H_
 
+/*
+ * Constants
+ */
+/* Read size of clicon_file_read if file size is not known, eg pipes */
+#define CLICON_FILE_READ_BLOCK 65536
+
+/*
+ * Prototypes
+ */
 int clicon_file_dirent(const char *dir, struct dirent **ent,
                        const char *regexp, mode_t type);
 int clicon_files_recursive(const char *dir, const char *regexp, cvec *cvv);
 int clicon_file_copy(char *src, char *target);
 int clicon_dir_copy(char *src, char *target);
 int clicon_file_cbuf(const char *filename, cbuf *cb);
+int clicon_file_read(FILE *fp, char **bufp, size_t *lenp);
 
 #endif /* _CLIXON_FILE_H_ */
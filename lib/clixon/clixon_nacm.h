@@ -53,12 +53,19 @@ enum nacm_access{
     NACM_EXEC
 };
 
+/* Prepared NACM read rules for a read-only view, see nacm_datanode_read_view */
+typedef struct nacm_view nacm_view;
+
 /*
  * Prototypes
  */
 int nacm_rpc(char *rpc, char *module, char *username, cxobj *xnacm, cbuf *cbret);
 int nacm_datanode_read(clixon_handle h, cxobj *xt, cxobj **xvec, size_t xlen, char *username,
                        cxobj *nacm_xtree);
+int nacm_datanode_read_view(clixon_handle h, cxobj *xt, char *username, cxobj *xnacm,
+                            nacm_view **nvp, int *permit);
+int nacm_datanode_read_view_fn(cxobj *x, void *arg);
+int nacm_view_free(nacm_view *nv);
 int nacm_datanode_write(clixon_handle h, cxobj *xr, cxobj *xt,
                         enum nacm_access access,
                         char *username, cxobj *xnacm, cbuf *cbret);
@@ -77,6 +77,11 @@ char  *clixon_trim2(char *str, char *trims);
 int    clicon_strcmp(char *s1, char *s2);
 int    clixon_unicode2utf8(char *ucstr, char *utfstr, size_t utflen);
 int    clixon_str_subst(char *str, cvec *cvv, cbuf *cb);
+char  *clixon_string_intern(const char *str);
+void   clixon_string_unintern(char *istr);
+char  *clixon_string_interned(const char *str);
+size_t clixon_string_intern_size(const char *istr);
+int    clixon_string_intern_stats(uint64_t *nr, size_t *sz);
 
 #ifndef HAVE_STRNDUP
 char *clicon_strndup (const char *, size_t);
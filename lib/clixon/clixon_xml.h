@@ -179,6 +179,16 @@ typedef struct xml cxobj; /* struct defined in clicon_xml.c */
  */
 typedef int (xml_applyfn_t)(cxobj *x, void *arg);
 
+/*! Callback function type for lazy loading, freeing and access of XML subtrees
+ *
+ * @param[in]  x    XML node
+ * @param[in]  arg  General-purpose argument
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_lazy_register
+ */
+typedef int (xml_lazyfn_t)(cxobj *x, void *arg);
+
 typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c */
 
 /* Alternative tree formats,
@@ -191,7 +201,8 @@ enum format_enum{
     FORMAT_CLI,
     FORMAT_NETCONF,  /* Last concrete format, used in code */
     FORMAT_DEFAULT,  /* Indirect: actual value in CLICON_CLI_OUTPUT_FORMAT */
-    FORMAT_PIPE_XML_DEFAULT /* Meta: If pipe, xml, if not default */
+    FORMAT_PIPE_XML_DEFAULT, /* Meta: If pipe, xml, if not default */
+    FORMAT_BINARY    /* Datastore only: pre-bound binary snapshot */
 };
 
 /*
@@ -210,13 +221,22 @@ enum format_enum{
 #define XML_FLAG_ANYDATA  0x200 /* Treat as anydata, eg mount-points before bound */
 #define XML_FLAG_CACHE_DIRTY 0x400 /* This part of XML tree is not synced to disk */
 #define XML_FLAG_SKIP      0x800 /* Node is skipped in xml_diff */
+#define XML_FLAG_EDITED   0x1000 /* Node or descendant edited since last commit, see xml_diff_edited */
+#define XML_FLAG_LAZY     0x2000 /* Children not loaded, loaded on first access, see xml_lazy_register */
+#define XML_FLAG_LAZY_LOADED 0x4000 /* Children loaded on access, may be unloaded again */
+#define XML_FLAG_DESCINDEX 0x8000 /* Node is in tree with descendant index, see xml_descendant_index_create */
 
 /*
  * Prototypes
  */
 char     *xml_type2str(enum cxobj_type type);
 int       xml_stats_global(uint64_t *nr);
+int       xml_stats_slab(uint64_t *slabs, uint64_t *used, size_t *sz);
 int       xml_stats(cxobj *xt, uint64_t *nrp, size_t *szp);
+int       xml_lazy_register(xml_lazyfn_t *loadfn, xml_lazyfn_t *freefn, xml_lazyfn_t *touchfn, void *arg);
+int       xml_lazy_suspend(int suspend);
+int       xml_lazy_load(cxobj *x);
+uint64_t  xml_lazy_errors(void);
 char     *xml_name(cxobj *xn);
 int       xml_name_set(cxobj *xn, char *name);
 char     *xml_prefix(cxobj *xn);
@@ -263,7 +283,10 @@ yang_stmt *xml_spec(cxobj *x);
 int       xml_spec_set(cxobj *x, yang_stmt *spec);
 cg_var   *xml_cv(cxobj *x);
 int       xml_cv_set(cxobj *x, cg_var *cv);
+struct xml_sortkey *xml_sortkey(cxobj *x);
+int       xml_sortkey_set(cxobj *x, struct xml_sortkey *sk);
 cxobj    *xml_find(cxobj *xn_parent, char *name);
+cxobj    *xml_find_interned(cxobj *xn_parent, char *iname);
 int       xml_addsub(cxobj *xp, cxobj *xc);
 cxobj    *xml_wrap_all(cxobj *xp, char *tag);
 cxobj    *xml_wrap(cxobj *xc, char *tag);
@@ -287,6 +310,10 @@ char     *xml_find_body(cxobj *xn, const char *name);
 cxobj    *xml_find_body_obj(cxobj *xt, const char *name, char *val);
 int       xml_free0(cxobj *x);
 int       xml_free(cxobj *xn);
+const uint8_t *xml_digest(cxobj *x);
+const uint8_t *xml_digest_cached(cxobj *x);
+int       xml_digest_equal(cxobj *x0, cxobj *x1);
+void      xml_digest_reset(cxobj *x);
 int       xml_copy_one(cxobj *xn0, cxobj *xn1);
 int       xml_copy(cxobj *x0, cxobj *x1);
 cxobj    *xml_dup(cxobj *x0);
@@ -307,6 +334,7 @@ int       xml_search_index_p(cxobj *x);
 int       xml_search_vector_get(cxobj *x, char *name, clixon_xvec **xvec);
 int       xml_search_child_insert(cxobj *xp, cxobj *x);
 int       xml_search_child_rm(cxobj *xp, cxobj *x);
+int       xml_search_index_verify(cxobj *xt);
 cxobj    *xml_child_index_each(cxobj *xparent, char *name, cxobj *xprev, enum cxobj_type type);
 
 #endif
@@ -40,6 +40,21 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/*! View function: decide if an XML node is part of a read-only view
+ *
+ * @param[in]  x    XML node with yang spec
+ * @param[in]  arg  Argument given to clixon_xml2cbuf_view
+ * @retval     2    No decision, same as parent
+ * @retval     1    Visible, and descendants unless they are hidden
+ * @retval     0    Hidden, including descendants
+ * @retval    -1    Error
+ * @see clixon_xml2cbuf_view
+ */
+typedef int (xml_view_fn_t)(cxobj *x, void *arg);
+
 /*
  * Prototypes
  */
@@ -56,6 +71,9 @@ int   clixon_xml2cbuf1(cbuf *cb, cxobj *x, int level, int prettyprint, char *pre
                        int32_t depth, int skiptop, withdefaults_type wdef);
 int   clixon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix, int32_t depth, 
 int skiptop);
+int   clixon_xml2cbuf_view(cbuf *cb, cxobj *xt, char *name, cxobj **xvec, size_t xlen,
+                           int32_t depth, withdefaults_type wdef,
+                           xml_view_fn_t *fn, void *arg, int visible);
 int   xmltree2cbuf(cbuf *cb, cxobj *x, int level);
 int   clixon_xml_parse_file(FILE *f, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
 int   clixon_xml_parse_string(const char *str, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
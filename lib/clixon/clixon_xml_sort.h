@@ -38,6 +38,24 @@
 #ifndef _CLIXON_XML_SORT_H
 #define _CLIXON_XML_SORT_H
 
+/*
+ * Types
+ */
+/*! Normalized sort key of a list or leaf-list entry, cached in the XML node
+ *
+ * Comparing two keys of the same yang with memcmp gives the same order as xml_cmp
+ * @see xml_sortkey_cache
+ */
+struct xml_sortkey {
+    uint32_t sk_len;    /* Length of sk_key */
+    uint8_t  sk_flags;  /* XML_SORTKEY_NONE, XML_SORTKEY_PARTIAL */
+    uint8_t  sk_key[];  /* Encoded key leafs in key order */
+};
+
+/* Sort key flags */
+#define XML_SORTKEY_NONE    0x01 /* No memcmp-comparable encoding, eg type not supported */
+#define XML_SORTKEY_PARTIAL 0x02 /* Some key leaf is missing */
+
 /*
  * Prototypes
  */
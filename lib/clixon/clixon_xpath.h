@@ -121,6 +121,9 @@ struct xpath_tree{
 };
 typedef struct xpath_tree xpath_tree;
 
+/* Compiled XPath handle, see xpath_compile */
+typedef struct xpath_compiled xpath_compiled;
+
 /*
  * Prototypes
  */
@@ -132,9 +135,20 @@ int   xpath_tree_print(FILE *f, xpath_tree *xs);
 int   xpath_tree2cbuf(xpath_tree *xs, cbuf *xpathcb);
 int   xpath_tree_eq(xpath_tree *xt1, xpath_tree *xt2, xpath_tree ***vec, size_t *len);
 xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
+int   xpath_tree_names(xpath_tree *xs, cvec *names, int *any);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx **xrp);
+int   xpath_cache_stats(uint64_t *nr, uint64_t *hits, uint64_t *misses);
+void  xpath_cache_exit(void);
+int   xpath_compile(const char *xpath, xpath_compiled **xpcp);
+int   xpath_compiled_free(xpath_compiled *xpc);
+char *xpath_compiled_str(xpath_compiled *xpc);
+xpath_tree *xpath_compiled_tree(xpath_compiled *xpc);
+int   xpath_vec_ctx_compiled(cxobj *xcur, cvec *nsc, xpath_compiled *xpc, int localonly, xp_ctx **xrp);
+cxobj *xpath_first_compiled(cxobj *xcur, cvec *nsc, xpath_compiled *xpc);
+int   xpath_vec_compiled(cxobj *xcur, cvec *nsc, xpath_compiled *xpc, cxobj ***vec, size_t *veclen);
+int   xpath_vec_bool_compiled(cxobj *xcur, cvec *nsc, xpath_compiled *xpc);
 
 int    xpath_vec_bool(cxobj *xcur, cvec *nsc, const char *xpformat, ...) __attribute__ ((format (printf, 3, 4)));
 int    xpath_vec_flag(cxobj *xcur, cvec *nsc, const char *xpformat, uint16_t flags,
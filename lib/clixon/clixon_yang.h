@@ -100,6 +100,13 @@
                                       * may be different from orig, therefore do not use link to
                                       * original. May also be due to deviations of derived trees
                                       */
+#define YANG_FLAG_DEPS        0x4000 /* (Dynamic) must/when or leafref of node may be
+                                      * affected by a diff, see xml_yang_validate_all_diff */
+#define YANG_FLAG_DEPS_DESC   0x8000 /* (Dynamic) Descendant of node has YANG_FLAG_DEPS */
+
+/* Kind of dependency of a constraint on the nodes its XPath reads, see yang_deps_get */
+#define YANG_DEPS_CHANGE 0  /* Added, deleted or changed node, eg must/when */
+#define YANG_DEPS_DELETE 1  /* Deleted or changed node, eg leafref without predicates */
 /*! Names of top-level data YANGs
  */
 #define YANG_DOMAIN_TOP "top"
@@ -208,6 +215,7 @@ enum yang_class{
 typedef enum yang_class yang_class;
 
 struct xml;
+struct xpath_compiled;
 
 /* This is the external handle type exposed in the API.
  * The internal struct is defined in clixon_yang_internal.h */
@@ -276,6 +284,8 @@ yang_stmt *yang_when_get(clixon_handle h, yang_stmt *ys);
 int        yang_when_set(clixon_handle h, yang_stmt *ys, yang_stmt *ywhen);
 int        yang_when_xpath_get(yang_stmt *ys, char **xpath, cvec **nsc);
 int        yang_when_canonical_xpath_get(yang_stmt *ys, char **xpath, cvec **nsc);
+int        yang_xpath_compiled_get(yang_stmt *ys, int canonical, struct xpath_compiled **xpcp, cvec **nscp);
+int        yang_deps_get(yang_stmt *yspec, int kind, const char *name, yang_stmt ***vecp, int *lenp);
 const char *yang_filename_get(yang_stmt *ys);
 int        yang_filename_set(yang_stmt *ys, const char *filename);
 uint32_t   yang_linenum_get(yang_stmt *ys);
@@ -333,6 +343,8 @@ int        yang_spec_print(FILE *f, yang_stmt *yspec);
 int        yang_spec_dump(yang_stmt *yspec, int debuglevel);
 int        yang_mounts_print(FILE *f, yang_stmt *ymounts);
 int        if_feature(yang_stmt *yspec, char *module, char *feature);
+int        yang_identity_index(yang_stmt *yspec);
+int        yang_identity_derived(yang_stmt *yid, yang_stmt *ybase);
 int        ys_populate(yang_stmt *ys, void *arg);
 int        ys_populate2(yang_stmt *ys, void *arg);
 int        yang_apply(yang_stmt *yn, enum rfc_6020 key, yang_applyfn_t fn, int from, void *arg);
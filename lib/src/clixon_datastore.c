@@ -78,12 +78,15 @@
 #include "clixon_data.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_bind.h"
+#include "clixon_xml_index.h"
 #include "clixon_xml_default.h"
 #include "clixon_xml_io.h"
 #include "clixon_json.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_journal.h"
+#include "clixon_datastore_lazy.h"
 
 /*! Get xml database element including id, xml cache, empty on startup and dirty bit
  *
@@ -244,7 +247,79 @@ xmldb_db2subdir(clixon_handle h,
 int
 xmldb_connect(clixon_handle h)
 {
-    return 0;
+    return xmldb_lazy_init(h);
+}
+
+/*! Find other datastores sharing cache tree with a datastore
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  de    Datastore element
+ * @param[out] de1   One of the other datastores, if any
+ * @retval     n     Number of other datastores sharing the cache tree
+ * @retval    -1     Error
+ * @see xmldb_copy
+ */
+static int
+xmldb_cache_sharers(clixon_handle h,
+                    db_elmnt     *de,
+                    db_elmnt    **de1)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    int       i;
+    db_elmnt *de2;
+    int       n = 0;
+
+    *de1 = NULL;
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++){
+        if ((de2 = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) == NULL ||
+            de2 == de || de2->de_xml != de->de_xml)
+            continue;
+        *de1 = de2;
+        n++;
+    }
+    retval = n;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Release datastore cache tree, free it unless shared with other datastores
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  de    Datastore element, de_xml is NULL on return
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_cache_release(clixon_handle h,
+                    db_elmnt     *de)
+{
+    int       retval = -1;
+    db_elmnt *de1 = NULL;
+    int       n = 0;
+
+    if (de->de_xml == NULL)
+        goto ok;
+    if (de->de_shared){
+        if ((n = xmldb_cache_sharers(h, de, &de1)) < 0)
+            goto done;
+        if (n == 1) /* Remaining datastore owns the tree */
+            de1->de_shared = 0;
+    }
+    if (n == 0)
+        xml_free(de->de_xml);
+    de->de_xml = NULL;
+    de->de_shared = 0;
+    de->de_edited = 0;
+ ok:
+    retval = 0;
+ done:
+    return retval;
 }
 
 /*! Disconnect from a datastore plugin and deallocate resources
@@ -266,11 +341,11 @@ xmldb_disconnect(clixon_handle h)
         goto done;
     for(i = 0; i < klen; i++) 
         if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) != NULL){
-            if (de->de_xml){
-                xml_free(de->de_xml);
-                de->de_xml = NULL;
-            }
+            if (xmldb_cache_release(h, de) < 0)
+                goto done;
         }
+    if (xmldb_lazy_exit(h) < 0)
+        goto done;
     retval = 0;
  done:
     if (keys)
@@ -278,6 +353,35 @@ xmldb_disconnect(clixon_handle h)
     return retval;
 }
 
+/*! Reset XML_FLAG_EDITED in a cache tree, only marked nodes are visited
+ *
+ * @param[in]  x    XML node
+ * @param[in]  arg  Not used
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     0    OK, continue
+ */
+static int
+xml_edited_reset(cxobj *x,
+                 void  *arg)
+{
+    if (xml_flag(x, XML_FLAG_EDITED) == 0)
+        return 2;
+    xml_flag_reset(x, XML_FLAG_EDITED);
+    return 0;
+}
+
+/*! Clear edit marks in a datastore cache tree
+ *
+ * @param[in]  xt   Top of cache tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_edited_clear(cxobj *xt)
+{
+    return xml_apply(xt, CX_ELMNT, xml_edited_reset, NULL);
+}
+
 /*! Copy datastore from db1 to db2, both cache and datastore
  *
  * May include copying datastore directory structure
@@ -313,35 +417,31 @@ xmldb_copy(clixon_handle h,
         x1 = de1->de_xml;
     if ((de2 = clicon_db_elmnt_get(h, to)) != NULL)
         x2 = de2->de_xml;
-    if (x1 == NULL && x2 == NULL){
-        /* do nothing */
-    }
-    else if (x1 == NULL){  /* free x2 and set to NULL */
-        xml_free(x2);
-        x2 = NULL;
-    }
-    else  if (x2 == NULL){ /* create x2 and copy from x1 */
-        if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
-            goto done;
-        xml_flag_set(x2, XML_FLAG_TOP);
-        if (xml_copy(x1, x2) < 0) 
+    /* Free x2 unless it is already same as x1 (or shared with other datastore) */
+    if (x2 != NULL && x2 != x1){
+        if (xmldb_cache_release(h, de2) < 0)
             goto done;
+        x2 = NULL;
     }
-    else{ /* copy x1 to x2 */
-        xml_free0(x2);
-        xml_type_set(x2, CX_ELMNT);
-        if (xml_name_set(x2, xml_name(x1)) < 0)
-            goto done;
-        xml_flag_set(x2, XML_FLAG_TOP);
-        if (xml_copy(x1, x2) < 0) 
-            goto done;
+    /* Share x1 instead of copying it, first write copies it, see xmldb_cache_unshare */
+    if (x1 != NULL){
+        x2 = x1;
+        de1->de_shared = 1;
     }
-    /* always set cache although not strictly necessary in case 1
-     * above, but logic gets complicated due to differences with
+    /* always set cache although not strictly necessary if both are NULL
+     * but logic gets complicated due to differences with
      * de and de->de_xml */
     if (de2)
         de0 = *de2;
     de0.de_xml = x2; /* The new tree */
+    de0.de_shared = (x2 != NULL);
+    /* A copy of running is equal to running: edit marks are valid from here */
+    de0.de_edited = 0;
+    if (x2 != NULL && strcmp(from, "running") == 0){
+        if (xmldb_edited_clear(x2) < 0)
+            goto done;
+        de0.de_edited = 1;
+    }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, to, &subdir) < 0)
             goto done;
@@ -353,6 +453,16 @@ xmldb_copy(clixon_handle h,
         }
     }
     clicon_db_elmnt_set(h, to, &de0);
+    /* New running: only the source datastore, eg committed candidate, is equal to it */
+    if (strcmp(to, "running") == 0){
+        if (xmldb_edited_invalidate(h, to) < 0)
+            goto done;
+        if ((de1 = clicon_db_elmnt_get(h, from)) != NULL && de1->de_xml != NULL){
+            if (xmldb_edited_clear(de1->de_xml) < 0)
+                goto done;
+            de1->de_edited = 1;
+        }
+    }
     /* Copy the files themselves (above only in-memory cache)
      * Alt, dump the cache to file
      */
@@ -362,6 +472,9 @@ xmldb_copy(clixon_handle h,
         goto done;
     if (clicon_file_copy(fromfile, tofile) < 0)
         goto done;
+    /* Journal is copied along with the file, it is compacted at checkpoints only */
+    if (xmldb_journal_copy(h, from, to) < 0)
+        goto done;
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")) {
         if (xmldb_db2subdir(h, from, &fromdir) < 0)
             goto done;
@@ -556,14 +669,11 @@ int
 xmldb_clear(clixon_handle h,
             const char   *db)
 {
-    cxobj    *xt = NULL;
     db_elmnt *de = NULL;
 
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
-        if ((xt = de->de_xml) != NULL){
-            xml_free(xt);
-            de->de_xml = NULL;
-        }
+        if (xmldb_cache_release(h, de) < 0)
+            return -1;
         de->de_modified = 0;
         de->de_id = 0;
         memset(&de->de_tv, 0, sizeof(struct timeval));
@@ -597,6 +707,8 @@ xmldb_delete(clixon_handle h,
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s", db);
     if (xmldb_clear(h, db) < 0)
         goto done;
+    if (xmldb_edited_invalidate(h, db) < 0)
+        goto done;
     if (xmldb_db2file(h, db, &filename) < 0)
         goto done;
     if (lstat(filename, &st) == 0)
@@ -604,6 +716,8 @@ xmldb_delete(clixon_handle h,
             clixon_err(OE_DB, errno, "truncate %s", filename);
             goto done;
         }
+    if (xmldb_journal_reset(h, db) < 0)
+        goto done;
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, db, &subdir) < 0)
             goto done;
@@ -653,16 +767,13 @@ xmldb_create(clixon_handle h,
     char       *filename = NULL;
     int         fd = -1;
     db_elmnt   *de = NULL;
-    cxobj      *xt = NULL;
     char       *subdir = NULL;
     struct stat st = {0,};
 
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s", db);
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
-        if ((xt = de->de_xml) != NULL){
-            xml_free(xt);
-            de->de_xml = NULL;
-        }
+        if (xmldb_cache_release(h, de) < 0)
+            goto done;
     }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, db, &subdir) < 0)
@@ -731,6 +842,66 @@ xmldb_cache_get(clixon_handle h,
     return de->de_xml;
 }
 
+/*! Ensure datastore XML cache is not shared with other datastores before modifying it
+ *
+ * xmldb_copy shares the cache tree between the source and destination datastores.
+ * The first datastore that is modified makes its own full copy of the tree, ie the copy
+ * is deferred, not avoided, and both trees exist in memory after the first write.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_copy
+ */
+int
+xmldb_cache_unshare(clixon_handle h,
+                    const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    db_elmnt *de1 = NULL;
+    cxobj    *x0;
+    cxobj    *x = NULL;
+    int       n;
+    int       ret;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+        (x0 = de->de_xml) == NULL ||
+        de->de_shared == 0)
+        goto ok;
+    if ((n = xmldb_cache_sharers(h, de, &de1)) < 0)
+        goto done;
+    if (n > 0){
+        clixon_debug(CLIXON_DBG_DATASTORE, "%s copy shared cache", db);
+        if ((x = xml_new(xml_name(x0), NULL, CX_ELMNT)) == NULL)
+            goto done;
+        xml_flag_set(x, XML_FLAG_TOP);
+        /* Lazy split nodes are copied as placeholders */
+        xml_lazy_suspend(1);
+        ret = xml_copy(x0, x);
+        if (ret == 0)
+            ret = xmldb_lazy_track(h, x0, x);
+        xml_lazy_suspend(0);
+        if (ret < 0)
+            goto done;
+        if (clicon_option_bool(h, "CLICON_XMLDB_DESCENDANT_INDEX") &&
+            !clicon_option_bool(h, "CLICON_XMLDB_MULTI_LAZY") &&
+            xml_descendant_index_create(x) < 0)
+            goto done;
+        de->de_xml = x;
+        x = NULL;
+        if (n == 1) /* Remaining datastore owns the tree */
+            de1->de_shared = 0;
+    }
+    de->de_shared = 0;
+ ok:
+    retval = 0;
+ done:
+    if (x)
+        xml_free(x);
+    return retval;
+}
+
 /*! Get modified flag from datastore
  *
  * @param[in]  h     Clixon handle
@@ -868,6 +1039,66 @@ xmldb_volatile_set(clixon_handle h,
     return 0;
 }
 
+/*! Get edit mark validity of datastore
+ *
+ * If valid, the cache tree was equal to running when the marks were cleared and all
+ * nodes edited since then are marked with XML_FLAG_EDITED together with their
+ * ancestors. This makes it possible to only diff edited subtrees on commit.
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Database name
+ * @retval     1     Edit marks are valid
+ * @retval     0     Edit marks are not valid, or no such datastore
+ * @see xml_diff_edited
+ */
+int
+xmldb_edited_get(clixon_handle h,
+                 const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+        de->de_xml == NULL)
+        return 0;
+    return de->de_edited;
+}
+
+/*! Invalidate edit marks of datastore after modifying its cache by other means than xmldb_put
+ *
+ * If db is running, the marks of all datastores are invalidated
+ * @param[in]  h     Clixon handle
+ * @param[in]  db    Database name
+ * @retval     0     OK
+ * @retval    -1    Error
+ * @see xmldb_edited_get
+ */
+int
+xmldb_edited_invalidate(clixon_handle h,
+                        const char   *db)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    int       i;
+    db_elmnt *de;
+
+    if (strcmp(db, "running") != 0){
+        if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+            de->de_edited = 0;
+        goto ok;
+    }
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++)
+        if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) != NULL)
+            de->de_edited = 0;
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
 /* Print the datastore meta-info to file
  */
 int
@@ -924,6 +1155,8 @@ xmldb_rename(clixon_handle h,
         goto done;
     if (newdb == NULL && suffix == NULL)        // no-op
         goto done;
+    if (xmldb_journal_checkpoint(h, db) < 0)
+        goto done;
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
@@ -945,6 +1178,53 @@ xmldb_rename(clixon_handle h,
     return retval;
 }
 
+/*! Populate edited subtrees of a cache tree with yang binding and default values
+ *
+ * Only nodes marked with XML_FLAG_EDITED are visited. Edited nodes are normally
+ * already populated by xmldb_put, unedited nodes are equal to populated running.
+ * @param[in]  h      Clixon handle
+ * @param[in]  xt     XML tree node
+ * @param[in]  yspec  Yang spec
+ * @retval     1      OK
+ * @retval     0      YANG assigment and default assignment not made
+ * @retval    -1      Error
+ * @see xmldb_edited_get
+ */
+static int
+xmldb_populate_edited(clixon_handle h,
+                      cxobj        *xt,
+                      yang_stmt    *yspec)
+{
+    int    retval = -1;
+    cxobj *x;
+    int    ret;
+
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if (xml_flag(x, XML_FLAG_EDITED) == 0)
+            continue;
+        if (xml_spec(x) == NULL){
+            if ((ret = xml_bind_yang0(h, x, xml_spec(xt)?YB_PARENT:YB_MODULE, yspec, NULL)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            if (xml_default_recurse(x, 0, 0) < 0)
+                goto done;
+            continue;
+        }
+        if ((ret = xmldb_populate_edited(h, x, yspec)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Given a datastore, populate its cache with yang binding and default values
  *
  * @param[in]  h      Clixon handle
@@ -963,20 +1243,29 @@ xmldb_populate(clixon_handle h,
     yang_stmt *yspec;
     int        ret;
 
+    /* The tree is not unshared: binding and defaults of a shared tree are valid for all
+     * datastores sharing it, see xmldb_copy */
     if ((x = xmldb_cache_get(h, db)) == NULL){
         clixon_err(OE_XML, 0, "XML cache not found");
         goto done;
     }
     yspec = clicon_dbspec_yang(h);
-    if ((ret = xml_bind_yang(h, x, YB_MODULE, yspec, NULL)) < 0)
-        goto done;
-    if (ret == 1){
-        /* Add default global values (to make xpath below include defaults) */
-        if (xml_global_defaults(h, x, NULL, "/", yspec, 0) < 0)
+    /* Only edited subtrees may be unpopulated, see xmldb_edited_get */
+    if (xmldb_edited_get(h, db)){
+        if ((ret = xmldb_populate_edited(h, x, yspec)) < 0)
             goto done;
-        /* Add default recursive values */
-        if (xml_default_recurse(x, 0, 0) < 0)
+    }
+    else {
+        if ((ret = xml_bind_yang(h, x, YB_MODULE, yspec, NULL)) < 0)
             goto done;
+        if (ret == 1){
+            /* Add default global values (to make xpath below include defaults) */
+            if (xml_global_defaults(h, x, NULL, "/", yspec, 0) < 0)
+                goto done;
+            /* Add default recursive values */
+            if (xml_default_recurse(x, 0, 0) < 0)
+                goto done;
+        }
     }
     retval = ret;
  done:
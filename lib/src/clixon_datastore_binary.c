@@ -0,0 +1,846 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2025 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary datastore snapshot
+ * An alternative to XML/JSON datastore files that is loaded without parsing, binding
+ * or sorting. The tree is stored as written from the (bound and sorted) cache and
+ * loaded with mmap.
+ * File format (host byte order, all sections 4-byte aligned):
+ *   struct xmldb_bin_hdr                   # Magic, version, byte order and yspec digest
+ *   uint32_t stroff[nstr]                  # Offset of each string in string section
+ *   uint32_t yang[nyang]                   # String id of stable YANG path of each yang id
+ *   struct xmldb_bin_node node[nnode]      # Nodes, breadth-first: children are adjacent
+ *   char     strs[strsz]                   # Null-terminated strings
+ * Element names and prefixes are interned, ie stored once. Schema nodes are referenced
+ * by yang id, which is resolved once per file via its YANG path, eg:
+ *   /module clixon-example/container table/list parameter
+ * The yspec digest covers loaded modules, revisions, module text and features. If it
+ * differs from the digest of the running yspec, the tree is loaded unbound and
+ * bound/sorted as a parsed XML file would be. If the file is not a binary snapshot (eg an XML datastore
+ * when changing format) it is parsed as XML.
+ * @see CLICON_XMLDB_FORMAT
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_debug.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_digest.h"
+#include "clixon_datastore_binary.h"
+
+/* Magic of binary datastore file, including terminating null */
+#define XMLDB_BIN_MAGIC   "CLXNBIN"
+
+/* Increase when the file format changes */
+#define XMLDB_BIN_VERSION 1
+
+/* Written in host byte order, used to detect files from other architectures */
+#define XMLDB_BIN_ORDER   0x01020304
+
+/* No string or yang id */
+#define XMLDB_BIN_NONE    0xffffffff
+
+/* XML flags saved in file */
+#define XMLDB_BIN_FLAGS   (XML_FLAG_DEFAULT|XML_FLAG_ANYDATA)
+
+/* Binary datastore file header */
+struct xmldb_bin_hdr{
+    char     bh_magic[8];    /* XMLDB_BIN_MAGIC */
+    uint32_t bh_version;     /* XMLDB_BIN_VERSION */
+    uint32_t bh_order;       /* XMLDB_BIN_ORDER */
+    char     bh_digest[80];  /* Null-terminated hex digest of yspec */
+    uint32_t bh_nstr;        /* Number of strings */
+    uint32_t bh_strsz;       /* Size of string section in bytes */
+    uint32_t bh_nyang;       /* Number of yang ids */
+    uint32_t bh_nnode;       /* Number of nodes */
+};
+
+/* Binary datastore node */
+struct xmldb_bin_node{
+    uint32_t bn_name;        /* String id of name */
+    uint32_t bn_prefix;      /* String id of prefix or XMLDB_BIN_NONE */
+    uint32_t bn_value;       /* String id of value (body/attr) or XMLDB_BIN_NONE */
+    uint32_t bn_yang;        /* Yang id or XMLDB_BIN_NONE */
+    uint32_t bn_child;       /* Node index of first child */
+    uint32_t bn_nchild;      /* Number of children */
+    uint16_t bn_type;        /* enum cxobj_type */
+    uint16_t bn_flags;       /* XML flags, see XMLDB_BIN_FLAGS */
+};
+
+/* Binary datastore writer state */
+struct xmldb_bin_wr{
+    yang_stmt             *bw_yspec;    /* Top-level yang spec */
+    clicon_hash_t         *bw_names;    /* Interned names and prefixes -> string id */
+    clicon_hash_t         *bw_yangs;    /* Yang statement pointer -> yang id */
+    uint32_t              *bw_stroff;   /* String offsets */
+    size_t                 bw_nstr;
+    size_t                 bw_maxstr;
+    char                  *bw_strs;     /* String section */
+    size_t                 bw_strsz;
+    size_t                 bw_maxstrsz;
+    uint32_t              *bw_yang;     /* Yang id -> string id of yang path */
+    size_t                 bw_nyang;
+    size_t                 bw_maxyang;
+    struct xmldb_bin_node *bw_nodes;    /* Nodes breadth-first */
+    cxobj                **bw_xvec;     /* XML node of each node */
+    size_t                 bw_nnode;
+    size_t                 bw_maxnode;
+};
+
+/* Binary datastore reader state */
+struct xmldb_bin_rd{
+    struct xmldb_bin_hdr  *br_hdr;
+    uint32_t              *br_stroff;
+    uint32_t              *br_yang;
+    struct xmldb_bin_node *br_nodes;
+    char                  *br_strs;
+    yang_stmt            **br_yvec;     /* Resolved yang ids, NULL if loaded unbound */
+};
+
+/*! Compute digest of yang spec identifying the schema a binary datastore is bound to
+ *
+ * Covers module names, revisions, features and the text of each module, so that a
+ * module changed without a revision bump is detected.
+ * @param[in]  h       Clixon handle
+ * @param[in]  yspec   Top-level yang spec
+ * @param[out] digest  Hex digest string. Free with free()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xmldb_binary_digest  Cached
+ */
+static int
+xmldb_binary_digest_compute(clixon_handle h,
+                            yang_stmt    *yspec,
+                            char        **digest)
+{
+    int        retval = -1;
+    cbuf      *cb = NULL;
+    cbuf      *cbm = NULL;
+    char      *mdigest = NULL;
+    yang_stmt *ym;
+    yang_stmt *yrev;
+    cxobj     *xconf;
+    cxobj     *x;
+    int        inext;
+
+    if ((cb = cbuf_new()) == NULL ||
+        (cbm = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s %d;", XMLDB_BIN_MAGIC, XMLDB_BIN_VERSION);
+    inext = 0;
+    while ((ym = yn_iter(yspec, &inext)) != NULL) {
+        if (yang_keyword_get(ym) != Y_MODULE && yang_keyword_get(ym) != Y_SUBMODULE)
+            continue;
+        cprintf(cb, "%s %s", yang_key2str(yang_keyword_get(ym)), yang_argument_get(ym));
+        if ((yrev = yang_find(ym, Y_REVISION, NULL)) != NULL)
+            cprintf(cb, "@%s", yang_argument_get(yrev));
+        /* Module text, schema may change without a new revision */
+        cbuf_reset(cbm);
+        if (yang_print_cbuf(cbm, ym, 0, 0) < 0)
+            goto done;
+        if (clixon_digest_hex(cbuf_get(cbm), &mdigest) < 0)
+            goto done;
+        cprintf(cb, " %s;", mdigest);
+        free(mdigest);
+        mdigest = NULL;
+    }
+    /* Features may remove schema nodes */
+    if ((xconf = clicon_conf_xml(h)) != NULL){
+        x = NULL;
+        while ((x = xml_child_each(xconf, x, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(x), "CLICON_FEATURE") == 0 && xml_body(x) != NULL)
+                cprintf(cb, "feature %s;", xml_body(x));
+        }
+    }
+    if (clixon_digest_hex(cbuf_get(cb), digest) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (mdigest)
+        free(mdigest);
+    if (cbm)
+        cbuf_free(cbm);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Get digest of yang spec, computed once per yang spec and set of loaded modules
+ *
+ * Printing and hashing all modules is expensive and the digest is used on every save
+ * and load. It is cached in the handle and recomputed if another yspec is used or the
+ * number of loaded modules changes, ie when modules are loaded.
+ * Features are read from config on loading modules and are thus also covered.
+ * @param[in]  h       Clixon handle
+ * @param[in]  yspec   Top-level yang spec
+ * @param[out] digest  Hex digest string, cached in handle. Do not free
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xmldb_binary_digest(clixon_handle h,
+                    yang_stmt    *yspec,
+                    char        **digest)
+{
+    int        retval = -1;
+    yang_stmt *ys = NULL;
+    char      *d = NULL;
+
+    if (clicon_ptr_get(h, "xmldb-bin-yspec", (void**)&ys) < 0 ||
+        ys != yspec ||
+        clicon_data_int_get(h, "xmldb-bin-ylen") != yang_len_get(yspec) ||
+        clicon_data_get(h, "xmldb-bin-digest", digest) < 0){
+        if (xmldb_binary_digest_compute(h, yspec, &d) < 0)
+            goto done;
+        if (clicon_data_set(h, "xmldb-bin-digest", d) < 0 ||
+            clicon_data_int_set(h, "xmldb-bin-ylen", yang_len_get(yspec)) < 0 ||
+            clicon_ptr_set(h, "xmldb-bin-yspec", yspec) < 0)
+            goto done;
+        if (clicon_data_get(h, "xmldb-bin-digest", digest) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    if (d)
+        free(d);
+    return retval;
+}
+
+/*! Resolve stable YANG path to yang statement
+ *
+ * @param[in]  yspec   Top-level yang spec
+ * @param[in]  path    YANG path on the form: /<keyword> <argument>/...
+ * @param[out] yres    Yang statement, or NULL if not found
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xmldb_binary_yang_path
+ */
+static int
+xmldb_binary_yang_resolve(yang_stmt  *yspec,
+                          const char *path,
+                          yang_stmt **yres)
+{
+    int        retval = -1;
+    char      *str = NULL;
+    char      *s;
+    char      *seg;
+    char      *arg;
+    int        keyword;
+    yang_stmt *y;
+
+    if ((str = strdup(path)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    y = yspec;
+    s = str;
+    while (y != NULL && (seg = strsep(&s, "/")) != NULL) {
+        if (*seg == '\0')
+            continue;
+        if ((arg = strchr(seg, ' ')) == NULL){
+            y = NULL;
+            break;
+        }
+        *arg++ = '\0';
+        if ((keyword = yang_str2key(seg)) < 0){
+            y = NULL;
+            break;
+        }
+        y = yang_find(y, keyword, arg);
+    }
+    *yres = y;
+    retval = 0;
+ done:
+    if (str)
+        free(str);
+    return retval;
+}
+
+/*! Get stable YANG path of a yang statement
+ *
+ * @param[in]  y       Yang statement
+ * @param[out] cb      YANG path on the form: /<keyword> <argument>/...
+ * @see xmldb_binary_yang_resolve
+ */
+static void
+xmldb_binary_yang_path(yang_stmt *y,
+                       cbuf      *cb)
+{
+    yang_stmt *yp;
+
+    if ((yp = yang_parent_get(y)) != NULL &&
+        yang_keyword_get(yp) != Y_SPEC)
+        xmldb_binary_yang_path(yp, cb);
+    cprintf(cb, "/%s %s", yang_key2str(yang_keyword_get(y)), yang_argument_get(y));
+}
+
+/*! Ensure vector has room for n elements
+ *
+ * @param[in,out] vecp  Vector
+ * @param[in,out] maxp  Allocated elements
+ * @param[in]     n     Required number of elements
+ * @param[in]     sz    Element size
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+xmldb_binary_grow(void  **vecp,
+                  size_t *maxp,
+                  size_t  n,
+                  size_t  sz)
+{
+    size_t max;
+    void  *vec;
+
+    if (n <= *maxp)
+        return 0;
+    max = *maxp ? *maxp : 64;
+    while (max < n)
+        max *= 2;
+    if ((vec = realloc(*vecp, max*sz)) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    *vecp = vec;
+    *maxp = max;
+    return 0;
+}
+
+/*! Add string to string section
+ *
+ * @param[in]  bw   Writer state
+ * @param[in]  str  Null-terminated string
+ * @param[out] id   String id
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_binary_str_add(struct xmldb_bin_wr *bw,
+                     const char          *str,
+                     uint32_t            *id)
+{
+    size_t len = strlen(str) + 1;
+
+    if (bw->bw_strsz + len >= XMLDB_BIN_NONE){
+        clixon_err(OE_DB, EFBIG, "Binary datastore string section too large");
+        return -1;
+    }
+    if (xmldb_binary_grow((void**)&bw->bw_stroff, &bw->bw_maxstr, bw->bw_nstr+1, sizeof(uint32_t)) < 0)
+        return -1;
+    if (xmldb_binary_grow((void**)&bw->bw_strs, &bw->bw_maxstrsz, bw->bw_strsz+len, 1) < 0)
+        return -1;
+    memcpy(bw->bw_strs + bw->bw_strsz, str, len);
+    bw->bw_stroff[bw->bw_nstr] = bw->bw_strsz;
+    bw->bw_strsz += len;
+    *id = bw->bw_nstr++;
+    return 0;
+}
+
+/*! Add interned string, ie only stored once
+ *
+ * @param[in]  bw   Writer state
+ * @param[in]  str  Null-terminated string
+ * @param[out] id   String id
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_binary_str_intern(struct xmldb_bin_wr *bw,
+                        const char          *str,
+                        uint32_t            *id)
+{
+    uint32_t *idp;
+
+    if ((idp = clicon_hash_value(bw->bw_names, str, NULL)) != NULL){
+        *id = *idp;
+        return 0;
+    }
+    if (xmldb_binary_str_add(bw, str, id) < 0)
+        return -1;
+    if (clicon_hash_add(bw->bw_names, str, id, sizeof(*id)) == NULL)
+        return -1;
+    return 0;
+}
+
+/*! Get yang id of yang statement, add a new id if not found
+ *
+ * @param[in]  bw   Writer state
+ * @param[in]  y    Yang statement
+ * @param[out] id   Yang id
+ * @retval     1    OK
+ * @retval     0    Yang statement cannot be referenced by path, eg mounted yang
+ * @retval    -1    Error
+ */
+static int
+xmldb_binary_yang_id(struct xmldb_bin_wr *bw,
+                     yang_stmt           *y,
+                     uint32_t            *id)
+{
+    int        retval = -1;
+    char       key[32];
+    uint32_t  *idp;
+    cbuf      *cb = NULL;
+    yang_stmt *yres = NULL;
+    uint32_t   strid;
+
+    snprintf(key, sizeof(key), "%p", y);
+    if ((idp = clicon_hash_value(bw->bw_yangs, key, NULL)) != NULL){
+        *id = *idp;
+        goto ok;
+    }
+    if (ys_spec(y) != bw->bw_yspec)
+        goto fail;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    xmldb_binary_yang_path(y, cb);
+    /* Path must resolve to same node when read */
+    if (xmldb_binary_yang_resolve(bw->bw_yspec, cbuf_get(cb), &yres) < 0)
+        goto done;
+    if (yres != y)
+        goto fail;
+    if (xmldb_binary_str_add(bw, cbuf_get(cb), &strid) < 0)
+        goto done;
+    if (xmldb_binary_grow((void**)&bw->bw_yang, &bw->bw_maxyang, bw->bw_nyang+1, sizeof(uint32_t)) < 0)
+        goto done;
+    bw->bw_yang[bw->bw_nyang] = strid;
+    *id = bw->bw_nyang++;
+    if (clicon_hash_add(bw->bw_yangs, key, id, sizeof(*id)) == NULL)
+        goto done;
+ ok:
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Append XML node to node vector
+ *
+ * @param[in]  bw   Writer state
+ * @param[in]  x    XML node
+ * @retval     1    OK
+ * @retval     0    Node cannot be represented
+ * @retval    -1    Error
+ */
+static int
+xmldb_binary_node_add(struct xmldb_bin_wr *bw,
+                      cxobj               *x)
+{
+    struct xmldb_bin_node *bn;
+    yang_stmt             *y;
+    char                  *str;
+    uint32_t               id;
+    int                    ret;
+
+    if (bw->bw_nnode + 1 >= XMLDB_BIN_NONE){
+        clixon_err(OE_DB, EFBIG, "Binary datastore too many nodes");
+        return -1;
+    }
+    if (xmldb_binary_grow((void**)&bw->bw_nodes, &bw->bw_maxnode, bw->bw_nnode+1,
+                          sizeof(struct xmldb_bin_node)) < 0)
+        return -1;
+    /* Same size as nodes */
+    if ((bw->bw_xvec = realloc(bw->bw_xvec, bw->bw_maxnode*sizeof(cxobj*))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    bn = &bw->bw_nodes[bw->bw_nnode];
+    memset(bn, 0, sizeof(*bn));
+    bn->bn_prefix = XMLDB_BIN_NONE;
+    bn->bn_value = XMLDB_BIN_NONE;
+    bn->bn_yang = XMLDB_BIN_NONE;
+    bn->bn_type = xml_type(x);
+    bn->bn_flags = xml_flag(x, XMLDB_BIN_FLAGS);
+    if (xmldb_binary_str_intern(bw, xml_name(x), &id) < 0)
+        return -1;
+    bn->bn_name = id;
+    if ((str = xml_prefix(x)) != NULL){
+        if (xmldb_binary_str_intern(bw, str, &id) < 0)
+            return -1;
+        bn->bn_prefix = id;
+    }
+    if (xml_type(x) != CX_ELMNT && (str = xml_value(x)) != NULL){
+        if (xmldb_binary_str_add(bw, str, &id) < 0)
+            return -1;
+        bn->bn_value = id;
+    }
+    if ((y = xml_spec(x)) != NULL){
+        if ((ret = xmldb_binary_yang_id(bw, y, &id)) < 0)
+            return -1;
+        if (ret == 0)
+            return 0;
+        bn->bn_yang = id;
+    }
+    bw->bw_xvec[bw->bw_nnode++] = x;
+    return 1;
+}
+
+/*! Write XML tree to file in binary datastore format
+ *
+ * The tree is written as-is, ie the bound and sorted cache including default values.
+ * @param[in]  h           Clixon handle
+ * @param[in]  f           Output file
+ * @param[in]  xt          Top of XML tree, ie <config>
+ * @param[in]  system_only Skip system-only-config data
+ * @retval     1           OK
+ * @retval     0           Tree cannot be represented, eg mounted yang, nothing written
+ * @retval    -1           Error
+ * @see xmldb_binary_read
+ */
+int
+xmldb_binary_write(clixon_handle h,
+                   FILE         *f,
+                   cxobj        *xt,
+                   int           system_only)
+{
+    int                  retval = -1;
+    struct xmldb_bin_wr  bw = {0,};
+    struct xmldb_bin_hdr hdr = {0};
+    char                *digest = NULL;
+    cxobj               *x;
+    cxobj               *xc;
+    yang_stmt           *y;
+    size_t               i;
+    size_t               first;
+    int                  exist;
+    int                  ret;
+
+    if ((bw.bw_yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if (xmldb_binary_digest(h, bw.bw_yspec, &digest) < 0)
+        goto done;
+    if ((bw.bw_names = clicon_hash_init()) == NULL)
+        goto done;
+    if ((bw.bw_yangs = clicon_hash_init()) == NULL)
+        goto done;
+    if ((ret = xmldb_binary_node_add(&bw, xt)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    /* Breadth-first: children of each node are appended adjacent to each other */
+    for (i=0; i<bw.bw_nnode; i++){
+        x = bw.bw_xvec[i];
+        if (xml_type(x) != CX_ELMNT)
+            continue;
+        first = bw.bw_nnode;
+        xc = NULL;
+        while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+            if (system_only && (y = xml_spec(xc)) != NULL){
+                exist = 0;
+                if (yang_extension_value(y, "system-only-config", CLIXON_LIB_NS, &exist, NULL) < 0)
+                    goto done;
+                if (exist)
+                    continue;
+            }
+            if ((ret = xmldb_binary_node_add(&bw, xc)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        bw.bw_nodes[i].bn_child = first;
+        bw.bw_nodes[i].bn_nchild = bw.bw_nnode - first;
+    }
+    memcpy(hdr.bh_magic, XMLDB_BIN_MAGIC, sizeof(XMLDB_BIN_MAGIC));
+    hdr.bh_version = XMLDB_BIN_VERSION;
+    hdr.bh_order = XMLDB_BIN_ORDER;
+    strncpy(hdr.bh_digest, digest, sizeof(hdr.bh_digest)-1);
+    hdr.bh_nstr = bw.bw_nstr;
+    hdr.bh_strsz = bw.bw_strsz;
+    hdr.bh_nyang = bw.bw_nyang;
+    hdr.bh_nnode = bw.bw_nnode;
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1 ||
+        fwrite(bw.bw_stroff, sizeof(uint32_t), bw.bw_nstr, f) != bw.bw_nstr ||
+        fwrite(bw.bw_yang, sizeof(uint32_t), bw.bw_nyang, f) != bw.bw_nyang ||
+        fwrite(bw.bw_nodes, sizeof(struct xmldb_bin_node), bw.bw_nnode, f) != bw.bw_nnode ||
+        fwrite(bw.bw_strs, 1, bw.bw_strsz, f) != bw.bw_strsz){
+        clixon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (bw.bw_names)
+        clicon_hash_free(bw.bw_names);
+    if (bw.bw_yangs)
+        clicon_hash_free(bw.bw_yangs);
+    if (bw.bw_stroff)
+        free(bw.bw_stroff);
+    if (bw.bw_strs)
+        free(bw.bw_strs);
+    if (bw.bw_yang)
+        free(bw.bw_yang);
+    if (bw.bw_nodes)
+        free(bw.bw_nodes);
+    if (bw.bw_xvec)
+        free(bw.bw_xvec);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get string given string id
+ *
+ * @param[in]  br   Reader state
+ * @param[in]  id   String id
+ * @retval     str  String
+ * @retval     NULL No string (XMLDB_BIN_NONE) or invalid id
+ */
+static char *
+xmldb_binary_str(struct xmldb_bin_rd *br,
+                 uint32_t             id)
+{
+    if (id >= br->br_hdr->bh_nstr)
+        return NULL;
+    return br->br_strs + br->br_stroff[id];
+}
+
+/*! Create XML node and its children from binary node
+ *
+ * @param[in]  br   Reader state
+ * @param[in]  i    Node index
+ * @param[in]  xp   XML parent
+ * @retval     1    OK
+ * @retval     0    Invalid node
+ * @retval    -1    Error
+ */
+static int
+xmldb_binary_node_build(struct xmldb_bin_rd *br,
+                        uint32_t             i,
+                        cxobj               *xp)
+{
+    struct xmldb_bin_node *bn = &br->br_nodes[i];
+    cxobj                 *x;
+    char                  *name;
+    char                  *str;
+    uint32_t               j;
+    int                    ret;
+
+    if (bn->bn_type != CX_ELMNT && bn->bn_type != CX_ATTR && bn->bn_type != CX_BODY)
+        return 0;
+    if ((name = xmldb_binary_str(br, bn->bn_name)) == NULL)
+        return 0;
+    /* Defaults are added when loaded unbound, schema defaults may have changed */
+    if (br->br_yvec == NULL && (bn->bn_flags & XML_FLAG_DEFAULT))
+        return 1;
+    if ((x = xml_new(name, xp, bn->bn_type)) == NULL)
+        return -1;
+    if (bn->bn_prefix != XMLDB_BIN_NONE){
+        if ((str = xmldb_binary_str(br, bn->bn_prefix)) == NULL)
+            return 0;
+        if (xml_prefix_set(x, str) < 0)
+            return -1;
+    }
+    if (bn->bn_value != XMLDB_BIN_NONE){
+        if ((str = xmldb_binary_str(br, bn->bn_value)) == NULL)
+            return 0;
+        if (xml_value_set(x, str) < 0)
+            return -1;
+    }
+    if (br->br_yvec){
+        if (bn->bn_yang != XMLDB_BIN_NONE){
+            if (bn->bn_yang >= br->br_hdr->bh_nyang)
+                return 0;
+            if (xml_spec_set(x, br->br_yvec[bn->bn_yang]) < 0)
+                return -1;
+        }
+        if (bn->bn_flags)
+            xml_flag_set(x, bn->bn_flags & XMLDB_BIN_FLAGS);
+    }
+    if (bn->bn_nchild == 0)
+        return 1;
+    /* Children are after parent, which also ensures the tree has no loops */
+    if (bn->bn_child <= i ||
+        (uint64_t)bn->bn_child + bn->bn_nchild > br->br_hdr->bh_nnode)
+        return 0;
+    for (j=0; j<bn->bn_nchild; j++){
+        if ((ret = xmldb_binary_node_build(br, bn->bn_child + j, x)) != 1)
+            return ret;
+    }
+    return 1;
+}
+
+/*! Read XML tree from binary datastore file
+ *
+ * If the yspec digest in the file is the same as the digest of yspec, the tree is returned
+ * bound and sorted. Otherwise it is returned unbound, and without default values, as if
+ * parsed from XML.
+ * @param[in]  h      Clixon handle
+ * @param[in]  fp     Datastore file
+ * @param[in]  yb     YB_MODULE: return bound tree if possible, YB_NONE: unbound
+ * @param[in]  yspec  Top-level yang spec
+ * @param[out] xtp    XML tree on the form <top><config>...</config></top>. Free with xml_free
+ * @param[out] bound  Set if tree is bound to yspec and sorted
+ * @retval     1      OK
+ * @retval     0      Not a binary datastore file, fp is unchanged
+ * @retval    -1      Error
+ * @see xmldb_binary_write
+ */
+int
+xmldb_binary_read(clixon_handle h,
+                  FILE         *fp,
+                  yang_bind     yb,
+                  yang_stmt    *yspec,
+                  cxobj       **xtp,
+                  int          *bound)
+{
+    int                  retval = -1;
+    struct xmldb_bin_rd  br = {0,};
+    struct xmldb_bin_hdr *hdr;
+    struct stat          st;
+    char                *p = MAP_FAILED;
+    size_t               sz = 0;
+    uint64_t             total;
+    char                *digest = NULL;
+    cxobj               *xt = NULL;
+    yang_stmt           *y;
+    char                *path;
+    uint32_t             i;
+    int                  ret;
+
+    *bound = 0;
+    if (fstat(fileno(fp), &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat");
+        goto done;
+    }
+    if (st.st_size < sizeof(struct xmldb_bin_hdr))
+        goto fail;
+    sz = st.st_size;
+    if ((p = mmap(NULL, sz, PROT_READ, MAP_PRIVATE, fileno(fp), 0)) == MAP_FAILED){
+        clixon_err(OE_UNIX, errno, "mmap");
+        goto done;
+    }
+    hdr = (struct xmldb_bin_hdr *)p;
+    if (memcmp(hdr->bh_magic, XMLDB_BIN_MAGIC, sizeof(XMLDB_BIN_MAGIC)) != 0)
+        goto fail;
+    if (hdr->bh_version != XMLDB_BIN_VERSION || hdr->bh_order != XMLDB_BIN_ORDER){
+        clixon_err(OE_DB, 0, "Binary datastore has unsupported version or byte order");
+        goto done;
+    }
+    total = sizeof(struct xmldb_bin_hdr) +
+        (uint64_t)hdr->bh_nstr*sizeof(uint32_t) +
+        (uint64_t)hdr->bh_nyang*sizeof(uint32_t) +
+        (uint64_t)hdr->bh_nnode*sizeof(struct xmldb_bin_node) +
+        hdr->bh_strsz;
+    if (total != sz || hdr->bh_nnode == 0 ||
+        (hdr->bh_strsz && p[sz-1] != '\0'))
+        goto corrupt;
+    br.br_hdr = hdr;
+    br.br_stroff = (uint32_t *)(p + sizeof(struct xmldb_bin_hdr));
+    br.br_yang = br.br_stroff + hdr->bh_nstr;
+    br.br_nodes = (struct xmldb_bin_node *)(br.br_yang + hdr->bh_nyang);
+    br.br_strs = (char *)(br.br_nodes + hdr->bh_nnode);
+    for (i=0; i<hdr->bh_nstr; i++)
+        if (br.br_stroff[i] >= hdr->bh_strsz)
+            goto corrupt;
+    /* Resolve all yang ids if file is bound to same yspec */
+    if (yb == YB_MODULE){
+        if (xmldb_binary_digest(h, yspec, &digest) < 0)
+            goto done;
+        if (strncmp(digest, hdr->bh_digest, sizeof(hdr->bh_digest)) == 0){
+            if ((br.br_yvec = calloc(hdr->bh_nyang+1, sizeof(yang_stmt *))) == NULL){
+                clixon_err(OE_UNIX, errno, "calloc");
+                goto done;
+            }
+            for (i=0; i<hdr->bh_nyang; i++){
+                if ((path = xmldb_binary_str(&br, br.br_yang[i])) == NULL)
+                    goto corrupt;
+                if (xmldb_binary_yang_resolve(yspec, path, &y) < 0)
+                    goto done;
+                if ((br.br_yvec[i] = y) == NULL){
+                    clixon_debug(CLIXON_DBG_DATASTORE, "%s not found, loading unbound", path);
+                    free(br.br_yvec);
+                    br.br_yvec = NULL;
+                    break;
+                }
+            }
+        }
+        else
+            clixon_debug(CLIXON_DBG_DATASTORE, "yspec digest differs, loading unbound");
+    }
+    if ((xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    if ((ret = xmldb_binary_node_build(&br, 0, xt)) < 0)
+        goto done;
+    if (ret == 0)
+        goto corrupt;
+    *bound = (br.br_yvec != NULL);
+    *xtp = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (br.br_yvec)
+        free(br.br_yvec);
+    if (p != MAP_FAILED)
+        munmap(p, sz);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+ corrupt:
+    clixon_err(OE_DB, 0, "Corrupt binary datastore");
+    goto done;
+}
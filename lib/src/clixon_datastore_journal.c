@@ -0,0 +1,780 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2025 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Datastore edit journal
+ * Instead of rewriting the whole datastore file on every edit (xmldb_put), the edit is
+ * appended to a journal file: <xmldb_dir>/<db>_journal
+ * The journal is compacted into the datastore file at checkpoints, and replayed on
+ * top of the datastore file when it is read from disk.
+ * File format:
+ *   clixon-journal 1 <inode> <size> <mtime-sec> <mtime-nsec>\n   # Identity of base datastore file
+ *   <len> <operation>\n<len bytes of XML><\n>               # One or several records
+ *   ...
+ * The journal header identifies the datastore file it applies to. If the datastore file has
+ * been replaced since (eg a checkpoint crashed after rename but before the journal was
+ * removed), the journal is stale and discarded.
+ * A record is only applied if it is complete, ie a truncated tail after a crash is ignored.
+ * Any other record that cannot be parsed or applied fails the read of the datastore.
+ * Appends are synced to disk before returning, so that an acknowledged edit survives a
+ * crash.
+ * When a datastore is copied, its journal is copied along with the file instead of being
+ * compacted, see xmldb_journal_copy.
+ * @see CLICON_XMLDB_JOURNAL
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_debug.h"
+#include "clixon_options.h"
+#include "clixon_yang_module.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_xml_io.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bind.h"
+#include "clixon_xml_default.h"
+#include "clixon_datastore.h"
+#include "clixon_datastore_write.h"
+#include "clixon_datastore_journal.h"
+
+/* First token of journal header line, followed by version */
+#define JOURNAL_MAGIC "clixon-journal 1"
+
+/*! Translate from symbolic database name to journal filename
+ *
+ * @param[in]   h        Clixon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Journal filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ */
+static int
+xmldb_db2journal(clixon_handle h,
+                 const char   *db,
+                 char        **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+        clixon_err(OE_XML, errno, "CLICON_XMLDB_DIR not set");
+        goto done;
+    }
+    cprintf(cb, "%s/%s_journal", dir, db);
+    if ((*filename = strdup(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Print identity of datastore file that a journal applies to
+ *
+ * @param[in]   h    Clixon handle
+ * @param[in]   db   Symbolic database name
+ * @param[out]  cb   Identity string is appended to this buffer
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+journal_base_id(clixon_handle h,
+                const char   *db,
+                cbuf         *cb)
+{
+    int         retval = -1;
+    char       *dbfile = NULL;
+    struct stat st = {0,};
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if (stat(dbfile, &st) < 0)
+        memset(&st, 0, sizeof(st));
+    cprintf(cb, "%ju %jd %jd %ld",
+            (uintmax_t)st.st_ino,
+            (intmax_t)st.st_size,
+            (intmax_t)st.st_mtim.tv_sec,
+            (long)st.st_mtim.tv_nsec);
+    retval = 0;
+ done:
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+/*! Check if journal is used for edits of this datastore
+ *
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Symbolic database name
+ * @retval     1   Yes, append edits to journal
+ * @retval     0   No, write edits to datastore file
+ */
+int
+xmldb_journal_active(clixon_handle h,
+                     const char   *db)
+{
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") == 0)
+        return 0;
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI"))
+        return 0;
+    return 1;
+}
+
+/*! Make a journal record of an edit before it is applied
+ *
+ * The edit tree is copied including all namespace declarations in its context, so
+ * that it can be parsed standalone on replay
+ * @param[in]  x1    Edit tree (top-level <config>) before modification
+ * @param[in]  op    Top-level operation
+ * @param[out] cbp   Record, free with cbuf_free
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xmldb_journal_record(cxobj              *x1,
+                     enum operation_type op,
+                     cbuf              **cbp)
+{
+    int    retval = -1;
+    cxobj *x1c = NULL;
+    cvec  *nsc = NULL;
+    cbuf  *cbx = NULL;
+    cbuf  *cb = NULL;
+
+    if ((cbx = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (x1 == NULL)
+        cprintf(cbx, "<%s/>", NETCONF_INPUT_CONFIG);
+    else {
+        if ((x1c = xml_dup(x1)) == NULL)
+            goto done;
+        if (xml_nsctx_node(x1, &nsc) < 0)
+            goto done;
+        if (xmlns_set_all(x1c, nsc) < 0)
+            goto done;
+        if (clixon_xml2cbuf(cbx, x1c, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+    }
+    cprintf(cb, "%zu %s\n", cbuf_len(cbx), xml_operation2str(op));
+    cbuf_append_str(cb, cbuf_get(cbx));
+    cprintf(cb, "\n");
+    *cbp = cb;
+    cb = NULL;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (cbx)
+        cbuf_free(cbx);
+    if (nsc)
+        cvec_free(nsc);
+    if (x1c)
+        xml_free(x1c);
+    return retval;
+}
+
+/*! Write a whole buffer to file descriptor
+ */
+static int
+journal_write(int         fd,
+              const char *buf,
+              size_t      len,
+              const char *filename)
+{
+    ssize_t n;
+
+    while (len > 0){
+        if ((n = write(fd, buf, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "write(%s)", filename);
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*! Sync datastore directory, eg after a journal has been created or renamed
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+journal_dir_sync(clixon_handle h)
+{
+    int   retval = -1;
+    char *dir;
+    int   fd = -1;
+
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+        clixon_err(OE_XML, errno, "CLICON_XMLDB_DIR not set");
+        goto done;
+    }
+    if ((fd = open(dir, O_RDONLY)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", dir);
+        goto done;
+    }
+    if (fsync(fd) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", dir);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    return retval;
+}
+
+/*! Append a record to the journal of a datastore
+ *
+ * If the journal does not exist, it is created with a header identifying the
+ * current datastore file.
+ * The journal is synced to disk before returning.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Symbolic database name
+ * @param[in]  cbr  Record, see xmldb_journal_record
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xmldb_journal_append(clixon_handle h,
+                     const char   *db,
+                     cbuf         *cbr)
+{
+    int         retval = -1;
+    char       *filename = NULL;
+    int         fd = -1;
+    struct stat st = {0,};
+    cbuf       *cb = NULL;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if ((fd = open(filename, O_WRONLY|O_APPEND|O_CREAT, S_IRUSR|S_IWUSR)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", filename);
+        goto done;
+    }
+    if (fstat(fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat(%s)", filename);
+        goto done;
+    }
+    if (st.st_size == 0){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "%s ", JOURNAL_MAGIC);
+        if (journal_base_id(h, db, cb) < 0)
+            goto done;
+        cprintf(cb, "\n");
+        if (journal_write(fd, cbuf_get(cb), cbuf_len(cb), filename) < 0)
+            goto done;
+    }
+    if (journal_write(fd, cbuf_get(cbr), cbuf_len(cbr), filename) < 0)
+        goto done;
+    if (fsync(fd) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", filename);
+        goto done;
+    }
+    /* New journal: make its directory entry durable */
+    if (st.st_size == 0 && journal_dir_sync(h) < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s: appended %zu bytes",
+                 filename, cbuf_len(cbr));
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (fd != -1)
+        close(fd);
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Read whole journal file into a null-terminated buffer
+ *
+ * @param[in]  filename  Journal file
+ * @param[out] bufp      Malloced buffer, or NULL if no journal or empty. Free after use
+ * @param[out] lenp      Length of buffer
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+journal_read(const char *filename,
+             char      **bufp,
+             size_t     *lenp)
+{
+    int         retval = -1;
+    int         fd = -1;
+    struct stat st = {0,};
+    char       *buf = NULL;
+    size_t      len = 0;
+    ssize_t     n;
+
+    *bufp = NULL;
+    *lenp = 0;
+    if ((fd = open(filename, O_RDONLY)) < 0){
+        if (errno == ENOENT)
+            goto ok;
+        clixon_err(OE_UNIX, errno, "open(%s)", filename);
+        goto done;
+    }
+    if (fstat(fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat(%s)", filename);
+        goto done;
+    }
+    if (st.st_size == 0)
+        goto ok;
+    if ((buf = malloc(st.st_size + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    while (len < st.st_size){
+        if ((n = read(fd, buf + len, st.st_size - len)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "read(%s)", filename);
+            goto done;
+        }
+        if (n == 0)
+            break;
+        len += n;
+    }
+    buf[len] = '\0';
+    *bufp = buf;
+    *lenp = len;
+    buf = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (buf)
+        free(buf);
+    if (fd != -1)
+        close(fd);
+    return retval;
+}
+
+/*! Apply a single journal record on a datastore tree
+ *
+ * @param[in]  h      Clixon handle
+ * @param[in]  x0     Datastore tree, bound to yang
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  opstr  Top-level operation as string
+ * @param[in]  str    Edit as XML string
+ * @retval     0      OK
+ * @retval    -1      Error, also if the record cannot be applied
+ */
+static int
+journal_record_apply(clixon_handle h,
+                     cxobj        *x0,
+                     yang_stmt    *yspec,
+                     char         *opstr,
+                     char         *str)
+{
+    int                 retval = -1;
+    enum operation_type op = OP_MERGE;
+    cxobj              *xt = NULL;
+    cxobj              *x1;
+    cxobj              *xerr = NULL;
+    cbuf               *cbret = NULL;
+    int                 ret;
+
+    if ((cbret = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (xml_operation(opstr, &op) < 0)
+        goto done;
+    if (clixon_xml_parse_string(str, YB_NONE, yspec, &xt, NULL) < 0)
+        goto done;
+    if ((x1 = xml_child_i_type(xt, 0, CX_ELMNT)) == NULL){
+        clixon_err(OE_DB, 0, "Journal record has no config");
+        goto done;
+    }
+    if ((ret = xml_bind_yang(h, x1, YB_MODULE, yspec, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        goto fail;
+    }
+    if (xml_sort_recurse(x1) < 0)
+        goto done;
+    if ((ret = xmldb_put_replay(h, x0, x1, yspec, op, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    retval = 0;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    if (xerr)
+        xml_free(xerr);
+    if (xt)
+        xml_free(xt);
+    return retval;
+ fail:
+    clixon_err(OE_DB, 0, "Journal record rejected: %s", cbuf_get(cbret));
+    goto done;
+}
+
+/*! Replay journal of a datastore on a tree read from the datastore file
+ *
+ * Complete records are applied in order. A truncated trailing record (eg from a crash) is
+ * removed from the journal. A journal whose header does not match the datastore file is
+ * stale and removed. A malformed or rejected record is an error, the journal is kept.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Symbolic database name
+ * @param[in]  yb     How x0 was bound to yang. If YB_NONE, x0 is bound if there is a journal
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  x0     Datastore tree as read from file
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Yang binding of datastore failed, xerr set
+ * @retval    -1      Error
+ */
+int
+xmldb_journal_replay(clixon_handle h,
+                     const char   *db,
+                     yang_bind     yb,
+                     yang_stmt    *yspec,
+                     cxobj        *x0,
+                     cxobj       **xerr)
+{
+    int     retval = -1;
+    char   *filename = NULL;
+    char   *buf = NULL;
+    size_t  len = 0;
+    cbuf   *cbid = NULL;
+    char   *p;
+    char   *nl;
+    char   *opstr;
+    char   *str;
+    size_t  pos;
+    size_t  reclen;
+    int     nr = 0;
+    int     ret;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if (journal_read(filename, &buf, &len) < 0)
+        goto done;
+    if (buf == NULL)
+        goto ok;
+    if ((cbid = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbid, "%s ", JOURNAL_MAGIC);
+    if (journal_base_id(h, db, cbid) < 0)
+        goto done;
+    cprintf(cbid, "\n");
+    if (len < cbuf_len(cbid) ||
+        strncmp(buf, cbuf_get(cbid), cbuf_len(cbid)) != 0){
+        clixon_debug(CLIXON_DBG_DATASTORE, "%s: stale, removed", filename);
+        if (xmldb_journal_reset(h, db) < 0)
+            goto done;
+        goto ok;
+    }
+    if (yb == YB_NONE){
+        if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (xml_sort_recurse(x0) < 0)
+            goto done;
+    }
+    /* Records were made on a tree with defaults */
+    if (xml_global_defaults(h, x0, NULL, "/", yspec, 0) < 0)
+        goto done;
+    if (xml_default_recurse(x0, 0, 0) < 0)
+        goto done;
+    pos = cbuf_len(cbid);
+    while (pos < len){
+        p = buf + pos;
+        if ((nl = strchr(p, '\n')) == NULL)
+            break;
+        *nl = '\0';
+        reclen = strtoul(p, &opstr, 10);
+        if (opstr == p || *opstr != ' ')
+            goto corrupt;
+        opstr++;
+        str = nl + 1;
+        if (str + reclen >= buf + len)
+            break; /* truncated */
+        if (str[reclen] != '\n')
+            goto corrupt;
+        str[reclen] = '\0';
+        if (journal_record_apply(h, x0, yspec, opstr, str) < 0)
+            goto done;
+        nr++;
+        pos = (str - buf) + reclen + 1;
+    }
+    if (pos < len){
+        clixon_log(h, LOG_WARNING, "%s: truncated record at offset %zu, discarded", filename, pos);
+        if (truncate(filename, pos) < 0){
+            clixon_err(OE_UNIX, errno, "truncate(%s)", filename);
+            goto done;
+        }
+    }
+    clixon_debug(CLIXON_DBG_DATASTORE, "%s: replayed %d records", filename, nr);
+ ok:
+    retval = 1;
+ done:
+    if (cbid)
+        cbuf_free(cbid);
+    if (buf)
+        free(buf);
+    if (filename)
+        free(filename);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+ corrupt:
+    clixon_err(OE_DB, 0, "%s: corrupt record at offset %zu", filename, pos);
+    goto done;
+}
+
+/*! Remove journal of a datastore, eg after it has been written to file
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Symbolic database name
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xmldb_journal_reset(clixon_handle h,
+                    const char   *db)
+{
+    int   retval = -1;
+    char *filename = NULL;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if (unlink(filename) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", filename);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (filename)
+        free(filename);
+    return retval;
+}
+
+/*! Copy journal of a datastore to another datastore after its file has been copied
+ *
+ * The records are copied and the header is set to identify the (copied) datastore file
+ * of the destination. The destination journal is written to a temporary file, synced and
+ * renamed. If the source has no journal, or a stale journal, the destination journal is
+ * removed.
+ * @param[in]  h     Clixon handle
+ * @param[in]  from  Source datastore
+ * @param[in]  to    Destination datastore, its file is a copy of the source file
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xmldb_copy
+ */
+int
+xmldb_journal_copy(clixon_handle h,
+                   const char   *from,
+                   const char   *to)
+{
+    int     retval = -1;
+    char   *fromfile = NULL;
+    char   *tofile = NULL;
+    char   *buf = NULL;
+    size_t  len = 0;
+    size_t  pos;
+    cbuf   *cb = NULL;
+    cbuf   *cbtmp = NULL;
+    char   *tmpfile;
+    int     fd = -1;
+
+    if (xmldb_db2journal(h, from, &fromfile) < 0)
+        goto done;
+    if (journal_read(fromfile, &buf, &len) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL ||
+        (cbtmp = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (buf != NULL){
+        cprintf(cb, "%s ", JOURNAL_MAGIC);
+        if (journal_base_id(h, from, cb) < 0)
+            goto done;
+        cprintf(cb, "\n");
+    }
+    if (buf == NULL ||
+        len < cbuf_len(cb) ||
+        strncmp(buf, cbuf_get(cb), cbuf_len(cb)) != 0){
+        if (xmldb_journal_reset(h, to) < 0)
+            goto done;
+        goto ok;
+    }
+    pos = cbuf_len(cb);
+    cbuf_reset(cb);
+    cprintf(cb, "%s ", JOURNAL_MAGIC);
+    if (journal_base_id(h, to, cb) < 0)
+        goto done;
+    cprintf(cb, "\n");
+    if (xmldb_db2journal(h, to, &tofile) < 0)
+        goto done;
+    cprintf(cbtmp, "%s.tmp", tofile);
+    tmpfile = cbuf_get(cbtmp);
+    if ((fd = open(tmpfile, O_WRONLY|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", tmpfile);
+        goto done;
+    }
+    if (journal_write(fd, cbuf_get(cb), cbuf_len(cb), tmpfile) < 0)
+        goto done;
+    if (journal_write(fd, buf + pos, len - pos, tmpfile) < 0)
+        goto done;
+    if (fsync(fd) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", tmpfile);
+        goto done;
+    }
+    close(fd);
+    fd = -1;
+    if (rename(tmpfile, tofile) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", tmpfile);
+        goto done;
+    }
+    if (journal_dir_sync(h) < 0)
+        goto done;
+    clixon_debug(CLIXON_DBG_DATASTORE, "%s: copied %zu bytes", tofile, len - pos);
+ ok:
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    if (cbtmp)
+        cbuf_free(cbtmp);
+    if (cb)
+        cbuf_free(cb);
+    if (buf)
+        free(buf);
+    if (tofile)
+        free(tofile);
+    if (fromfile)
+        free(fromfile);
+    return retval;
+}
+
+/*! Compact journal of a datastore into the datastore file
+ *
+ * If the datastore has a non-empty journal, read the datastore (replaying the journal if
+ * not cached), write it to file and remove the journal.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Symbolic database name
+ * @retval     0    OK, or no journal
+ * @retval    -1    Error
+ * @see CLICON_XMLDB_JOURNAL_CHECKPOINT
+ */
+int
+xmldb_journal_checkpoint(clixon_handle h,
+                         const char   *db)
+{
+    int         retval = -1;
+    char       *filename = NULL;
+    struct stat st = {0,};
+    cxobj      *xt = NULL;
+    cxobj      *xerr = NULL;
+    int         ret;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if (stat(filename, &st) < 0 || st.st_size == 0)
+        goto ok;
+    clixon_debug(CLIXON_DBG_DATASTORE, "%s", db);
+    if ((ret = xmldb_get_cache(h, db, YB_MODULE, &xt, NULL, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err_netconf(h, OE_DB, 0, xerr, "Checkpoint of %s", db);
+        goto done;
+    }
+    if (xmldb_write_cache2file(h, db) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    if (filename)
+        free(filename);
+    return retval;
+}
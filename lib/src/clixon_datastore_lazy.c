@@ -0,0 +1,621 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2025 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Lazy loading of CLICON_XMLDB_MULTI split files
+ * When a datastore is read, split nodes keep their link attribute and are flagged with
+ * XML_FLAG_LAZY. On first access of their children, the split file is read from the
+ * directory of the datastore owning the tree, bound to YANG, sorted and defaults added.
+ * Loaded split nodes are kept in a list in least recently used order: a node is moved
+ * last in list when loaded or accessed. Least recently used nodes are unloaded back to
+ * placeholders by xmldb_lazy_evict if the memory limit is exceeded and they are in sync
+ * with their split files.
+ * A split file that cannot be loaded leaves a placeholder, accessors count the failure,
+ * see xml_lazy_errors.
+ * @see CLICON_XMLDB_MULTI_LAZY
+ * @see CLICON_XMLDB_MULTI_LAZY_MAX
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_debug.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_json.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_io.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bind.h"
+#include "clixon_xml_default.h"
+#include "clixon_datastore.h"
+#include "clixon_datastore_lazy.h"
+
+/* Name of lazy loading state in clixon handle data */
+#define XMLDB_LAZY_DATA "xmldb-lazy"
+
+/* Loaded split node */
+struct xmldb_lazy_node {
+    qelem_t  ln_qelem;  /* List header */
+    cxobj   *ln_x;      /* Split node */
+    char    *ln_link;   /* Split file name in datastore directory */
+    size_t   ln_size;   /* Memory size of subtree when loaded */
+};
+typedef struct xmldb_lazy_node xmldb_lazy_node;
+
+/* Lazy loading state */
+struct xmldb_lazy {
+    xmldb_lazy_node *xl_list;  /* Loaded split nodes, least recently used first */
+    clicon_hash_t   *xl_hash;  /* Split node pointer to list element */
+    size_t           xl_size;  /* Total memory size of loaded split nodes */
+};
+typedef struct xmldb_lazy xmldb_lazy;
+
+/*! Lazy loading is active
+ *
+ * @param[in]  h   Clixon handle
+ * @retval     1   Yes
+ * @retval     0   No
+ */
+int
+xmldb_lazy_active(clixon_handle h)
+{
+    return clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+        clicon_option_bool(h, "CLICON_XMLDB_MULTI_LAZY");
+}
+
+/*! Get lazy loading state
+ */
+static xmldb_lazy *
+xmldb_lazy_get(clixon_handle h)
+{
+    void *ptr = NULL;
+
+    if (clicon_ptr_get(h, XMLDB_LAZY_DATA, &ptr) < 0)
+        return NULL;
+    return (xmldb_lazy *)ptr;
+}
+
+/*! Hash key of an XML node
+ */
+static void
+xmldb_lazy_key(cxobj *x,
+               char  *key,
+               size_t len)
+{
+    snprintf(key, len, "%p", x);
+}
+
+/*! Add a loaded split node last in list, or after another element
+ *
+ * @param[in]  xl    Lazy loading state
+ * @param[in]  x     Split node
+ * @param[in]  link  Split file name, copied
+ * @param[in]  size  Memory size of subtree
+ * @param[in]  prev  Add after this element, or NULL for last in list
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_lazy_add(xmldb_lazy      *xl,
+               cxobj           *x,
+               const char      *link,
+               size_t           size,
+               xmldb_lazy_node *prev)
+{
+    xmldb_lazy_node *next;
+    int              retval = -1;
+    xmldb_lazy_node *ln = NULL;
+    char             key[32];
+
+    if ((ln = malloc(sizeof(*ln))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(ln, 0, sizeof(*ln));
+    if ((ln->ln_link = strdup(link)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    ln->ln_x = x;
+    ln->ln_size = size;
+    xmldb_lazy_key(x, key, sizeof(key));
+    if (clicon_hash_add(xl->xl_hash, key, &ln, sizeof(ln)) == NULL)
+        goto done;
+    if (prev){
+        next = NEXTQ(xmldb_lazy_node *, prev);
+        ADDQ(ln, next);
+    }
+    else
+        ADDQ(ln, xl->xl_list);
+    xl->xl_size += size;
+    xml_flag_set(x, XML_FLAG_LAZY_LOADED);
+    ln = NULL;
+    retval = 0;
+ done:
+    if (ln){
+        if (ln->ln_link)
+            free(ln->ln_link);
+        free(ln);
+    }
+    return retval;
+}
+
+/*! Remove a loaded split node from list and free it
+ *
+ * @param[in]  xl    Lazy loading state
+ * @param[in]  ln    List element
+ */
+static int
+xmldb_lazy_rm(xmldb_lazy      *xl,
+              xmldb_lazy_node *ln)
+{
+    char key[32];
+
+    xml_flag_reset(ln->ln_x, XML_FLAG_LAZY_LOADED);
+    xmldb_lazy_key(ln->ln_x, key, sizeof(key));
+    clicon_hash_del(xl->xl_hash, key);
+    DELQ(ln, xl->xl_list, xmldb_lazy_node *);
+    xl->xl_size -= ln->ln_size;
+    if (ln->ln_link)
+        free(ln->ln_link);
+    free(ln);
+    return 0;
+}
+
+/*! Get directory of datastore owning the XML tree of a node
+ *
+ * Datastores sharing a tree have the same split files, any of them is used
+ * @param[in]  h       Clixon handle
+ * @param[in]  x       XML node in datastore cache
+ * @param[out] subdir  Datastore directory, malloced, or NULL if not found
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xmldb_lazy_subdir(clixon_handle h,
+                  cxobj        *x,
+                  char        **subdir)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    int       i;
+    db_elmnt *de;
+    cxobj    *xt;
+
+    *subdir = NULL;
+    xt = x;
+    while (xml_parent(xt) != NULL)
+        xt = xml_parent(xt);
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++){
+        if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) == NULL ||
+            de->de_xml != xt)
+            continue;
+        if (xmldb_db2subdir(h, keys[i], subdir) < 0)
+            goto done;
+        break;
+    }
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Load children of a split node from its split file, lazy callback
+ *
+ * @param[in]  x    Split node, XML_FLAG_LAZY is reset
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_lazy_register
+ */
+static int
+xmldb_lazy_load(cxobj *x,
+                void  *arg)
+{
+    int              retval = -1;
+    clixon_handle    h = (clixon_handle)arg;
+    xmldb_lazy      *xl;
+    cxobj           *xa;
+    char            *link = NULL;
+    char            *subdir = NULL;
+    cbuf            *cb = NULL;
+    FILE            *fp = NULL;
+    yang_stmt       *yspec;
+    cxobj           *xerr = NULL;
+    enum format_enum format;
+    uint64_t         nr = 0;
+    size_t           sz = 0;
+    int              linked = 0; /* Link attribute present */
+    cxobj           *xc;
+    cxobj           *xprev;
+    int              ret;
+
+    if ((xl = xmldb_lazy_get(h)) == NULL){
+        clixon_err(OE_DB, 0, "Lazy loading not initialized");
+        goto done;
+    }
+    if ((xa = xml_find_type(x, CLIXON_LIB_PREFIX, "link", CX_ATTR)) == NULL ||
+        xml_value(xa) == NULL){
+        clixon_err(OE_DB, 0, "Lazy node %s has no link", xml_name(x));
+        goto done;
+    }
+    linked = 1;
+    if ((link = strdup(xml_value(xa))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if (xmldb_lazy_subdir(h, x, &subdir) < 0)
+        goto done;
+    if (subdir == NULL){
+        clixon_err(OE_DB, 0, "Lazy node %s: no datastore found", xml_name(x));
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s/%s", subdir, link);
+    clixon_debug(CLIXON_DBG_DATASTORE, "Loading: %s", cbuf_get(cb));
+    if ((fp = fopen(cbuf_get(cb), "r")) == NULL) {
+        clixon_err(OE_UNIX, errno, "open(%s)", cbuf_get(cb));
+        goto done;
+    }
+    yspec = clicon_dbspec_yang(h);
+    format = format_str2int(clicon_option_str(h, "CLICON_XMLDB_FORMAT"));
+    if (format == FORMAT_JSON){
+        if (clixon_json_parse_file(fp, 1, YB_NONE, yspec, &x, &xerr) < 0)
+            goto done;
+    }
+    else if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x, &xerr) < 0)
+        goto done;
+    /* Link attributes are removed when split file is parsed */
+    xml_purge(xa);
+    if ((xa = xml_find_type(x, "xmlns", CLIXON_LIB_PREFIX, CX_ATTR)) != NULL)
+        xml_purge(xa);
+    linked = 0;
+    if ((ret = xml_bind_yang0(h, x, YB_PARENT, NULL, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_err(OE_DB, 0, "%s: YANG binding failed", cbuf_get(cb));
+        goto done;
+    }
+    if (xml_sort_recurse(x) < 0)
+        goto done;
+    if (xml_default_recurse(x, 0, 0) < 0)
+        goto done;
+    if (xml_stats(x, &nr, &sz) < 0)
+        goto done;
+    if (xmldb_lazy_add(xl, x, link, sz, NULL) < 0)
+        goto done;
+    retval = 0;
+ done:
+    /* Keep placeholder if split file not parsed, to not lose link */
+    if (retval < 0 && linked){
+        xc = NULL;
+        xprev = NULL;
+        while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+            if (xml_type(xc) != CX_ATTR){
+                xml_purge(xc);
+                xc = xprev;
+                continue;
+            }
+            xprev = xc;
+        }
+        xml_flag_set(x, XML_FLAG_LAZY);
+    }
+    if (xerr)
+        xml_free(xerr);
+    if (fp)
+        fclose(fp);
+    if (cb)
+        cbuf_free(cb);
+    if (subdir)
+        free(subdir);
+    if (link)
+        free(link);
+    return retval;
+}
+
+/*! Split node is freed, lazy callback
+ *
+ * @param[in]  x    Split node with XML_FLAG_LAZY_LOADED
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @see xml_lazy_register
+ */
+static int
+xmldb_lazy_free(cxobj *x,
+                void  *arg)
+{
+    clixon_handle    h = (clixon_handle)arg;
+    xmldb_lazy      *xl;
+    xmldb_lazy_node **lnp;
+    char             key[32];
+
+    if ((xl = xmldb_lazy_get(h)) == NULL)
+        return 0;
+    xmldb_lazy_key(x, key, sizeof(key));
+    if ((lnp = clicon_hash_value(xl->xl_hash, key, NULL)) != NULL)
+        xmldb_lazy_rm(xl, *lnp);
+    return 0;
+}
+
+/*! Loaded split node is accessed, move it last in list, lazy callback
+ *
+ * @param[in]  x    Split node with XML_FLAG_LAZY_LOADED
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ * @see xml_lazy_register
+ */
+static int
+xmldb_lazy_touch(cxobj *x,
+                 void  *arg)
+{
+    clixon_handle    h = (clixon_handle)arg;
+    xmldb_lazy      *xl;
+    xmldb_lazy_node **lnp;
+    xmldb_lazy_node *ln;
+    char             key[32];
+
+    if ((xl = xmldb_lazy_get(h)) == NULL)
+        return 0;
+    xmldb_lazy_key(x, key, sizeof(key));
+    if ((lnp = clicon_hash_value(xl->xl_hash, key, NULL)) == NULL)
+        return 0;
+    ln = *lnp;
+    if (PREVQ(xmldb_lazy_node *, xl->xl_list) != ln){ /* Not already last */
+        DELQ(ln, xl->xl_list, xmldb_lazy_node *);
+        ADDQ(ln, xl->xl_list);
+    }
+    return 0;
+}
+
+/*! Unload children of a split node and make it a placeholder again
+ *
+ * @param[in]  xl    Lazy loading state
+ * @param[in]  ln    List element, freed
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_lazy_unload(xmldb_lazy      *xl,
+                  xmldb_lazy_node *ln)
+{
+    int    retval = -1;
+    cxobj *x = ln->ln_x;
+    cxobj *xc;
+    cxobj *xprev;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "Unloading: %s", ln->ln_link);
+    xc = NULL;
+    xprev = NULL;
+    while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+        if (xml_type(xc) != CX_ATTR){
+            if (xml_purge(xc) < 0)
+                goto done;
+            xc = xprev;
+            continue;
+        }
+        xprev = xc;
+    }
+    if (xml_add_attr(x, "link", ln->ln_link, CLIXON_LIB_PREFIX, CLIXON_LIB_NS) == NULL)
+        goto done;
+    if (xmldb_lazy_rm(xl, ln) < 0)
+        goto done;
+    xml_flag_set(x, XML_FLAG_LAZY);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Unload least recently used split nodes until memory limit is not exceeded
+ *
+ * Split nodes not in sync with their split files, or edited since last commit, are
+ * kept in place. The datastore cache may not be referenced by callers when called,
+ * eg call between client requests.
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see CLICON_XMLDB_MULTI_LAZY_MAX
+ */
+int
+xmldb_lazy_evict(clixon_handle h)
+{
+    int              retval = -1;
+    xmldb_lazy      *xl;
+    xmldb_lazy_node *ln;
+    xmldb_lazy_node *next;
+    size_t           max;
+    char            *subdir = NULL;
+    int              n;
+
+    if (!xmldb_lazy_active(h) ||
+        (max = 1024*(size_t)clicon_option_int(h, "CLICON_XMLDB_MULTI_LAZY_MAX")) == 0 ||
+        (xl = xmldb_lazy_get(h)) == NULL)
+        goto ok;
+    n = 0;
+    for (ln = xl->xl_list; ln; ln = NEXTQ(xmldb_lazy_node *, ln)){
+        n++;
+        if (NEXTQ(xmldb_lazy_node *, ln) == xl->xl_list)
+            break;
+    }
+    ln = xl->xl_list;
+    while (xl->xl_size > max && n-- > 0){
+        next = NEXTQ(xmldb_lazy_node *, ln);
+        if (xml_flag(ln->ln_x, XML_FLAG_CACHE_DIRTY|XML_FLAG_EDITED) == 0){
+            if (xmldb_lazy_subdir(h, ln->ln_x, &subdir) < 0)
+                goto done;
+        }
+        if (subdir != NULL){ /* Otherwise not in sync or not in datastore: keep */
+            free(subdir);
+            subdir = NULL;
+            if (xmldb_lazy_unload(xl, ln) < 0)
+                goto done;
+        }
+        ln = next;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (subdir)
+        free(subdir);
+    return retval;
+}
+
+/*! Copy list elements of loaded split nodes of a copied XML tree
+ *
+ * Loaded split nodes of the copy can then also be unloaded.
+ * @param[in]  h    Clixon handle
+ * @param[in]  x0   Original XML tree
+ * @param[in]  x1   Copy of x0, made with lazy loading suspended
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_cache_unshare
+ */
+int
+xmldb_lazy_track(clixon_handle h,
+                 cxobj        *x0,
+                 cxobj        *x1)
+{
+    int               retval = -1;
+    xmldb_lazy       *xl;
+    xmldb_lazy_node **lnp;
+    cxobj            *xc0;
+    cxobj            *xc1;
+    char              key[32];
+    int               i;
+
+    if ((xl = xmldb_lazy_get(h)) == NULL)
+        goto ok;
+    if (xml_flag(x0, XML_FLAG_LAZY_LOADED)){
+        xmldb_lazy_key(x0, key, sizeof(key));
+        if ((lnp = clicon_hash_value(xl->xl_hash, key, NULL)) != NULL &&
+            xmldb_lazy_add(xl, x1, (*lnp)->ln_link, (*lnp)->ln_size, *lnp) < 0)
+            goto done;
+        goto ok; /* Split nodes are not split further */
+    }
+    for (i = 0; i < xml_child_nr(x0) && i < xml_child_nr(x1); i++){
+        xc0 = xml_child_i(x0, i);
+        xc1 = xml_child_i(x1, i);
+        if (xml_type(xc0) != CX_ELMNT)
+            continue;
+        if (xmldb_lazy_track(h, xc0, xc1) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Initialize lazy loading of split files if CLICON_XMLDB_MULTI_LAZY is set
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xmldb_lazy_init(clixon_handle h)
+{
+    int         retval = -1;
+    xmldb_lazy *xl = NULL;
+
+    if (!xmldb_lazy_active(h) || xmldb_lazy_get(h) != NULL)
+        goto ok;
+    if ((xl = malloc(sizeof(*xl))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xl, 0, sizeof(*xl));
+    if ((xl->xl_hash = clicon_hash_init()) == NULL)
+        goto done;
+    if (clicon_ptr_set(h, XMLDB_LAZY_DATA, xl) < 0)
+        goto done;
+    xl = NULL;
+    xml_lazy_register(xmldb_lazy_load, xmldb_lazy_free, xmldb_lazy_touch, h);
+ ok:
+    retval = 0;
+ done:
+    if (xl){
+        if (xl->xl_hash)
+            clicon_hash_free(xl->xl_hash);
+        free(xl);
+    }
+    return retval;
+}
+
+/*! Terminate lazy loading of split files
+ *
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ */
+int
+xmldb_lazy_exit(clixon_handle h)
+{
+    xmldb_lazy *xl;
+
+    if ((xl = xmldb_lazy_get(h)) == NULL)
+        goto ok;
+    xml_lazy_register(NULL, NULL, NULL, NULL);
+    while (xl->xl_list)
+        xmldb_lazy_rm(xl, xl->xl_list);
+    clicon_hash_free(xl->xl_hash);
+    free(xl);
+    clicon_ptr_del(h, XMLDB_LAZY_DATA);
+ ok:
+    return 0;
+}
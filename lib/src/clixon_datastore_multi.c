@@ -0,0 +1,461 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2025 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Concurrent file I/O of CLICON_XMLDB_MULTI split files
+ * The split files are distributed over a pool of worker threads. Each worker takes the
+ * next unprocessed file from the vector until all files are processed.
+ * Workers only make system calls and memory allocation, errors are recorded per file
+ * and reported by the calling thread.
+ * On read, the calling thread handles (parses) each file as soon as it is read, in
+ * completion order, and frees its content. Workers wait if too many files are read
+ * but not yet handled, which bounds the file content held in memory.
+ * @see CLICON_XMLDB_MULTI_THREADS
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_debug.h"
+#include "clixon_options.h"
+#include "clixon_datastore_multi.h"
+
+/* Max number of files read but not handled per thread */
+#define XMLDB_MULTI_INFLIGHT 2
+
+/* Worker pool state shared by all threads, counters protected by mp_mutex */
+struct xmldb_multi_pool {
+    xmldb_multi_file *mp_vec;    /* Files to process */
+    int               mp_len;    /* Length of mp_vec */
+    int               mp_next;   /* Next file to process */
+    int               mp_write;  /* Write files, else read */
+    int              *mp_done;   /* Read files in completion order, if handled */
+    int               mp_ndone;  /* Number of read files in mp_done */
+    int               mp_nhandled; /* Number of read files handled by calling thread */
+    int               mp_max;    /* Max read files not handled */
+    int               mp_abort;  /* Calling thread failed, do not process more files */
+    pthread_mutex_t   mp_mutex;
+    pthread_cond_t    mp_cond_done;  /* File is read */
+    pthread_cond_t    mp_cond_space; /* File is handled or abort */
+};
+
+/*! Append a split file to a file vector
+ *
+ * @param[in,out] vec      File vector, free with xmldb_multi_free
+ * @param[in,out] len      Length of file vector
+ * @param[in]     filename Split file name, copied
+ * @param[in]     x        XML node of split file, or NULL
+ * @param[in]     buf      File content to write (consumed), or NULL
+ * @param[in]     buflen   Length of buf
+ * @retval        0        OK
+ * @retval       -1        Error
+ */
+int
+xmldb_multi_add(xmldb_multi_file **vec,
+                int               *len,
+                const char        *filename,
+                cxobj             *x,
+                char              *buf,
+                size_t             buflen)
+{
+    int               retval = -1;
+    xmldb_multi_file *mf;
+
+    if ((*vec = realloc(*vec, (*len+1)*sizeof(xmldb_multi_file))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        goto done;
+    }
+    mf = &(*vec)[(*len)++];
+    memset(mf, 0, sizeof(*mf));
+    mf->mf_x = x;
+    mf->mf_buf = buf;
+    mf->mf_len = buflen;
+    if ((mf->mf_filename = strdup(filename)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Read one split file into memory
+ *
+ * Runs in a worker thread: do not call clixon_err, record errno in mf instead
+ * @param[in]  mf   Split file, content returned in mf_buf
+ */
+static void
+xmldb_multi_read1(xmldb_multi_file *mf)
+{
+    int         fd = -1;
+    struct stat st = {0,};
+    size_t      len = 0;
+    ssize_t     n;
+
+    if ((fd = open(mf->mf_filename, O_RDONLY)) < 0){
+        mf->mf_op = "open";
+        goto fail;
+    }
+    if (fstat(fd, &st) < 0){
+        mf->mf_op = "fstat";
+        goto fail;
+    }
+    if ((mf->mf_buf = malloc(st.st_size + 1)) == NULL){
+        mf->mf_op = "malloc";
+        goto fail;
+    }
+    while (len < st.st_size){
+        if ((n = read(fd, mf->mf_buf + len, st.st_size - len)) < 0){
+            if (errno == EINTR)
+                continue;
+            mf->mf_op = "read";
+            goto fail;
+        }
+        if (n == 0) /* Truncated since fstat */
+            break;
+        len += n;
+    }
+    mf->mf_buf[len] = '\0';
+    mf->mf_len = len;
+    close(fd);
+    return;
+ fail:
+    mf->mf_errno = errno;
+    if (fd != -1)
+        close(fd);
+}
+
+/*! Write one split file from memory
+ *
+ * Runs in a worker thread: do not call clixon_err, record errno in mf instead
+ * @param[in]  mf   Split file, content in mf_buf
+ */
+static void
+xmldb_multi_write1(xmldb_multi_file *mf)
+{
+    int     fd = -1;
+    size_t  len = 0;
+    ssize_t n;
+
+    if ((fd = open(mf->mf_filename, O_CREAT|O_WRONLY|O_TRUNC, S_IRWXU)) < 0){
+        mf->mf_op = "open";
+        goto fail;
+    }
+    while (len < mf->mf_len){
+        if ((n = write(fd, mf->mf_buf + len, mf->mf_len - len)) < 0){
+            if (errno == EINTR)
+                continue;
+            mf->mf_op = "write";
+            goto fail;
+        }
+        len += n;
+    }
+    if (close(fd) < 0){
+        fd = -1;
+        mf->mf_op = "close";
+        goto fail;
+    }
+    return;
+ fail:
+    mf->mf_errno = errno;
+    if (fd != -1)
+        close(fd);
+}
+
+/*! Worker thread: process files until none is left
+ *
+ * If read files are handled by the calling thread, wait until there is space for
+ * another read file before taking it, and hand it over when read.
+ * @param[in]  arg  Worker pool
+ * @retval     NULL
+ */
+static void *
+xmldb_multi_worker(void *arg)
+{
+    struct xmldb_multi_pool *mp = (struct xmldb_multi_pool *)arg;
+    int                      i;
+
+    for (;;){
+        pthread_mutex_lock(&mp->mp_mutex);
+        if (mp->mp_done)
+            while (mp->mp_abort == 0 &&
+                   mp->mp_next < mp->mp_len &&
+                   mp->mp_next - mp->mp_nhandled >= mp->mp_max)
+                pthread_cond_wait(&mp->mp_cond_space, &mp->mp_mutex);
+        i = mp->mp_abort ? mp->mp_len : mp->mp_next++;
+        pthread_mutex_unlock(&mp->mp_mutex);
+        if (i >= mp->mp_len)
+            break;
+        if (mp->mp_write)
+            xmldb_multi_write1(&mp->mp_vec[i]);
+        else
+            xmldb_multi_read1(&mp->mp_vec[i]);
+        if (mp->mp_done){
+            pthread_mutex_lock(&mp->mp_mutex);
+            mp->mp_done[mp->mp_ndone++] = i;
+            pthread_cond_signal(&mp->mp_cond_done);
+            pthread_mutex_unlock(&mp->mp_mutex);
+        }
+    }
+    return NULL;
+}
+
+/*! Handle one read file in the calling thread and free its content
+ *
+ * @param[in]  mf     Split file
+ * @param[in]  fn     Handler callback
+ * @param[in]  arg    Argument to fn
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_multi_handle1(xmldb_multi_file *mf,
+                    xmldb_multi_fn_t *fn,
+                    void             *arg)
+{
+    int retval = -1;
+
+    if (mf->mf_errno != 0){
+        clixon_err(OE_UNIX, mf->mf_errno, "%s(%s)", mf->mf_op, mf->mf_filename);
+        goto done;
+    }
+    if ((*fn)(mf, arg) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (mf->mf_buf){
+        free(mf->mf_buf);
+        mf->mf_buf = NULL;
+    }
+    return retval;
+}
+
+/*! Read or write split files in the calling thread, one at a time
+ *
+ * @param[in]  vec    File vector
+ * @param[in]  len    Length of file vector
+ * @param[in]  write  Write files from mf_buf, else read files into mf_buf
+ * @param[in]  fn     On read, handler of each read file
+ * @param[in]  arg    Argument to fn
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_multi_io
+ */
+static int
+xmldb_multi_seq(xmldb_multi_file *vec,
+                int               len,
+                int               write,
+                xmldb_multi_fn_t *fn,
+                void             *arg)
+{
+    int retval = -1;
+    int i;
+
+    for (i = 0; i < len; i++){
+        if (write){
+            xmldb_multi_write1(&vec[i]);
+            if (vec[i].mf_errno != 0){
+                clixon_err(OE_UNIX, vec[i].mf_errno, "%s(%s)", vec[i].mf_op, vec[i].mf_filename);
+                goto done;
+            }
+        }
+        else {
+            xmldb_multi_read1(&vec[i]);
+            if (xmldb_multi_handle1(&vec[i], fn, arg) < 0)
+                goto done;
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Read or write split files concurrently
+ *
+ * Number of threads is given by CLICON_XMLDB_MULTI_THREADS. If 0 or 1, or only one
+ * file, the files are processed by the calling thread.
+ * On write, the calling thread is one of the workers.
+ * On read, the calling thread calls fn for each file as soon as it is read, in
+ * completion order, and then frees the file content. At most XMLDB_MULTI_INFLIGHT
+ * files per thread are read but not handled at any time.
+ * @param[in]  h      Clixon handle
+ * @param[in]  vec    File vector
+ * @param[in]  len    Length of file vector
+ * @param[in]  write  Write files from mf_buf, else read files into mf_buf
+ * @param[in]  fn     On read, handler of each read file, called by calling thread
+ * @param[in]  arg    Argument to fn
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xmldb_multi_io(clixon_handle     h,
+               xmldb_multi_file *vec,
+               int               len,
+               int               write,
+               xmldb_multi_fn_t *fn,
+               void             *arg)
+{
+    int                     retval = -1;
+    struct xmldb_multi_pool mp = {0,};
+    pthread_t              *threads = NULL;
+    int                     nthreads;
+    int                     n = 0;
+    int                     i;
+    int                     k;
+    int                     ret;
+
+    if (!write && fn == NULL){
+        clixon_err(OE_DB, EINVAL, "fn is NULL");
+        goto done;
+    }
+    nthreads = clicon_option_int(h, "CLICON_XMLDB_MULTI_THREADS");
+    if (nthreads > len)
+        nthreads = len;
+    clixon_debug(CLIXON_DBG_DATASTORE, "%s %d files using %d threads",
+                 write?"write":"read", len, nthreads);
+    if (nthreads <= 1){
+        retval = xmldb_multi_seq(vec, len, write, fn, arg);
+        goto done;
+    }
+    mp.mp_vec = vec;
+    mp.mp_len = len;
+    mp.mp_write = write;
+    if (!write){
+        if ((mp.mp_done = calloc(len, sizeof(int))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        mp.mp_max = XMLDB_MULTI_INFLIGHT*nthreads;
+    }
+    if ((threads = calloc(nthreads, sizeof(pthread_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if ((ret = pthread_mutex_init(&mp.mp_mutex, NULL)) != 0){
+        clixon_err(OE_UNIX, ret, "pthread_mutex_init");
+        goto done;
+    }
+    pthread_cond_init(&mp.mp_cond_done, NULL);
+    pthread_cond_init(&mp.mp_cond_space, NULL);
+    /* On write, the calling thread is one of the workers, on read it handles files */
+    for (n = 0; n < (write?nthreads-1:nthreads); n++)
+        if (pthread_create(&threads[n], NULL, xmldb_multi_worker, &mp) != 0)
+            break;
+    retval = 0;
+    if (write)
+        xmldb_multi_worker(&mp);
+    else {
+        /* Handle read files in completion order */
+        for (k = 0; n > 0 && k < len; k++){
+            pthread_mutex_lock(&mp.mp_mutex);
+            while (mp.mp_ndone <= k)
+                pthread_cond_wait(&mp.mp_cond_done, &mp.mp_mutex);
+            i = mp.mp_done[k];
+            pthread_mutex_unlock(&mp.mp_mutex);
+            ret = xmldb_multi_handle1(&vec[i], fn, arg);
+            pthread_mutex_lock(&mp.mp_mutex);
+            mp.mp_nhandled++;
+            if (ret < 0)
+                mp.mp_abort = 1;
+            pthread_cond_broadcast(&mp.mp_cond_space);
+            pthread_mutex_unlock(&mp.mp_mutex);
+            if (ret < 0){
+                retval = -1;
+                break;
+            }
+        }
+    }
+    for (i = 0; i < n; i++)
+        pthread_join(threads[i], NULL);
+    /* If no threads could be created, the calling thread does all */
+    if (!write && n == 0)
+        retval = xmldb_multi_seq(vec, len, write, fn, arg);
+    for (i = 0; write && retval == 0 && i < len; i++)
+        if (vec[i].mf_errno != 0){
+            clixon_err(OE_UNIX, vec[i].mf_errno, "%s(%s)", vec[i].mf_op, vec[i].mf_filename);
+            retval = -1;
+        }
+    pthread_cond_destroy(&mp.mp_cond_space);
+    pthread_cond_destroy(&mp.mp_cond_done);
+    pthread_mutex_destroy(&mp.mp_mutex);
+ done:
+    if (threads)
+        free(threads);
+    if (mp.mp_done)
+        free(mp.mp_done);
+    return retval;
+}
+
+/*! Free split file vector
+ *
+ * @param[in]  vec    File vector
+ * @param[in]  len    Length of file vector
+ * @retval     0      OK
+ */
+int
+xmldb_multi_free(xmldb_multi_file *vec,
+                 int               len)
+{
+    int i;
+
+    for (i = 0; i < len; i++){
+        if (vec[i].mf_filename)
+            free(vec[i].mf_filename);
+        if (vec[i].mf_buf)
+            free(vec[i].mf_buf);
+    }
+    if (vec)
+        free(vec);
+    return 0;
+}
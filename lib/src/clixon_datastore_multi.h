@@ -0,0 +1,75 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2025 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Concurrent file I/O of CLICON_XMLDB_MULTI split files
+ * Split files of a datastore are read into memory, or written from memory, by a pool
+ * of worker threads, see CLICON_XMLDB_MULTI_THREADS.
+ * Parsing and serializing of XML is made by the calling thread since the parsers and
+ * the error handling are not reentrant. Each read file is parsed as soon as it is read.
+ */
+#ifndef _CLIXON_DATASTORE_MULTI_H
+#define _CLIXON_DATASTORE_MULTI_H
+
+/*
+ * Types
+ */
+/* One split file to read or write */
+struct xmldb_multi_file {
+    char       *mf_filename; /* Split file name */
+    cxobj      *mf_x;        /* XML node of split file (read) */
+    char       *mf_buf;      /* File content, null-terminated on read */
+    size_t      mf_len;      /* Length of file content */
+    int         mf_errno;    /* errno of failed I/O, or 0 */
+    const char *mf_op;       /* Failed system call if mf_errno is set */
+};
+typedef struct xmldb_multi_file xmldb_multi_file;
+
+/*! Handler of a read split file, called by the calling thread of xmldb_multi_io
+ *
+ * @param[in]  mf   Split file, content in mf_buf, freed after call
+ * @param[in]  arg  Argument given to xmldb_multi_io
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+typedef int (xmldb_multi_fn_t)(xmldb_multi_file *mf, void *arg);
+
+/*
+ * Prototypes
+ */
+int xmldb_multi_add(xmldb_multi_file **vec, int *len, const char *filename, cxobj *x,
+                    char *buf, size_t buflen);
+int xmldb_multi_io(clixon_handle h, xmldb_multi_file *vec, int len, int write,
+                   xmldb_multi_fn_t *fn, void *arg);
+int xmldb_multi_free(xmldb_multi_file *vec, int len);
+
+#endif /* _CLIXON_DATASTORE_MULTI_H */
@@ -66,6 +66,7 @@
 #include "clixon_debug.h"
 #include "clixon_file.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_index.h"
 #include "clixon_xml_bind.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
@@ -83,6 +84,10 @@
 #include "clixon_xml_nsctx.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_journal.h"
+#include "clixon_datastore_binary.h"
+#include "clixon_datastore_multi.h"
+#include "clixon_datastore_lazy.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
@@ -91,10 +96,13 @@
  * @see xmldb_multi_write_arg
  */
 struct xmldb_multi_read_arg {
-    char            *mr_subdir;
-    yang_stmt       *mr_yspec;
-    enum format_enum mr_format;
-    cxobj          **mr_xerr;
+    char             *mr_subdir;
+    xmldb_multi_file *mr_vec;   /* Split files to read */
+    int               mr_len;   /* Length of mr_vec */
+    int               mr_lazy;  /* Keep links, see CLICON_XMLDB_MULTI_LAZY */
+    enum format_enum  mr_format; /* Datastore format */
+    yang_stmt        *mr_yspec; /* Top-level yang spec */
+    cxobj           **mr_xerr;  /* XML error if parse failed */
 };
 
 /*! Ensure that xt only has a single sub-element and that is "config"
@@ -415,6 +423,33 @@ text_read_modstate(clixon_handle       h,
     return retval;
 }
 
+/*! Check if nacm only contains default values
+ *
+ * @param[in]  xt    Top-level XML
+ * @param[in]  yspec YANG spec
+ * @retval     1     NACM only contains default values
+ * @retval     0     No NACM, or NACM has non-default values
+ */
+static int
+nacm_is_empty(cxobj     *xt,
+              yang_stmt *yspec)
+{
+    cxobj *xnacm;
+    cxobj *x;
+
+    if (yang_find(yspec, Y_MODULE, "ietf-netconf-acm") == NULL)
+        return 0;
+    if ((xnacm = xpath_first(xt, NULL, "nacm")) == NULL)
+        return 0;
+    /* Go through all children and check all are defaults, otherwise quit */
+    x = NULL;
+    while ((x = xml_child_each(xnacm, x, CX_ELMNT)) != NULL) {
+        if (!xml_flag(x, XML_FLAG_DEFAULT))
+            return 0; /* not empty, at least one non-default child of nacm */
+    }
+    return 1;
+}
+
 /*! Check if nacm only contains default values, if so disable NACM
  *
  * @param[in]  xt    Top-level XML
@@ -427,25 +462,12 @@ disable_nacm_on_empty(cxobj     *xt,
                       yang_stmt *yspec)
 {
     int        retval = -1;
-    yang_stmt *ymod;
     cxobj    **vec = NULL;
     int        len = 0;
-    cxobj     *xnacm = NULL;
-    cxobj     *x;
     cxobj     *xb;
 
-    if ((ymod = yang_find(yspec, Y_MODULE, "ietf-netconf-acm")) == NULL)
-        goto ok;
-    if ((xnacm = xpath_first(xt, NULL, "nacm")) == NULL)
+    if (!nacm_is_empty(xt, yspec))
         goto ok;
-    /* Go through all children and check all are defaults, otherwise quit */
-    x = NULL;
-    while ((x = xml_child_each(xnacm, x, CX_ELMNT)) != NULL) {
-        if (!xml_flag(x, XML_FLAG_DEFAULT))
-            break;
-    }
-    if (x != NULL)
-        goto ok; /* not empty, at least one non-default child of nacm */
     if (clixon_xml_find_instance_id(xt, yspec, &vec, &len, "/nacm:nacm/nacm:enable-nacm") < 1)
         goto done;
     if (len){
@@ -464,13 +486,14 @@ disable_nacm_on_empty(cxobj     *xt,
 
 /*! Callback function for xmldb-multi read
  *
- * Look for link attribute in XML, and if found open the linked file for parsing
+ * Look for link attribute in XML, and if found add the linked file for reading
  * @param[in]  x    XML node
  * @param[in]  arg
  * @retval     2    Locally abort this subtree, continue with others
  * @retval     1    Abort, dont continue with others, return 1 to end user
  * @retval     0    OK, continue
  * @retval    -1    Error, aborted at first error encounter, return -1 to end user
+ * @see xmldb_multi_read
  */
 static int
 xmldb_multi_read_applyfn(cxobj *x,
@@ -481,11 +504,14 @@ xmldb_multi_read_applyfn(cxobj *x,
     cxobj                  *xa;
     char                   *filename;
     cbuf                   *cb = NULL;
-    char                   *dbfile;
-    FILE                   *fp = NULL;
 
     if ((xa = xml_find_type(x, CLIXON_LIB_PREFIX, "link", CX_ATTR)) != NULL &&
         (filename = xml_value(xa)) != NULL){
+        if (mr->mr_lazy){ /* Keep link, split file is loaded on access */
+            xml_flag_set(x, XML_FLAG_LAZY);
+            retval = 2;
+            goto done;
+        }
         if ((cb = cbuf_new()) == NULL){
             clixon_err(OE_XML, errno, "cbuf_new");
             goto done;
@@ -494,33 +520,94 @@ xmldb_multi_read_applyfn(cxobj *x,
         xml_purge(xa);
         if ((xa = xml_find_type(x, "xmlns", CLIXON_LIB_PREFIX, CX_ATTR)) != NULL)
             xml_purge(xa);
-        dbfile = cbuf_get(cb);
-        clixon_debug(CLIXON_DBG_DATASTORE, "Parsing: %s", dbfile);
-        if ((fp = fopen(dbfile, "r")) == NULL){
-            clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
+        if (xmldb_multi_add(&mr->mr_vec, &mr->mr_len, cbuf_get(cb), x, NULL, 0) < 0)
             goto done;
-        }
-        switch (mr->mr_format){
-        case FORMAT_JSON:
-            if (clixon_json_parse_file(fp, 1, YB_NONE, mr->mr_yspec, &x, mr->mr_xerr) < 0)
-                goto done;
-            break;
-        case FORMAT_XML:
-            if (clixon_xml_parse_file(fp, YB_NONE, mr->mr_yspec, &x, mr->mr_xerr) < 0)
-                goto done;
-            break;
-        default:
-            clixon_err(OE_DB, 0, "Format not supported");
-            goto done;
-            break;
-        }
+        retval = 2; /* Split files are not split further */
+        goto done;
     }
     retval = 0;
  done:
     if (cb)
         cbuf_free(cb);
-    if (fp)
-        fclose(fp);
+    return retval;
+}
+
+/*! Parse a read split file into its XML node, called when read
+ *
+ * @param[in]  mf   Split file
+ * @param[in]  arg  Read argument
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_multi_io
+ */
+static int
+xmldb_multi_read_parse(xmldb_multi_file *mf,
+                       void             *arg)
+{
+    struct xmldb_multi_read_arg *mr = (struct xmldb_multi_read_arg *) arg;
+    int                          retval = -1;
+    cxobj                       *x = mf->mf_x;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "Parsing: %s", mf->mf_filename);
+    switch (mr->mr_format){
+    case FORMAT_JSON:
+        if (clixon_json_parse_string(mf->mf_buf, 1, YB_NONE, mr->mr_yspec, &x, mr->mr_xerr) < 0)
+            goto done;
+        break;
+    case FORMAT_XML:
+        if (clixon_xml_parse_string(mf->mf_buf, YB_NONE, mr->mr_yspec, &x, mr->mr_xerr) < 0)
+            goto done;
+        break;
+    default:
+        clixon_err(OE_DB, 0, "Format not supported");
+        goto done;
+        break;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Read split files of a xmldb-multi datastore and add them to the XML tree
+ *
+ * The files are read concurrently, see CLICON_XMLDB_MULTI_THREADS, and each file is
+ * parsed into its XML node as soon as it is read.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Symbolic database name
+ * @param[in]  x0     XML tree of top-level file
+ * @param[in]  format Datastore format
+ * @param[in]  yspec  Top-level yang spec
+ * @param[out] xerr   XML error if parse failed
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_multi_read(clixon_handle    h,
+                 const char      *db,
+                 cxobj           *x0,
+                 enum format_enum format,
+                 yang_stmt       *yspec,
+                 cxobj          **xerr)
+{
+    int                         retval = -1;
+    struct xmldb_multi_read_arg mr = {0, };
+
+    if (xmldb_db2subdir(h, db, &mr.mr_subdir) < 0)
+        goto done;
+    mr.mr_lazy = xmldb_lazy_active(h);
+    mr.mr_format = format;
+    mr.mr_yspec = yspec;
+    mr.mr_xerr = xerr;
+    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xmldb_multi_read_applyfn, &mr) < 0)
+        goto done;
+    if (xmldb_multi_io(h, mr.mr_vec, mr.mr_len, 0, xmldb_multi_read_parse, &mr) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (mr.mr_subdir)
+        free(mr.mr_subdir);
+    if (mr.mr_vec)
+        xmldb_multi_free(mr.mr_vec, mr.mr_len);
     return retval;
 }
 
@@ -568,8 +655,10 @@ xmldb_readfile(clixon_handle    h,
     cxobj           *xmodfile = NULL;
     cxobj           *x;
     yang_stmt       *yspec1 = NULL;
-    struct xmldb_multi_read_arg mr = {0, };
+    int              bound = 0;     /* Binary datastore already bound and sorted */
 
+    /* Lazy split nodes are bound and sorted when loaded */
+    xml_lazy_suspend(1);
     if (yb != YB_MODULE && yb != YB_NONE){
         clixon_err(OE_XML, EINVAL, "yb is %d but should be module or none", yb);
         goto done;
@@ -610,18 +699,25 @@ xmldb_readfile(clixon_handle    h,
         if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0)
             goto done;
         break;
+    case FORMAT_BINARY:
+        if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+            clixon_err(OE_CFG, 0, "binary+multi not supported");
+            goto done;
+        }
+        if ((ret = xmldb_binary_read(h, fp, yb, yspec, &x0, &bound)) < 0)
+            goto done;
+        /* Not a binary file, eg written before changing format */
+        if (ret == 0 &&
+            clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0)
+            goto done;
+        break;
     default:
         clixon_err(OE_DB, 0, "Format %s not supported", formatstr);
         goto done;
         break;
     }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
-        if (xmldb_db2subdir(h, db, &mr.mr_subdir) < 0)
-            goto done;
-        mr.mr_format = format;
-        mr.mr_yspec = yspec;
-        mr.mr_xerr = xerr;
-        if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xmldb_multi_read_applyfn, &mr) < 0)
+        if (xmldb_multi_read(h, db, x0, format, yspec, xerr) < 0)
             goto done;
     }
     /* Always assert a top-level called "config".
@@ -727,14 +823,28 @@ xmldb_readfile(clixon_handle    h,
             }
         } /* if msdiff */
         /* xml looks like: <top><config><x>... actually YB_MODULE_NEXT
+         * Binary datastore is already bound and sorted unless yspec differs
          */
-        if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec1?yspec1:yspec, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-        if (xml_sort_recurse(x0) < 0)
-            goto done;
+        if (!bound || yspec1){
+            if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec1?yspec1:yspec, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            if (xml_sort_recurse(x0) < 0)
+                goto done;
+        }
     }
+    /* Replay edits appended to journal since last checkpoint, see CLICON_XMLDB_JOURNAL */
+    if ((ret = xmldb_journal_replay(h, db, yb, yspec1?yspec1:yspec, x0, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (de && xml_child_nr(x0) != 0)
+        de->de_empty = 0;
+    if (clicon_option_bool(h, "CLICON_XMLDB_DESCENDANT_INDEX") &&
+        !clicon_option_bool(h, "CLICON_XMLDB_MULTI_LAZY") &&
+        xml_descendant_index_create(x0) < 0)
+        goto done;
     if (xp){
         *xp = x0;
         x0 = NULL;
@@ -746,8 +856,7 @@ xmldb_readfile(clixon_handle    h,
     }
     retval = 1;
  done:
-    if (mr.mr_subdir)
-        free(mr.mr_subdir);
+    xml_lazy_suspend(0);
     if (xmodfile)
         xml_free(xmodfile);
     if (msdiff)
@@ -958,6 +1067,78 @@ xmldb_get_copy(clixon_handle     h,
     goto done;
 }
 
+/*! Get a read-only view of datastore cache using xpath, without copying
+ *
+ * Return the cache tree and the nodes matching xpath. The view is the same tree as
+ * returned by xmldb_get0 with report-all, and is printed with clixon_xml2cbuf_view.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Name of datastore, eg "running"
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath syntax. or NULL for all
+ * @param[out] xtp    Top-level XML tree, direct cache pointer, or NULL if no view is possible
+ * @param[out] xvecp  Nodes in xtp matching xpath. Free with free()
+ * @param[out] xlenp  Length of xvecp
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1      Error
+ * @code
+ *   if ((ret = xmldb_get_view(h, "running", YB_MODULE, nsc, xpath, &xt, &xvec, &xlen, &xerr)) < 0)
+ *      err;
+ *   if (ret == 1 && xt != NULL)
+ *      clixon_xml2cbuf_view(cb, xt, "data", xvec, xlen, -1, WITHDEFAULTS_EXPLICIT, NULL, NULL, 1);
+ *   if (xvec)
+ *      free(xvec);
+ * @endcode
+ * @note Do not modify or free xtp
+ * @note No view if datastore content is changed on output, eg system-only-config or
+ *       NACM disabled on empty, use xmldb_get0
+ * @see xmldb_get0
+ */
+int
+xmldb_get_view(clixon_handle h,
+               const char   *db,
+               yang_bind     yb,
+               cvec         *nsc,
+               const char   *xpath,
+               cxobj       **xtp,
+               cxobj      ***xvecp,
+               size_t       *xlenp,
+               cxobj       **xerr)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    int    ret;
+
+    clixon_debug(CLIXON_DBG_DATASTORE, "db %s", db);
+    *xtp = NULL;
+    *xvecp = NULL;
+    *xlenp = 0;
+    if (clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG") &&
+        (strcmp(db, "candidate") != 0 ||
+         (xmldb_modified_get(h, db) == 0 &&
+          xmldb_islocked(h, db) == 0)))
+        goto ok;
+    if ((ret = xmldb_get_cache(h, db, yb, &xt, NULL, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY") &&
+        nacm_is_empty(xt, clicon_dbspec_yang(h)))
+        goto ok;
+    if (xpath_vec(xt, nsc, "%s", xvecp, xlenp, xpath?xpath:"/") < 0)
+        goto done;
+    *xtp = xt;
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Get content of datastore and return a copy of the XML tree
  *
  * @param[in]  h      Clixon handle
@@ -1046,18 +1227,23 @@ xmldb_get0(clixon_handle    h,
            modstate_diff_t *msdiff,
            cxobj          **xerr)
 {
-    int    retval = -1;
-    int    ret;
-    cxobj *x = NULL;
+    int      retval = -1;
+    int      ret;
+    cxobj   *x = NULL;
+    uint64_t lazyerr = xml_lazy_errors();
 
-    if (wdef != WITHDEFAULTS_EXPLICIT)
-        return xmldb_get_copy(h, db, yb, nsc, xpath, xret, msdiff, xerr);
     if ((ret = xmldb_get_copy(h, db, yb, nsc, xpath, &x, msdiff, xerr)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
-    if (xml_default_nopresence(x, 2, 0) < 0)
+    if (wdef == WITHDEFAULTS_EXPLICIT &&
+        xml_default_nopresence(x, 2, 0) < 0)
         goto done;
+    /* Result is incomplete if a split node could not be loaded */
+    if (xml_lazy_errors() != lazyerr){
+        clixon_err(OE_DB, 0, "%s: loading of split file failed", db);
+        goto done;
+    }
     *xret = x;
     x = NULL;
     retval = 1;
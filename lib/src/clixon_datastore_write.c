@@ -87,6 +87,10 @@
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_journal.h"
+#include "clixon_datastore_binary.h"
+#include "clixon_datastore_multi.h"
+#include "clixon_datastore_lazy.h"
 
 /* Local types */
 /* Argument to apply for recursive call to xmldb_multi write calls
@@ -98,6 +102,8 @@ struct xmldb_multi_write_arg {
     int               mw_pretty;
     withdefaults_type mw_wdef;
     enum format_enum  mw_format;
+    xmldb_multi_file *mw_vec;   /* Split files to write */
+    int               mw_len;   /* Length of mw_vec */
 };
 
 /*! Given an attribute name and its expected namespace, find its value
@@ -294,7 +300,8 @@ check_when_condition(cxobj     *x0p,
                      cbuf      *cbret)
 {
     int        retval = -1;
-    char      *xpath = NULL;
+    yang_stmt *ywhen;
+    xpath_compiled *xpc = NULL;
     cvec      *nsc = NULL;
     int        nr;
     yang_stmt *y = NULL;
@@ -302,19 +309,20 @@ check_when_condition(cxobj     *x0p,
     cxobj     *x1p;
     cvec      *cnsc = NULL;
     cvec      *nnsc = NULL;
-    char      *cxpath = NULL;
+    xpath_compiled *cxpc = NULL;
 
     if ((y = y0) != NULL ||
         (y = (yang_stmt*)xml_spec(x1)) != NULL){
         x1p = xml_parent(x1);
-        if (yang_when_xpath_get(y, &xpath, &nsc) < 0)
-            goto done;
-        if (xpath == NULL)
+        /* XPath and namespace contexts are compiled once and cached in the when statement */
+        if ((ywhen = yang_when_get(NULL, y)) == NULL)
             goto ok;
+        if (yang_xpath_compiled_get(ywhen, 0, &xpc, &nsc) < 0)
+            goto done;
         /* 1. Try yang context for existing xml
          * Sufficient for all clixon/controller tests.
          * Required for test_augment */
-        if ((nr = xpath_vec_bool(x0p, nsc, "%s", xpath)) < 0)
+        if ((nr = xpath_vec_bool_compiled(x0p, nsc, xpc)) < 0)
             goto done;
         if (nr != 0)
             goto ok;
@@ -322,32 +330,34 @@ check_when_condition(cxobj     *x0p,
         if (xml_nsctx_node(x1p, &nnsc) < 0)
             goto done;
 #if 0
-        if ((nr = xpath_vec_bool(x1p, nsc, "%s", xpath)) < 0)
+        if ((nr = xpath_vec_bool_compiled(x1p, nsc, xpc)) < 0)
             goto done;
         if (nr != 0)
             goto ok;
         /* 3. Try xml context for incoming xml */
-        if ((nr = xpath_vec_bool(x1p, nnsc, "%s", xpath)) < 0) /* Try request */
+        if ((nr = xpath_vec_bool_compiled(x1p, nnsc, xpc)) < 0) /* Try request */
             goto done;
         if (nr != 0)
             goto ok;
 #endif
         /* 4. Try xml context for existing xml */
-        if ((nr = xpath_vec_bool(x0p, nnsc, "%s", xpath)) < 0) /* Try request */
+        if ((nr = xpath_vec_bool_compiled(x0p, nnsc, xpc)) < 0) /* Try request */
             goto done;
         if (nr != 0)
             goto ok;
         /* 5. Try yang canonical context for incoming xml */
-        if (yang_when_canonical_xpath_get(y, &cxpath, &cnsc) < 0)
+        if (yang_xpath_compiled_get(ywhen, 1, &cxpc, &cnsc) < 0)
             goto done;
 #if 0
-        if ((nr = xpath_vec_bool(x1p, cnsc, "%s", cxpath)) < 0)
+        if (cxpc &&
+            (nr = xpath_vec_bool_compiled(x1p, cnsc, cxpc)) < 0)
             goto done;
         if (nr != 0)
             goto ok;
 #endif
         /* 6. Try yang canonical context for existing xml */
-        if ((nr = xpath_vec_bool(x0p, cnsc, "%s", cxpath)) < 0)
+        if (cxpc &&
+            (nr = xpath_vec_bool_compiled(x0p, cnsc, cxpc)) < 0)
             goto done;
         if (nr != 0)
             goto ok;
@@ -357,7 +367,7 @@ check_when_condition(cxobj     *x0p,
         }
         cprintf(cberr, "Node '%s' tagged with 'when' condition '%s' in module '%s' evaluates to false in edit-config operation (see RFC 7950 Sec 8.3.2)",
                 yang_argument_get(y),
-                xpath,
+                xpath_compiled_str(xpc),
                 yang_argument_get(ys_module(y)));
         if (netconf_unknown_element(cbret, "application", yang_argument_get(y),
                                     cbuf_get(cberr)) < 0)
@@ -367,12 +377,6 @@ check_when_condition(cxobj     *x0p,
  ok:
     retval = 1;
  done:
-    if (cxpath)
-        free(cxpath);
-    if (cnsc)
-        cvec_free(cnsc);
-    if (nsc)
-        cvec_free(nsc);
     if (cberr)
         cbuf_free(cberr);
     if (nnsc)
@@ -1359,6 +1363,31 @@ xml_mark_cache_dirty(cxobj *x,
     return 2;
 }
 
+/*! Mark edited xml for incremental diff on commit, see xml_diff_edited
+ *
+ * Added subtrees are marked completely, changed nodes individually.
+ * Created default nodes are marked by xml_default
+ * @param[in]  x    XML node
+ * @param[in]  arg  Not used
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     0    OK, continue
+ * @retval    -1    Error
+ */
+static int
+xml_mark_edited(cxobj *x,
+                void  *arg)
+{
+    if (xml_flag(x, XML_FLAG_ADD)){
+        if (xml_apply0(x, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_EDITED) < 0)
+            return -1;
+        return 2;
+    }
+    if (xml_flag(x, XML_FLAG_CHANGE|XML_FLAG_DEL) == 0)
+        return 2;
+    xml_flag_set(x, XML_FLAG_EDITED);
+    return 0;
+}
+
 /*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
@@ -1403,6 +1432,10 @@ xmldb_put(clixon_handle       h,
     cvec       *nsc = NULL; /* nacm namespace context */
     int         firsttime = 0;
     cxobj      *xerr = NULL;
+    int         journal = 0;
+    cbuf       *cbj = NULL; /* journal record */
+    int         suspended = 0;
+    uint64_t    lazyerr = xml_lazy_errors();
 
     clixon_debug(CLIXON_DBG_DATASTORE|CLIXON_DBG_DETAIL, "db %s", db);
     if (cbret == NULL){
@@ -1418,6 +1451,9 @@ xmldb_put(clixon_handle       h,
                    xml_name(x1), NETCONF_INPUT_CONFIG);
         goto done;
     }
+    /* Cache may be shared with other datastore after xmldb_copy */
+    if (xmldb_cache_unshare(h, db) < 0)
+        goto done;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
         x0 = de->de_xml; /* XXX flag is not XML_FLAG_TOP */
     }
@@ -1435,6 +1471,15 @@ xmldb_put(clixon_handle       h,
         /* Add default recursive values */
         if (xml_default_recurse(x0, 0, 0) < 0)
             goto done;
+        /* Lazy split nodes are loaded from the datastore owning the tree */
+        if (xmldb_lazy_active(h)){
+            if (de != NULL)
+                de0 = *de;
+            de0.de_xml = x0;
+            clicon_db_elmnt_set(h, db, &de0);
+            de = clicon_db_elmnt_get(h, db);
+            firsttime = 0;
+        }
     }
     if (strcmp(xml_name(x0), DATASTORE_TOP_SYMBOL) !=0 ||
         xml_flag(x0, XML_FLAG_TOP) == 0){
@@ -1447,6 +1492,13 @@ xmldb_put(clixon_handle       h,
     permit = (xnacm==NULL);
     /* Here assume if xnacm is set and !permit do NACM */
     clicon_data_del(h, "objectexisted");
+    /* Record edit before x1 is modified, appended to journal below if successful */
+    if ((de == NULL || de->de_volatile == 0) &&
+        xmldb_journal_active(h, db)){
+        journal++;
+        if (xmldb_journal_record(x1, op, &cbj) < 0)
+            goto done;
+    }
     /*
      * Modify base tree x with modification x1. This is where the
      * new tree is made.
@@ -1462,6 +1514,9 @@ xmldb_put(clixon_handle       h,
         }
         goto fail;
     }
+    /* Split nodes not reached by the edit are not loaded by the traversals below */
+    xml_lazy_suspend(1);
+    suspended++;
     /* Remove NONE nodes if all subs recursively are also NONE */
     if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
         goto done;
@@ -1476,9 +1531,14 @@ xmldb_put(clixon_handle       h,
     if (xml_default_nopresence(x0, 3, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
         goto done;
     /* Complete defaults
+     * Global defaults may be merged into split nodes, which are then loaded
      */
+    xml_lazy_suspend(0);
+    suspended = 0;
     if (xml_global_defaults(h, x0, nsc, "/", yspec, 0) < 0)
         goto done;
+    xml_lazy_suspend(1);
+    suspended++;
     /* Add default recursive values */
     if (xml_default_recurse(x0, 0, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
         goto done;
@@ -1488,6 +1548,19 @@ xmldb_put(clixon_handle       h,
     if (xml_default_recurse(x0, 0, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
         goto done;
 #endif
+    /* Edit is incomplete if a split node it accessed could not be loaded */
+    if (xml_lazy_errors() != lazyerr){
+        clixon_err(OE_DB, 0, "%s: loading of split file failed", db);
+        goto done;
+    }
+    /* Mark edited xml for incremental commit diff. Editing running makes the marks of
+     * other datastores invalid */
+    if (strcmp(db, "running") == 0){
+        if (xmldb_edited_invalidate(h, db) < 0)
+            goto done;
+    }
+    else if (xml_apply(x0, CX_ELMNT, xml_mark_edited, NULL) < 0)
+        goto done;
     /* Write back to datastore cache if first time */
     if (de != NULL)
         de0 = *de;
@@ -1495,9 +1568,13 @@ xmldb_put(clixon_handle       h,
         de0.de_xml = x0;
     de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
     clicon_db_elmnt_set(h, db, &de0);
-    /* Write cache to file unless volatile (ie stop syncing to store) */
+    /* Write cache to file (or append edit to journal) unless volatile (ie stop syncing to store) */
     if (xmldb_volatile_get(h, db) == 0){
-        if (xmldb_write_cache2file(h, db) < 0)
+        if (journal){
+            if (xmldb_journal_append(h, db, cbj) < 0)
+                goto done;
+        }
+        else if (xmldb_write_cache2file(h, db) < 0)
             goto done;
         /* Clear flags from previous steps + dirty */
         if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
@@ -1513,6 +1590,10 @@ xmldb_put(clixon_handle       h,
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (suspended)
+        xml_lazy_suspend(0);
+    if (cbj)
+        cbuf_free(cbj);
     if (xerr)
         xml_free(xerr);
     if (nsc)
@@ -1523,9 +1604,61 @@ xmldb_put(clixon_handle       h,
     goto done;
 }
 
+/*! Apply an edit from the datastore journal on a datastore tree
+ *
+ * Same as the modification part of xmldb_put but without NACM and without datastore cache
+ * and file handling.
+ * @param[in]  h      Clixon handle
+ * @param[in]  x0     Datastore tree
+ * @param[in]  x1     Edit tree. Top-level symbol is <config>
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  op     Top-level operation
+ * @param[out] cbret  Initialized cligen buffer. On exit contains XML if retval == 0
+ * @retval     1      OK
+ * @retval     0      Failed, cbret contains error xml message
+ * @retval    -1      Error
+ * @see xmldb_put
+ * @see xmldb_journal_replay
+ */
+int
+xmldb_put_replay(clixon_handle       h,
+                 cxobj              *x0,
+                 cxobj              *x1,
+                 yang_stmt          *yspec,
+                 enum operation_type op,
+                 cbuf               *cbret)
+{
+    int retval = -1;
+    int ret;
+
+    clicon_data_del(h, "objectexisted");
+    if ((ret = text_modify_top(h, x0, x1, yspec, op, NULL, NULL, 1, cbret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
+        goto done;
+    if (xml_apply(x0, CX_ELMNT, xml_mark_added_ancestors, (void*)(XML_FLAG_ADD|XML_FLAG_DEL)) < 0)
+        goto done;
+    if (xml_default_nopresence(x0, 3, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
+        goto done;
+    if (xml_default_recurse(x0, 0, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
+        goto done;
+    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                  (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE)) < 0)
+        goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Callback function for xmldb-multi write
  *
- * Look for link attribute in XML, and if found open the linked file for parsing
+ * Look for split nodes in XML, and if found serialize the node to be written to
+ * its split file
  * @param[in]  x    XML node
  * @param[in]  arg
  * @retval     2    Locally abort this subtree, continue with others
@@ -1548,8 +1681,9 @@ xmldb_multi_write_applyfn(cxobj *x,
     char         *subdir = NULL;
     char         *dbfile;
     struct stat   st = {0,};
-    int           fd = -1;
     FILE         *fsub = NULL;
+    char         *buf = NULL;
+    size_t        buflen = 0;
 
     if (xml_child_nr_type(x, CX_ELMNT) > 0 &&
         (y = xml_spec(x)) != NULL){
@@ -1570,18 +1704,24 @@ xmldb_multi_write_applyfn(cxobj *x,
             dbfile = cbuf_get(cb);
             if (xml_flag(x, XML_FLAG_CACHE_DIRTY) ||
                 lstat(dbfile, &st) < 0){
-                clixon_debug(CLIXON_DBG_DATASTORE, "Open: %s for writing", dbfile);
-                if ((fd = open(dbfile, O_CREAT|O_WRONLY|O_TRUNC, S_IRWXU)) < 0) {
-                    clixon_err(OE_UNIX, errno, "open(%s)", dbfile);
-                    goto done;
-                }
-                if ((fsub = fdopen(fd, "w")) == NULL){
-                    clixon_err(OE_CFG, errno, "fdopen(%s)", dbfile);
+                clixon_debug(CLIXON_DBG_DATASTORE, "Serialize: %s", dbfile);
+                /* Serialize to memory, the file is written by xmldb_multi_io */
+                if ((fsub = open_memstream(&buf, &buflen)) == NULL){
+                    clixon_err(OE_UNIX, errno, "open_memstream(%s)", dbfile);
                     goto done;
                 }
                 /* Dont recurse multi-file yet */
                 if (clixon_xml2file1(fsub, x, 0, mw->mw_pretty, NULL, fprintf, 1, 0, mw->mw_wdef, 0, 0) < 0)
                     goto done;
+                if (fclose(fsub) != 0){
+                    fsub = NULL;
+                    clixon_err(OE_UNIX, errno, "fclose(%s)", dbfile);
+                    goto done;
+                }
+                fsub = NULL;
+                if (xmldb_multi_add(&mw->mw_vec, &mw->mw_len, dbfile, x, buf, buflen) < 0)
+                    goto done;
+                buf = NULL;
             }
             retval = 2; /* Locally abort */
             goto done;
@@ -1591,6 +1731,8 @@ xmldb_multi_write_applyfn(cxobj *x,
  done:
     if (fsub != NULL)
         fclose(fsub);
+    if (buf)
+        free(buf);
     if (cb)
         cbuf_free(cb);
     if (subdir)
@@ -1629,7 +1771,12 @@ xmldb_dump(clixon_handle     h,
     struct xmldb_multi_write_arg mw = {0,};
     cxobj                       *xm;
     cxobj                       *xmodst = NULL;
+    int                          system_only;
+    int                          ret;
 
+    system_only = clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG");
+    /* Write lazy split nodes as links, their split files are unchanged */
+    xml_lazy_suspend(1);
     /* Add modstate */
     if ((xm = clicon_modst_cache_get(h, 1)) != NULL){
         if ((xmodst = xml_dup(xm)) == NULL)
@@ -1647,8 +1794,7 @@ xmldb_dump(clixon_handle     h,
     }
     switch (format){
     case FORMAT_XML:
-        if (clixon_xml2file1(f, xt, 0, pretty, NULL, fprintf, 0, 0, wdef, multi,
-                             clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")) < 0)
+        if (clixon_xml2file1(f, xt, 0, pretty, NULL, fprintf, 0, 0, wdef, multi, system_only) < 0)
             goto done;
         if (multi){
             mw.mw_h = h;
@@ -1658,6 +1804,9 @@ xmldb_dump(clixon_handle     h,
             mw.mw_format = format;
             if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xmldb_multi_write_applyfn, &mw) < 0)
                 goto done;
+            /* Write split files concurrently */
+            if (xmldb_multi_io(h, mw.mw_vec, mw.mw_len, 1, NULL, NULL) < 0)
+                goto done;
         }
         break;
     case FORMAT_JSON:
@@ -1665,8 +1814,19 @@ xmldb_dump(clixon_handle     h,
             clixon_err(OE_CFG, errno, "JSON+multi not supported");
             goto done;
         }
-        if (clixon_json2file(f, xt, pretty, fprintf, 0, 0,
-                             clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")) < 0)
+        if (clixon_json2file(f, xt, pretty, fprintf, 0, 0, system_only) < 0)
+            goto done;
+        break;
+    case FORMAT_BINARY:
+        if (multi){
+            clixon_err(OE_CFG, errno, "binary+multi not supported");
+            goto done;
+        }
+        if ((ret = xmldb_binary_write(h, f, xt, system_only)) < 0)
+            goto done;
+        /* Tree cannot be represented in binary, eg mounted yangs, save as XML */
+        if (ret == 0 &&
+            clixon_xml2file1(f, xt, 0, pretty, NULL, fprintf, 0, 0, wdef, 0, system_only) < 0)
             goto done;
         break;
     default:
@@ -1679,6 +1839,9 @@ xmldb_dump(clixon_handle     h,
         goto done;
     retval = 0;
  done:
+    xml_lazy_suspend(0);
+    if (mw.mw_vec)
+        xmldb_multi_free(mw.mw_vec, mw.mw_len);
     return retval;
 }
 
@@ -1703,6 +1866,8 @@ xmldb_write_cache2file(clixon_handle h,
     int               multi;
     FILE             *f = NULL;
     char             *dbfile = NULL;
+    cbuf             *cbtmp = NULL;
+    char             *tmpfile = NULL;
     int               ret;
 
     if ((xt = xmldb_cache_get(h, db)) == NULL){
@@ -1720,14 +1885,41 @@ xmldb_write_cache2file(clixon_handle h,
     }
     if (xmldb_db2file(h, db, &dbfile) < 0)
         goto done;
-    if ((f = fopen(dbfile, "w")) == NULL){
-        clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
+    /* With journal, replace datastore file atomically so that a crash leaves either
+     * old file + journal, or new file */
+    if (xmldb_journal_active(h, db)){
+        if ((cbtmp = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cbtmp, "%s.tmp", dbfile);
+        tmpfile = cbuf_get(cbtmp);
+    }
+    if ((f = fopen(tmpfile?tmpfile:dbfile, "w")) == NULL){
+        clixon_err(OE_CFG, errno, "fopen(%s)", tmpfile?tmpfile:dbfile);
         goto done;
     }
     if (xmldb_dump(h, f, xt, format, pretty, wdef, multi, db) < 0)
         goto done;
+    if (tmpfile){
+        if (fflush(f) != 0 || fsync(fileno(f)) < 0){
+            clixon_err(OE_UNIX, errno, "fsync(%s)", tmpfile);
+            goto done;
+        }
+        fclose(f);
+        f = NULL;
+        if (rename(tmpfile, dbfile) < 0){
+            clixon_err(OE_UNIX, errno, "rename(%s)", tmpfile);
+            goto done;
+        }
+    }
+    /* Datastore file is now complete, edits in journal (if any) are obsolete */
+    if (xmldb_journal_reset(h, db) < 0)
+        goto done;
     retval = 0;
  done:
+    if (cbtmp)
+        cbuf_free(cbtmp);
     if (dbfile)
         free(dbfile);
     if (f)
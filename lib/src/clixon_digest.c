@@ -37,6 +37,7 @@
 #endif
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 #include <string.h>
 #include <openssl/sha.h>
@@ -110,3 +111,24 @@ clixon_digest_hex(const char *str,
         free(md);
     return retval;
 }
+
+/*! Compute binary SHA-256 digest of a buffer
+ *
+ * @param[in]  buf  Buffer
+ * @param[in]  len  Length of buffer
+ * @param[out] md   Digest, CLIXON_DIGEST_LEN bytes
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_digest
+ */
+int
+clixon_digest_sha256(const void *buf,
+                     size_t      len,
+                     uint8_t    *md)
+{
+    if (SHA256((const unsigned char *)buf, len, md) == NULL){
+        clixon_err(OE_UNIX, 0, "SHA256 error");
+        return -1;
+    }
+    return 0;
+}
@@ -391,3 +391,69 @@ clicon_file_cbuf(const char *filename,
         errno = err;
     return retval;
 }
+
+/*! Read the rest of an open file into a buffer using large reads
+ *
+ * The size of a regular file is used to allocate the buffer once. The buffer is
+ * terminated by two null characters, as required by flex yy_scan_buffer to scan the
+ * buffer in place without copying it.
+ * @param[in]   fp    Open file
+ * @param[out]  bufp  Buffer with file content, malloced, free with free()
+ * @param[out]  lenp  Length of file content, not including the null characters
+ * @retval      0     OK
+ * @retval     -1     Error
+ * @see clixon_xml_parse_file
+ */
+int
+clicon_file_read(FILE   *fp,
+                 char  **bufp,
+                 size_t *lenp)
+{
+    int         retval = -1;
+    char       *buf = NULL;
+    size_t      bufsize = CLICON_FILE_READ_BLOCK;
+    size_t      len = 0;
+    size_t      n;
+    char       *b;
+    struct stat st;
+    off_t       pos;
+
+    /* Regular file: room for content, one more byte to detect EOF, and two nulls */
+    if (fstat(fileno(fp), &st) == 0 &&
+        S_ISREG(st.st_mode) &&
+        (pos = ftello(fp)) >= 0 &&
+        st.st_size > pos)
+        bufsize = st.st_size - pos + 3;
+    if ((buf = malloc(bufsize)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    while (1){
+        if (bufsize - len < 3){
+            bufsize *= 2;
+            if ((b = realloc(buf, bufsize)) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            buf = b;
+        }
+        if ((n = fread(buf+len, 1, bufsize-len-2, fp)) == 0){
+            if (ferror(fp)){
+                clixon_err(OE_UNIX, errno, "fread");
+                goto done;
+            }
+            break;
+        }
+        len += n;
+    }
+    buf[len] = '\0';
+    buf[len+1] = '\0';
+    *bufp = buf;
+    buf = NULL;
+    *lenp = len;
+    retval = 0;
+ done:
+    if (buf)
+        free(buf);
+    return retval;
+}
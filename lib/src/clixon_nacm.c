@@ -820,25 +820,22 @@ nacm_data_read_action(cxobj *xrule,
     return retval;
 }
 
-/*! Match specific rule to specific requested node
+/*! Match specific rule to specific requested node, without taking action
  *
  * @param[in]  xn       XML node (requested node)
  * @param[in]  xrule    NACM rule
+ * @param[in]  xpathvec Nodes matching the rule path
  * @param[in]  yspec    YANG spec
  * @retval     1        OK and rule matches
  * @retval     0        OK and rule does not match
  * @retval    -1        Error
- * Two distinct cases:
- * (1) read_default is permit
- *     mark all deny rules and remove them
- * (2) read_default is deny:
- *     mark all permit rules and ancestors, remove everything else
+ * @see nacm_data_read_xrule_xml
  */
 static int
-nacm_data_read_xrule_xml(cxobj        *xn,
-                         cxobj        *xrule,
-                         clixon_xvec  *xpathvec,
-                         yang_stmt    *yspec)
+nacm_data_read_xrule_match(cxobj        *xn,
+                           cxobj        *xrule,
+                           clixon_xvec  *xpathvec,
+                           yang_stmt    *yspec)
 {
     int        retval = -1;
     yang_stmt *ymod;
@@ -860,19 +857,13 @@ nacm_data_read_xrule_xml(cxobj        *xn,
     /*  6b) Either (1) the rule does not have a "rule-type" defined or
         (2) the "rule-type" is "data-node" and the "path" matches the
         requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (nacm_data_read_action(xrule, xn) < 0)
-            goto done;
+    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL)
         goto match;
-    }
     for (i=0; i<clixon_xvec_len(xpathvec); i++){
         xp = clixon_xvec_i(xpathvec, i);
         /* Check if ancestor is xp (for every xpathvec?) */
-        if (xn == xp || xml_isancestor(xn, xp)){
-            if (nacm_data_read_action(xrule, xn) < 0)
-                goto done;
+        if (xn == xp || xml_isancestor(xn, xp))
             goto match;
-        }
     }
  nomatch:
     retval = 0;
@@ -883,6 +874,37 @@ nacm_data_read_xrule_xml(cxobj        *xn,
     goto done;
 }
 
+/*! Match specific rule to specific requested node
+ *
+ * @param[in]  xn       XML node (requested node)
+ * @param[in]  xrule    NACM rule
+ * @param[in]  xpathvec Nodes matching the rule path
+ * @param[in]  yspec    YANG spec
+ * @retval     1        OK and rule matches
+ * @retval     0        OK and rule does not match
+ * @retval    -1        Error
+ * Two distinct cases:
+ * (1) read_default is permit
+ *     mark all deny rules and remove them
+ * (2) read_default is deny:
+ *     mark all permit rules and ancestors, remove everything else
+ */
+static int
+nacm_data_read_xrule_xml(cxobj        *xn,
+                         cxobj        *xrule,
+                         clixon_xvec  *xpathvec,
+                         yang_stmt    *yspec)
+{
+    int ret;
+
+    if ((ret = nacm_data_read_xrule_match(xn, xrule, xpathvec, yspec)) < 0)
+        return -1;
+    if (ret == 1 &&
+        nacm_data_read_action(xrule, xn) < 0)
+        return -1;
+    return ret;
+}
+
 /*! Recursive check for NACM read rules among all XML nodes
  *
  * @param[in]  h        Clixon handle
@@ -1088,6 +1110,142 @@ nacm_datanode_read(clixon_handle h,
     return retval;
 }
 
+/* Prepared NACM read rules for a read-only view, see nacm_datanode_read_view */
+struct nacm_view{
+    prepvec   *nv_pv_list;
+    yang_stmt *nv_yspec;
+};
+
+/*! Prepare NACM read access validation on the fly, on a tree that is not modified
+ *
+ * Same rules as nacm_datanode_read, but instead of purging nodes, each node is checked
+ * with nacm_datanode_read_view_fn when printed, see clixon_xml2cbuf_view
+ * @param[in]  h        Clixon handle
+ * @param[in]  xt       XML root tree with "config" label, eg datastore cache
+ * @param[in]  username User name of requestor, not NULL
+ * @param[in]  xnacm    NACM xml tree
+ * @param[out] nvp      NACM view, free with nacm_view_free
+ * @param[out] permit   1: read-default is permit, 0: read-default is deny
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @code
+ *   if (nacm_datanode_read_view(h, xt, username, xnacm, &nv, &permit) < 0)
+ *      err;
+ *   if (clixon_xml2cbuf_view(cb, xt, "data", xvec, xlen, -1, wdef,
+ *                            nacm_datanode_read_view_fn, nv, permit) < 0)
+ *      err;
+ *   nacm_view_free(nv);
+ * @endcode
+ * @see nacm_datanode_read
+ */
+int
+nacm_datanode_read_view(clixon_handle h,
+                        cxobj        *xt,
+                        char         *username,
+                        cxobj        *xnacm,
+                        nacm_view   **nvp,
+                        int          *permit)
+{
+    int        retval = -1;
+    cxobj    **gvec = NULL; /* groups */
+    size_t     glen;
+    cxobj    **rlistvec = NULL; /* rule-list */
+    size_t     rlistlen;
+    char      *read_default;
+    cvec      *nsc = NULL;
+    nacm_view *nv = NULL;
+
+    if (username == NULL){
+        clixon_err(OE_XML, EINVAL, "username is NULL");
+        goto done;
+    }
+    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
+        goto done;
+    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+        goto done;
+    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
+        goto done;
+    if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
+        clixon_err(OE_XML, EINVAL, "No nacm read-default rule");
+        goto done;
+    }
+    if ((nv = malloc(sizeof(*nv))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(nv, 0, sizeof(*nv));
+    nv->nv_yspec = clicon_dbspec_yang(h);
+    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc,
+                              &nv->nv_pv_list) < 0)
+        goto done;
+    *permit = strcmp(read_default, "deny") != 0;
+    *nvp = nv;
+    nv = NULL;
+    retval = 0;
+ done:
+    if (nv)
+        nacm_view_free(nv);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (gvec)
+        free(gvec);
+    if (rlistvec)
+        free(rlistvec);
+    return retval;
+}
+
+/*! NACM read access of a single node in a view, first matching rule decides
+ *
+ * @param[in]  x     XML node with yang spec
+ * @param[in]  arg   NACM view, see nacm_datanode_read_view
+ * @retval     2     No matching rule
+ * @retval     1     Permit
+ * @retval     0     Deny
+ * @retval    -1     Error
+ * @see xml_view_fn_t
+ */
+int
+nacm_datanode_read_view_fn(cxobj *x,
+                           void  *arg)
+{
+    nacm_view *nv = (nacm_view *)arg;
+    prepvec   *pv;
+    char      *action;
+    int        ret;
+
+    if ((pv = nv->nv_pv_list) == NULL)
+        return 2;
+    do {
+        if ((ret = nacm_data_read_xrule_match(x, pv->pv_xrule, pv->pv_xpathvec,
+                                              nv->nv_yspec)) < 0)
+            return -1;
+        if (ret == 1){ /* stop at first match */
+            if ((action = xml_find_body(pv->pv_xrule, "action")) != NULL){
+                if (strcmp(action, "deny") == 0)
+                    return 0;
+                if (strcmp(action, "permit") == 0)
+                    return 1;
+            }
+            return 2;
+        }
+        pv = NEXTQ(prepvec *, pv);
+    } while (pv && pv != nv->nv_pv_list);
+    return 2;
+}
+
+/*! Free NACM view
+ *
+ * @param[in]  nv   NACM view, see nacm_datanode_read_view
+ */
+int
+nacm_view_free(nacm_view *nv)
+{
+    if (nv->nv_pv_list)
+        prepvec_free(nv->nv_pv_list);
+    free(nv);
+    return 0;
+}
+
 /*---------------------------------------------------------------
  * NACM pre-procesing
  */
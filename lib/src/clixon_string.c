@@ -42,6 +42,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <errno.h>
 #include <ctype.h>
 
@@ -1198,6 +1199,212 @@ clixon_str_subst(char *str,
     return retval;
 }
 
+/* Interned string, the string follows the header
+ * @see clixon_string_intern
+ */
+struct intern_str{
+    struct intern_str *is_next;   /* Next in hash bucket */
+    uint32_t           is_hash;   /* Hash of string */
+    uint32_t           is_refcnt; /* Number of references */
+    char               is_str[];  /* Null-terminated string */
+};
+
+/* Initial number of buckets of string intern table */
+#define INTERN_SIZE_START 1024
+
+/* String intern table (too low-level to hang it on handle) */
+static struct intern_str **_intern_vec = NULL;
+static size_t              _intern_size = 0; /* Number of buckets, power of 2 */
+static size_t              _intern_nr = 0;   /* Number of interned strings */
+
+/*! Hash and length of string (FNV-1a)
+ */
+static uint32_t
+intern_hash(const char *str,
+            size_t     *lenp)
+{
+    const char *p;
+    uint32_t    h = 2166136261U;
+
+    for (p = str; *p; p++){
+        h ^= (uint8_t)*p;
+        h *= 16777619U;
+    }
+    *lenp = p - str;
+    return h;
+}
+
+/*! Resize string intern table
+ *
+ * @param[in]  size  New number of buckets, power of 2
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+intern_resize(size_t size)
+{
+    struct intern_str **vec;
+    struct intern_str  *is;
+    size_t              i;
+
+    if ((vec = calloc(size, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    for (i = 0; i < _intern_size; i++)
+        while ((is = _intern_vec[i]) != NULL){
+            _intern_vec[i] = is->is_next;
+            is->is_next = vec[is->is_hash & (size-1)];
+            vec[is->is_hash & (size-1)] = is;
+        }
+    if (_intern_vec)
+        free(_intern_vec);
+    _intern_vec = vec;
+    _intern_size = size;
+    return 0;
+}
+
+/*! Get shared reference-counted copy of a string
+ *
+ * Equal strings return the same pointer, so that two interned strings are equal if and
+ * only if the pointers are equal.
+ * @param[in]  str  Null-terminated string
+ * @retval     istr Interned string, release with clixon_string_unintern, do not modify
+ * @retval     NULL Error
+ * @code
+ *   if ((name = clixon_string_intern("interface")) == NULL)
+ *     err;
+ *   ...
+ *   clixon_string_unintern(name);
+ * @endcode
+ * @see xml_name_set  XML element names and prefixes are interned
+ */
+char *
+clixon_string_intern(const char *str)
+{
+    struct intern_str *is;
+    uint32_t           h;
+    size_t             len;
+
+    if (str == NULL){
+        clixon_err(OE_UNIX, EINVAL, "str is NULL");
+        return NULL;
+    }
+    h = intern_hash(str, &len);
+    if (_intern_size){
+        for (is = _intern_vec[h & (_intern_size-1)]; is; is = is->is_next)
+            if (is->is_hash == h && strcmp(is->is_str, str) == 0){
+                is->is_refcnt++;
+                return is->is_str;
+            }
+    }
+    if (_intern_nr >= _intern_size &&
+        intern_resize(_intern_size?2*_intern_size:INTERN_SIZE_START) < 0)
+        return NULL;
+    if ((is = malloc(sizeof(*is) + len + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    is->is_hash = h;
+    is->is_refcnt = 1;
+    memcpy(is->is_str, str, len + 1);
+    is->is_next = _intern_vec[h & (_intern_size-1)];
+    _intern_vec[h & (_intern_size-1)] = is;
+    _intern_nr++;
+    return is->is_str;
+}
+
+/*! Get interned copy of a string if it exists, without adding a reference
+ *
+ * Use for lookups: since all XML names are interned, a name that is not interned
+ * cannot match any XML node, and a match can be made by pointer comparison only.
+ * @param[in]  str  Null-terminated string
+ * @retval     istr Interned string, do not unintern or modify
+ * @retval     NULL Not interned
+ * @see clixon_string_intern
+ */
+char *
+clixon_string_interned(const char *str)
+{
+    struct intern_str *is;
+    uint32_t           h;
+    size_t             len;
+
+    if (str == NULL || _intern_size == 0)
+        return NULL;
+    h = intern_hash(str, &len);
+    for (is = _intern_vec[h & (_intern_size-1)]; is; is = is->is_next)
+        if (is->is_hash == h && strcmp(is->is_str, str) == 0)
+            return is->is_str;
+    return NULL;
+}
+
+/*! Get a single reference's share of the memory of an interned string
+ *
+ * The size of the string is divided by its number of references, so that summing the
+ * shares over all references gives the memory of the string.
+ * @param[in]  istr Interned string returned by clixon_string_intern
+ * @retval     sz   Size in bytes
+ */
+size_t
+clixon_string_intern_size(const char *istr)
+{
+    struct intern_str *is;
+
+    if (istr == NULL)
+        return 0;
+    is = (struct intern_str *)(istr - offsetof(struct intern_str, is_str));
+    return (sizeof(*is) + strlen(istr) + 1) / is->is_refcnt;
+}
+
+/*! Release reference of an interned string, free it if last reference
+ *
+ * @param[in]  istr Interned string returned by clixon_string_intern
+ */
+void
+clixon_string_unintern(char *istr)
+{
+    struct intern_str  *is;
+    struct intern_str **isp;
+
+    if (istr == NULL)
+        return;
+    is = (struct intern_str *)(istr - offsetof(struct intern_str, is_str));
+    if (--is->is_refcnt > 0)
+        return;
+    for (isp = &_intern_vec[is->is_hash & (_intern_size-1)]; *isp; isp = &(*isp)->is_next)
+        if (*isp == is){
+            *isp = is->is_next;
+            break;
+        }
+    free(is);
+    _intern_nr--;
+}
+
+/*! Get statistics of interned strings
+ *
+ * @param[out] nr   Number of interned strings
+ * @param[out] sz   Size in bytes of interned strings and table
+ * @retval     0    OK
+ */
+int
+clixon_string_intern_stats(uint64_t *nr,
+                           size_t   *sz)
+{
+    struct intern_str *is;
+    size_t             i;
+
+    if (nr)
+        *nr = _intern_nr;
+    if (sz){
+        *sz = _intern_size * sizeof(*_intern_vec);
+        for (i = 0; i < _intern_size; i++)
+            for (is = _intern_vec[i]; is; is = is->is_next)
+                *sz += sizeof(*is) + strlen(is->is_str) + 1;
+    }
+    return 0;
+}
+
 /*! strndup() for systems without it, such as xBSD
  */
 #ifndef HAVE_STRNDUP
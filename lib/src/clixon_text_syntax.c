@@ -47,6 +47,7 @@
 #include <limits.h>
 #include <stdint.h>
 #include <syslog.h>
+#include <dirent.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -69,9 +70,7 @@
 #include "clixon_xml_bind.h"
 #include "clixon_text_syntax.h"
 #include "clixon_text_syntax_parse.h"
-
-/* Size of json read buffer when reading from file*/
-#define BUFLEN 1024
+#include "clixon_file.h"
 
 /* Name of xml top object created by parse functions
  * See also DATASTORE_TOP_SYMBOL which is the clixon datastore top symbol. By default also config
@@ -985,6 +984,7 @@ text_populate_list(cxobj *xn)
 /*! Parse a string containing text syntax and return an XML tree
  *
  * @param[in]  str    Input string containing JSON
+ * @param[in]  len    If > 0, str is a buffer of len followed by two nulls, parsed in place
  * @param[in]  rfc7951 Do sanity checks according to RFC 7951 JSON Encoding of Data Modeled with YANG
  * @param[in]  yb     How to bind yang to XML top-level when parsing (if rfc7951)
  * @param[in]  yspec  Yang specification (if rfc 7951)
@@ -998,6 +998,7 @@ text_populate_list(cxobj *xn)
  */
 static int
 _text_syntax_parse(char      *str,
+                   size_t     len,
                    yang_bind  yb,
                    yang_stmt *yspec,
                    cxobj     *xt,
@@ -1020,6 +1021,7 @@ _text_syntax_parse(char      *str,
         return -1;
     }
     ts.ts_parse_string = str;
+    ts.ts_parse_len = len;
     ts.ts_linenum = 1;
     ts.ts_xtop = xt;
     ts.ts_yspec = yspec;
@@ -1116,7 +1118,7 @@ clixon_text_syntax_parse_string(char      *str,
         if ((*xt = xml_new("top", NULL, CX_ELMNT)) == NULL)
             return -1;
     }
-    return _text_syntax_parse(str, yb, yspec, *xt, xerr);
+    return _text_syntax_parse(str, 0, yb, yspec, *xt, xerr);
 }
 
 /*! Read a TEXT syntax definition from file and parse it into a parse-tree. 
@@ -1144,6 +1146,7 @@ clixon_text_syntax_parse_string(char      *str,
  * @note  you need to free the xml parse tree after use, using xml_free()
  * @note, If xt empty, a top-level symbol will be added so that <tree../> will be:  <top><tree.../></tree></top>
  * @note May block on file I/O
+ * @note The file is read in large blocks and parsed in place, see clicon_file_read
  * @note Parsing requires YANG, which means yb must be YB_MODULE/_NEXT
  *
  * @see clixon_text_syntax_parse_string
@@ -1158,51 +1161,22 @@ clixon_text_syntax_parse_file(FILE      *fp,
     int       retval = -1;
     int       ret;
     char     *textbuf = NULL;
-    int       textbuflen = BUFLEN; /* start size */
-    int       oldtextbuflen;
-    char     *ptr;
-    char      ch;
-    int       len = 0;
+    size_t    len = 0;
 
     if (xt == NULL){
         clixon_err(OE_XML, EINVAL, "xt is NULL");
         return -1;
     }
-    if ((textbuf = malloc(textbuflen)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    if (clicon_file_read(fp, &textbuf, &len) < 0)
         goto done;
-    }
-    memset(textbuf, 0, textbuflen);
-    ptr = textbuf;
-    while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret != 0)
-            textbuf[len++] = ch;
-        if (ret == 0){
-            if (*xt == NULL)
-                if ((*xt = xml_new(TEXT_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if (len){
-                if ((ret = _text_syntax_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-                    goto done;
-                if (ret == 0)
-                    goto fail;
-            }
-            break;
-        }
-        if (len >= textbuflen-1){ /* Space: one for the null character */
-            oldtextbuflen = textbuflen;
-            textbuflen *= 2;
-            if ((textbuf = realloc(textbuf, textbuflen)) == NULL){
-                clixon_err(OE_XML, errno, "realloc");
-                goto done;
-            }
-            memset(textbuf+oldtextbuflen, 0, textbuflen-oldtextbuflen);
-            ptr = textbuf;
-        }
+    if (*xt == NULL)
+        if ((*xt = xml_new(TEXT_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if (len){
+        if ((ret = _text_syntax_parse(textbuf, len, yb, yspec, *xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
     }
     retval = 1;
  done:
@@ -43,6 +43,8 @@
  */
 struct clixon_text_syntax_parse_yacc {
     char      *ts_parse_string; /* original (copy of) parse string */
+    size_t     ts_parse_len;    /* If set, parse string is a buffer of this length
+                                   followed by two nulls and scanned in place */
     int        ts_linenum;      /* Number of \n in parsed buffer */
     void      *ts_lexbuf;       /* internal parse buffer from lex */
     cxobj     *ts_xtop;         /* Vector of created top-level nodes (to know which are created) */
@@ -79,9 +79,628 @@
 #include "clixon_xml_default.h"
 #include "clixon_xml_map.h"
 #include "clixon_xml_bind.h"
+#include "clixon_xml_sort.h"
 #include "clixon_validate_minmax.h"
 #include "clixon_validate.h"
 
+/* Initial size of leafref hash tables, power of 2 */
+#define LEAFREF_HASH_SIZE_START 16
+
+/*! Set of string values, eg bodies of leafref targets
+ *
+ * Open addressing hash table with linear probing. The strings are not copied, they
+ * are bodies of XML nodes that are not modified during a validation pass
+ */
+struct leafref_valset {
+    const char **lv_vec;  /* Hash table, NULL is empty slot */
+    size_t       lv_size; /* Size of hash table, power of 2 */
+    size_t       lv_len;  /* Number of values */
+};
+typedef struct leafref_valset leafref_valset;
+
+/*! Target values of a leafref path from one anchor node
+ *
+ * The anchor is the root for absolute paths, and the ancestor reached by the leading
+ * "../" steps for relative paths. All leafrefs with same path and anchor have the
+ * same targets.
+ */
+struct leafref_targets {
+    struct leafref_targets *lt_next;   /* Next in hash bucket */
+    yang_stmt              *lt_ypath;  /* Leafref path statement */
+    yang_stmt              *lt_ys;     /* Yang of leafref, defines namespace context */
+    cxobj                  *lt_anchor; /* Anchor XML node */
+    leafref_valset          lt_values; /* Bodies of target nodes */
+};
+typedef struct leafref_targets leafref_targets;
+
+/*! Leafref state of one validation pass, see xml_yang_validate_all_top
+ */
+struct leafref_pass {
+    leafref_targets **lp_vec;       /* Hash table of leafref targets */
+    size_t            lp_size;      /* Number of buckets, power of 2 */
+    size_t            lp_len;       /* Number of leafref targets */
+    int               lp_diff;      /* Only check added or changed leafrefs, and leafrefs
+                                     * whose value is in lp_deleted */
+    leafref_valset    lp_deleted;   /* Values of deleted or changed leafs in source */
+};
+typedef struct leafref_pass leafref_pass;
+
+/* Leafref state of ongoing validation pass, NULL if none */
+static leafref_pass *_leafref_pass = NULL;
+
+/*! Dependency state of an incremental validation pass, see xml_yang_validate_all_diff
+ *
+ * Nodes of the target tree that are not added or changed are only validated if they
+ * have a must/when or leafref constraint that may be affected by the diff, or if a
+ * child was deleted.
+ */
+struct validate_diff {
+    leafref_valset  vd_changed; /* Names of added, deleted and changed nodes, and ancestors */
+    leafref_valset  vd_deleted; /* Names of deleted and changed nodes in source */
+    yang_stmt     **vd_ymark;   /* Schema nodes with YANG_FLAG_DEPS or _DEPS_DESC set */
+    int             vd_ylen;    /* Length of vd_ymark */
+    cxobj         **vd_xdel;    /* Sorted target parents of deleted nodes, and ancestors */
+    int             vd_xlen;    /* Length of vd_xdel */
+};
+typedef struct validate_diff validate_diff;
+
+/* Dependency state of ongoing incremental validation pass, NULL if none */
+static validate_diff *_validate_diff = NULL;
+
+/*! Hash of string (FNV-1a)
+ */
+static uint32_t
+leafref_hash_str(const char *str)
+{
+    uint32_t h = 2166136261U;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*! Hash of leafref path, yang and anchor node pointers
+ */
+static uint32_t
+leafref_hash_ptr(yang_stmt *ypath,
+                 yang_stmt *ys,
+                 cxobj     *anchor)
+{
+    uint64_t h;
+
+    h = (uint64_t)(uintptr_t)ypath ^ ((uint64_t)(uintptr_t)ys << 7) ^
+        ((uint64_t)(uintptr_t)anchor << 17);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (uint32_t)h;
+}
+
+/*! Add value to value set, if not already present
+ *
+ * @param[in]  lv    Value set
+ * @param[in]  val   String value, not copied
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+leafref_valset_add(leafref_valset *lv,
+                   const char     *val)
+{
+    const char **vec0;
+    size_t       size0;
+    size_t       i;
+    size_t       j;
+
+    if (4*(lv->lv_len + 1) > 3*lv->lv_size){
+        vec0 = lv->lv_vec;
+        size0 = lv->lv_size;
+        lv->lv_size = size0 ? 2*size0 : LEAFREF_HASH_SIZE_START;
+        if ((lv->lv_vec = calloc(lv->lv_size, sizeof(char *))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            lv->lv_vec = vec0;
+            lv->lv_size = size0;
+            return -1;
+        }
+        for (i=0; i<size0; i++){
+            if (vec0[i] == NULL)
+                continue;
+            j = leafref_hash_str(vec0[i]) & (lv->lv_size - 1);
+            while (lv->lv_vec[j] != NULL)
+                j = (j + 1) & (lv->lv_size - 1);
+            lv->lv_vec[j] = vec0[i];
+        }
+        if (vec0)
+            free(vec0);
+    }
+    i = leafref_hash_str(val) & (lv->lv_size - 1);
+    while (lv->lv_vec[i] != NULL){
+        if (strcmp(lv->lv_vec[i], val) == 0)
+            return 0;
+        i = (i + 1) & (lv->lv_size - 1);
+    }
+    lv->lv_vec[i] = val;
+    lv->lv_len++;
+    return 0;
+}
+
+/*! Check if value is in value set
+ *
+ * @param[in]  lv    Value set
+ * @param[in]  val   String value
+ * @retval     1     Found
+ * @retval     0     Not found
+ */
+static int
+leafref_valset_find(leafref_valset *lv,
+                    const char     *val)
+{
+    size_t i;
+
+    if (lv->lv_len == 0)
+        return 0;
+    i = leafref_hash_str(val) & (lv->lv_size - 1);
+    while (lv->lv_vec[i] != NULL){
+        if (strcmp(lv->lv_vec[i], val) == 0)
+            return 1;
+        i = (i + 1) & (lv->lv_size - 1);
+    }
+    return 0;
+}
+
+/*! Add bodies of leafs in an XML subtree to a value set
+ *
+ * @param[in]  lv    Value set
+ * @param[in]  x     XML subtree
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+leafref_valset_add_tree(leafref_valset *lv,
+                        cxobj          *x)
+{
+    char  *body;
+    cxobj *xc;
+
+    if ((body = xml_body(x)) != NULL &&
+        leafref_valset_add(lv, body) < 0)
+        return -1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+        if (leafref_valset_add_tree(lv, xc) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Start leafref state of a validation pass, unless one is ongoing
+ *
+ * @retval     lp    New leafref state, to be freed by caller with leafref_pass_end
+ * @retval     NULL  A pass is ongoing (or error)
+ */
+static leafref_pass *
+leafref_pass_begin(void)
+{
+    leafref_pass *lp;
+
+    if (_leafref_pass != NULL)
+        return NULL;
+    if ((lp = malloc(sizeof(*lp))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(lp, 0, sizeof(*lp));
+    _leafref_pass = lp;
+    return lp;
+}
+
+/*! End leafref state of a validation pass and free it
+ *
+ * @param[in]  lp    Leafref state, as returned by leafref_pass_begin, may be NULL
+ */
+static void
+leafref_pass_end(leafref_pass *lp)
+{
+    leafref_targets *lt;
+    size_t           i;
+
+    if (lp == NULL)
+        return;
+    for (i=0; i<lp->lp_size; i++)
+        while ((lt = lp->lp_vec[i]) != NULL){
+            lp->lp_vec[i] = lt->lt_next;
+            if (lt->lt_values.lv_vec)
+                free(lt->lt_values.lv_vec);
+            free(lt);
+        }
+    if (lp->lp_vec)
+        free(lp->lp_vec);
+    if (lp->lp_deleted.lv_vec)
+        free(lp->lp_deleted.lv_vec);
+    free(lp);
+    if (_leafref_pass == lp)
+        _leafref_pass = NULL;
+}
+
+/*! Add names of nodes of an XML subtree to a name set, optionally also of ancestors
+ *
+ * @param[in]  lv        Name set
+ * @param[in]  x         XML subtree
+ * @param[in]  ancestors Also add names of ancestors, since their string values change
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+validate_diff_names(leafref_valset *lv,
+                    cxobj          *x,
+                    int             ancestors)
+{
+    cxobj *xc;
+    cxobj *xp;
+
+    if (leafref_valset_add(lv, xml_name(x)) < 0)
+        return -1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+        if (validate_diff_names(lv, xc, 0) < 0)
+            return -1;
+    if (ancestors)
+        for (xp = xml_parent(x); xp && xml_parent(xp); xp = xml_parent(xp))
+            if (leafref_valset_add(lv, xml_name(xp)) < 0)
+                return -1;
+    return 0;
+}
+
+/*! Mark schema nodes with affected constraints, and their ancestors
+ *
+ * @param[in]  vd    Dependency state
+ * @param[in]  vec   Schema nodes with must/when or leafref, see yang_deps_get
+ * @param[in]  len   Length of vec
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_diff_mark(validate_diff *vd,
+                   yang_stmt    **vec,
+                   int            len)
+{
+    yang_stmt  *ys;
+    yang_stmt **ymark;
+    uint16_t    flag;
+    int         i;
+
+    for (i=0; i<len; i++){
+        flag = YANG_FLAG_DEPS;
+        for (ys = vec[i];
+             ys && yang_keyword_get(ys) != Y_SPEC;
+             ys = yang_parent_get(ys), flag = YANG_FLAG_DEPS_DESC){
+            if (yang_flag_get(ys, flag))
+                break;
+            if ((ymark = realloc(vd->vd_ymark, (vd->vd_ylen+1)*sizeof(yang_stmt *))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                return -1;
+            }
+            vd->vd_ymark = ymark;
+            vd->vd_ymark[vd->vd_ylen++] = ys;
+            yang_flag_set(ys, flag);
+        }
+    }
+    return 0;
+}
+
+/*! Mark schema nodes whose constraints read any of a set of names
+ *
+ * @param[in]  vd    Dependency state
+ * @param[in]  yspec YANG spec
+ * @param[in]  kind  YANG_DEPS_CHANGE or YANG_DEPS_DELETE
+ * @param[in]  lv    Name set
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_diff_mark_names(validate_diff  *vd,
+                         yang_stmt      *yspec,
+                         int             kind,
+                         leafref_valset *lv)
+{
+    yang_stmt **vec;
+    int         len;
+    size_t      i;
+
+    if (lv->lv_len == 0)
+        return 0;
+    yang_deps_get(yspec, kind, "*", &vec, &len);
+    if (validate_diff_mark(vd, vec, len) < 0)
+        return -1;
+    for (i=0; i<lv->lv_size; i++){
+        if (lv->lv_vec[i] == NULL)
+            continue;
+        yang_deps_get(yspec, kind, lv->lv_vec[i], &vec, &len);
+        if (validate_diff_mark(vd, vec, len) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Get node of target tree corresponding to node of source tree
+ *
+ * @param[in]  xt    Target tree root
+ * @param[in]  xs    Source tree node
+ * @param[out] xtp   Target tree node, or NULL if not found
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_diff_target(cxobj  *xt,
+                     cxobj  *xs,
+                     cxobj **xtp)
+{
+    cxobj *xp;
+
+    *xtp = NULL;
+    if (xml_parent(xs) == NULL){
+        *xtp = xt;
+        return 0;
+    }
+    if (validate_diff_target(xt, xml_parent(xs), &xp) < 0)
+        return -1;
+    if (xp == NULL)
+        return 0;
+    return match_base_child(xp, xs, xml_spec(xs), xtp);
+}
+
+/*! Compare pointers, for qsort and bsearch
+ */
+static int
+validate_diff_xcmp(const void *a,
+                   const void *b)
+{
+    uintptr_t pa = (uintptr_t)*(cxobj **)a;
+    uintptr_t pb = (uintptr_t)*(cxobj **)b;
+
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+/*! Check if target node is added or changed, or a child was deleted
+ *
+ * @param[in]  vd    Dependency state
+ * @param[in]  xt    Target tree node
+ * @retval     1     Changed
+ * @retval     0     Not changed
+ */
+static int
+validate_diff_changed(validate_diff *vd,
+                      cxobj         *xt)
+{
+    if (xml_flag(xt, XML_FLAG_ADD|XML_FLAG_CHANGE))
+        return 1;
+    return vd->vd_xlen &&
+        bsearch(&xt, vd->vd_xdel, vd->vd_xlen, sizeof(cxobj *), validate_diff_xcmp) != NULL;
+}
+
+/*! End dependency state of incremental validation pass, reset schema marks and free
+ *
+ * @param[in]  vd    Dependency state, may be NULL
+ */
+static void
+validate_diff_end(validate_diff *vd)
+{
+    int i;
+
+    if (vd == NULL)
+        return;
+    for (i=0; i<vd->vd_ylen; i++)
+        yang_flag_reset(vd->vd_ymark[i], YANG_FLAG_DEPS|YANG_FLAG_DEPS_DESC);
+    if (vd->vd_ymark)
+        free(vd->vd_ymark);
+    if (vd->vd_xdel)
+        free(vd->vd_xdel);
+    if (vd->vd_changed.lv_vec)
+        free(vd->vd_changed.lv_vec);
+    if (vd->vd_deleted.lv_vec)
+        free(vd->vd_deleted.lv_vec);
+    free(vd);
+    if (_validate_diff == vd)
+        _validate_diff = NULL;
+}
+
+/*! Start dependency state of incremental validation pass
+ *
+ * Mark schema nodes whose must/when or leafref constraints read nodes with the same
+ * names as the added, deleted and changed nodes, using the reverse dependencies computed
+ * when YANG was loaded. Also find the target parents of deleted nodes.
+ * @param[in]  yspec  YANG spec
+ * @param[in]  xt     XML target tree
+ * @param[in]  dvec   Nodes removed from source tree
+ * @param[in]  dlen   Length of dvec
+ * @param[in]  avec   Nodes added to target tree
+ * @param[in]  alen   Length of avec
+ * @param[in]  scvec  Changed nodes of source tree
+ * @param[in]  tcvec  Changed nodes of target tree
+ * @param[in]  clen   Length of scvec and tcvec
+ * @retval     vd     Dependency state, free with validate_diff_end
+ * @retval     NULL   Error
+ * @see yang_deps_get
+ */
+static validate_diff *
+validate_diff_begin(yang_stmt *yspec,
+                    cxobj     *xt,
+                    cxobj    **dvec,
+                    int        dlen,
+                    cxobj    **avec,
+                    int        alen,
+                    cxobj    **scvec,
+                    cxobj    **tcvec,
+                    int        clen)
+{
+    validate_diff *vd;
+    cxobj         *xp;
+    cxobj        **xdel;
+    int            i;
+
+    if ((vd = malloc(sizeof(*vd))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(vd, 0, sizeof(*vd));
+    for (i=0; i<alen; i++)
+        if (validate_diff_names(&vd->vd_changed, avec[i], 1) < 0)
+            goto err;
+    for (i=0; i<clen; i++){
+        if (validate_diff_names(&vd->vd_changed, tcvec[i], 1) < 0)
+            goto err;
+        if (validate_diff_names(&vd->vd_deleted, scvec[i], 0) < 0)
+            goto err;
+    }
+    for (i=0; i<dlen; i++){
+        if (validate_diff_names(&vd->vd_changed, dvec[i], 1) < 0)
+            goto err;
+        if (validate_diff_names(&vd->vd_deleted, dvec[i], 0) < 0)
+            goto err;
+        if (validate_diff_target(xt, xml_parent(dvec[i]), &xp) < 0)
+            goto err;
+        for (; xp != NULL; xp = xml_parent(xp)){
+            if ((xdel = realloc(vd->vd_xdel, (vd->vd_xlen+1)*sizeof(cxobj *))) == NULL){
+                clixon_err(OE_UNIX, errno, "realloc");
+                goto err;
+            }
+            vd->vd_xdel = xdel;
+            vd->vd_xdel[vd->vd_xlen++] = xp;
+        }
+    }
+    if (vd->vd_xlen)
+        qsort(vd->vd_xdel, vd->vd_xlen, sizeof(cxobj *), validate_diff_xcmp);
+    if (validate_diff_mark_names(vd, yspec, YANG_DEPS_CHANGE, &vd->vd_changed) < 0)
+        goto err;
+    if (validate_diff_mark_names(vd, yspec, YANG_DEPS_DELETE, &vd->vd_deleted) < 0)
+        goto err;
+    return vd;
+ err:
+    validate_diff_end(vd);
+    return NULL;
+}
+
+/*! Get anchor node of a leafref path, if its targets can be shared
+ *
+ * The path may not contain predicates or function calls, eg current() or deref(),
+ * and ".." may only be used in the leading steps.
+ * @param[in]  xt       XML leafref node
+ * @param[in]  path_arg Leafref path
+ * @retval     anchor   Root for absolute path, or ancestor for relative path
+ * @retval     NULL     Targets depend on the leafref node
+ */
+static cxobj *
+leafref_anchor(cxobj      *xt,
+               const char *path_arg)
+{
+    const char *p = path_arg;
+    cxobj      *x = xt;
+
+    if (strpbrk(path_arg, "[(") != NULL)
+        return NULL;
+    if (*p == '/'){
+        while (xml_parent(x) != NULL)
+            x = xml_parent(x);
+        return x;
+    }
+    while (strncmp(p, "../", 3) == 0){
+        if ((x = xml_parent(x)) == NULL)
+            return NULL;
+        p += 3;
+    }
+    if (strstr(p, "..") != NULL)
+        return NULL;
+    return x;
+}
+
+/*! Get target values of a leafref path from the leafref state, compute if not found
+ *
+ * @param[in]  lp       Leafref state
+ * @param[in]  xt       XML leafref node
+ * @param[in]  ys       Yang spec of leafref node
+ * @param[in]  ypath    Leafref path statement
+ * @param[in]  anchor   Anchor node, see leafref_anchor
+ * @param[out] ltp      Leafref targets
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+leafref_targets_get(leafref_pass     *lp,
+                    cxobj            *xt,
+                    yang_stmt        *ys,
+                    yang_stmt        *ypath,
+                    cxobj            *anchor,
+                    leafref_targets **ltp)
+{
+    int               retval = -1;
+    leafref_targets  *lt;
+    leafref_targets **vec;
+    cvec             *nsc = NULL;
+    cxobj           **xvec = NULL;
+    size_t            xlen = 0;
+    char             *body;
+    size_t            size;
+    size_t            i;
+    uint32_t          h;
+
+    h = leafref_hash_ptr(ypath, ys, anchor);
+    if (lp->lp_size){
+        for (lt = lp->lp_vec[h & (lp->lp_size-1)]; lt; lt = lt->lt_next)
+            if (lt->lt_ypath == ypath && lt->lt_ys == ys && lt->lt_anchor == anchor){
+                *ltp = lt;
+                goto ok;
+            }
+    }
+    if (lp->lp_len >= lp->lp_size){
+        size = lp->lp_size ? 2*lp->lp_size : LEAFREF_HASH_SIZE_START;
+        if ((vec = calloc(size, sizeof(*vec))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        for (i=0; i<lp->lp_size; i++)
+            while ((lt = lp->lp_vec[i]) != NULL){
+                lp->lp_vec[i] = lt->lt_next;
+                lt->lt_next = vec[leafref_hash_ptr(lt->lt_ypath, lt->lt_ys, lt->lt_anchor) & (size-1)];
+                vec[leafref_hash_ptr(lt->lt_ypath, lt->lt_ys, lt->lt_anchor) & (size-1)] = lt;
+            }
+        if (lp->lp_vec)
+            free(lp->lp_vec);
+        lp->lp_vec = vec;
+        lp->lp_size = size;
+    }
+    if ((lt = malloc(sizeof(*lt))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(lt, 0, sizeof(*lt));
+    lt->lt_ypath = ypath;
+    lt->lt_ys = ys;
+    lt->lt_anchor = anchor;
+    lt->lt_next = lp->lp_vec[h & (lp->lp_size-1)];
+    lp->lp_vec[h & (lp->lp_size-1)] = lt;
+    lp->lp_len++;
+    if (xml_nsctx_yang(ys, &nsc) < 0)
+        goto done;
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, yang_argument_get(ypath)) < 0)
+        goto done;
+    for (i = 0; i < xlen; i++) {
+        if ((body = xml_body(xvec[i])) == NULL)
+            continue;
+        if (leafref_valset_add(&lt->lt_values, body) < 0)
+            goto done;
+    }
+    *ltp = lt;
+ ok:
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (xvec)
+        free(xvec);
+    return retval;
+}
+
 /*! Validate xml node of type leafref, ensure the value is one of that path's reference
  *
  * @param[in]  xt    XML leaf node of type leafref
@@ -121,20 +740,23 @@ validate_leafref(cxobj     *xt,
                  yang_stmt *ytype,
                  cxobj    **xret)
 {
-    int          retval = -1;
-    yang_stmt   *ypath;
-    yang_stmt   *yreqi;
-    cxobj      **xvec = NULL;
-    cxobj       *x;
-    int          i;
-    size_t       xlen = 0;
-    char        *leafrefbody;
-    char        *leafbody;
-    cvec        *nsc = NULL;
-    cbuf        *cberr = NULL;
-    char        *path_arg;
-    cg_var      *cv;
-    int          require_instance = 1;
+    int              retval = -1;
+    yang_stmt       *ypath;
+    yang_stmt       *yreqi;
+    cxobj          **xvec = NULL;
+    cxobj           *x;
+    int              i;
+    size_t           xlen = 0;
+    char            *leafrefbody;
+    char            *leafbody;
+    cvec            *nsc = NULL;
+    cbuf            *cberr = NULL;
+    char            *path_arg;
+    cg_var          *cv;
+    int              require_instance = 1;
+    cxobj           *anchor;
+    leafref_targets *lt = NULL;
+    int              found;
 
     /* require instance */
     if ((yreqi = yang_find(ytype, Y_REQUIRE_INSTANCE, NULL)) != NULL){
@@ -162,18 +784,34 @@ validate_leafref(cxobj     *xt,
     }
     if ((leafrefbody = xml_body(xt)) == NULL)
         goto ok;
-    if (xml_nsctx_yang(ys, &nsc) < 0)
-        goto done;
-    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path_arg) < 0)
-        goto done;
-    for (i = 0; i < xlen; i++) {
-        x = xvec[i];
-        if ((leafbody = xml_body(x)) == NULL)
-            continue;
-        if (strcmp(leafbody, leafrefbody) == 0)
-            break;
+    /* Within a validation pass, targets of paths without predicates are computed once
+     * per anchor node and looked up by value */
+    if (_leafref_pass != NULL &&
+        (anchor = leafref_anchor(xt, path_arg)) != NULL){
+        /* Unchanged leafref of a valid source is valid unless a target was removed */
+        if (_leafref_pass->lp_diff &&
+            xml_flag(xt, XML_FLAG_ADD|XML_FLAG_CHANGE) == 0 &&
+            !leafref_valset_find(&_leafref_pass->lp_deleted, leafrefbody))
+            goto ok;
+        if (leafref_targets_get(_leafref_pass, xt, ys, ypath, anchor, &lt) < 0)
+            goto done;
+        found = leafref_valset_find(&lt->lt_values, leafrefbody);
     }
-    if (i==xlen){
+    else {
+        if (xml_nsctx_yang(ys, &nsc) < 0)
+            goto done;
+        if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path_arg) < 0)
+            goto done;
+        for (i = 0; i < xlen; i++) {
+            x = xvec[i];
+            if ((leafbody = xml_body(x)) == NULL)
+                continue;
+            if (strcmp(leafbody, leafrefbody) == 0)
+                break;
+        }
+        found = (i < xlen);
+    }
+    if (!found){
         if ((cberr = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
             goto done;
@@ -220,7 +858,7 @@ validate_leafref(cxobj     *xt,
  * @retval     1     Validation OK
  * @retval     0     Validation failed
  * @retval    -1     Error
- * @see ys_populate_identity where the derived types are set
+ * @see yang_identity_index where the base bitsets are set
  * @see yang_augment_node
  * @see RFC7950 Sec 9.10.2:
  * @see xp_function_derived_from  similar code other context
@@ -233,20 +871,15 @@ validate_identityref(cxobj     *xt,
 {
     int         retval = -1;
     char       *node = NULL;
-    char       *idref = NULL;
     yang_stmt  *ybaseref; /* This is the type's base reference */
     yang_stmt  *ybaseid;
+    yang_stmt  *yid;
     char       *prefix = NULL;
     char       *id = NULL;
     cbuf       *cberr = NULL;
-    cbuf       *cb = NULL;
-    cvec       *idrefvec; /* Derived identityref list: (module:id)**/
     yang_stmt  *ymod;
+    int         ret = 0;
 
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
     if ((cberr = cbuf_new()) == NULL){
         clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
@@ -291,14 +924,11 @@ validate_identityref(cxobj     *xt,
             goto done;
         goto fail;
     }
-    cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
-    idref = cbuf_get(cb);
-    /* Here check if node is in the derived node list of the base identity
-     * The derived node list is a cvec computed XXX
-     */
-    idrefvec = yang_cvec_get(ybaseid);
-    if (cvec_find(idrefvec, idref) == NULL){
-
+    /* Here check if the identity of node is derived from the base identity */
+    if ((yid = yang_find(ymod, Y_IDENTITY, id)) != NULL &&
+        (ret = yang_identity_derived(yid, ybaseid)) < 0)
+        goto done;
+    if (ret == 0){
         cprintf(cberr, "Identityref validation failed, %s not derived from %s in %s.yang",
                 node,
                 yang_argument_get(ybaseid),
@@ -314,8 +944,6 @@ validate_identityref(cxobj     *xt,
  done:
     if (cberr)
         cbuf_free(cberr);
-    if (cb)
-        cbuf_free(cb);
     if (id)
         free(id);
     if (prefix)
@@ -1218,6 +1846,8 @@ xml_yang_validate_leaf_union(clixon_handle h,
 /*! Validate a single XML node with yang specification for all (not only added) entries
  *
  * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
+ * In an incremental validation pass, nodes that are not added or changed are skipped,
+ * unless a must/when or leafref constraint in the subtree may be affected by the diff.
  * @param[in]  xt  XML node to be validated
  * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
  * @retval     1     Validation OK
@@ -1253,10 +1883,12 @@ xml_yang_validate_all(clixon_handle h,
     char      *ns = NULL;
     cbuf      *cb = NULL;
     cvec      *nsc = NULL;
+    xpath_compiled *xpc = NULL;
     int        hit = 0;
     validate_level vl = VL_NONE;
     int        saw_node = 0;
     int        inext;
+    int        unchanged = 0; /* Incremental: only affected constraints are checked */
 
     if (clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT")){
         if ((ret = xml_yang_mount_get(h, xt, &vl, NULL, NULL)) < 0)
@@ -1289,7 +1921,13 @@ xml_yang_validate_all(clixon_handle h,
             goto done;
         goto fail;
     }
-    if (yang_config(yt) != 0){
+    if (_validate_diff != NULL && !validate_diff_changed(_validate_diff, xt)){
+        if (yang_flag_get(yt, YANG_FLAG_DEPS|YANG_FLAG_DEPS_DESC) == 0)
+            goto ok;
+        unchanged = 1;
+    }
+    if (yang_config(yt) != 0 &&
+        (!unchanged || yang_flag_get(yt, YANG_FLAG_DEPS))){
         ret = yang_check_when_xpath(xt, xml_parent(xt), yt, &hit, &nr, &xpath1);
         clixon_debug(CLIXON_DBG_XPATH|CLIXON_DBG_DETAIL, "nr:%d xpath:%s return:%d", nr, xpath1, ret);
         if (ret < 0)
@@ -1309,10 +1947,12 @@ xml_yang_validate_all(clixon_handle h,
                 goto done;
             goto fail;
         }
-        if ((ret = check_mandatory(xt, yt, xret)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
+        if (!unchanged){
+            if ((ret = check_mandatory(xt, yt, xret)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
         /* Node-specific validation */
         switch (yang_keyword_get(yt)){
         case Y_ANYXML:
@@ -1365,11 +2005,12 @@ xml_yang_validate_all(clixon_handle h,
             /* the context node is the node in the accessible tree for
              * which the "must" statement is defined. 
              * The set of namespace declarations is the set of all "import" statements' 
+             * Both are compiled once and cached in the must statement
              */
-            if (xml_nsctx_yang(yc, &nsc) < 0)
+            if (yang_xpath_compiled_get(yc, 0, &xpc, &nsc) < 0)
                 goto done;
             clixon_debug(CLIXON_DBG_XPATH, "namespace '%s'", xml_nsctx_get(nsc, NULL));
-            nr = xpath_vec_bool(xt, nsc, "%s", xpath);
+            nr = xpath_vec_bool_compiled(xt, nsc, xpc);
             clixon_debug(CLIXON_DBG_XPATH, "result %s", (nr < 0 ? "error" : (nr != 0 ? "true" : "false")));
             if (nr < 0)
                 goto done;
@@ -1386,10 +2027,6 @@ xml_yang_validate_all(clixon_handle h,
                     goto done;
                 goto fail;
             }
-            if (nsc){
-                xml_nsctx_free(nsc);
-                nsc = NULL;
-            }
         }
     }
     x = NULL;
@@ -1400,7 +2037,7 @@ xml_yang_validate_all(clixon_handle h,
             goto fail;
     }
     /* Check unique and min-max after choice test for example*/
-    if (yang_config(yt) != 0){
+    if (yang_config(yt) != 0 && !unchanged){
         /* Checks if next level contains any unique list constraints */
         if ((ret = xml_yang_validate_minmax(xt, 1, xret)) < 0)
             goto done;
@@ -1414,26 +2051,25 @@ xml_yang_validate_all(clixon_handle h,
         free(xpath1);
     if (cb)
         cbuf_free(cb);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
  fail:
     retval = 0;
     goto done;
 }
 
-/*! Validate a single XML node with yang specification
+/*! Validate all top-level XML nodes and their children
  *
- * @param[in]  h     Clixon handle
+ * @param[in]  h      Clixon handle
+ * @param[in]  xt     XML top node
  * @param[out] xret   Error XML tree (if ret == 0). Free with xml_free after use
  * @retval     1      Validation OK
  * @retval     0      Validation failed (xret set)
  * @retval    -1      Error
  */
-int
-xml_yang_validate_all_top(clixon_handle h,
-                          cxobj        *xt,
-                          cxobj       **xret)
+static int
+xml_yang_validate_all_top1(clixon_handle h,
+                           cxobj        *xt,
+                           cxobj       **xret)
 {
     int    ret;
     cxobj *x;
@@ -1448,6 +2084,107 @@ xml_yang_validate_all_top(clixon_handle h,
     return 1;
 }
 
+/*! Validate a single XML node with yang specification
+ *
+ * Leafref targets are computed once per leafref path in the validation pass
+ * @param[in]  h     Clixon handle
+ * @param[out] xret   Error XML tree (if ret == 0). Free with xml_free after use
+ * @retval     1      Validation OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ * @see xml_yang_validate_all_diff  Incremental leafref validation
+ */
+int
+xml_yang_validate_all_top(clixon_handle h,
+                          cxobj        *xt,
+                          cxobj       **xret)
+{
+    int           ret;
+    leafref_pass *lp;
+
+    if ((lp = leafref_pass_begin()) == NULL && _leafref_pass == NULL)
+        return -1;
+    ret = xml_yang_validate_all_top1(h, xt, xret);
+    leafref_pass_end(lp);
+    return ret;
+}
+
+/*! Validate XML tree with yang specification given diff from a valid source tree
+ *
+ * Same as xml_yang_validate_all_top except that only constraints that may be affected by
+ * the diff are checked, so that validation cost follows the size of the diff:
+ * - Added and changed nodes are validated as in xml_yang_validate_all.
+ * - Other nodes are only validated if a must/when or leafref constraint reads nodes with
+ *   the same name as an added, deleted or changed node, see yang_deps_get.
+ * - Mandatory and min/max-elements are checked for parents of deleted nodes
+ * - Leafrefs without predicates are only checked if added or changed, or if their value
+ *   is the value of a removed or changed leaf of the source.
+ * - Keys and unique constraints are only checked for lists with added or changed entries.
+ * With CLICON_YANG_SCHEMA_MOUNT, all nodes are traversed.
+ * @param[in]  h      Clixon handle
+ * @param[in]  xt     XML target tree, with XML_FLAG_ADD and XML_FLAG_CHANGE set from diff
+ * @param[in]  dvec   Nodes removed from source tree
+ * @param[in]  dlen   Length of dvec
+ * @param[in]  avec   Nodes added to target tree
+ * @param[in]  alen   Length of avec
+ * @param[in]  scvec  Changed nodes of source tree (original values)
+ * @param[in]  tcvec  Changed nodes of target tree (new values)
+ * @param[in]  clen   Length of scvec and tcvec
+ * @param[out] xret   Error XML tree (if ret == 0). Free with xml_free after use
+ * @retval     1      Validation OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ * @note The source tree must be valid, eg running
+ * @see xml_diff  Computes dvec, avec, scvec and tcvec
+ */
+int
+xml_yang_validate_all_diff(clixon_handle h,
+                           cxobj        *xt,
+                           cxobj       **dvec,
+                           int           dlen,
+                           cxobj       **avec,
+                           int           alen,
+                           cxobj       **scvec,
+                           cxobj       **tcvec,
+                           int           clen,
+                           cxobj       **xret)
+{
+    int            retval = -1;
+    leafref_pass  *lp;
+    validate_diff *vd = NULL;
+    int            i;
+    int            diff0;
+
+    diff0 = xml_yang_validate_minmax_diff(1);
+    if ((lp = leafref_pass_begin()) == NULL){
+        if (_leafref_pass == NULL)
+            goto done;
+        retval = xml_yang_validate_all_top1(h, xt, xret);
+        goto done;
+    }
+    lp->lp_diff = 1;
+    for (i=0; i<dlen; i++)
+        if (leafref_valset_add_tree(&lp->lp_deleted, dvec[i]) < 0)
+            goto done;
+    for (i=0; i<clen; i++)
+        if (leafref_valset_add_tree(&lp->lp_deleted, scvec[i]) < 0)
+            goto done;
+    if (!clicon_option_bool(h, "CLICON_YANG_SCHEMA_MOUNT") && _validate_diff == NULL){
+        if ((vd = validate_diff_begin(clicon_dbspec_yang(h), xt, dvec, dlen, avec, alen,
+                                      scvec, tcvec, clen)) == NULL)
+            goto done;
+        clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "changed names:%zu marked:%d",
+                     vd->vd_changed.lv_len, vd->vd_ylen);
+        _validate_diff = vd;
+    }
+    retval = xml_yang_validate_all_top1(h, xt, xret);
+ done:
+    validate_diff_end(vd);
+    xml_yang_validate_minmax_diff(diff0);
+    leafref_pass_end(lp);
+    return retval;
+}
+
 /*! Check validity of outgoing RPC
  *
  * Rewrite return message if errors
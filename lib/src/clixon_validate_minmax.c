@@ -95,29 +95,137 @@ struct vec_order {
     size_t        vo_slen;   /* Length of vo_strvec (is actually global to vector) */
 };
 
-/*! New element last in list, check if already exists if so return -1
+/*! Slot of tuple hash set
+ */
+struct tuple_slot {
+    char **tsl_tuple; /* Tuple of strings, NULL if empty slot */
+    int    tsl_i;     /* Index of tuple given by caller, eg list entry */
+};
+
+/*! Hash set of string tuples, eg list keys or values of unique statement
  *
- * @param[in]  vec   Vector of existing entries (new is last)
- * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Length of entry
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
- * @retval     1     Validation OK
- * @retval     0     Validation failed (cbret set)
+ * Open addressing with linear probing. The table is sized on init for the max number
+ * of tuples. Tuples and strings are not copied.
+ */
+struct tuple_set {
+    struct tuple_slot *ts_vec;  /* Hash table */
+    size_t             ts_size; /* Size of hash table, power of 2 */
+    size_t             ts_clen; /* Number of strings in a tuple */
+};
+
+/* Local variables */
+
+/* Only check unique constraints of lists whose parent is added or changed,
+ * see xml_yang_validate_minmax_diff */
+static int _minmax_diff = 0;
+
+/*! Init tuple hash set
+ *
+ * @param[in]  ts    Tuple set
+ * @param[in]  clen  Number of strings in a tuple
+ * @param[in]  n     Max number of tuples
+ * @retval     0     OK
  * @retval    -1     Error
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
  */
 static int
-unique_search_xpath(cxobj  *x,
-                    char   *xpath,
-                    cvec   *nsc,
-                    char ***svec,
-                    size_t *slen)
+tuple_set_init(struct tuple_set *ts,
+               size_t            clen,
+               size_t            n)
+{
+    size_t size = 16;
+
+    while (size < 2*n)
+        size *= 2;
+    if ((ts->ts_vec = calloc(size, sizeof(struct tuple_slot))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    ts->ts_size = size;
+    ts->ts_clen = clen;
+    return 0;
+}
+
+/*! Free tuple hash set (not the tuples)
+ */
+static void
+tuple_set_free(struct tuple_set *ts)
+{
+    if (ts->ts_vec)
+        free(ts->ts_vec);
+    ts->ts_vec = NULL;
+}
+
+/*! Find slot of tuple in tuple hash set
+ *
+ * @param[in]  ts    Tuple set
+ * @param[in]  tuple Tuple of strings, NULL strings allowed
+ * @retval     slot  Slot with equal tuple, or empty slot where the tuple is inserted
+ * @code
+ *   slot = tuple_set_lookup(&ts, tuple);
+ *   if (slot->tsl_tuple != NULL)
+ *      duplicate of entry slot->tsl_i;
+ *   else {
+ *      slot->tsl_tuple = tuple;
+ *      slot->tsl_i = i;
+ *   }
+ * @endcode
+ * @note Table must not be full, ensured by tuple_set_init
+ */
+static struct tuple_slot *
+tuple_set_lookup(struct tuple_set *ts,
+                 char            **tuple)
+{
+    struct tuple_slot *slot;
+    uint32_t           h = 2166136261U;
+    size_t             i;
+    size_t             v;
+    char              *p;
+
+    /* FNV-1a over all strings, separated */
+    for (v=0; v<ts->ts_clen; v++){
+        if ((p = tuple[v]) != NULL)
+            for (; *p; p++){
+                h ^= (uint8_t)*p;
+                h *= 16777619U;
+            }
+        h ^= 0xff;
+        h *= 16777619U;
+    }
+    i = h & (ts->ts_size - 1);
+    while ((slot = &ts->ts_vec[i])->tsl_tuple != NULL){
+        for (v=0; v<ts->ts_clen; v++)
+            if (clicon_strcmp(slot->tsl_tuple[v], tuple[v]) != 0)
+                break;
+        if (v == ts->ts_clen)
+            break;
+        i = (i + 1) & (ts->ts_size - 1);
+    }
+    return slot;
+}
+
+/*! Collect values of a unique descendant schema node id of a list entry
+ *
+ * @param[in]     x     List entry
+ * @param[in]     xpath Descendant schema node id in canonical form
+ * @param[in]     nsc   Namespace context of xpath
+ * @param[in,out] svec  Vector of values
+ * @param[in,out] sxvec Vector of list entries of values
+ * @param[in,out] slen  Length of svec and sxvec
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+unique_search_xpath(cxobj    *x,
+                    char     *xpath,
+                    cvec     *nsc,
+                    char   ***svec,
+                    cxobj  ***sxvec,
+                    size_t   *slen)
 {
     int     retval = -1;
     cxobj **xvec = NULL;
     size_t  xveclen;
     int     i;
-    int     s;
     cxobj  *xi;
     char   *bi;
 
@@ -128,86 +236,58 @@ unique_search_xpath(cxobj  *x,
         xi = xvec[i];
         if ((bi = xml_body(xi)) == NULL)
             break;
-        /* Check if bi is duplicate?
-         * XXX: sort svec?
-         */
-        for (s=0; s<(*slen); s++){
-            if (strcmp(bi, (*svec)[s]) == 0){
-                goto fail;
-            }
-        }
         (*slen) ++;
         if (((*svec) = realloc((*svec), (*slen)*sizeof(char*))) == NULL){
             clixon_err(OE_UNIX, errno, "realloc");
             goto done;
         }
         (*svec)[(*slen)-1] = bi;
+        if (((*sxvec) = realloc((*sxvec), (*slen)*sizeof(cxobj*))) == NULL){
+            clixon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        (*sxvec)[(*slen)-1] = x;
     } /* i search results */
-    retval = 1;
+    retval = 0;
  done:
     if (xvec)
         free(xvec);
     return retval;
- fail:
-    retval = 0;
-    goto done;
 }
 
-/*! New element last in list, return error if already exists
+/*! New element last in list sorted by key, return error if already exists
  *
  * @param[in]  vec    Vector of existing entries (new is last)
  * @param[in]  i1     The new entry is placed at vec[i1]
- * @param[in]  vlen   Length of vec
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
+ * @param[in]  vlen   Length of entry
  * @param[out] dupl   Index of duplicated element (if retval = -1)
  * @retval     0      OK, entry is unique
  * @retval    -1      Duplicate detected
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
+ * @note Only previous element is compared, for other lists use tuple_set_lookup
  */
 static int
 check_insert_duplicate(char **vec,
                        int    i1,
                        int    vlen,
-                       int    sorted,
                        int   *dupl)
 {
     int i;
     int v;
     char *b;
 
-    if (sorted){
-        /* Just go look at previous element to see if it is duplicate (sorted by system) */
-        if (i1 == 0)
-            return 0;
-        i = i1-1;
-        for (v=0; v<vlen; v++){
-            b = vec[i*vlen+v];
-            if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-                return 0;
-        }
-        /* here we have passed thru all keys of previous element and they are all equal */
-        if (dupl)
-            *dupl = i;
-        return -1;
-    }
-    else{
-        for (i=0; i<i1; i++){
-            for (v=0; v<vlen; v++){
-                b = vec[i*vlen+v];
-                if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-                    break;
-            }
-            if (v==vlen) /* duplicate */
-                break;
-        }
-        if (i<i1){
-            if (dupl)
-                *dupl = i;
-            return -1;
-        }
-        else
+    /* Just go look at previous element to see if it is duplicate (sorted by system) */
+    if (i1 == 0)
+        return 0;
+    i = i1-1;
+    for (v=0; v<vlen; v++){
+        b = vec[i*vlen+v];
+        if (b == NULL || strcmp(b, vec[i1*vlen+v]))
             return 0;
     }
+    /* here we have passed thru all keys of previous element and they are all equal */
+    if (dupl)
+        *dupl = i;
+    return -1;
 }
 
 /*! Given a list with unique constraint, detect duplicates
@@ -255,10 +335,11 @@ check_unique_list_direct(cxobj     *x,
     char     *str;
     cvec     *cvk;
     int       dupl;
+    struct tuple_set   ts = {0,};
+    struct tuple_slot *slot;
 
     /* If list and is sorted by system, then it is assumed elements are in key-order which is optimized
-     * Other cases are "unique" constraint or list sorted by user which is quadratic in complexity
-     * This second case COULD be optimized if binary insert is made on the vec vector.
+     * Other cases are "unique" constraint or list sorted by user which use a hash set of tuples
      */
     sorted = (yang_keyword_get(yu) == Y_LIST &&
               yang_find(y, Y_ORDERED_BY, "user") == NULL);
@@ -280,6 +361,8 @@ check_unique_list_direct(cxobj     *x,
         clixon_err(OE_UNIX, errno, "calloc");
         goto done;
     }
+    if (!sorted && tuple_set_init(&ts, clen, xml_child_nr(xt)) < 0)
+        goto done;
     /* Loop over children, then over each key, then search "backwards" */
     i = 0; /* x element index */
     do {
@@ -303,7 +386,16 @@ check_unique_list_direct(cxobj     *x,
         }
         if (cvi==NULL){
             /* Last element (i) is newly inserted, see if it is already there */
-            if (check_insert_duplicate(vec, i, clen, sorted, &dupl) < 0){
+            if (sorted)
+                dupl = check_insert_duplicate(vec, i, clen, NULL);
+            else {
+                slot = tuple_set_lookup(&ts, &vec[i*clen]);
+                if ((dupl = (slot->tsl_tuple != NULL ? -1 : 0)) == 0){
+                    slot->tsl_tuple = &vec[i*clen];
+                    slot->tsl_i = i;
+                }
+            }
+            if (dupl < 0){
                 if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
                     goto done;
                 goto fail;
@@ -316,6 +408,7 @@ check_unique_list_direct(cxobj     *x,
     /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
+    tuple_set_free(&ts);
     if (xvec)
         free(xvec);
     if (vec)
@@ -360,7 +453,11 @@ check_unique_list(cxobj     *x,
     int     retval = -1;
     cg_var *cvi; /* unique node name */
     char  **svec = NULL; /* vector of search results */
+    cxobj **sxvec = NULL; /* list entries of search results */
     size_t  slen = 0;
+    size_t  i;
+    struct tuple_set   ts = {0,};
+    struct tuple_slot *slot;
     char   *xpath0 = NULL;
     char   *xpath1 = NULL;
     int     ret;
@@ -394,19 +491,30 @@ check_unique_list(cxobj     *x,
         goto fail; // XXX set xret
     do {
         /* Collect search results from one */
-        if ((ret = unique_search_xpath(x, xpath1, nsc1, &svec, &slen)) < 0)
+        if (unique_search_xpath(x, xpath1, nsc1, &svec, &sxvec, &slen) < 0)
             goto done;
-        if (ret == 0){
-            if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
+        x = xml_child_each(xt, x, CX_ELMNT);
+    } while (x && y == xml_spec(x));  /* stop if list ends, others may follow */
+    /* First value that is equal to a previous value */
+    if (tuple_set_init(&ts, 1, slen) < 0)
+        goto done;
+    for (i=0; i<slen; i++){
+        slot = tuple_set_lookup(&ts, &svec[i]);
+        if (slot->tsl_tuple != NULL){
+            if (xret && netconf_data_not_unique_xml(xret, sxvec[i], cvk) < 0)
                 goto done;
             goto fail;
         }
-        x = xml_child_each(xt, x, CX_ELMNT);
-    } while (x && y == xml_spec(x));  /* stop if list ends, others may follow */
+        slot->tsl_tuple = &svec[i];
+        slot->tsl_i = i;
+    }
     // ok:
     /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
+    tuple_set_free(&ts);
+    if (sxvec)
+        free(sxvec);
     if (nsc0)
         cvec_free(nsc0);
     if (nsc1)
@@ -726,8 +834,9 @@ xml_yang_validate_minmax(cxobj  *xt,
                     goto done;
             }
             nr=1;
-            /* new list check */
-            if (ret){
+            /* new list check, unless unchanged since valid source */
+            if (ret &&
+                (_minmax_diff == 0 || xml_flag(xt, XML_FLAG_ADD|XML_FLAG_CHANGE) != 0)){
                 if (keyw == Y_LIST){
                     if ((ret = check_unique_list_direct(x, xt, y, y, xret)) < 0)
                         goto done;
@@ -812,6 +921,23 @@ xml_yang_validate_minmax(cxobj  *xt,
     goto done;
 }
 
+/*! Set incremental mode of unique checks of xml_yang_validate_minmax
+ *
+ * If set, keys and unique constraints of a list are only checked if its parent has
+ * XML_FLAG_ADD or XML_FLAG_CHANGE set from a diff with a valid source tree.
+ * @param[in]  diff  1: incremental, 0: check all lists
+ * @retval     diff0 Previous value
+ * @see xml_yang_validate_all_diff
+ */
+int
+xml_yang_validate_minmax_diff(int diff)
+{
+    int diff0 = _minmax_diff;
+
+    _minmax_diff = diff;
+    return diff0;
+}
+
 /*----------- New linear vector code -----------------*/
 
 static int
@@ -828,34 +954,126 @@ vec_free(struct vec_order *vec,
     return 0;
 }
 
-/*! Leaf-list qsort comparison function
+/*! Compare two string vectors, for error reporting of lists ordered by user
  */
 static int
-cmp_list_qsort(const void *arg1,
-               const void *arg2)
+vec_order_cmp(struct vec_order *v1,
+              struct vec_order *v2)
 {
-    struct vec_order *v1 = (struct vec_order *)arg1;
-    struct vec_order *v2 = (struct vec_order *)arg2;
-    int               i1;
-    int               i2;
-    int               eq;
-    int               i;
+    int eq = 0;
+    int i;
 
-    eq = 0;
     for (i=0; i<v1->vo_slen; i++){
-        if ((eq = strcmp(v1->vo_strvec[i], v2->vo_strvec[i])) != 0)
+        if ((eq = clicon_strcmp(v1->vo_strvec[i], v2->vo_strvec[i])) != 0)
             break;
     }
-    if (eq != 0)
-        return eq;
-    i1 = xml_enumerate_get(v1->vo_xml);
-    i2 = xml_enumerate_get(v2->vo_xml);
-    if (i1 > i2)
-        return 1;
-    else if (i1 < i2)
-        return -1;
-    else
-        return 0;
+    return eq;
+}
+
+/*! Create not-unique error of list or leaf-list
+ *
+ * @param[in]  y     YANG node of list
+ * @param[in]  x     XML list entry
+ * @param[in]  str   Value if leaf-list
+ * @param[out] xret  Error XML tree. Free with xml_free after use
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+duplicates_list_err(yang_stmt *y,
+                    cxobj     *x,
+                    char      *str,
+                    cxobj    **xret)
+{
+    int   retval = -1;
+    cvec *cvk = NULL;
+
+    if (yang_keyword_get(y) == Y_LEAF_LIST){
+        if ((cvk = cvec_new(0)) == NULL){
+            clixon_err(OE_UNIX, errno, "cvec_new");
+            goto done;
+        }
+        cvec_add_string(cvk, "name", str);
+        if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
+            goto done;
+    }
+    else if (xret && netconf_data_not_unique_xml(xret, x, yang_cvec_get(y)) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (cvk)
+        cvec_free(cvk);
+    return retval;
+}
+
+/*! Remove duplicates of list ordered by user using a hash set, keep last
+ *
+ * @param[in]  y     YANG node of list segment
+ * @param[in]  vec   Vector of string vectors in list order
+ * @param[in]  vlen  Length of vec
+ * @param[in]  rm    0: return 0 on first duplicate, 1: remove all duplicates
+ * @param[out] nr    Number of removed entries
+ * @param[out] xret  Error XML tree. Free with xml_free after use
+ * @retval     1     OK, no duplicates
+ * @retval     0     Validation failed (xret set) (only if rm=0)
+ * @retval    -1     Error
+ * @see remove_duplicates_list  for lists sorted by system
+ */
+static int
+remove_duplicates_hash(yang_stmt        *y,
+                       struct vec_order *vec,
+                       size_t            vlen,
+                       int               rm,
+                       int              *nr,
+                       cxobj           **xret)
+{
+    int                retval = -1;
+    struct tuple_set   ts = {0,};
+    struct tuple_slot *slot;
+    int                v;
+    int                vmin;
+
+    if (nr)
+        *nr = 0;
+    if (vlen < 2)
+        goto ok;
+    if (tuple_set_init(&ts, vec[0].vo_slen, vlen) < 0)
+        goto done;
+    for (v=0; v<vlen; v++){
+        slot = tuple_set_lookup(&ts, vec[v].vo_strvec);
+        if (slot->tsl_tuple == NULL){
+            slot->tsl_tuple = vec[v].vo_strvec;
+            slot->tsl_i = v;
+            continue;
+        }
+        if (rm){
+            if (xml_purge(vec[slot->tsl_i].vo_xml) < 0)
+                goto done;
+            if (nr)
+                (*nr)++;
+            /* Keep last */
+            slot->tsl_tuple = vec[v].vo_strvec;
+            slot->tsl_i = v;
+        }
+        else{
+            /* Report smallest entry, as if sorted */
+            vmin = 0;
+            for (v=1; v<vlen; v++)
+                if (vec_order_cmp(&vec[v], &vec[vmin]) < 0)
+                    vmin = v;
+            if (duplicates_list_err(y, vec[vmin].vo_xml, vec[slot->tsl_i].vo_strvec[0], xret) < 0)
+                goto done;
+            goto fail;
+        }
+    }
+ ok:
+    retval = 1;
+ done:
+    tuple_set_free(&ts);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
 /*! Remove duplicates list
@@ -878,7 +1096,6 @@ remove_duplicates_list(yang_stmt        *y,
                        cxobj           **xret)
 {
     int   retval = -1;
-    cvec *cvk;
     int   v;
     int   i;
 
@@ -897,20 +1114,8 @@ remove_duplicates_list(yang_stmt        *y,
                     (*nr)++;
             }
             else{
-                cvk = NULL;
-                if (yang_keyword_get(y) == Y_LEAF_LIST){
-                    if ((cvk = cvec_new(0)) == NULL){
-                        clixon_err(OE_UNIX, errno, "cvec_new");
-                        goto done;
-                    }
-                    cvec_add_string(cvk, "name", vec[v].vo_strvec[0]);
-                }
-                else
-                    cvk = yang_cvec_get(y);
-                if (xret && netconf_data_not_unique_xml(xret, vec[0].vo_xml, cvk) < 0)
+                if (duplicates_list_err(y, vec[0].vo_xml, vec[v].vo_strvec[0], xret) < 0)
                     goto done;
-                if (yang_keyword_get(y) == Y_LEAF_LIST && cvk != NULL)
-                    cvec_free(cvk);
                 goto fail;
             }
         }
@@ -993,8 +1198,10 @@ vec_order_analyze(yang_stmt        *y,
     case Y_LIST:
     case Y_LEAF_LIST:
         if (yang_find(y, Y_ORDERED_BY, "user") != NULL)
-            qsort(vec, vlen, sizeof(*vec), cmp_list_qsort);
-        if ((ret = remove_duplicates_list(y, vec, vlen, rm, &nr, xret)) < 0)
+            ret = remove_duplicates_hash(y, vec, vlen, rm, &nr, xret);
+        else
+            ret = remove_duplicates_list(y, vec, vlen, rm, &nr, xret);
+        if (ret < 0)
             goto done;
         if (ret == 0)
             goto fail;
@@ -1052,7 +1259,6 @@ xml_duplicate_detect1(cxobj  *xt,
     int               v;
     int               ret;
 
-    xml_enumerate_children(xt); // Could be done in-line
     y0 = NULL;
     slen0 = 0;
     x = NULL;
@@ -1128,11 +1334,13 @@ xml_duplicate_detect1(cxobj  *xt,
                 slen0 = clen;
                 vlen++;
             }
-            /* Special case of YANG unique statement */
-            if ((ret = xml_unique_detect(x, xt, y, xret)) < 0)
-                goto done;
-            if (ret == 0)
-                goto fail;
+            /* Special case of YANG unique statement, once for whole list */
+            if (y != y0){
+                if ((ret = xml_unique_detect(x, xt, y, xret)) < 0)
+                    goto done;
+                if (ret == 0)
+                    goto fail;
+            }
             break;
         case Y_LEAF_LIST:
             if (vlen > 0 && slen0 != 1){ /* Sanity check */
@@ -66,16 +66,19 @@
 #include "clixon_xml.h"
 #include "clixon_err.h"
 #include "clixon_log.h"
+#include "clixon_string.h"
 #include "clixon_debug.h"
 #include "clixon_options.h" /* xml_bind_yang */
 #include "clixon_yang_module.h"
 #include "clixon_xml_map.h" /* xml_bind_yang */
 #include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_index.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_io.h"
 #include "clixon_xml_parse.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_digest.h"
 
 /*
  * Constants
@@ -89,6 +92,25 @@
 #define XML_CHILDVEC_SIZE_START_ELMNT 16
 #define XML_CHILDVEC_SIZE_THRESHOLD 65536
 
+/* Storage of body and attribute values, see struct xmlbody
+ * Short values, eg integers, enums and IPv4 addresses, are stored inline in the node.
+ * Longer values are malloced strings. Values that are appended to, eg by the parsers, are
+ * converted to cbufs unless they still fit inline.
+ */
+#define XML_VALUE_NONE   0 /* No value */
+#define XML_VALUE_INLINE 1 /* Value stored inline */
+#define XML_VALUE_STR    2 /* Value is malloced string */
+#define XML_VALUE_CB     3 /* Value is cbuf */
+
+/* Max length of inline value including null-termination */
+#define XML_VALUE_INLINE_LEN 16
+
+#ifdef XML_SLAB
+/* Size and alignment of XML object slabs, the slab of an object is found by masking
+ * its address */
+#define XML_SLAB_SIZE 65536
+#endif
+
 /* Intention of these macros is to guard against access of type-specific fields 
  * As debug they can contain an assert.
  */
@@ -101,6 +123,8 @@
 
 #ifdef XML_EXPLICIT_INDEX
 static int xml_search_index_free(cxobj *x);
+static int xml_search_index_child(cxobj *xp, cxobj *xc, int add);
+static int xml_search_index_value(cxobj *xi, int add);
 
 /* A search index pair consisting of a name of an (index) variable and a vector of xml children
  * the variable should be a potential child of the XML node
@@ -175,18 +199,20 @@ struct xml{
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for stable sorting:
                                        see xml_enumerate_children and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-                                       memory) cv? */
     /*----- up to here is common to all next is element only */
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
     int               x_childvec_len;/* Number of children */
+    int               x_childvec_elmnt;/* Number of element children */
+    int               x_childvec_attr;/* Number of attribute children */
+    int               x_childvec_body;/* Number of body children */
     int               x_childvec_max;/* Length of allocated vector */
 
     cvec             *x_ns_cache;   /* Cached vector of namespaces (set by bind-yang) */
     yang_stmt        *x_spec;       /* Pointer to specification, eg yang, 
                                        by reference, dont free */
     cg_var           *x_cv;         /* Cached value as cligen variable (set by xml_cmp) */
+    struct xml_sortkey *x_sortkey;  /* Cached sort key of list entry (set by xml_cmp) */
+    uint8_t          *x_digest;     /* Cached subtree digest, NULL if not computed, see xml_digest */
 #ifdef XML_EXPLICIT_INDEX
     struct search_index *x_search_index; /* explicit search index vectors */
 #endif
@@ -200,6 +226,7 @@ struct xmlbody{
     char             *xb_name;       /* name of node */
     char             *xb_prefix;     /* namespace localname N, called prefix */
     uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           xb_value_mode; /* How value is stored: XML_VALUE_* */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *xb_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -207,9 +234,16 @@ struct xmlbody{
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
                                        see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    union {                          /* attribute and body nodes have values */
+        char          xv_inline[XML_VALUE_INLINE_LEN]; /* XML_VALUE_INLINE: short value */
+        char         *xv_str;        /* XML_VALUE_STR: malloced value */
+        cbuf         *xv_cb;         /* XML_VALUE_CB: value that has been appended to */
+    } xb_value;
 };
 
+/* Get body/attribute variant of node */
+#define XML_BODY(x) ((struct xmlbody *)(x))
+
 /*
  * Variables
  */
@@ -237,6 +271,172 @@ xml_type2str(enum cxobj_type type)
 /* Stats (too low-level to hang it on handle) */
 static uint64_t _stats_xml_nr = 0;
 
+#ifdef XML_SLAB
+/* Slab of fixed size XML objects. Header at start of an aligned XML_SLAB_SIZE block,
+ * followed by the objects
+ */
+struct xml_slab{
+    struct xml_slab      *xs_next;   /* Next slab in pool list of slabs with free objects */
+    struct xml_slab      *xs_prev;   /* Previous slab in pool list of slabs with free objects */
+    struct xml_slab_pool *xs_pool;   /* Pool of this slab */
+    void                 *xs_free;   /* List of freed objects, linked via first word */
+    uint32_t              xs_used;   /* Number of allocated objects */
+    uint32_t              xs_bump;   /* Number of objects ever allocated, rest is untouched */
+};
+
+/* Pool of slabs for one object size */
+struct xml_slab_pool{
+    size_t                sp_size;   /* Object size */
+    uint32_t              sp_nobj;   /* Number of objects per slab */
+    struct xml_slab      *sp_avail;  /* Slabs with free objects */
+    uint64_t              sp_slabs;  /* Number of slabs */
+    uint64_t              sp_used;   /* Number of allocated objects */
+};
+
+/* Offset of first object in slab */
+#define XML_SLAB_HDR ((sizeof(struct xml_slab) + 15) & ~(size_t)15)
+
+/* Slab pools for elements and for bodies/attributes (too low-level to hang it on handle) */
+static struct xml_slab_pool _xml_slab_elmnt = {0,};
+static struct xml_slab_pool _xml_slab_body = {0,};
+#endif /* XML_SLAB */
+
+/* Lazy loading callbacks, see xml_lazy_register (too low-level to hang it on handle) */
+static xml_lazyfn_t *_xml_lazy_loadfn = NULL;
+static xml_lazyfn_t *_xml_lazy_freefn = NULL;
+static xml_lazyfn_t *_xml_lazy_touchfn = NULL;
+static void         *_xml_lazy_arg = NULL;
+static int           _xml_lazy_suspend = 0;
+static uint64_t      _xml_lazy_errors = 0;
+static cxobj        *_xml_lazy_last = NULL;  /* Last loaded or touched node */
+
+/*! Load children of a lazy node on first access unless suspended
+ *
+ * Accessors without error return count a failed load, the node is kept as placeholder
+ * and accessed as empty. Callers check xml_lazy_errors and abort.
+ * Functions with error return use XML_LAZY_PENDING and return the error instead.
+ * Access of a loaded node calls the touch callback, unless it was the last node
+ * loaded or touched, eg repeated access when iterating over its children.
+ */
+#define XML_LAZY_PENDING(x) \
+    (((x)->x_flags & XML_FLAG_LAZY) && _xml_lazy_suspend == 0)
+#define XML_LAZY_ACCESS(x) do {                                 \
+        if (XML_LAZY_PENDING(x)){                               \
+            if (xml_lazy_load(x) < 0)                           \
+                _xml_lazy_errors++;                             \
+        }                                                       \
+        else if (((x)->x_flags & XML_FLAG_LAZY_LOADED) &&       \
+                 (x) != _xml_lazy_last &&                       \
+                 _xml_lazy_suspend == 0)                        \
+            xml_lazy_touch(x);                                  \
+    } while (0)
+
+/*! Loaded lazy node is accessed, call touch callback
+ *
+ * @param[in]  x    XML node with XML_FLAG_LAZY_LOADED
+ * @see xml_lazy_register
+ */
+static void
+xml_lazy_touch(cxobj *x)
+{
+    _xml_lazy_last = x;
+    if (_xml_lazy_touchfn)
+        (*_xml_lazy_touchfn)(x, _xml_lazy_arg);
+}
+
+#ifdef XML_SLAB
+/*! Remove slab from pool list of slabs with free objects
+ */
+static void
+xml_slab_unlink(struct xml_slab_pool *sp,
+                struct xml_slab      *xs)
+{
+    if (xs->xs_prev)
+        xs->xs_prev->xs_next = xs->xs_next;
+    else
+        sp->sp_avail = xs->xs_next;
+    if (xs->xs_next)
+        xs->xs_next->xs_prev = xs->xs_prev;
+    xs->xs_next = xs->xs_prev = NULL;
+}
+
+/*! Add slab first in pool list of slabs with free objects
+ */
+static void
+xml_slab_link(struct xml_slab_pool *sp,
+              struct xml_slab      *xs)
+{
+    xs->xs_prev = NULL;
+    xs->xs_next = sp->sp_avail;
+    if (sp->sp_avail)
+        sp->sp_avail->xs_prev = xs;
+    sp->sp_avail = xs;
+}
+
+/*! Allocate an object from a slab pool, allocate a new slab if none has free objects
+ *
+ * @param[in]  sp   Slab pool
+ * @param[in]  sz   Object size
+ * @retval     obj  Object, not initialized
+ * @retval     NULL Error
+ */
+static void *
+xml_slab_alloc(struct xml_slab_pool *sp,
+               size_t                sz)
+{
+    struct xml_slab *xs;
+    void            *obj;
+
+    if (sp->sp_size == 0){
+        sp->sp_size = (sz + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+        sp->sp_nobj = (XML_SLAB_SIZE - XML_SLAB_HDR) / sp->sp_size;
+    }
+    if ((xs = sp->sp_avail) == NULL){
+        if (posix_memalign((void**)&xs, XML_SLAB_SIZE, XML_SLAB_SIZE) != 0){
+            clixon_err(OE_XML, errno, "posix_memalign");
+            return NULL;
+        }
+        memset(xs, 0, sizeof(*xs));
+        xs->xs_pool = sp;
+        xml_slab_link(sp, xs);
+        sp->sp_slabs++;
+    }
+    if ((obj = xs->xs_free) != NULL)
+        xs->xs_free = *(void**)obj;
+    else
+        obj = (char*)xs + XML_SLAB_HDR + xs->xs_bump++ * sp->sp_size;
+    if (++xs->xs_used == sp->sp_nobj)
+        xml_slab_unlink(sp, xs);
+    sp->sp_used++;
+    return obj;
+}
+
+/*! Free an object to its slab, release slab if empty and not the only slab
+ *
+ * @param[in]  obj  Object allocated by xml_slab_alloc
+ */
+static void
+xml_slab_free(void *obj)
+{
+    struct xml_slab      *xs;
+    struct xml_slab_pool *sp;
+
+    xs = (struct xml_slab *)((uintptr_t)obj & ~(uintptr_t)(XML_SLAB_SIZE - 1));
+    sp = xs->xs_pool;
+    if (xs->xs_used-- == sp->sp_nobj)
+        xml_slab_link(sp, xs);
+    sp->sp_used--;
+    if (xs->xs_used == 0 && sp->sp_slabs > 1){
+        xml_slab_unlink(sp, xs);
+        sp->sp_slabs--;
+        free(xs);
+        return;
+    }
+    *(void**)obj = xs->xs_free;
+    xs->xs_free = obj;
+}
+#endif /* XML_SLAB */
+
 /*! Get global statistics about XML objects
  *
  * @param[out]  nr  Number of existing XML objects (created - freed)
@@ -249,12 +449,48 @@ xml_stats_global(uint64_t *nr)
     return 0;
 }
 
+/*! Get statistics about XML object slabs
+ *
+ * @param[out]  slabs  Number of allocated slabs
+ * @param[out]  used   Number of XML objects allocated from slabs
+ * @param[out]  sz     Size in bytes of allocated slabs
+ * @retval      0      OK
+ * @see XML_SLAB
+ */
+int
+xml_stats_slab(uint64_t *slabs,
+               uint64_t *used,
+               size_t   *sz)
+{
+#ifdef XML_SLAB
+    uint64_t n;
+
+    n = _xml_slab_elmnt.sp_slabs + _xml_slab_body.sp_slabs;
+    if (slabs)
+        *slabs = n;
+    if (used)
+        *used = _xml_slab_elmnt.sp_used + _xml_slab_body.sp_used;
+    if (sz)
+        *sz = n * XML_SLAB_SIZE;
+#else
+    if (slabs)
+        *slabs = 0;
+    if (used)
+        *used = 0;
+    if (sz)
+        *sz = 0;
+#endif
+    return 0;
+}
+
 /*! Return the alloced memory of a single XML obj 
  *
  * @param[in]   x    XML object
  * @param[out]  szp  Size of this XML obj
  * @retval      0    OK
  * (baseline: 96 bytes per object on x86-64)
+ * Names and prefixes are interned and shared, each node counts its share of them
+ * @see clixon_string_intern_size
  */
 static int
 xml_stats_one(cxobj    *x,
@@ -262,10 +498,8 @@ xml_stats_one(cxobj    *x,
 {
     size_t sz = 0;
 
-    if (x->x_name)
-        sz += strlen(x->x_name) + 1;
-    if (x->x_prefix)
-        sz += strlen(x->x_prefix) + 1;
+    sz += clixon_string_intern_size(x->x_name);
+    sz += clixon_string_intern_size(x->x_prefix);
     switch (xml_type(x)){
     case CX_ELMNT:
         sz += sizeof(struct xml);
@@ -274,6 +508,10 @@ xml_stats_one(cxobj    *x,
             sz += cvec_size(x->x_ns_cache);
         if (x->x_cv)
             sz += cv_size(x->x_cv);
+        if (x->x_sortkey)
+            sz += sizeof(struct xml_sortkey) + x->x_sortkey->sk_len;
+        if (x->x_digest)
+            sz += CLIXON_DIGEST_LEN;
 #ifdef XML_EXPLICIT_INDEX
         if (x->x_search_index){
             /* XXX: only one */
@@ -288,8 +526,10 @@ xml_stats_one(cxobj    *x,
     case CX_BODY:
     case CX_ATTR:
         sz += sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            sz += cbuf_buflen(x->x_value_cb);
+        if (XML_BODY(x)->xb_value_mode == XML_VALUE_STR)
+            sz += strlen(XML_BODY(x)->xb_value.xv_str) + 1;
+        else if (XML_BODY(x)->xb_value_mode == XML_VALUE_CB)
+            sz += cbuf_buflen(XML_BODY(x)->xb_value.xv_cb);
         break;
     default:
         break;
@@ -324,6 +564,7 @@ xml_stats(cxobj    *xt,
     xml_stats_one(xt, &sz);
     if (szp)
         *szp += sz;
+    _xml_lazy_suspend++; /* Only count loaded nodes */
     xc = NULL;
     while ((xc = xml_child_each(xt, xc, -1)) != NULL) {
         sz=0;
@@ -331,11 +572,97 @@ xml_stats(cxobj    *xt,
         if (szp)
             *szp += sz;
     }
+    _xml_lazy_suspend--;
     retval = 0;
  done:
     return retval;
 }
 
+/*! Register callbacks for lazy loading of XML subtrees
+ *
+ * A node with XML_FLAG_LAZY set is a placeholder whose children have not been loaded.
+ * The load callback is called on first access of the children of such a node, eg
+ * xml_child_each, xml_child_i or adding a child. The flag is reset before the callback
+ * is called.
+ * The free callback is called when a node with XML_FLAG_LAZY_LOADED is freed.
+ * The touch callback is called when the children of a node with XML_FLAG_LAZY_LOADED
+ * are accessed, eg to keep loaded nodes in least recently used order.
+ * @param[in]  loadfn  Load children of node, or NULL
+ * @param[in]  freefn  Node with XML_FLAG_LAZY_LOADED is freed, or NULL
+ * @param[in]  touchfn Node with XML_FLAG_LAZY_LOADED is accessed, or NULL
+ * @param[in]  arg     Argument to callbacks, eg clixon handle
+ * @retval     0       OK
+ * @see xml_lazy_suspend
+ */
+int
+xml_lazy_register(xml_lazyfn_t *loadfn,
+                  xml_lazyfn_t *freefn,
+                  xml_lazyfn_t *touchfn,
+                  void         *arg)
+{
+    _xml_lazy_loadfn = loadfn;
+    _xml_lazy_freefn = freefn;
+    _xml_lazy_touchfn = touchfn;
+    _xml_lazy_arg = arg;
+    _xml_lazy_last = NULL;
+    return 0;
+}
+
+/*! Suspend or resume lazy loading on access
+ *
+ * Used by traversals of whole trees that should not load lazy nodes, such as writing
+ * a datastore or marking flags. Calls may be nested.
+ * @param[in]  suspend  1: suspend, 0: resume
+ * @retval     n        Suspend level after call
+ */
+int
+xml_lazy_suspend(int suspend)
+{
+    if (suspend)
+        _xml_lazy_suspend++;
+    else if (_xml_lazy_suspend > 0)
+        _xml_lazy_suspend--;
+    return _xml_lazy_suspend;
+}
+
+/*! Load children of a lazy XML node, also when suspended
+ *
+ * @param[in]  x    XML node
+ * @retval     0    OK, or not a lazy node
+ * @retval    -1    Error
+ * @see xml_lazy_register
+ */
+int
+xml_lazy_load(cxobj *x)
+{
+    if (x == NULL ||
+        (x->x_flags & XML_FLAG_LAZY) == 0 ||
+        _xml_lazy_loadfn == NULL)
+        return 0;
+    x->x_flags &= ~XML_FLAG_LAZY;
+    _xml_lazy_last = x;
+    return (*_xml_lazy_loadfn)(x, _xml_lazy_arg);
+}
+
+/*! Get number of failed loads of lazy XML nodes on access
+ *
+ * The number is never reset. Compare before and after an operation to detect whether
+ * any lazy node accessed by the operation failed to load, in which case the result of
+ * the operation is incomplete.
+ * @retval     n    Number of failed loads on access since start
+ * @code
+ *   uint64_t n0 = xml_lazy_errors();
+ *   ...
+ *   if (xml_lazy_errors() != n0)
+ *      err;
+ * @endcode
+ */
+uint64_t
+xml_lazy_errors(void)
+{
+    return _xml_lazy_errors;
+}
+
 /*
  * Access functions
  */
@@ -353,27 +680,35 @@ xml_name(cxobj *xn)
     return xn->x_name;
 }
 
-/*! Set name of xnode, name is copied
+/*! Set name of xnode, name is interned
  *
+ * Names are shared between nodes, two nodes have equal names if the name pointers are equal
  * @param[in]  xn    xml node
- * @param[in]  name  new name, null-terminated string, copied by function
+ * @param[in]  name  new name, null-terminated string, interned by function
  * @retval     0     OK
  * @retval    -1     On error with clicon-err set
+ * @see clixon_string_intern
  */
 int
 xml_name_set(cxobj *xn,
              char  *name)
 {
-    if (xn->x_name){
-        free(xn->x_name);
-        xn->x_name = NULL;
-    }
+    char *old;
+
+    xml_digest_reset(xn);
+    /* Descendant index is keyed by name */
+    if (xn->x_up && xml_descendant_index_child(xn->x_up, xn, 0) < 0)
+        return -1;
+    old = xn->x_name;
+    xn->x_name = NULL;
     if (name){
-        if ((xn->x_name = strdup(name)) == NULL){
-            clixon_err(OE_XML, errno, "strdup");
+        if ((xn->x_name = clixon_string_intern(name)) == NULL)
             return -1;
-        }
     }
+    if (old)
+        clixon_string_unintern(old);
+    if (xn->x_up && xml_descendant_index_child(xn->x_up, xn, 1) < 0)
+        return -1;
     return 0;
 }
 
@@ -388,27 +723,29 @@ xml_prefix(cxobj *xn)
     return xn->x_prefix;
 }
 
-/*! Set prefix of xnode, prefix is copied
+/*! Set prefix of xnode, prefix is interned
  *
  * @param[in]  xn      XML node
- * @param[in]  prefix  New prefix, null-terminated string, copied by function
+ * @param[in]  prefix  New prefix, null-terminated string, interned by function
  * @retval     0       OK
  * @retval    -1       Error with clicon-err set
+ * @see xml_name_set
  */
 int
 xml_prefix_set(cxobj *xn,
                char  *prefix)
 {
-    if (xn->x_prefix){
-        free(xn->x_prefix);
-        xn->x_prefix = NULL;
-    }
+    char *old;
+
+    xml_digest_reset(xn);
+    old = xn->x_prefix;
+    xn->x_prefix = NULL;
     if (prefix){
-        if ((xn->x_prefix = strdup(prefix)) == NULL){
-            clixon_err(OE_XML, errno, "strdup");
+        if ((xn->x_prefix = clixon_string_intern(prefix)) == NULL)
             return -1;
-        }
     }
+    if (old)
+        clixon_string_unintern(old);
     return 0;
 }
 
@@ -639,6 +976,26 @@ xml_flag_reset(cxobj   *xn,
     return 0;
 }
 
+/*! Free value of body or attribute node
+ *
+ * @param[in]  xb    Body or attribute node
+ */
+static void
+xml_value_free(struct xmlbody *xb)
+{
+    switch (xb->xb_value_mode){
+    case XML_VALUE_STR:
+        free(xb->xb_value.xv_str);
+        break;
+    case XML_VALUE_CB:
+        cbuf_free(xb->xb_value.xv_cb);
+        break;
+    default:
+        break;
+    }
+    xb->xb_value_mode = XML_VALUE_NONE;
+}
+
 /*! Get value of xnode
  *
  * @param[in]  xn    xml node
@@ -647,13 +1004,83 @@ xml_flag_reset(cxobj   *xn,
 char*
 xml_value(cxobj *xn)
 {
+    struct xmlbody *xb;
+
     if (!is_bodyattr(xn))
         return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    xb = XML_BODY(xn);
+    switch (xb->xb_value_mode){
+    case XML_VALUE_INLINE:
+        return xb->xb_value.xv_inline;
+    case XML_VALUE_STR:
+        return xb->xb_value.xv_str;
+    case XML_VALUE_CB:
+        return cbuf_get(xb->xb_value.xv_cb);
+    default:
+        break;
+    }
+    return NULL;
+}
+
+/*! Clear sort key cache of XML node
+ *
+ * @param[in]  x    XML node, or NULL
+ */
+static void
+xml_sortkey_reset(cxobj *x)
+{
+    if (x && is_element(x) && x->x_sortkey){
+        free(x->x_sortkey);
+        x->x_sortkey = NULL;
+    }
+}
+
+/*! Clear value caches of parent of body when value has changed
+ *
+ * The parent leaf may have cached the body as a typed value, and the leaf-list or list entry
+ * a sort key, used when sorting and searching
+ * @param[in]  xn    xml body node
+ * @see xml_cv_cache
+ */
+static void
+xml_value_changed(cxobj *xn)
+{
+    cxobj *xp;
+
+    if (xml_type(xn) == CX_BODY &&
+        (xp = xn->x_up) != NULL){
+        if (xp->x_cv != NULL){
+            cv_free(xp->x_cv);
+            xp->x_cv = NULL;
+        }
+        xml_sortkey_reset(xp);
+        xml_sortkey_reset(xp->x_up);
+    }
+}
+
+/*! Clear value caches of XML node when a child is added or removed
+ *
+ * An element child may be a key leaf of list entry xp, a body child is the value of leaf xp
+ * @param[in]  xp   xml parent node
+ * @param[in]  xc   xml child node, added or removed
+ */
+static void
+xml_child_changed(cxobj *xp,
+                  cxobj *xc)
+{
+    xml_sortkey_reset(xp);
+    if (xml_type(xc) == CX_BODY){
+        if (xp->x_cv != NULL){
+            cv_free(xp->x_cv);
+            xp->x_cv = NULL;
+        }
+        xml_sortkey_reset(xp->x_up);
+    }
 }
 
 /*! Set value of xml node, value is copied
  *
+ * Short values are stored inline in the node, longer in a malloced string
  * @param[in]  xn    xml node
  * @param[in]  val   new value, null-terminated string, copied by function
  * @retval     0     OK
@@ -663,8 +1090,11 @@ int
 xml_value_set(cxobj *xn,
               char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          sz;
+    char            buf[XML_VALUE_INLINE_LEN];
+    char           *str;
 
     if (!is_bodyattr(xn))
         return 0;
@@ -672,16 +1102,35 @@ xml_value_set(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
+    xb = XML_BODY(xn);
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_value(xn->x_up, 0) < 0)
+        goto done;
+#endif
     sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
+    /* val may point into old value, copy before freeing it */
+    if (sz <= XML_VALUE_INLINE_LEN){
+        memcpy(buf, val, sz);
+        xml_value_free(xb);
+        memcpy(xb->xb_value.xv_inline, buf, sz);
+        xb->xb_value_mode = XML_VALUE_INLINE;
+    }
+    else {
+        if ((str = malloc(sz)) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
             goto done;
         }
+        memcpy(str, val, sz);
+        xml_value_free(xb);
+        xb->xb_value.xv_str = str;
+        xb->xb_value_mode = XML_VALUE_STR;
     }
-    else
-        cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+    xml_value_changed(xn);
+    xml_digest_reset(xn);
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_value(xn->x_up, 1) < 0)
+        goto done;
+#endif
     retval = 0;
  done:
     return retval;
@@ -689,17 +1138,21 @@ xml_value_set(cxobj *xn,
 
 /*! Append value of xnode, value is copied
  *
+ * Value is converted to a cbuf unless it fits inline
  * @param[in]  xn    xml node
  * @param[in]  val   appended value, null-terminated string, copied by function
- * @retval     new value
- * @retval     NULL  on error with clicon-err set, or if value is set to NULL
+ * @retval     0     OK
+ * @retval    -1     On error with clicon-err set
  */
 int
 xml_value_append(cxobj *xn,
                  char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          len0;
+    size_t          sz;
+    cbuf           *cb;
 
     if (!is_bodyattr(xn))
         return 0;
@@ -707,17 +1160,39 @@ xml_value_append(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
+    xb = XML_BODY(xn);
+    if (xb->xb_value_mode == XML_VALUE_NONE)
+        return xml_value_set(xn, val);
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_value(xn->x_up, 0) < 0)
+        goto done;
+#endif
     sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
+    if (xb->xb_value_mode == XML_VALUE_INLINE &&
+        (len0 = strlen(xb->xb_value.xv_inline)) + sz <= XML_VALUE_INLINE_LEN)
+        memmove(xb->xb_value.xv_inline + len0, val, sz);
+    else {
+        if (xb->xb_value_mode != XML_VALUE_CB){
+            if ((cb = cbuf_new_alloc(strlen(xml_value(xn)) + sz)) == NULL){
+                clixon_err(OE_XML, errno, "cbuf_new");
+                goto done;
+            }
+            cbuf_append_str(cb, xml_value(xn));
+            xml_value_free(xb);
+            xb->xb_value.xv_cb = cb;
+            xb->xb_value_mode = XML_VALUE_CB;
+        }
+        if (cbuf_append_str(xb->xb_value.xv_cb, val) < 0){
+            clixon_err(OE_XML, errno, "cprintf");
             goto done;
         }
     }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-        clixon_err(OE_XML, errno, "cprintf");
+    xml_value_changed(xn);
+    xml_digest_reset(xn);
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_value(xn->x_up, 1) < 0)
         goto done;
-    }
+#endif
     retval = 0;
  done:
     return retval;
@@ -737,6 +1212,33 @@ xml_type(cxobj *xn)
     return xn->x_type;
 }
 
+/*! Update typed child counts of parent when a child is added or removed
+ *
+ * @param[in]  xp    Parent XML element
+ * @param[in]  type  Type of child
+ * @param[in]  delta 1 if added, -1 if removed
+ * @see xml_child_nr_type
+ */
+static void
+xml_childvec_count(cxobj          *xp,
+                   enum cxobj_type type,
+                   int             delta)
+{
+    switch (type){
+    case CX_ELMNT:
+        xp->x_childvec_elmnt += delta;
+        break;
+    case CX_ATTR:
+        xp->x_childvec_attr += delta;
+        break;
+    case CX_BODY:
+        xp->x_childvec_body += delta;
+        break;
+    default:
+        break;
+    }
+}
+
 /*! Set type of xnode
  *
  * @param[in]  xn    xml node
@@ -750,6 +1252,10 @@ xml_type_set(cxobj          *xn,
     enum cxobj_type old = xn->x_type;
 
     xn->x_type = type;
+    if (old != type && xn->x_up){
+        xml_childvec_count(xn->x_up, old, -1);
+        xml_childvec_count(xn->x_up, type, 1);
+    }
     return old;
 }
 
@@ -768,6 +1274,7 @@ xml_child_nr(cxobj *xn)
     }
     if (!is_element(xn))
         return 0;
+    XML_LAZY_ACCESS(xn);
     return xn->x_childvec_len;
 }
 
@@ -783,16 +1290,11 @@ int
 xml_child_nr_notype(cxobj          *xn,
                     enum cxobj_type type)
 {
-    cxobj *x = NULL;
-    int    nr = 0;
-
     if (!is_element(xn))
         return 0;
-    while ((x = xml_child_each(xn, x, -1)) != NULL) {
-        if (xml_type(x) != type)
-            nr++;
-    }
-    return nr;
+    if (type == CX_ERROR)
+        return xml_child_nr_type(xn, CX_ERROR);
+    return xml_child_nr_type(xn, CX_ERROR) - xml_child_nr_type(xn, type);
 }
 
 /*! Get number of children of specific type
@@ -807,14 +1309,21 @@ int
 xml_child_nr_type(cxobj          *xn,
                   enum cxobj_type type)
 {
-    cxobj *x = NULL;
-    int    len = 0;
-
     if (!is_element(xn))
         return 0;
-    while ((x = xml_child_each(xn, x, type)) != NULL)
-        len++;
-    return len;
+    if (type != CX_ATTR)
+        XML_LAZY_ACCESS(xn);
+    switch (type){
+    case CX_ELMNT:
+        return xn->x_childvec_elmnt;
+    case CX_ATTR:
+        return xn->x_childvec_attr;
+    case CX_BODY:
+        return xn->x_childvec_body;
+    default:
+        break;
+    }
+    return xn->x_childvec_elmnt + xn->x_childvec_attr + xn->x_childvec_body;
 }
 
 /*! Get a specific child
@@ -835,6 +1344,7 @@ xml_child_i(cxobj *xn,
     }
     if (!is_element(xn))
         return NULL;
+    XML_LAZY_ACCESS(xn);
     if (i < xn->x_childvec_len)
         return xn->x_childvec[i];
     return NULL;
@@ -858,6 +1368,8 @@ xml_child_i_type(cxobj          *xn,
 
     if (!is_element(xn))
         return NULL;
+    if (type == CX_ELMNT && xml_child_nr_type(xn, CX_ELMNT) == xn->x_childvec_len)
+        return xml_child_i(xn, i); /* Only elements */
     while ((x = xml_child_each(xn, x, type)) != NULL) {
         if (x->x_type == type && (i == it++))
             return x;
@@ -879,8 +1391,14 @@ xml_child_i_set(cxobj *xt,
 {
     if (!is_element(xt))
         return NULL;
-    if (i < xt->x_childvec_len)
+    if (i < xt->x_childvec_len){
+        if (xt->x_childvec[i])
+            xml_childvec_count(xt, xml_type(xt->x_childvec[i]), -1);
         xt->x_childvec[i] = xc;
+        if (xc)
+            xml_childvec_count(xt, xml_type(xc), 1);
+        xml_digest_reset(xt);
+    }
     return 0;
 }
 
@@ -965,6 +1483,20 @@ xml_child_each(cxobj           *xparent,
         return NULL;
     if (!is_element(xparent))
         return NULL;
+    if (type != CX_ATTR)
+        XML_LAZY_ACCESS(xparent);
+    if (type == CX_ELMNT){
+        if (xparent->x_childvec_elmnt == 0)
+            return NULL;
+        if (xparent->x_childvec_elmnt == xparent->x_childvec_len){ /* Only elements */
+            i = xprev?xprev->_x_vector_i+1:0;
+            if (i >= xparent->x_childvec_len)
+                return NULL;
+            xn = xparent->x_childvec[i];
+            xn->_x_vector_i = i;
+            return xn;
+        }
+    }
     for (i=xprev?xprev->_x_vector_i+1:0; i<xparent->x_childvec_len; i++){
         xn = xparent->x_childvec[i];
         if (xn == NULL)
@@ -1032,6 +1564,13 @@ xml_child_append(cxobj *xp,
 
     if (!is_element(xp))
         return 0;
+    if (XML_LAZY_PENDING(xp) && xml_lazy_load(xp) < 0)
+        return -1;
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_type(xc) == CX_BODY && xml_value(xc) &&
+        xml_search_index_value(xp, 0) < 0)
+        return -1;
+#endif
     start = XML_CHILDVEC_SIZE_START;
     /* Heurestics: if child is body only single child is expected, but element children may
      * have siblings
@@ -1051,6 +1590,19 @@ xml_child_append(cxobj *xp,
         }
     }
     xp->x_childvec[xp->x_childvec_len-1] = xc;
+    xml_childvec_count(xp, xml_type(xc), 1);
+    xml_digest_reset(xp);
+    xml_child_changed(xp, xc);
+#ifdef XML_EXPLICIT_INDEX
+    /* Re-insert list entry with new index value */
+    if (xml_type(xc) == CX_BODY && xml_value(xc) &&
+        xml_search_index_value(xp, 1) < 0)
+        return -1;
+    if (xml_search_index_child(xp, xc, 1) < 0)
+        return -1;
+#endif
+    if (xml_descendant_index_child(xp, xc, 1) < 0)
+        return -1;
     return 0;
 }
 
@@ -1073,6 +1625,13 @@ xml_child_insert_pos(cxobj *xp,
 
     if (!is_element(xp))
         return 0;
+    if (XML_LAZY_PENDING(xp) && xml_lazy_load(xp) < 0)
+        return -1;
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_type(xc) == CX_BODY && xml_value(xc) &&
+        xml_search_index_value(xp, 0) < 0)
+        return -1;
+#endif
     xp->x_childvec_len++;
     if (xp->x_childvec_len > xp->x_childvec_max){
         if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
@@ -1088,6 +1647,19 @@ xml_child_insert_pos(cxobj *xp,
     size = (xml_child_nr(xp) - pos - 1)*sizeof(cxobj *);
     memmove(&xp->x_childvec[pos+1], &xp->x_childvec[pos], size);
     xp->x_childvec[pos] = xc;
+    xml_childvec_count(xp, xml_type(xc), 1);
+    xml_digest_reset(xp);
+    xml_child_changed(xp, xc);
+#ifdef XML_EXPLICIT_INDEX
+    /* Re-insert list entry with new index value */
+    if (xml_type(xc) == CX_BODY && xml_value(xc) &&
+        xml_search_index_value(xp, 1) < 0)
+        return -1;
+    if (xml_search_index_child(xp, xc, 1) < 0)
+        return -1;
+#endif
+    if (xml_descendant_index_child(xp, xc, 1) < 0)
+        return -1;
     return 0;
 }
 
@@ -1105,8 +1677,10 @@ xml_childvec_set(cxobj *x,
 {
     if (!is_element(x))
         return 0;
+    xml_digest_reset(x);
     x->x_childvec_len = len;
     x->x_childvec_max = len;
+    x->x_childvec_elmnt = x->x_childvec_attr = x->x_childvec_body = 0;
     if (x->x_childvec)
         free(x->x_childvec);
     if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
@@ -1123,6 +1697,7 @@ xml_childvec_get(cxobj *x)
 {
     if (!is_element(x))
         return NULL;
+    XML_LAZY_ACCESS(x);
     return x->x_childvec;
 }
 
@@ -1176,24 +1751,38 @@ xml_new(char           *name,
 {
     struct xml *x = NULL;
     size_t      sz;
+#ifdef XML_SLAB
+    struct xml_slab_pool *sp;
+#endif
 
     switch (type){
     case CX_ELMNT:
         sz = sizeof(struct xml);
+#ifdef XML_SLAB
+        sp = &_xml_slab_elmnt;
+#endif
         break;
     case CX_ATTR:
     case CX_BODY:
         sz = sizeof(struct xmlbody);
+#ifdef XML_SLAB
+        sp = &_xml_slab_body;
+#endif
         break;
     default:
         clixon_err(OE_XML, EINVAL, "Invalid type: %d", type);
         return NULL;
         break;
     }
+#ifdef XML_SLAB
+    if ((x = xml_slab_alloc(sp, sz)) == NULL)
+        return NULL;
+#else
     if ((x = malloc(sz)) == NULL){
         clixon_err(OE_XML, errno, "malloc");
         return NULL;
     }
+#endif
     memset(x, 0, sz);
     xml_type_set(x, type);
     if (name && (xml_name_set(x, name)) < 0)
@@ -1263,6 +1852,21 @@ xml_spec_set(cxobj     *x,
 {
     if (!is_element(x))
         return 0;
+    if (x->x_spec != spec){
+        xml_sortkey_reset(x);
+        xml_sortkey_reset(x->x_up);
+    }
+#ifdef XML_EXPLICIT_INDEX
+    /* Index membership depends on yang spec, move from old to new */
+    if (x->x_up && x->x_spec != spec){
+        if (xml_search_index_child(x->x_up, x, 0) < 0)
+            return -1;
+        x->x_spec = spec;
+        if (xml_search_index_child(x->x_up, x, 1) < 0)
+            return -1;
+        return 0;
+    }
+#endif
     x->x_spec = spec;
     return 0;
 }
@@ -1305,6 +1909,45 @@ xml_cv_set(cxobj  *x,
     return 0;
 }
 
+/*! Return cached sort key of list or leaf-list entry
+ *
+ * @param[in]  x    XML node
+ * @retval     sk   Sort key
+ * @retval     NULL Not computed or changed since computed
+ * Only accessed by xml_cmp
+ * @see xml_sortkey_cache
+ */
+struct xml_sortkey *
+xml_sortkey(cxobj *x)
+{
+    if (!is_element(x))
+        return NULL;
+    return x->x_sortkey;
+}
+
+/*! Set cached sort key of list or leaf-list entry
+ *
+ * @param[in]  x    XML node
+ * @param[in]  sk   Malloced sort key, consumed by the function
+ * @retval     0    OK
+ * The key is cleared when a child, a key value or the yang spec changes
+ * @see xml_sortkey_cache
+ */
+int
+xml_sortkey_set(cxobj              *x,
+                struct xml_sortkey *sk)
+{
+    if (!is_element(x)){
+        if (sk)
+            free(sk);
+        return 0;
+    }
+    if (x->x_sortkey)
+        free(x->x_sortkey);
+    x->x_sortkey = sk;
+    return 0;
+}
+
 /*! Find an XML node matching name among a parent's children.
  *
  * Get first XML node directly under x_up in the xml hierarchy with
@@ -1318,7 +1961,7 @@ xml_cv_set(cxobj  *x,
  * There are several issues with this function:
  * @note (1) Ignores prefix which means namespaces are ignored
  * @note (2) Does not differentiate between element,attributes and body. You usually want elements.
- * @note (3) Linear scalability and relies on strcmp, does not use search/key indexes
+ * @note (3) Linear scalability, does not use search/key indexes
  * @note (4) Only returns first match, eg a list/leaf-list may have several children with same name
  * @see xml_find_type  A more generic function fixes (1) and (2) above
  */
@@ -1333,8 +1976,34 @@ xml_find(cxobj *xp,
     }
     if (!is_element(xp))
         return NULL;
+    /* XML names are interned: a name not interned matches no node */
+    if ((name = clixon_string_interned(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xp, x, -1)) != NULL)
-        if (strcmp(name, xml_name(x)) == 0)
+        if (name == xml_name(x))
+            break; /* x is set */
+    return x;
+}
+
+/*! Find an XML node matching an interned name among a parent's children.
+ *
+ * As xml_find but name is already interned, and is compared by pointer only
+ * @param[in]  xp    Base XML object
+ * @param[in]  iname Interned node name, see clixon_string_interned
+ * @retval     xmlobj  if found.
+ * @retval     NULL    if no such node found.
+ * @see xml_find
+ */
+cxobj *
+xml_find_interned(cxobj *xp,
+                  char  *iname)
+{
+    cxobj *x = NULL;
+
+    if (xp == NULL || iname == NULL || !is_element(xp))
+        return NULL;
+    while ((x = xml_child_each(xp, x, -1)) != NULL)
+        if (iname == xml_name(x))
             break; /* x is set */
     return x;
 }
@@ -1392,10 +2061,6 @@ xml_addsub(cxobj *xp,
         }
         /* clear namespace context cache of child */
         nscache_clear(xc);
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xc))
-            xml_search_child_insert(xp, xc);
-#endif
     }
     retval = 0;
  done:
@@ -1420,6 +2085,7 @@ xml_wrap_all(cxobj *xp,
 
     if (!is_element(xp))
         return NULL;
+    XML_LAZY_ACCESS(xp);
     if ((xw = xml_new(tag, NULL, CX_ELMNT)) == NULL)
         goto done;
     while (xp->x_childvec_len)
@@ -1515,17 +2181,29 @@ xml_child_rm(cxobj *xp,
         clixon_err(OE_XML, 0, "Child not found");
         goto done;
     }
+#ifdef XML_EXPLICIT_INDEX
+    /* Remove before the index value is gone */
+    if (xml_type(xc) == CX_BODY){
+        if (xml_value(xc) && xml_search_index_value(xp, 0) < 0)
+            goto done;
+    }
+    else if (xml_search_index_child(xp, xc, 0) < 0)
+        goto done;
+#endif
+    if (xml_descendant_index_child(xp, xc, 0) < 0)
+        goto done;
     xml_parent_set(xc, NULL);
     xp->x_childvec[i] = NULL;
     xp->x_childvec_len--;
+    xml_childvec_count(xp, xml_type(xc), -1);
     if (i<xp->x_childvec_len)
         memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
+    xml_digest_reset(xp);
+    xml_child_changed(xp, xc);
 #ifdef XML_EXPLICIT_INDEX
-    if (xml_type(xc) == CX_ELMNT){
-        if (xml_search_index_p(xc))
-            xml_search_child_rm(xp, xc);
-
-    }
+    if (xml_type(xc) == CX_BODY && xml_value(xc) &&
+        xml_search_index_value(xp, 1) < 0)
+        goto done;
 #endif
     retval = 0;
  done:
@@ -1962,11 +2640,17 @@ xml_free0(cxobj *x)
     if (x == NULL)
         return 0;
     if (x->x_name)
-        free(x->x_name);
+        clixon_string_unintern(x->x_name);
     if (x->x_prefix)
-        free(x->x_prefix);
+        clixon_string_unintern(x->x_prefix);
     switch (xml_type(x)){
     case CX_ELMNT:
+        if ((x->x_flags & XML_FLAG_LAZY_LOADED) && _xml_lazy_freefn)
+            (*_xml_lazy_freefn)(x, _xml_lazy_arg);
+        if (x == _xml_lazy_last)
+            _xml_lazy_last = NULL;
+        if (x->x_up == NULL)
+            xml_descendant_index_free(x);
         sz = sizeof(struct xml);
         for (i=0; i<x->x_childvec_len; i++){
             if ((xc = x->x_childvec[i]) != NULL){
@@ -1978,6 +2662,10 @@ xml_free0(cxobj *x)
             free(x->x_childvec);
         if (x->x_cv)
             cv_free(x->x_cv);
+        if (x->x_sortkey)
+            free(x->x_sortkey);
+        if (x->x_digest)
+            free(x->x_digest);
         if (x->x_ns_cache)
             xml_nsctx_free(x->x_ns_cache);
 #ifdef XML_EXPLICIT_INDEX
@@ -1987,8 +2675,7 @@ xml_free0(cxobj *x)
     case CX_BODY:
     case CX_ATTR:
         sz = sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            cbuf_free(x->x_value_cb);
+        xml_value_free(XML_BODY(x));
         break;
     default:
         break;
@@ -2009,11 +2696,192 @@ xml_free(cxobj *x)
     if (x == NULL)
         return 0;
     xml_free0(x);
+#ifdef XML_SLAB
+    xml_slab_free(x);
+#else
     free(x);
+#endif
     _stats_xml_nr--;
     return 0;
 }
 
+/*! Append a string to digest input, with length so that adjacent strings are not ambiguous
+ *
+ * @param[in]  cb   Digest input buffer
+ * @param[in]  str  String, or NULL
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_digest_str(cbuf *cb,
+               char *str)
+{
+    uint64_t len;
+
+    len = str ? strlen(str) : UINT64_MAX;
+    if (cbuf_append_buf(cb, &len, sizeof(len)) < 0)
+        return -1;
+    if (str && cbuf_append_buf(cb, str, len) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Get subtree digest of an XML element, compute it if not cached
+ *
+ * The digest is a SHA-256 over name, prefix, attributes, bodies and child element
+ * digests in order, not yang binding or flags. Two subtrees with the same digest are
+ * considered equal, see xml_diff.
+ * The digest is cached in the node and reset on the modified node and its ancestors
+ * by all functions that modify the tree, so that only the modified path is recomputed.
+ * @param[in]  x       XML element
+ * @retval     digest  CLIXON_DIGEST_LEN bytes. Do not free
+ * @retval     NULL    Not an element, or error
+ * @note Lazy nodes are loaded, see xml_lazy_load
+ * @see xml_digest_cached  Get digest only if cached, eg on read-only paths
+ */
+const uint8_t *
+xml_digest(cxobj *x)
+{
+    cbuf          *cb = NULL;
+    uint8_t       *md = NULL;
+    const uint8_t *d;
+    cxobj         *xc;
+    uint8_t        t;
+
+    if (x == NULL || !is_element(x))
+        return NULL;
+    XML_LAZY_ACCESS(x);
+    if (x->x_digest)
+        return x->x_digest;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (xml_digest_str(cb, x->x_name) < 0 ||
+        xml_digest_str(cb, x->x_prefix) < 0)
+        goto done;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+        t = xml_type(xc);
+        if (cbuf_append_buf(cb, &t, sizeof(t)) < 0)
+            goto done;
+        switch (t){
+        case CX_ELMNT:
+            if ((d = xml_digest(xc)) == NULL ||
+                cbuf_append_buf(cb, (void *)d, CLIXON_DIGEST_LEN) < 0)
+                goto done;
+            break;
+        case CX_ATTR:
+            if (xml_digest_str(cb, xml_name(xc)) < 0 ||
+                xml_digest_str(cb, xml_prefix(xc)) < 0 ||
+                xml_digest_str(cb, xml_value(xc)) < 0)
+                goto done;
+            break;
+        default:
+            if (xml_digest_str(cb, xml_value(xc)) < 0)
+                goto done;
+            break;
+        }
+    }
+    if ((md = malloc(CLIXON_DIGEST_LEN)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    if (clixon_digest_sha256(cbuf_get(cb), cbuf_len(cb), md) < 0)
+        goto done;
+    x->x_digest = md;
+    md = NULL;
+ done:
+    if (md)
+        free(md);
+    if (cb)
+        cbuf_free(cb);
+    return x->x_digest;
+}
+
+/*! Get subtree digest of an XML element only if it is cached
+ *
+ * @param[in]  x       XML element
+ * @retval     digest  CLIXON_DIGEST_LEN bytes. Do not free
+ * @retval     NULL    Not computed since last change, or not an element
+ * @see xml_digest
+ */
+const uint8_t *
+xml_digest_cached(cxobj *x)
+{
+    if (x == NULL || !is_element(x))
+        return NULL;
+    return x->x_digest;
+}
+
+/*! Two XML elements have cached subtree digests that are equal
+ *
+ * Does not compute digests, and may be used on read-only paths
+ * @param[in]  x0  XML element
+ * @param[in]  x1  XML element
+ * @retval     1   Both digests cached and equal: subtrees are equal
+ * @retval     0   Not equal, or not known
+ * @see xml_digest
+ */
+int
+xml_digest_equal(cxobj *x0,
+                 cxobj *x1)
+{
+    const uint8_t *d0;
+    const uint8_t *d1;
+
+    if ((d0 = xml_digest_cached(x0)) == NULL ||
+        (d1 = xml_digest_cached(x1)) == NULL)
+        return 0;
+    return memcmp(d0, d1, CLIXON_DIGEST_LEN) == 0;
+}
+
+/*! Reset cached digest of an XML node and its ancestors after modification
+ *
+ * Stop at first node whose digest is not cached, since a digest is only computed
+ * together with the digests of all its descendants, its ancestors are not cached either.
+ * @param[in]  x   XML node, if not an element, start with its parent
+ */
+void
+xml_digest_reset(cxobj *x)
+{
+    if (x && !is_element(x))
+        x = x->x_up;
+    while (x && x->x_digest){
+        free(x->x_digest);
+        x->x_digest = NULL;
+        x = x->x_up;
+    }
+}
+
+/*! Copy cached digest after a recursive copy if the copy is equal to the original
+ *
+ * @param[in]  x0  Original XML node
+ * @param[in]  x1  Copy, all child elements copied and their digests set
+ * @see xml_copy
+ */
+static void
+xml_digest_copy(cxobj *x0,
+                cxobj *x1)
+{
+    cxobj *xc;
+
+    if (!is_element(x0) || !is_element(x1) || x0->x_digest == NULL || x1->x_digest != NULL)
+        return;
+    /* x1 may have had children or another prefix before copy */
+    if (x1->x_childvec_len != x0->x_childvec_len ||
+        clicon_strcmp(x1->x_name, x0->x_name) != 0 ||
+        clicon_strcmp(x1->x_prefix, x0->x_prefix) != 0)
+        return;
+    xc = NULL;
+    while ((xc = xml_child_each(x1, xc, CX_ELMNT)) != NULL)
+        if (xc->x_digest == NULL)
+            return;
+    if ((x1->x_digest = malloc(CLIXON_DIGEST_LEN)) == NULL)
+        return; /* Not cached */
+    memcpy(x1->x_digest, x0->x_digest, CLIXON_DIGEST_LEN);
+}
+
 /*! Copy single xml node from x0 to x1 without copying children
  *
  * @param[in]  x0  Source XML tree
@@ -2032,6 +2900,9 @@ xml_copy_one(cxobj *x0,
         clixon_err(OE_XML, EINVAL, "x0 or x1 is NULL");
         goto done;
     }
+    /* Load before copying flags */
+    if (is_element(x0) && XML_LAZY_PENDING(x0) && xml_lazy_load(x0) < 0)
+        goto done;
     xml_type_set(x1, xml_type(x0));
     if ((s = xml_name(x0))) /* malloced string */
         if ((xml_name_set(x1, s)) < 0)
@@ -2054,7 +2925,7 @@ xml_copy_one(cxobj *x0,
     default:
         break;
     }
-    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY)); /* Maybe more flags */
+    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY | XML_FLAG_EDITED | XML_FLAG_LAZY)); /* Maybe more flags */
     retval = 0;
  done:
     return retval;
@@ -2092,6 +2963,7 @@ xml_copy(cxobj *x0,
         if (xml_copy(x, xcopy) < 0) /* recursion */
             goto done;
     }
+    xml_digest_copy(x0, x1);
     retval = 0;
   done:
     return retval;
@@ -2515,6 +3387,32 @@ xml_add_attr(cxobj *xn,
 }
 
 #ifdef XML_EXPLICIT_INDEX
+/*! Get the XML node where a search index of an index variable is stored
+ *
+ * @param[in] xl  XML list entry, parent of xi
+ * @param[in] xi  XML index variable
+ * @retval    xpp Grand-parent of xi, where search vector is placed
+ * @retval    NULL xi is not a search index
+ */
+static cxobj *
+xml_search_index_xpp(cxobj *xl,
+                     cxobj *xi)
+{
+    yang_stmt *y;
+
+    /* The index variable has a yang spec and is a registered search index */
+    if ((y = xi->x_spec) == NULL ||
+        yang_flag_get(y, YANG_FLAG_INDEX) == 0)
+        return NULL;
+    /* The index variable has a parent which has a LIST yang spec  */
+    if (xl == NULL ||
+        (y = xl->x_spec) == NULL ||
+        yang_keyword_get(y) != Y_LIST)
+        return NULL;
+    /* The index variable has a grand-parent */
+    return xl->x_up;
+}
+
 /*! Is this XML object a search index, ie it is registered as a yang clixon cc:search_index
  *
  * Is this xml node a search index and does it have a parent that is a list and a grandparent 
@@ -2526,26 +3424,9 @@ xml_add_attr(cxobj *xn,
 int
 xml_search_index_p(cxobj *x)
 {
-    yang_stmt *y;
-    cxobj     *xp;
-
-    /* The index variable has a yang spec */
-    if ((y = xml_spec(x)) == NULL)
-        return 0;
-    /* The index variable is a registered search index */
-    if (yang_flag_get(y, YANG_FLAG_INDEX) == 0)
-        return 0;
-    /* The index variable has a parent which has a LIST yang spec  */
-    if ((xp = xml_parent(x)) == NULL)
-        return 0;
-    if ((y = xml_spec(xp)) == NULL)
-        return 0;
-    if (yang_keyword_get(y) != Y_LIST)
-        return 0;
-    /* The index variable has a grand-parent */
-    if (xml_parent(xp) == NULL)
+    if (!is_element(x))
         return 0;
-    return 1;
+    return xml_search_index_xpp(xml_parent(x), x) != NULL;
 }
 
 /*! Free all search vector pairs of this XML node
@@ -2660,46 +3541,218 @@ xml_search_vector_get(cxobj        *xp,
     return 0;
 }
 
-/*! Insert a new cxobj into search index vector for list for variable "name"
+/*! Insert list entry into search index vector of variable "indexvar" in grandparent
  *
- * @param[in] xp  XML parent object (the list element)
- * @param[in] xi  XML index object (that should be added)
- * @retval    0   OK
- * @retval   -1   Error
+ * @param[in] xpp       XML grandparent object where the vector is stored
+ * @param[in] xl        XML list entry
+ * @param[in] indexvar  Name of index variable
+ * @retval    0         OK
+ * @retval   -1         Error
  */
-int
-xml_search_child_insert(cxobj *xp,
-                        cxobj *xi)
+static int
+xml_search_index_insert(cxobj *xpp,
+                        cxobj *xl,
+                        char  *indexvar)
 {
     int                  retval = -1;
-    char                *indexvar;
     struct search_index *si;
-    cxobj               *xpp;
     int                  i;
     int                  len;
 
-    indexvar = xml_name(xi);
-    if ((xpp = xml_parent(xp)) == NULL)
-        goto ok;
     /* Find base vector in grandparent */
     if ((si = xml_search_index_get(xpp, indexvar)) == NULL){
         /* If not found add base vector in grand-parent */
         if ((si = xml_search_index_add(xpp, indexvar)) == NULL)
             goto done;
     }
-    /* Find element position using binary search and then remove */
+    /* Find element position using binary search and then insert */
     len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, NULL)) < 0)
+    if ((i = xml_search_indexvar_binary_pos(xl, indexvar, si->si_xvec, 0, len, len, NULL)) < 0)
+        goto done;
+    if (clixon_xvec_insert_pos(si->si_xvec, xl, i) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find position of list entry in search index vector using binary search
+ *
+ * Binary search finds an entry with equal index value, then the range of equal entries
+ * is scanned for xl.
+ * @param[in] si  Search index
+ * @param[in] xl  XML list entry
+ * @retval    i   Position of xl in index vector
+ * @retval   -1   Not found (or error)
+ */
+static int
+xml_search_index_pos(struct search_index *si,
+                     cxobj               *xl)
+{
+    clixon_xvec *xv = si->si_xvec;
+    cxobj       *xc;
+    int          len;
+    int          i;
+    int          j;
+    int          eq = 0;
+
+    if ((len = clixon_xvec_len(xv)) == 0)
+        return -1;
+    if ((i = xml_search_indexvar_binary_pos(xl, si->si_name, xv, 0, len, len, &eq)) < 0)
+        return -1;
+    if (!eq)
+        return -1;
+    for (j=i; j>=0; j--){
+        if ((xc = clixon_xvec_i(xv, j)) == xl)
+            return j;
+        if (xml_cmp(xl, xc, 0, 0, si->si_name) != 0)
+            break;
+    }
+    for (j=i+1; j<len; j++){
+        if ((xc = clixon_xvec_i(xv, j)) == xl)
+            return j;
+        if (xml_cmp(xl, xc, 0, 0, si->si_name) != 0)
+            break;
+    }
+    return -1;
+}
+
+/*! Remove list entry from search index vector of variable "indexvar" in grandparent
+ *
+ * If xl is not found using its index value, the vector is scanned linearly as a fallback.
+ * @param[in] xpp       XML grandparent object where the vector is stored
+ * @param[in] xl        XML list entry
+ * @param[in] indexvar  Name of index variable
+ * @retval    0         OK
+ * @retval   -1         Error
+ */
+static int
+xml_search_index_rm(cxobj *xpp,
+                    cxobj *xl,
+                    char  *indexvar)
+{
+    int                  retval = -1;
+    struct search_index *si;
+    int                  i;
+    int                  len;
+
+    if ((si = xml_search_index_get(xpp, indexvar)) == NULL)
+        goto ok;
+    if ((i = xml_search_index_pos(si, xl)) < 0){
+        len = clixon_xvec_len(si->si_xvec);
+        for (i=0; i<len; i++)
+            if (clixon_xvec_i(si->si_xvec, i) == xl)
+                break;
+        if (i == len)
+            goto ok;
+    }
+    if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
         goto done;
-    assert(clixon_xvec_i(si->si_xvec, i) != xp);
-    if (clixon_xvec_insert_pos(si->si_xvec, xp, i) < 0)
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Update search indexes when an element is added to or removed from its parent
+ *
+ * Either xc is an index variable and xp its list entry, or xc is a list entry with index
+ * variables and xp its parent where the vectors are stored.
+ * Called after xc is added and before it is removed
+ * @param[in] xp   XML parent
+ * @param[in] xc   XML child element
+ * @param[in] add  1: xc is added, 0: xc is removed
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+static int
+xml_search_index_child(cxobj *xp,
+                       cxobj *xc,
+                       int    add)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cxobj     *xpp;
+    cxobj     *xi;
+    int        i;
+
+    if (!is_element(xc) || (y = xc->x_spec) == NULL)
+        goto ok;
+    if (yang_flag_get(y, YANG_FLAG_INDEX)){
+        if ((xpp = xml_search_index_xpp(xp, xc)) == NULL)
+            goto ok;
+        if (add)
+            retval = xml_search_index_insert(xpp, xp, xml_name(xc));
+        else
+            retval = xml_search_index_rm(xpp, xp, xml_name(xc));
         goto done;
+    }
+    if (yang_keyword_get(y) != Y_LIST)
+        goto ok;
+    /* Direct access to not trigger lazy loading */
+    for (i=0; i<xc->x_childvec_len; i++){
+        xi = xc->x_childvec[i];
+        if (!is_element(xi) ||
+            xi->x_spec == NULL ||
+            yang_flag_get(xi->x_spec, YANG_FLAG_INDEX) == 0)
+            continue;
+        if (add){
+            if (xml_search_index_insert(xp, xc, xml_name(xi)) < 0)
+                goto done;
+        }
+        else if (xml_search_index_rm(xp, xc, xml_name(xi)) < 0)
+            goto done;
+    }
  ok:
     retval = 0;
  done:
     return retval;
 }
 
+/*! Update search index when the value of an index variable changes
+ *
+ * Call with add=0 before and add=1 after the body of xi changes
+ * @param[in] xi   XML index variable, parent of changed body (or NULL)
+ * @param[in] add  0: remove list entry before change, 1: re-insert after
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+static int
+xml_search_index_value(cxobj *xi,
+                       int    add)
+{
+    cxobj *xpp;
+
+    if (xi == NULL ||
+        !is_element(xi) ||
+        (xpp = xml_search_index_xpp(xi->x_up, xi)) == NULL)
+        return 0;
+    if (add)
+        return xml_search_index_insert(xpp, xi->x_up, xml_name(xi));
+    else
+        return xml_search_index_rm(xpp, xi->x_up, xml_name(xi));
+}
+
+/*! Insert a new cxobj into search index vector for list for variable "name"
+ *
+ * @param[in] xp  XML parent object (the list element)
+ * @param[in] xi  XML index object (that should be added)
+ * @retval    0   OK
+ * @retval   -1   Error
+ * @note Indexes are maintained when XML is modified, this is only needed if xp is not
+ *       already indexed
+ */
+int
+xml_search_child_insert(cxobj *xp,
+                        cxobj *xi)
+{
+    cxobj *xpp;
+
+    if ((xpp = xml_parent(xp)) == NULL)
+        return 0;
+    return xml_search_index_insert(xpp, xp, xml_name(xi));
+}
+
 /*! Remove a single cxobj from search vector 
  *
  * @param[in] xp    XML parent object (the list element)
@@ -2711,30 +3764,101 @@ int
 xml_search_child_rm(cxobj *xp,
                     cxobj *xi)
 {
-    int                 retval = -1;
-    cxobj              *xpp;
-    char               *indexvar;
-    int                 i;
-    int                 len;
-    struct search_index *si;
-    int                  eq = 0;
+    cxobj *xpp;
 
-    indexvar = xml_name(xi);
     if ((xpp = xml_parent(xp)) == NULL)
-        goto ok;
-    /* Find base vector in grandparent */
-    if ((si = xml_search_index_get(xpp, indexvar)) == NULL)
-        goto ok;
+        return 0;
+    return xml_search_index_rm(xpp, xp, xml_name(xi));
+}
 
-    /* Find element using binary search and then remove */
-    len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, &eq)) < 0)
+/*! Verify search index vectors of one XML node
+ *
+ * @param[in] xpp   XML node, parent of list entries
+ * @retval    0     OK
+ * @retval   -1    Inconsistent index vector, with clixon_err set
+ */
+static int
+xml_search_index_verify1(cxobj *xpp)
+{
+    int                  retval = -1;
+    struct search_index *si;
+    clixon_xvec         *xv;
+    cxobj               *xl;
+    cxobj               *xi;
+    cxobj               *xprev;
+    int                  n;
+    int                  i;
+
+    /* 1. Each index vector is sorted and contains list entries of xpp */
+    if ((si = xpp->x_search_index) != NULL) {
+        do {
+            xv = si->si_xvec;
+            xprev = NULL;
+            for (i=0; i<clixon_xvec_len(xv); i++){
+                xl = clixon_xvec_i(xv, i);
+                if (xml_parent(xl) != xpp ||
+                    (xi = xml_find_type(xl, NULL, si->si_name, CX_ELMNT)) == NULL ||
+                    xml_search_index_xpp(xl, xi) != xpp){
+                    clixon_err(OE_XML, 0, "Search index %s of %s: entry %d is not an indexed child",
+                               si->si_name, xml_name(xpp), i);
+                    goto done;
+                }
+                if (xprev && xml_cmp(xprev, xl, 0, 0, si->si_name) > 0){
+                    clixon_err(OE_XML, 0, "Search index %s of %s: entry %d is not sorted",
+                               si->si_name, xml_name(xpp), i);
+                    goto done;
+                }
+                xprev = xl;
+            }
+            si = NEXTQ(struct search_index *, si);
+        } while (si && si != xpp->x_search_index);
+    }
+    /* 2. Each indexed list entry is in the index vector */
+    for (n=0; n<xpp->x_childvec_len; n++){
+        xl = xpp->x_childvec[n];
+        if (!is_element(xl))
+            continue;
+        for (i=0; i<xl->x_childvec_len; i++){
+            xi = xl->x_childvec[i];
+            if (!is_element(xi) || xml_search_index_xpp(xl, xi) == NULL)
+                continue;
+            if ((si = xml_search_index_get(xpp, xml_name(xi))) == NULL ||
+                xml_search_index_pos(si, xl) < 0){
+                clixon_err(OE_XML, 0, "Search index %s of %s: %s entry %d is not indexed",
+                           xml_name(xi), xml_name(xpp), xml_name(xl), n);
+                goto done;
+            }
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Verify that all search index vectors of an XML tree are consistent
+ *
+ * Intended for tests and debugging. Each index vector should be sorted on its index variable
+ * and contain exactly the list entries that have the index variable.
+ * @param[in] xt    XML tree
+ * @retval    0     OK
+ * @retval   -1     Inconsistent index vector, or error, with clixon_err set
+ */
+int
+xml_search_index_verify(cxobj *xt)
+{
+    int    retval = -1;
+    cxobj *x;
+    int    i;
+
+    if (!is_element(xt))
+        return 0;
+    if (xml_search_index_verify1(xt) < 0)
         goto done;
-        //    if (clixon_xvec_i(si->si_xvec, i) == xp)
-    if (eq)
-        if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
+    for (i=0; i<xt->x_childvec_len; i++){
+        x = xt->x_childvec[i];
+        if (xml_search_index_verify(x) < 0)
             goto done;
- ok:
+    }
     retval = 0;
  done:
     return retval;
@@ -237,11 +237,8 @@ populate_self_parent(clixon_handle h,
         goto fail;
     }
  set:
-    xml_spec_set(xt, y);
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xt))
-        xml_search_child_insert(xp, xt);
-#endif
+    if (xml_spec_set(xt, y) < 0) /* Also updates explicit search indexes */
+        goto done;
     retval = 1;
  done:
     if (cb)
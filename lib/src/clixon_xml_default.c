@@ -115,6 +115,9 @@ xml_default_create1(yang_stmt *y,
     }
     if (xml_addsub(xt, xc) < 0)
         goto done;
+    /* Mark new node as edited, see xml_diff_edited */
+    xml_flag_set(xc, XML_FLAG_EDITED);
+    xml_apply_ancestor(xc, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_EDITED);
     *xcp = xc;
     xc = NULL;
     retval = 0;
@@ -311,6 +314,11 @@ xml_default(yang_stmt *yt,
         clixon_err(OE_XML, EINVAL, "No XML argument");
         goto done;
     }
+    /* Children of lazy node not loaded, defaults are set when loaded */
+    if (xml_flag(xt, XML_FLAG_LAZY)){
+        retval = 0;
+        goto done;
+    }
     switch (yang_keyword_get(yt)){
     case Y_MODULE:
     case Y_SUBMODULE:
@@ -438,6 +446,8 @@ xml_default_recurse(cxobj *xn,
     cxobj     *x;
     yang_stmt *y;
 
+    if (xml_flag(xn, XML_FLAG_LAZY)) /* Defaults are set when loaded */
+        goto skip;
     if (flag){
         if (xml_flag(xn, XML_FLAG_CHANGE) != 0)
             ; /* continue */
@@ -610,6 +620,11 @@ xml_default_nopresence(cxobj *xn,
     enum rfc_6020 keyw;
     int           config = 1;
 
+    /* Children of lazy node not loaded, it is not empty */
+    if (xml_flag(xn, XML_FLAG_LAZY)){
+        retval = 0;
+        goto done;
+    }
     if (flag){
         if (xml_flag(xn, XML_FLAG_CHANGE) != 0)
             ; /* continue */
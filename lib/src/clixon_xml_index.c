@@ -0,0 +1,606 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2025 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Descendant index of XML trees
+ * An indexed tree, typically a datastore cache, maps the local name of each element
+ * below the root to the set of element nodes with that name. The index is maintained
+ * when nodes are inserted, removed or renamed, see xml_descendant_index_child.
+ * XPath descendant steps, eg //name, use the index instead of scanning the whole
+ * subtree, see xml_descendant_index_find.
+ * Namespaces are not part of the index key: the caller makes the namespace test on the
+ * (few) nodes found.
+ * @see CLICON_XMLDB_DESCENDANT_INDEX
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <sys/types.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_err.h"
+#include "clixon_debug.h"
+#include "clixon_xml_index.h"
+
+/* Initial size of node set hash table, power of 2 */
+#define DESCENDANT_SET_SIZE_START 16
+
+/* Deleted slot in node set hash table */
+#define DESCENDANT_SET_DELETED ((cxobj *)1)
+
+/*! Set of element nodes with the same name
+ *
+ * Open addressing hash table of node pointers with linear probing
+ */
+struct descendant_set {
+    cxobj  **ds_vec;   /* Hash table, NULL is empty slot */
+    size_t   ds_size;  /* Size of hash table, power of 2 */
+    size_t   ds_len;   /* Number of nodes */
+    size_t   ds_used;  /* Number of nodes and deleted slots */
+};
+typedef struct descendant_set descendant_set;
+
+/*! Descendant index of one XML tree
+ */
+struct descendant_index {
+    qelem_t        di_qelem;  /* List of indexed trees */
+    cxobj         *di_xtop;   /* Root of indexed tree */
+    clicon_hash_t *di_names;  /* Local name -> descendant_set pointer */
+    uint64_t       di_nr;     /* Number of indexed nodes */
+};
+typedef struct descendant_index descendant_index;
+
+/* List of indexed trees, typically one per datastore cache */
+static descendant_index *_descendant_index_list = NULL;
+
+/*! Hash slot of node pointer
+ *
+ * @param[in]  x     XML node
+ * @param[in]  size  Size of hash table, power of 2
+ */
+static size_t
+descendant_set_slot(cxobj *x,
+                    size_t size)
+{
+    uint64_t h = (uint64_t)(uintptr_t)x;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h & (size - 1);
+}
+
+/*! Resize node set hash table and drop deleted slots
+ *
+ * @param[in]  ds    Node set
+ * @param[in]  size  New size, power of 2
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+descendant_set_resize(descendant_set *ds,
+                      size_t          size)
+{
+    cxobj **vec0 = ds->ds_vec;
+    size_t  size0 = ds->ds_size;
+    size_t  i;
+    size_t  j;
+
+    if ((ds->ds_vec = calloc(size, sizeof(cxobj *))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        ds->ds_vec = vec0;
+        return -1;
+    }
+    ds->ds_size = size;
+    for (i=0; i<size0; i++){
+        if (vec0[i] == NULL || vec0[i] == DESCENDANT_SET_DELETED)
+            continue;
+        j = descendant_set_slot(vec0[i], size);
+        while (ds->ds_vec[j] != NULL)
+            j = (j + 1) & (size - 1);
+        ds->ds_vec[j] = vec0[i];
+    }
+    ds->ds_used = ds->ds_len;
+    if (vec0)
+        free(vec0);
+    return 0;
+}
+
+/*! Add node to node set, if not already present
+ *
+ * @param[in]  ds    Node set
+ * @param[in]  x     XML node
+ * @retval     1     Added
+ * @retval     0     Already present
+ * @retval    -1     Error
+ */
+static int
+descendant_set_add(descendant_set *ds,
+                   cxobj          *x)
+{
+    size_t i;
+    size_t del = SIZE_MAX;
+
+    /* Keep load including deleted slots below 3/4 */
+    if (4*(ds->ds_used + 1) > 3*ds->ds_size){
+        if (descendant_set_resize(ds, ds->ds_size?2*ds->ds_size:DESCENDANT_SET_SIZE_START) < 0)
+            return -1;
+    }
+    i = descendant_set_slot(x, ds->ds_size);
+    while (ds->ds_vec[i] != NULL){
+        if (ds->ds_vec[i] == x)
+            return 0;
+        if (ds->ds_vec[i] == DESCENDANT_SET_DELETED && del == SIZE_MAX)
+            del = i;
+        i = (i + 1) & (ds->ds_size - 1);
+    }
+    if (del != SIZE_MAX)
+        i = del;
+    else
+        ds->ds_used++;
+    ds->ds_vec[i] = x;
+    ds->ds_len++;
+    return 1;
+}
+
+/*! Node set contains node
+ *
+ * @param[in]  ds    Node set
+ * @param[in]  x     XML node
+ * @retval     1     Present
+ * @retval     0     Not present
+ */
+static int
+descendant_set_has(descendant_set *ds,
+                   cxobj          *x)
+{
+    size_t i;
+
+    if (ds->ds_size == 0)
+        return 0;
+    i = descendant_set_slot(x, ds->ds_size);
+    while (ds->ds_vec[i] != NULL){
+        if (ds->ds_vec[i] == x)
+            return 1;
+        i = (i + 1) & (ds->ds_size - 1);
+    }
+    return 0;
+}
+
+/*! Remove node from node set, if present
+ *
+ * @param[in]  ds    Node set
+ * @param[in]  x     XML node
+ * @retval     1     Removed
+ * @retval     0     Not present
+ */
+static int
+descendant_set_rm(descendant_set *ds,
+                  cxobj          *x)
+{
+    size_t i;
+
+    if (ds->ds_size == 0)
+        return 0;
+    i = descendant_set_slot(x, ds->ds_size);
+    while (ds->ds_vec[i] != NULL){
+        if (ds->ds_vec[i] == x){
+            ds->ds_vec[i] = DESCENDANT_SET_DELETED;
+            ds->ds_len--;
+            return 1;
+        }
+        i = (i + 1) & (ds->ds_size - 1);
+    }
+    return 0;
+}
+
+/*! Get node set of name, optionally create it
+ *
+ * @param[in]  di     Descendant index
+ * @param[in]  name   Local name
+ * @param[in]  create Create node set if not found
+ * @param[out] dsp    Node set, NULL if not found and not created
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+descendant_index_set(descendant_index *di,
+                     const char       *name,
+                     int               create,
+                     descendant_set  **dsp)
+{
+    int             retval = -1;
+    descendant_set *ds = NULL;
+    void           *val;
+
+    if ((val = clicon_hash_value(di->di_names, name, NULL)) != NULL)
+        ds = *(descendant_set **)val;
+    else if (create){
+        if ((ds = malloc(sizeof(*ds))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(ds, 0, sizeof(*ds));
+        if (clicon_hash_add(di->di_names, name, &ds, sizeof(ds)) == NULL){
+            free(ds);
+            goto done;
+        }
+    }
+    *dsp = ds;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add or remove an XML subtree to/from a descendant index
+ *
+ * @param[in]  di   Descendant index
+ * @param[in]  x    XML element, root of subtree
+ * @param[in]  add  1: add, 0: remove
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+descendant_index_update(descendant_index *di,
+                        cxobj            *x,
+                        int               add)
+{
+    int             retval = -1;
+    descendant_set *ds = NULL;
+    cxobj          *xc;
+    int             ret;
+
+    if (add)
+        xml_flag_set(x, XML_FLAG_DESCINDEX);
+    else
+        xml_flag_reset(x, XML_FLAG_DESCINDEX);
+    if (xml_name(x) != NULL){
+        if (descendant_index_set(di, xml_name(x), add, &ds) < 0)
+            goto done;
+        if (ds != NULL){
+            if (add){
+                if ((ret = descendant_set_add(ds, x)) < 0)
+                    goto done;
+                di->di_nr += ret;
+            }
+            else
+                di->di_nr -= descendant_set_rm(ds, x);
+        }
+    }
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+        if (descendant_index_update(di, xc, add) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find descendant index of the tree that an XML node belongs to
+ *
+ * Nodes of indexed trees are flagged, the root is only searched for if x is flagged
+ * @param[in]  x    XML node
+ * @retval     di   Descendant index
+ * @retval     NULL Tree is not indexed
+ */
+static descendant_index *
+descendant_index_get(cxobj *x)
+{
+    descendant_index *di;
+
+    if ((di = _descendant_index_list) == NULL ||
+        xml_flag(x, XML_FLAG_DESCINDEX) == 0)
+        return NULL;
+    while (xml_parent(x) != NULL)
+        x = xml_parent(x);
+    do {
+        if (di->di_xtop == x)
+            return di;
+        di = NEXTQ(descendant_index *, di);
+    } while (di && di != _descendant_index_list);
+    return NULL;
+}
+
+/*! Free descendant index, not in list
+ *
+ * @param[in]  di   Descendant index
+ */
+static void
+descendant_index_free1(descendant_index *di)
+{
+    char          **keys = NULL;
+    size_t          nkeys = 0;
+    size_t          i;
+    void           *val;
+    descendant_set *ds;
+
+    if (di->di_names){
+        if (clicon_hash_keys(di->di_names, &keys, &nkeys) == 0){
+            for (i=0; i<nkeys; i++){
+                if ((val = clicon_hash_value(di->di_names, keys[i], NULL)) == NULL)
+                    continue;
+                ds = *(descendant_set **)val;
+                if (ds->ds_vec)
+                    free(ds->ds_vec);
+                free(ds);
+            }
+        }
+        if (keys)
+            free(keys);
+        clicon_hash_free(di->di_names);
+    }
+    free(di);
+}
+
+/*! Create descendant index of an XML tree
+ *
+ * All elements below the root are indexed. From here the index is maintained on all
+ * insertions, removals and renames of nodes in the tree until the root is freed.
+ * @param[in]  xt   Root of XML tree, eg datastore cache
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_descendant_index_free
+ */
+int
+xml_descendant_index_create(cxobj *xt)
+{
+    int               retval = -1;
+    descendant_index *di = NULL;
+    cxobj            *xc;
+
+    if (xml_parent(xt) != NULL){
+        clixon_err(OE_XML, EINVAL, "%s is not root of XML tree", xml_name(xt));
+        goto done;
+    }
+    if (descendant_index_get(xt) != NULL)
+        goto ok;
+    if ((di = malloc(sizeof(*di))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(di, 0, sizeof(*di));
+    di->di_xtop = xt;
+    if ((di->di_names = clicon_hash_init()) == NULL)
+        goto done;
+    xml_flag_set(xt, XML_FLAG_DESCINDEX);
+    xc = NULL;
+    while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
+        if (descendant_index_update(di, xc, 1) < 0)
+            goto done;
+    }
+    clixon_debug(CLIXON_DBG_XML, "%s: %" PRIu64 " nodes", xml_name(xt), di->di_nr);
+    ADDQ(di, _descendant_index_list);
+    di = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (di){
+        xml_apply0(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_DESCINDEX);
+        descendant_index_free1(di);
+    }
+    return retval;
+}
+
+/*! Free descendant index of an XML tree, if any
+ *
+ * Called when the root is freed, see xml_free
+ * @param[in]  xt   Root of XML tree
+ * @retval     0    OK
+ */
+int
+xml_descendant_index_free(cxobj *xt)
+{
+    descendant_index *di;
+
+    if (_descendant_index_list == NULL ||
+        xml_parent(xt) != NULL ||
+        (di = descendant_index_get(xt)) == NULL)
+        return 0;
+    DELQ(di, _descendant_index_list, descendant_index *);
+    descendant_index_free1(di);
+    return 0;
+}
+
+/*! Update descendant index when a child is inserted or removed
+ *
+ * Called when a child has been inserted into a parent, or is about to be removed from it.
+ * If the tree of the parent is indexed, the child and all its element descendants are
+ * added to, or removed from, the index.
+ * @param[in]  xp   XML parent
+ * @param[in]  xc   XML child, inserted or removed
+ * @param[in]  add  1: inserted, 0: removed
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xml_descendant_index_child(cxobj *xp,
+                           cxobj *xc,
+                           int    add)
+{
+    descendant_index *di;
+
+    if (_descendant_index_list == NULL ||
+        xml_type(xc) != CX_ELMNT ||
+        (di = descendant_index_get(xp)) == NULL)
+        return 0;
+    return descendant_index_update(di, xc, add);
+}
+
+/*! Collect visited nodes with name in document order
+ *
+ * @param[in]     xn      XML node
+ * @param[in]     name    Local name
+ * @param[in]     visited Set of nodes found in index and their ancestors
+ * @param[in,out] vec     Vector of XML nodes
+ * @param[in,out] veclen  Length of vector
+ * @retval        0       OK
+ * @retval       -1       Error
+ */
+static int
+descendant_index_collect(cxobj          *xn,
+                         const char     *name,
+                         descendant_set *visited,
+                         cxobj        ***vec,
+                         int            *veclen)
+{
+    int    retval = -1;
+    cxobj *x;
+
+    x = NULL;
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+        if (descendant_set_has(visited, x) == 0)
+            continue;
+        if (strcmp(xml_name(x), name) == 0 &&
+            cxvec_append(x, vec, veclen) < 0)
+            goto done;
+        if (descendant_index_collect(x, name, visited, vec, veclen) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find all descendants of an XML node with a local name using the descendant index
+ *
+ * The nodes in the index and their ancestors are added to a local visited set, and only
+ * visited subtrees are traversed to return the descendants in document order.
+ * The tree is not modified.
+ * @param[in]  xn      XML node, context of descendant step
+ * @param[in]  name    Local name
+ * @param[out] vec     Vector of XML nodes in document order, free after use
+ * @param[out] veclen  Length of vector
+ * @retval     1       OK, tree of xn is indexed
+ * @retval     0       Tree is not indexed, vec not set
+ * @retval    -1       Error
+ * @note Namespaces are not checked
+ * @see nodetest_recursive  Same result without index
+ */
+int
+xml_descendant_index_find(cxobj       *xn,
+                          const char  *name,
+                          cxobj     ***vec,
+                          int         *veclen)
+{
+    int               retval = -1;
+    descendant_index *di;
+    descendant_set   *ds = NULL;
+    descendant_set    visited = {NULL, 0, 0, 0};
+    cxobj            *x;
+    size_t            i;
+    int               ret;
+
+    if ((di = descendant_index_get(xn)) == NULL)
+        return 0;
+    if (descendant_index_set(di, name, 0, &ds) < 0)
+        goto done;
+    if (ds != NULL && ds->ds_len > 0){
+        /* Visit nodes and their ancestors up to xn, stop at already visited */
+        for (i=0; i<ds->ds_size; i++){
+            x = ds->ds_vec[i];
+            if (x == NULL || x == DESCENDANT_SET_DELETED)
+                continue;
+            while (x != NULL && x != xn){
+                if ((ret = descendant_set_add(&visited, x)) < 0)
+                    goto done;
+                if (ret == 0)
+                    break;
+                x = xml_parent(x);
+            }
+        }
+        if (descendant_index_collect(xn, name, &visited, vec, veclen) < 0)
+            goto done;
+    }
+    retval = 1;
+ done:
+    if (visited.ds_vec)
+        free(visited.ds_vec);
+    return retval;
+}
+
+/*! Get statistics of descendant index of an XML tree
+ *
+ * @param[in]  xt    Root of XML tree
+ * @param[out] nr    Number of indexed nodes
+ * @param[out] szp   Size in bytes of index
+ * @retval     1     OK, tree is indexed
+ * @retval     0     Tree is not indexed
+ */
+int
+xml_descendant_index_stats(cxobj    *xt,
+                           uint64_t *nr,
+                           size_t   *szp)
+{
+    descendant_index *di;
+    descendant_set   *ds;
+    char            **keys = NULL;
+    size_t            nkeys = 0;
+    size_t            sz;
+    size_t            i;
+    void             *val;
+
+    if ((di = descendant_index_get(xt)) == NULL)
+        return 0;
+    sz = sizeof(*di);
+    if (clicon_hash_keys(di->di_names, &keys, &nkeys) == 0){
+        for (i=0; i<nkeys; i++){
+            if ((val = clicon_hash_value(di->di_names, keys[i], NULL)) == NULL)
+                continue;
+            ds = *(descendant_set **)val;
+            sz += sizeof(*ds) + ds->ds_size*sizeof(cxobj *) + strlen(keys[i]) + 1;
+        }
+    }
+    if (keys)
+        free(keys);
+    if (nr)
+        *nr = di->di_nr;
+    if (szp)
+        *szp = sz;
+    return 1;
+}
@@ -53,6 +53,7 @@
 #include <string.h>
 #include <limits.h>
 #include <fcntl.h>
+#include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -85,12 +86,7 @@
 #include "clixon_xpath.h"
 #include "clixon_datastore.h"
 #include "clixon_xml_io.h"
-
-/*
- * Constants
- */
-/* Size of xml read buffer */
-#define BUFLEN 1024
+#include "clixon_file.h"
 
 /* Forward */
 static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop);
@@ -790,6 +786,264 @@ clixon_xml2cbuf(cbuf   *cb,
     return clixon_xml2cbuf1(cb, xn, level, pretty, prefix, depth, skiptop, 0);
 }
 
+/*! Internal: print a read-only view of an XML tree to a cligen buffer
+ *
+ * @param[in,out] cb      Cligen buffer to write to, or NULL to only compute visibility
+ * @param[in]     x       Clixon xml tree
+ * @param[in]     depth   Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     wdns    Parent has no yang spec: declare with-defaults namespace if tagged
+ * @param[in]     sel     1: x is in a selected subtree, 0: x is an ancestor of a selected node
+ * @param[in]     vis     1: x is visible unless hidden, 0: x is visible if a non-key child is
+ * @param[in]     fn      View function, or NULL
+ * @param[in]     arg     Argument to view function
+ * @param[out]    visible 1 if x is part of the view (it may still be left out by wdef or depth)
+ * @retval        0       OK
+ * @retval       -1       Error
+ * Non-presence containers with EXPLICIT/TRIM are printed if any child is printed, ie
+ * evaluated on the view, not on the tree, unless children are beyond depth.
+ * @see xml2cbuf_recurse
+ */
+static int
+xml2cbuf_view_recurse(cbuf             *cb,
+                      cxobj            *x,
+                      int32_t           depth,
+                      withdefaults_type wdef,
+                      int               wdns,
+                      int               sel,
+                      int               vis,
+                      xml_view_fn_t    *fn,
+                      void             *arg,
+                      int              *visible)
+{
+    int        retval = -1;
+    cxobj     *xc;
+    yang_stmt *y;
+    char      *prefix;
+    char      *ns = NULL;
+    char      *val;
+    int        tag = 0;
+    int        wdefcond = 0;
+    int        hasbody = 0;
+    int        nelmnt = 0; /* Visible element children */
+    int        nvis = 0;   /* Visible non-key element children */
+    int        iskey;
+    int        v;
+    size_t     len0 = 0;
+    size_t     len1 = 0;
+    int        ret;
+
+    *visible = 0;
+    if (depth == 0)
+        cb = NULL;
+    if ((y = xml_spec(x)) != NULL && fn != NULL){
+        if ((ret = fn(x, arg)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+        if (ret == 1)
+            vis = 1;
+    }
+    if (xml_flag(x, XML_FLAG_MARK))
+        sel = 1;
+    if (cb == NULL && vis){
+        *visible = 1;
+        goto ok;
+    }
+    if (cb != NULL && y != NULL){
+        /* with-defaults: if object should be printed or not */
+        if ((wdef == WITHDEFAULTS_EXPLICIT || wdef == WITHDEFAULTS_TRIM) &&
+            depth != 1 && /* Children are printed */
+            yang_keyword_get(y) == Y_CONTAINER &&
+            yang_find(y, Y_PRESENCE, NULL) == NULL)
+            wdefcond = 1;
+        else{
+            if ((ret = xml2output_wdef(x, wdef, &tag)) < 0)
+                goto done;
+            if (ret == 0){
+                if (vis){
+                    *visible = 1;
+                    goto ok;
+                }
+                cb = NULL;
+            }
+        }
+    }
+    /* Load lazy split node before printing attributes, loading removes its link */
+    if (cb != NULL && xml_lazy_load(x) < 0)
+        goto done;
+    prefix = xml_prefix(x);
+    if (cb != NULL){
+        len0 = cbuf_len(cb);
+        cbuf_append_str(cb, "<");
+        if (prefix){
+            cbuf_append_str(cb, prefix);
+            cbuf_append_str(cb, ":");
+        }
+        cbuf_append_str(cb, xml_name(x));
+        if (tag) /* If default and WITHDEFAULTS_REPORT_ALL_TAGGED */
+            cbuf_append_str(cb, " wd:default=\"true\"");
+        xc = NULL;
+        while ((xc = xml_child_each_attr(x, xc)) != NULL)
+            if (xml2cbuf_recurse(cb, xc, 0, 0, NULL, -1, wdef) < 0)
+                goto done;
+        if (wdns && wdef == WITHDEFAULTS_REPORT_ALL_TAGGED && y != NULL){
+            if (xml2ns(x, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, &ns) < 0)
+                goto done;
+            if (ns == NULL)
+                cprintf(cb, " xmlns:%s=\"%s\"", IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX,
+                        IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE);
+        }
+        len1 = cbuf_len(cb);
+        cbuf_append_str(cb, ">");
+    }
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, -1)) != NULL){
+        switch (xml_type(xc)){
+        case CX_BODY:
+            hasbody = 1;
+            if (cb != NULL && (val = xml_value(xc)) != NULL)
+                if (xml_chardata_cbuf_append(cb, 0, val) < 0)
+                    goto done;
+            break;
+        case CX_ELMNT:
+            /* Keys of list entries are in the view if any other child is */
+            iskey = 0;
+            if ((!sel || !vis) && y != NULL && yang_keyword_get(y) == Y_LIST)
+                if ((iskey = yang_key_match(y, xml_name(xc), NULL)) < 0)
+                    goto done;
+            /* Ancestor of selected nodes: only selected nodes and their ancestors */
+            if (!sel && !iskey && !xml_flag(xc, XML_FLAG_MARK|XML_FLAG_CHANGE))
+                break;
+            if (xml2cbuf_view_recurse(cb, xc, depth-1, wdef, y == NULL,
+                                      sel || iskey, vis || iskey, fn, arg, &v) < 0)
+                goto done;
+            if (v){
+                nelmnt++;
+                if (!iskey)
+                    nvis++;
+            }
+            break;
+        default:
+            break;
+        }
+        if (cb == NULL && nvis)
+            break;
+    }
+    if (!vis && nvis == 0){
+        if (cb != NULL)
+            cbuf_trunc(cb, len0);
+        goto ok;
+    }
+    *visible = 1;
+    if (cb == NULL)
+        goto ok;
+    if (wdefcond && cbuf_len(cb) == len1 + 1)
+        cbuf_trunc(cb, len0);
+    else if (hasbody == 0 && nelmnt == 0){ /* <a/> instead of <a></a> */
+        cbuf_trunc(cb, len1);
+        cbuf_append_str(cb, "/>");
+    }
+    else{
+        cbuf_append_str(cb, "</");
+        if (prefix){
+            cbuf_append_str(cb, prefix);
+            cbuf_append_str(cb, ":");
+        }
+        cbuf_append_str(cb, xml_name(x));
+        cbuf_append_str(cb, ">");
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print a read-only view of an XML tree to a cligen buffer without copying it
+ *
+ * The view is the nodes in xvec with their subtrees, their ancestors, and the keys of
+ * ancestor list entries, ie the same tree as made by xml_copy_marked.
+ * The top object is printed with another name and without attributes.
+ * The view function may hide nodes, eg NACM, as follows:
+ * - A hidden node is left out with its descendants
+ * - If visible is 0, a node is left out unless it or an ancestor is shown, or a non-key
+ *   descendant is visible
+ * With-defaults and depth are applied on the view as in clixon_xml2cbuf1.
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xt      Top-level xml object, eg datastore cache
+ * @param[in]     name    Name of top-level object in output, eg "data"
+ * @param[in]     xvec    Selected nodes in xt, eg xpath result
+ * @param[in]     xlen    Length of xvec
+ * @param[in]     depth   Limit levels of child resources: -1: all, 0: none, 1: top object
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     fn      View function, or NULL
+ * @param[in]     arg     Argument to view function
+ * @param[in]     visible 1: Nodes are visible unless hidden 0: Nodes are visible if shown
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @note XML_FLAG_MARK and XML_FLAG_CHANGE are set in xt during the call and then reset
+ * @see xmldb_get_view
+ */
+int
+clixon_xml2cbuf_view(cbuf             *cb,
+                     cxobj            *xt,
+                     char             *name,
+                     cxobj           **xvec,
+                     size_t            xlen,
+                     int32_t           depth,
+                     withdefaults_type wdef,
+                     xml_view_fn_t    *fn,
+                     void             *arg,
+                     int               visible)
+{
+    int      retval = -1;
+    cxobj   *xc;
+    int      sel;
+    int      n = 0;
+    int      v;
+    int      i;
+    size_t   len1;
+    uint64_t lazyerr = xml_lazy_errors();
+
+    for (i=0; i<xlen; i++){
+        xml_flag_set(xvec[i], XML_FLAG_MARK);
+        xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    if (depth != 0){
+        sel = xml_flag(xt, XML_FLAG_MARK) != 0;
+        cprintf(cb, "<%s", name);
+        len1 = cbuf_len(cb);
+        cbuf_append_str(cb, ">");
+        xc = NULL;
+        while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL){
+            if (!sel && !xml_flag(xc, XML_FLAG_MARK|XML_FLAG_CHANGE))
+                continue;
+            if (xml2cbuf_view_recurse(cb, xc, depth-1, wdef, 1, sel, visible, fn, arg, &v) < 0)
+                goto done;
+            if (v)
+                n++;
+        }
+        if (n == 0){
+            cbuf_trunc(cb, len1);
+            cbuf_append_str(cb, "/>");
+        }
+        else
+            cprintf(cb, "</%s>", name);
+    }
+    /* View is incomplete if a split node could not be loaded */
+    if (xml_lazy_errors() != lazyerr){
+        clixon_err(OE_XML, 0, "Loading of split file failed");
+        goto done;
+    }
+    retval = 0;
+ done:
+    for (i=0; i<xlen; i++){
+        xml_flag_reset(xvec[i], XML_FLAG_MARK);
+        xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_CHANGE);
+    }
+    return retval;
+}
+
 /*! Print actual xml tree datastructures (not xml), mainly for debugging
  *
  * @param[in,out] cb          Cligen buffer to write to
@@ -837,6 +1091,7 @@ xmltree2cbuf(cbuf  *cb,
  *
  * Given a string containing XML, parse into existing XML tree and return
  * @param[in]     str   Pointer to string containing XML definition.
+ * @param[in]     len   If > 0, str is a buffer of len followed by two nulls, parsed in place
  * @param[in]     yb    How to bind yang to XML top-level when parsing
  * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
  * @param[in,out] xtop  Top of XML parse tree. Assume created. Holds new tree.
@@ -860,11 +1115,12 @@ xmltree2cbuf(cbuf  *cb,
  * @note yang-binding over schema mount-points do not work, you need to make a separate bind call
  */
 static int
-_xml_parse(const char *str,
-           yang_bind   yb,
-           yang_stmt  *yspec,
-           cxobj      *xt,
-           cxobj     **xerr)
+_xml_parse0(char       *str,
+            size_t      len,
+            yang_bind   yb,
+            yang_stmt  *yspec,
+            cxobj      *xt,
+            cxobj     **xerr)
 {
     int             retval = -1;
     clixon_xml_yacc xy = {0,};
@@ -884,7 +1140,11 @@ _xml_parse(const char *str,
         clixon_err(OE_XML, errno, "Unexpected NULL XML");
         return -1;
     }
-    if ((xy.xy_parse_string = strdup(str)) == NULL){
+    if (len > 0){ /* Parse buffer in place */
+        xy.xy_parse_string = str;
+        xy.xy_parse_len = len;
+    }
+    else if ((xy.xy_parse_string = strdup(str)) == NULL){
         clixon_err(OE_XML, errno, "strdup");
         return -1;
     }
@@ -955,7 +1215,7 @@ _xml_parse(const char *str,
  done:
     clixon_debug(CLIXON_DBG_PARSE | CLIXON_DBG_DETAIL, "retval:%d", retval);
     clixon_xml_parsel_exit(&xy);
-    if (xy.xy_parse_string != NULL)
+    if (xy.xy_parse_len == 0 && xy.xy_parse_string != NULL)
         free(xy.xy_parse_string);
     if (xy.xy_xvec)
         free(xy.xy_xvec);
@@ -965,6 +1225,20 @@ _xml_parse(const char *str,
     goto done;
 }
 
+/*! Common internal xml parsing function string to parse-tree
+ *
+ * @see _xml_parse0
+ */
+static int
+_xml_parse(const char *str,
+           yang_bind   yb,
+           yang_stmt  *yspec,
+           cxobj      *xt,
+           cxobj     **xerr)
+{
+    return _xml_parse0((char*)str, 0, yb, yspec, xt, xerr);
+}
+
 /*! Read an XML definition from file and parse it into a parse-tree, advanced API
  *
  * @param[in]     fd    A file descriptor containing the XML file (as ASCII characters)
@@ -990,6 +1264,7 @@ _xml_parse(const char *str,
  * @see clixon_json_parse_file
  * @note, If xt empty, a top-level symbol will be added so that <tree../> will be:  <top><tree.../></tree></top>
  * @note May block on file I/O
+ * @note The file is read in large blocks and parsed in place, see clicon_file_read
  */
 int
 clixon_xml_parse_file(FILE      *fp,
@@ -998,16 +1273,12 @@ clixon_xml_parse_file(FILE      *fp,
                       cxobj    **xt,
                       cxobj    **xerr)
 {
-    int   retval = -1;
-    int   ret;
-    int   len = 0;
-    char  ch;
-    char *xmlbuf = NULL;
-    char *ptr;
-    int   xmlbuflen = BUFLEN; /* start size */
-    int   oldxmlbuflen;
-    int   failed = 0;
-    int   xtempty; /* empty on entry */
+    int    retval = -1;
+    int    ret;
+    size_t len = 0;
+    char  *xmlbuf = NULL;
+    int    failed = 0;
+    int    xtempty; /* empty on entry */
 
     if (xt == NULL || fp == NULL){
         clixon_err(OE_XML, EINVAL, "arg is NULL");
@@ -1018,41 +1289,17 @@ clixon_xml_parse_file(FILE      *fp,
         clixon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
         return -1;
     }
-    if ((xmlbuf = malloc(xmlbuflen)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    if (clicon_file_read(fp, &xmlbuf, &len) < 0)
         goto done;
+    if (*xt == NULL)
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    if (len > 0){
+        if ((ret = _xml_parse0(xmlbuf, len, yb, yspec, *xt, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            failed++;
     }
-    memset(xmlbuf, 0, xmlbuflen);
-    ptr = xmlbuf;
-    while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret != 0){
-            xmlbuf[len++] = ch;
-        }
-        if (ret == 0) {
-            if (*xt == NULL)
-                if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if ((ret = _xml_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        }
-        if (len >= xmlbuflen-1){ /* Space: one for the null character */
-            oldxmlbuflen = xmlbuflen;
-            xmlbuflen *= 2;
-            if ((xmlbuf = realloc(xmlbuf, xmlbuflen)) == NULL){
-                clixon_err(OE_XML, errno, "realloc");
-                goto done;
-            }
-            memset(xmlbuf+oldxmlbuflen, 0, xmlbuflen-oldxmlbuflen);
-            ptr = xmlbuf;
-        }
-    } /* while */
     retval = (failed==0) ? 1 : 0;
  done:
     if (retval < 0 && *xt && xtempty){
@@ -94,7 +94,7 @@ typedef struct  {
 } merge_twophase;
 
 /* Forward declaration */
-static int xml_diff1(cxobj *x0, cxobj *x1, cxobj ***x0vec, int *x0veclen,
+static int xml_diff1(cxobj *x0, cxobj *x1, int edited, cxobj ***x0vec, int *x0veclen,
                      cxobj ***x1vec, int *x1veclen,
                      cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen);
 
@@ -348,6 +348,10 @@ xml_diff_ordered_by_user(cxobj     *x0,
  * Also, a node is skipped if:
  * 1) its xml flag has XML_FLAG_SKIP
  * 2) its yang has extension clixon-lib:ignore-compare
+ * If edited is set, equal non-leaf nodes are not descended into unless the x1 node
+ * is marked with XML_FLAG_EDITED
+ * Equal non-leaf nodes with the same cached subtree digest are not descended into,
+ * see xml_digest
  * @see xml_diff2cbuf, clixon_text_diff2cbuf  for +/- diff for XML and TEXT formats
  * @see text_diff2cbuf for curly
  * @see xml_tree_equal Equal or not
@@ -356,6 +360,7 @@ xml_diff_ordered_by_user(cxobj     *x0,
 static int
 xml_diff1(cxobj     *x0,
           cxobj     *x1,
+          int        edited,
           cxobj   ***x0vec,
           int       *x0veclen,
           cxobj   ***x1vec,
@@ -476,7 +481,8 @@ xml_diff1(cxobj     *x0,
             /* xml-spec NULL could happen with anydata children for example,
              * if so, continute compare children but without yang
              */
-            if (y0c && y1c && y0c != y1c){ /* choice */
+            if ((y0c && y1c && y0c != y1c) || /* choice */
+                (y0c == NULL && xml_name(x0c) != xml_name(x1c))){ /* no yang: interned names differ */
                 if (cxvec_append(x0c, x0vec, x0veclen) < 0)
                     goto done;
                 if (cxvec_append(x1c, x1vec, x1veclen) < 0)
@@ -498,7 +504,11 @@ xml_diff1(cxobj     *x0,
                         goto done;
                 }
             }
-            else if (xml_diff1(x0c, x1c,
+            else if (edited && xml_flag(x1c, XML_FLAG_EDITED) == 0)
+                ; /* Not edited since x0 and x1 were equal */
+            else if (xml_digest_equal(x0c, x1c))
+                ; /* Equal subtrees */
+            else if (xml_diff1(x0c, x1c, edited,
                                x0vec, x0veclen,
                                x1vec, x1veclen,
                                changed_x0, changed_x1, changedlen)< 0)
@@ -513,10 +523,11 @@ xml_diff1(cxobj     *x0,
     return retval;
 }
 
-/*! Compute differences between two xml trees
+/*! Compute differences between two xml trees, common function
  *
  * @param[in]  x0         First XML tree
  * @param[in]  x1         Second XML tree
+ * @param[in]  edited     Only descend into subtrees marked with XML_FLAG_EDITED in x1
  * @param[out] first      Pointervector to XML nodes existing in only first tree
  * @param[out] firstlen   Length of first vector
  * @param[out] second     Pointervector to XML nodes existing in only second tree
@@ -526,20 +537,20 @@ xml_diff1(cxobj     *x0,
  * @param[out] changedlen Length of changed vector
  * @retval     0          OK
  * @retval    -1          Error
- * All xml vectors should be freed after use.
- * @see xml_tree_equal  same algorithm but do not bother with what has changed
- * @see clixon_xml_diff_print  same algorithm but print in +/- diff format
+ * @see xml_diff
+ * @see xml_diff_edited
  */
-int
-xml_diff(cxobj     *x0,
-         cxobj     *x1,
-         cxobj   ***first,
-         int       *firstlen,
-         cxobj   ***second,
-         int       *secondlen,
-         cxobj   ***changed_x0,
-         cxobj   ***changed_x1,
-         int       *changedlen)
+static int
+xml_diff0(cxobj     *x0,
+          cxobj     *x1,
+          int        edited,
+          cxobj   ***first,
+          int       *firstlen,
+          cxobj   ***second,
+          int       *secondlen,
+          cxobj   ***changed_x0,
+          cxobj   ***changed_x1,
+          int       *changedlen)
 {
     int retval = -1;
 
@@ -558,7 +569,15 @@ xml_diff(cxobj     *x0,
             goto done;
         goto ok;
     }
-    if (xml_diff1(x0, x1,
+    /* Compute subtree digests of both trees unless only edited subtrees are compared.
+     * Digests of unmodified subtrees are cached, typically in datastore caches */
+    if (!edited){
+        xml_digest(x0);
+        xml_digest(x1);
+        if (xml_digest_equal(x0, x1))
+            goto ok;
+    }
+    if (xml_diff1(x0, x1, edited,
                   first, firstlen,
                   second, secondlen,
                   changed_x0, changed_x1, changedlen) < 0)
@@ -569,6 +588,76 @@ xml_diff(cxobj     *x0,
     return retval;
 }
 
+/*! Compute differences between two xml trees
+ *
+ * @param[in]  x0         First XML tree
+ * @param[in]  x1         Second XML tree
+ * @param[out] first      Pointervector to XML nodes existing in only first tree
+ * @param[out] firstlen   Length of first vector
+ * @param[out] second     Pointervector to XML nodes existing in only second tree
+ * @param[out] secondlen  Length of second vector
+ * @param[out] changed_x0 Pointervector to XML nodes changed orig value
+ * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
+ * @param[out] changedlen Length of changed vector
+ * @retval     0          OK
+ * @retval    -1          Error
+ * All xml vectors should be freed after use.
+ * @see xml_tree_equal  same algorithm but do not bother with what has changed
+ * @see clixon_xml_diff_print  same algorithm but print in +/- diff format
+ */
+int
+xml_diff(cxobj     *x0,
+         cxobj     *x1,
+         cxobj   ***first,
+         int       *firstlen,
+         cxobj   ***second,
+         int       *secondlen,
+         cxobj   ***changed_x0,
+         cxobj   ***changed_x1,
+         int       *changedlen)
+{
+    return xml_diff0(x0, x1, 0,
+                     first, firstlen,
+                     second, secondlen,
+                     changed_x0, changed_x1, changedlen);
+}
+
+/*! Compute differences between two xml trees only descending into edited subtrees
+ *
+ * Same as xml_diff but non-leaf nodes in x1 not marked with XML_FLAG_EDITED are assumed
+ * to be equal to their x0 counterparts and are not compared.
+ * This requires that x1 was equal to x0 when the marks were cleared and that every node
+ * edited since then is marked together with its ancestors, see xmldb_edited_get.
+ * @param[in]  x0         First XML tree
+ * @param[in]  x1         Second XML tree, with edited nodes marked
+ * @param[out] first      Pointervector to XML nodes existing in only first tree
+ * @param[out] firstlen   Length of first vector
+ * @param[out] second     Pointervector to XML nodes existing in only second tree
+ * @param[out] secondlen  Length of second vector
+ * @param[out] changed_x0 Pointervector to XML nodes changed orig value
+ * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
+ * @param[out] changedlen Length of changed vector
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see xml_diff
+ */
+int
+xml_diff_edited(cxobj     *x0,
+                cxobj     *x1,
+                cxobj   ***first,
+                int       *firstlen,
+                cxobj   ***second,
+                int       *secondlen,
+                cxobj   ***changed_x0,
+                cxobj   ***changed_x1,
+                int       *changedlen)
+{
+    return xml_diff0(x0, x1, 1,
+                     first, firstlen,
+                     second, secondlen,
+                     changed_x0, changed_x1, changedlen);
+}
+
 /*! Compute if two XML trees are equal or not
  *
  * @param[in]  x0   First XML tree
@@ -639,7 +728,8 @@ xml_tree_equal(cxobj *x0,
             /* xml-spec NULL could happen with anydata children for example,
              * if so, continue compare children but without yang
              */
-            if (y0c && y1c && y0c != y1c){ /* choice */
+            if ((y0c && y1c && y0c != y1c) || /* choice */
+                (y0c == NULL && xml_name(x0c) != xml_name(x1c))){ /* no yang: interned names differ */
                 goto done;
             }
             else
@@ -655,6 +745,8 @@ xml_tree_equal(cxobj *x0,
                         goto done;
                     }
                 }
+                else if (xml_digest_equal(x0c, x1c))
+                    ; /* Equal subtrees, see xml_digest */
                 else {
                     eq = xml_tree_equal(x0c, x1c);
                     if (eq)
@@ -2079,59 +2171,59 @@ yang_check_when_xpath(cxobj        *xn,
                       int          *nrp,
                       char        **xpathp)
 {
-    int        retval = 1;
-    yang_stmt *yc;
-    char      *xpath = NULL;
-    cxobj     *x = NULL;
-    int        nr = 0;
-    cvec      *nsc = NULL;
-    int        variant = 0;   /* ugly help variable to clean temporary object */
+    int             retval = -1;
+    yang_stmt      *ywhen;
+    xpath_compiled *xpc = NULL;
+    cxobj          *x = NULL;
+    int             nr = 0;
+    cvec           *nsc = NULL;
+    int             variant = 0;   /* ugly help variable to clean temporary object */
 
-    if (yang_when_canonical_xpath_get(yn, &xpath, &nsc) < 0)
-        goto done;
-    if (xpath != NULL){
-        x = xp;
-        *hit = 1;
-    }
-    else if ((yc = yang_find(yn, Y_WHEN, NULL)) != NULL){
-        /* "when" has xpath argument */
-        if ((xpath = strdup(yang_argument_get(yc))) == NULL){
-            clixon_err(OE_UNIX, errno, "strdup");
+    /* XPath and namespace context are compiled once and cached in the when statement */
+    if ((ywhen = yang_when_get(NULL, yn)) != NULL){
+        if (yang_xpath_compiled_get(ywhen, 1, &xpc, &nsc) < 0)
             goto done;
+        if (xpc != NULL){
+            x = xp;
+            *hit = 1;
         }
-        /* Create dummy */
-        if (xn == NULL){
-            if ((x = xml_new(yang_argument_get(yn), xp, CX_ELMNT)) == NULL)
+    }
+    if (xpc == NULL){
+        if ((ywhen = yang_find(yn, Y_WHEN, NULL)) != NULL){
+            /* "when" has xpath argument */
+            if (yang_xpath_compiled_get(ywhen, 0, &xpc, &nsc) < 0)
                 goto done;
-            xml_spec_set(x, yn);
-            variant = 1;
+            /* Create dummy */
+            if (xn == NULL){
+                if ((x = xml_new(yang_argument_get(yn), xp, CX_ELMNT)) == NULL)
+                    goto done;
+                xml_spec_set(x, yn);
+                variant = 1;
+            }
+            else
+                x = xn;
+            *hit = 1;
         }
         else
-            x = xn;
-        if (xml_nsctx_yang(yn, &nsc) < 0)
-            goto done;
-        *hit = 1;
+            *hit = 0;
     }
-    else
-        *hit = 0;
-    if (x && xpath){
-        if ((nr = xpath_vec_bool(x, nsc, "%s", xpath)) < 0)
+    if (x && xpc){
+        if ((nr = xpath_vec_bool_compiled(x, nsc, xpc)) < 0)
             goto done;
     }
     if (nrp)
         *nrp = nr;
     if (xpathp){
-        *xpathp = xpath;
-        xpath = NULL;
+        *xpathp = NULL;
+        if (xpc && (*xpathp = strdup(xpath_compiled_str(xpc))) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
     }
     retval = 0;
  done:
     if (variant)
         xml_purge(x);
-    if (xpath)
-        free(xpath);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
 }
 
@@ -2348,6 +2440,9 @@ clixon_compare_xmls(cxobj            *xc1,
 
     snprintf(filename1, sizeof(filename1), "/tmp/cliconXXXXXX");
     snprintf(filename2, sizeof(filename2), "/tmp/cliconXXXXXX");
+    /* Equal cached subtree digests: no diff */
+    if (xml_digest_equal(xc1, xc2))
+        goto ok;
     if ((fd = mkstemp(filename1)) < 0){
         clixon_err(OE_UNDEF, errno, "tmpfile");
         goto done;
@@ -2399,7 +2494,7 @@ clixon_compare_xmls(cxobj            *xc1,
             filename1, filename2);
     if (system(cbuf_get(cb)) < 0)
         goto done;
-
+ ok:
     retval = 0;
   done:
     if (cb)
@@ -161,6 +161,222 @@ xml_cv_cache_clear(cxobj *xt)
     return retval;
 }
 
+#ifdef XML_SORTKEY
+/*! Encode value of a leaf so that encodings can be compared with memcmp
+ *
+ * Encoding is a tag: 0 if leaf is missing, 1 if it has no body, 2 if it has a value
+ * followed by the value, which is self-delimiting:
+ * - integers and decimal64 in big-endian with the sign bit inverted
+ * - strings null-terminated
+ * The order is the same as xml_cmp using cv_cmp of the values
+ * @param[in]  x    Leaf or leaf-list XML node, or NULL if missing
+ * @param[out] buf  Buffer to write encoding to, or NULL to only compute length
+ * @param[out] len  Length of encoding
+ * @retval     1    OK
+ * @retval     0    Type has no memcmp-comparable encoding
+ * @retval    -1    Error
+ */
+static int
+xml_sortkey_leaf(cxobj   *x,
+                 uint8_t *buf,
+                 size_t  *len)
+{
+    cg_var  *cv = NULL;
+    char    *str = NULL;
+    uint64_t u = 0;
+    int      w = 0; /* Width of integer in bytes */
+    int      i;
+
+    if (x == NULL || xml_body(x) == NULL){
+        if (buf)
+            buf[0] = x==NULL ? 0 : 1;
+        *len = 1;
+        return 1;
+    }
+    if (xml_cv_cache(x, &cv) < 0)
+        return -1;
+    switch (cv_type_get(cv)){
+    case CGV_INT8:
+        w = 1;
+        u = (uint64_t)(int64_t)cv_int8_get(cv);
+        break;
+    case CGV_INT16:
+        w = 2;
+        u = (uint64_t)(int64_t)cv_int16_get(cv);
+        break;
+    case CGV_INT32:
+        w = 4;
+        u = (uint64_t)(int64_t)cv_int32_get(cv);
+        break;
+    case CGV_INT64:
+        w = 8;
+        u = (uint64_t)cv_int64_get(cv);
+        break;
+    case CGV_DEC64: /* Same fraction-digits since same yang type */
+        w = 8;
+        u = (uint64_t)cv_dec64_i_get(cv);
+        break;
+    case CGV_UINT8:
+        u = cv_uint8_get(cv);
+        *len = 2;
+        break;
+    case CGV_UINT16:
+        u = cv_uint16_get(cv);
+        *len = 3;
+        break;
+    case CGV_UINT32:
+        u = cv_uint32_get(cv);
+        *len = 5;
+        break;
+    case CGV_UINT64:
+        u = cv_uint64_get(cv);
+        *len = 9;
+        break;
+    case CGV_BOOL:
+        u = cv_bool_get(cv) ? 1 : 0;
+        *len = 2;
+        break;
+    case CGV_STRING:
+    case CGV_REST:
+        if ((str = cv_string_get(cv)) == NULL)
+            str = "";
+        *len = 1 + strlen(str) + 1;
+        break;
+    default:
+        return 0;
+    }
+    if (w){ /* Signed: invert sign bit */
+        u ^= (uint64_t)1 << (8*w - 1);
+        *len = 1 + w;
+    }
+    if (buf){
+        buf[0] = 2;
+        if (str)
+            memcpy(&buf[1], str, *len - 1);
+        else
+            for (i=1; i<*len; i++)
+                buf[i] = (u >> (8*(*len - 1 - i))) & 0xff;
+    }
+    return 1;
+}
+
+/*! Encode sort key of a list or leaf-list entry
+ *
+ * @param[in]  x    List or leaf-list XML entry
+ * @param[in]  y    Yang spec of x
+ * @param[out] buf  Buffer to write encoding to, or NULL to only compute length
+ * @param[out] len  Length of encoding
+ * @param[out] flags XML_SORTKEY_NONE and/or XML_SORTKEY_PARTIAL
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_sortkey_encode(cxobj     *x,
+                   yang_stmt *y,
+                   uint8_t   *buf,
+                   size_t    *len,
+                   uint8_t   *flags)
+{
+    cvec   *cvk;
+    cg_var *cvi = NULL;
+    cxobj  *xk;
+    size_t  n;
+    int     ret;
+
+    *len = 0;
+    *flags = 0;
+    if (yang_keyword_get(y) == Y_LEAF_LIST){
+        if ((ret = xml_sortkey_leaf(x, buf, len)) < 0)
+            return -1;
+        if (ret == 0)
+            *flags = XML_SORTKEY_NONE;
+        return 0;
+    }
+    cvk = yang_cvec_get(y); /* Use Y_LIST cache, see ys_populate_list() */
+    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+        if ((xk = xml_find(x, cv_string_get(cvi))) == NULL)
+            *flags |= XML_SORTKEY_PARTIAL;
+        if ((ret = xml_sortkey_leaf(xk, buf?buf+*len:NULL, &n)) < 0)
+            return -1;
+        if (ret == 0){
+            *flags = XML_SORTKEY_NONE;
+            *len = 0;
+            break;
+        }
+        *len += n;
+    }
+    return 0;
+}
+
+/*! Get sort key of a list or leaf-list entry, compute and cache it if not set
+ *
+ * @param[in]  x    List or leaf-list XML entry
+ * @param[in]  y    Yang spec of x
+ * @retval     sk   Sort key
+ * @retval     NULL Error
+ * @see xml_sortkey_set  The key is cleared when a key value or the yang spec changes
+ */
+static struct xml_sortkey *
+xml_sortkey_cache(cxobj     *x,
+                  yang_stmt *y)
+{
+    struct xml_sortkey *sk;
+    size_t              len;
+    uint8_t             flags;
+
+    if ((sk = xml_sortkey(x)) != NULL)
+        return sk;
+    if (xml_sortkey_encode(x, y, NULL, &len, &flags) < 0)
+        return NULL;
+    if ((sk = malloc(sizeof(*sk) + len)) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        return NULL;
+    }
+    sk->sk_len = len;
+    if (len && xml_sortkey_encode(x, y, sk->sk_key, &len, &flags) < 0){
+        free(sk);
+        return NULL;
+    }
+    sk->sk_flags = flags;
+    xml_sortkey_set(x, sk);
+    return sk;
+}
+
+/*! Compare two list or leaf-list entries of same yang using sort keys
+ *
+ * @param[in]  x1    object 1
+ * @param[in]  x2    object 2
+ * @param[in]  y     Yang spec of x1 and x2
+ * @param[in]  skip1 Key matching skipped for keys not in x1
+ * @param[out] cmp   <0, 0, or >0, see xml_cmp
+ * @retval     1     Compared, see cmp
+ * @retval     0     Not comparable with sort keys, use values
+ */
+static int
+xml_sortkey_cmp(cxobj     *x1,
+                cxobj     *x2,
+                yang_stmt *y,
+                int        skip1,
+                int       *cmp)
+{
+    struct xml_sortkey *sk1;
+    struct xml_sortkey *sk2;
+    uint32_t            len;
+
+    if ((sk1 = xml_sortkey_cache(x1, y)) == NULL ||
+        (sk2 = xml_sortkey_cache(x2, y)) == NULL)
+        return 0;
+    if ((sk1->sk_flags & XML_SORTKEY_NONE) || (sk2->sk_flags & XML_SORTKEY_NONE))
+        return 0;
+    if (skip1 && (sk1->sk_flags & XML_SORTKEY_PARTIAL))
+        return 0;
+    len = sk1->sk_len < sk2->sk_len ? sk1->sk_len : sk2->sk_len;
+    if ((*cmp = memcmp(sk1->sk_key, sk2->sk_key, len)) == 0)
+        *cmp = (int)sk1->sk_len - (int)sk2->sk_len;
+    return 1;
+}
+#endif /* XML_SORTKEY */
+
 /*! Help function to qsort for sorting entries in xml child vector same parent
  *
  * @param[in]  x1    object 1
@@ -284,6 +500,12 @@ xml_cmp(cxobj  *x1,
             equal = nr1-nr2;
             goto done; /* Ordered by user or state data : maintain existing order */
         }
+#ifdef XML_SORTKEY
+    if (indexvar == NULL &&
+        (yang_keyword_get(y1) == Y_LIST || yang_keyword_get(y1) == Y_LEAF_LIST) &&
+        xml_sortkey_cmp(x1, x2, y1, skip1, &equal) == 1)
+        goto done;
+#endif
     switch (yang_keyword_get(y1)){
     case Y_LEAF_LIST: /* Match with name and value */
 #ifdef XML_EXPLICIT_INDEX
@@ -365,11 +587,13 @@ xml_cmp(cxobj  *x1,
         cvi = NULL;
         while ((cvi = cvec_each(cvk, cvi)) != NULL) {
             keyname = cv_string_get(cvi); /* operational data may have NULL keys*/
-            x1b = xml_find(x1, keyname);
+            /* Lookup interned name once, compare children by pointer */
+            keyname = keyname ? clixon_string_interned(keyname) : NULL;
+            x1b = xml_find_interned(x1, keyname);
             /* match1: key matching skipped for keys not in x1 (see explanation) */
             if (skip1 && x1b == NULL)
                 continue;
-            x2b = xml_find(x2, keyname);
+            x2b = xml_find_interned(x2, keyname);
             if (x1b == NULL && x2b == NULL)
                 ;
             else if (x1b == NULL)
@@ -423,6 +647,26 @@ xml_cmp_qsort(const void *arg1,
     return xml_cmp(*(struct xml**)arg1, *(struct xml**)arg2, 1, 0, indexvar);
 }
 
+/*! Reset subtree digest after sort if order of children was changed
+ *
+ * Sorting is made directly on the child vector, and children are enumerated before sort
+ * @param[in] x        XML node
+ * @see xml_digest
+ */
+static void
+xml_sort_digest_reset(cxobj *x)
+{
+    int i;
+
+    if (xml_digest_cached(x) == NULL)
+        return;
+    for (i=0; i<xml_child_nr(x); i++)
+        if (xml_enumerate_get(xml_child_i(x, i)) != i){
+            xml_digest_reset(x);
+            break;
+        }
+}
+
 /*! Sort children of an XML node using an index
  *
  * @param[in] x        XML node
@@ -439,6 +683,7 @@ xml_sort_by(cxobj *x,
 #else
     qsort_r(xml_childvec_get(x), xml_child_nr(x), sizeof(cxobj *), xml_cmp_qsort, indexvar);
 #endif
+    xml_sort_digest_reset(x);
     return 0;
 }
 
@@ -468,6 +713,7 @@ xml_sort(cxobj *x)
 #else
     qsort_r(xml_childvec_get(x), xml_child_nr(x), sizeof(cxobj *), xml_cmp_qsort, NULL);
 #endif
+    xml_sort_digest_reset(x);
     return 0;
 }
 
@@ -513,10 +759,12 @@ xml_sort_recurse(cxobj *xn)
  * @param[in]  x1    XML node to match
  * @param[in]  yangi Yang order number (according to spec)
  * @param[in]  mid   Where to start from (may be in middle of interval)
+ * @param[in]  skip1 Key matching skipped for keys not in x1
  * @param[out] xvec      Vector of matching XML return objects (can be empty)
  * @retval     0         OK, see xvec (may be empty)
  * @retval    -1         Error
- * XXX: only first match
+ * Only first match with all keys, but all matches in document order if skip1 is set, since
+ * entries matching a prefix of the keys are not adjacent
  */
 static int
 xml_find_keys_notsorted(cxobj   *xp,
@@ -532,6 +780,26 @@ xml_find_keys_notsorted(cxobj   *xp,
     yang_stmt *yc;
     int        yi;
 
+    if (skip1){
+        /* Find first entry of same yang, then all matches forward */
+        for (i=mid; i>0; i--){
+            if ((yi = yang_order(xml_spec(xml_child_i(xp, i-1)))) < -1)
+                goto done;
+            if (yangi != yi)
+                break;
+        }
+        for (; i<xml_child_nr(xp); i++){
+            xc = xml_child_i(xp, i);
+            if ((yi = yang_order(xml_spec(xc))) < -1)
+                goto done;
+            if (yangi != yi)
+                break;
+            if (xml_cmp(xc, x1, 0, skip1, NULL) == 0 &&
+                clixon_xvec_append(xvec, xc) < 0)
+                goto done;
+        }
+        goto ok;
+    }
     for (i=mid+1; i<xml_child_nr(xp); i++){ /* First increment */
         xc = xml_child_i(xp, i);
         yc = xml_spec(xc);
@@ -830,7 +1098,7 @@ xml_search_binary(cxobj   *xp,
 #endif
         /* >0 means search upper interval, <0 lower interval, = 0 is equal */
         cmp = xml_cmp(x1, xc, 0, skip1, NULL);
-        if (cmp && !sorted){ /* Ordered by user (if not equal) */
+        if (!sorted && (cmp || skip1)){ /* Ordered by user (if not equal, or partial keys) */
             retval = xml_find_keys_notsorted(xp, x1, yangi, mid, skip1, xvec);
             goto done;
         }
@@ -891,9 +1159,12 @@ xml_search_yang(cxobj       *xp,
     upper = xml_child_nr(xp);
     /* Assume if there are any attributes, they are first in the list, mask
        them by raising low to skip them */
-    for (low=0; low<upper; low++)
-        if ((xa = xml_child_i(xp, low)) == NULL || xml_type(xa) != CX_ATTR)
-            break;
+    if (xml_child_nr_type(xp, CX_ATTR) == 0)
+        low = 0;
+    else
+        for (low=0; low<upper; low++)
+            if ((xa = xml_child_i(xp, low)) == NULL || xml_type(xa) != CX_ATTR)
+                break;
 #ifndef STATE_ORDERED_BY_SYSTEM
     /* Find if non-config and if ordered-by-user */
     if (yang_config_ancestor(yc)==0)
@@ -1409,6 +1680,7 @@ xml_find_index_yang(cxobj       *xp,
     char      *encstr;
     int        revert = 0;
     char      *indexvar = NULL;
+    int        partial = 0;
 
     if (xp == NULL){
         clixon_err(OE_XML, EINVAL, "xp is NULL");
@@ -1449,6 +1721,7 @@ xml_find_index_yang(cxobj       *xp,
         }
         if (revert)
             break;
+        partial = i < cvec_len(ycvk);
         cprintf(cb, "</%s>", name);
         break;
     case Y_LEAF_LIST:
@@ -1503,7 +1776,8 @@ xml_find_index_yang(cxobj       *xp,
         if (xml_spec_set(xk, yk) < 0)
             goto done;
     }
-    if (xml_search_yang(xp, xc, yc, 1, indexvar, xvec) < 0)
+    /* Skip missing keys only if partial, then all matches are collected */
+    if (xml_search_yang(xp, xc, yc, partial, indexvar, xvec) < 0)
         goto done;
     retval = 1; /* OK */
  done:
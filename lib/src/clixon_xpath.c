@@ -515,6 +515,88 @@ xpath_tree_traverse(xpath_tree *xt,
     return xs;
 }
 
+/*! Collect local names of nodes read by an XPath tree, help function
+ *
+ * @param[in]     xs      XPath tree
+ * @param[in]     ptype   Type of parent XPath tree node, or -1 if top
+ * @param[in,out] names   Local names
+ * @param[out]    any     Set to 1 if XPath may read any node
+ * @retval        0       OK
+ * @retval       -1       Error
+ */
+static int
+xpath_tree_names1(xpath_tree *xs,
+                  int         ptype,
+                  cvec       *names,
+                  int        *any)
+{
+    int         retval = -1;
+    xpath_tree *xstep;
+
+    switch (xs->xs_type){
+    case XP_NODE:
+        if (xs->xs_s1 == NULL || strcmp(xs->xs_s1, "*") == 0)
+            *any = 1;
+        else if (cvec_find(names, xs->xs_s1) == NULL &&
+                 cvec_add_string(names, xs->xs_s1, NULL) < 0){
+            clixon_err(OE_UNIX, errno, "cvec_add_string");
+            goto done;
+        }
+        break;
+    case XP_NODE_FN: /* node(), text(), etc */
+        *any = 1;
+        break;
+    case XP_PRIME_FN: /* deref() reads leafref targets */
+        if (xs->xs_s0 && strcmp(xs->xs_s0, "deref") == 0)
+            *any = 1;
+        break;
+    case XP_ABSPATH:
+        if (xs->xs_c0 == NULL) /* "/" */
+            *any = 1;
+        break;
+    case XP_RELLOCPATH:
+        /* Last step of location path is "..", eg string(..): depends on all descendants */
+        if (ptype != XP_RELLOCPATH){
+            xstep = xs->xs_c1 ? xs->xs_c1 : xs->xs_c0;
+            if (xstep && xstep->xs_type == XP_STEP && xstep->xs_c0 == NULL &&
+                xstep->xs_int != A_SELF)
+                *any = 1;
+        }
+        break;
+    default:
+        break;
+    }
+    if (xs->xs_c0 && xpath_tree_names1(xs->xs_c0, xs->xs_type, names, any) < 0)
+        goto done;
+    if (xs->xs_c1 && xpath_tree_names1(xs->xs_c1, xs->xs_type, names, any) < 0)
+        goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Collect local names of nodes read by an XPath tree, eg for dependency tracking
+ *
+ * Names of all name tests are collected, in location paths as well as in predicates.
+ * The XPath may also read other nodes than the named, if it has wildcards, node-type
+ * tests, deref(), or a location path ending with "..".
+ * @param[in]     xs      XPath tree
+ * @param[in,out] names   Local names, no duplicates
+ * @param[out]    any     1 if XPath may read any node, 0 if only named nodes
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @note A changed node may change the string value of its ancestors, names of ancestors
+ *       of changed nodes should therefore also be considered changed
+ */
+int
+xpath_tree_names(xpath_tree *xs,
+                 cvec       *names,
+                 int        *any)
+{
+    *any = 0;
+    return xpath_tree_names1(xs, -1, names, any);
+}
+
 /*! Free a XPath_tree
  *
  * @param[in]  xs  XPath tree
@@ -527,8 +609,12 @@ xpath_tree_free(xpath_tree *xs)
         free(xs->xs_strnr);
     if (xs->xs_s0)
         free(xs->xs_s0);
-    if (xs->xs_s1)
-        free(xs->xs_s1);
+    if (xs->xs_s1){
+        if (xs->xs_type == XP_NODE)
+            clixon_string_unintern(xs->xs_s1);
+        else
+            free(xs->xs_s1);
+    }
     if (xs->xs_c0)
         xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
@@ -607,57 +693,489 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
-/*! Given XML tree and XPath, parse XPath, eval it and return XPath context,
+/*! Compiled XPath: parsed XPath tree shared by the XPath cache and precompiled handles
+ *
+ * The XPath tree is not modified by evaluation and does not depend on the namespace context,
+ * prefixes are resolved against the nsc when evaluated.
+ * @see xpath_compile
+ */
+struct xpath_compiled {
+    qelem_t     xpc_qelem;  /* LRU list of cached entries, most recently used first */
+    char       *xpc_xpath;  /* Original XPath string, key in cache */
+    xpath_tree *xpc_tree;   /* Parsed XPath tree */
+    int         xpc_refcnt; /* References from cache, handles and ongoing evaluations */
+    int         xpc_cached; /* Entry is in cache */
+};
+
+#ifdef XPATH_CACHE_SIZE
+/* XPath cache: hash of XPath string to compiled entry and LRU list for eviction */
+static clicon_hash_t  *_xpath_cache = NULL;
+static xpath_compiled *_xpath_lru = NULL;
+static uint64_t        _xpath_cache_nr = 0;
+#endif
+static uint64_t        _xpath_cache_hit = 0;
+static uint64_t        _xpath_cache_miss = 0;
+
+/*! Parse XPath and create a compiled XPath with one reference
  *
- * This is a raw form of XPath where you can do type conversion of the return
- * value, etc, not just a nodeset.
- * @param[in]  xcur   XML-tree where to search
- * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPath 1.0 syntax
- * @param[in]  localonly Skip prefix and namespace tests
- * @param[out] xrp    Return XPath context
+ * @param[out] xpcp   Compiled XPath
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xpath_compiled_new(const char      *xpath,
+                   xpath_compiled **xpcp)
+{
+    int             retval = -1;
+    xpath_compiled *xpc = NULL;
+
+    if ((xpc = malloc(sizeof(*xpc))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xpc, 0, sizeof(*xpc));
+    if (xpath_parse(xpath, &xpc->xpc_tree) < 0)
+        goto done;
+    if ((xpc->xpc_xpath = strdup(xpath)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    xpc->xpc_refcnt = 1;
+    *xpcp = xpc;
+    xpc = NULL;
+    retval = 0;
+ done:
+    if (xpc){
+        if (xpc->xpc_tree)
+            xpath_tree_free(xpc->xpc_tree);
+        free(xpc);
+    }
+    return retval;
+}
+
+/*! Release one reference of a compiled XPath, free it when there are no references left
+ *
+ * @param[in]  xpc  Compiled XPath
+ */
+static void
+xpath_compiled_unref(xpath_compiled *xpc)
+{
+    if (--xpc->xpc_refcnt > 0)
+        return;
+    if (xpc->xpc_tree)
+        xpath_tree_free(xpc->xpc_tree);
+    if (xpc->xpc_xpath)
+        free(xpc->xpc_xpath);
+    free(xpc);
+}
+
+#ifdef XPATH_CACHE_SIZE
+/*! Remove entry from XPath cache
+ *
+ * The entry is freed unless it is referenced by a handle or an ongoing evaluation
+ * @param[in]  xpc  Compiled XPath in cache
+ */
+static void
+xpath_cache_rm(xpath_compiled *xpc)
+{
+    clicon_hash_del(_xpath_cache, xpc->xpc_xpath);
+    DELQ(xpc, _xpath_lru, xpath_compiled *);
+    xpc->xpc_cached = 0;
+    _xpath_cache_nr--;
+    xpath_compiled_unref(xpc);
+}
+#endif /* XPATH_CACHE_SIZE */
+
+/*! Get compiled XPath from cache, parse and add it to the cache if not found
+ *
+ * @param[in]  xpath  String with XPath 1.0 syntax
+ * @param[out] xpcp   Compiled XPath, referenced, release with xpath_compiled_unref
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see XPATH_CACHE_SIZE
+ */
+static int
+xpath_cache_get(const char      *xpath,
+                xpath_compiled **xpcp)
+{
+    int             retval = -1;
+    xpath_compiled *xpc = NULL;
+#ifdef XPATH_CACHE_SIZE
+    void           *val;
+#endif
+
+    if (xpath == NULL){
+        clixon_err(OE_XML, EINVAL, "XPath is NULL");
+        goto done;
+    }
+#ifdef XPATH_CACHE_SIZE
+    if (_xpath_cache == NULL &&
+        (_xpath_cache = clicon_hash_init()) == NULL)
+        goto done;
+    if ((val = clicon_hash_value(_xpath_cache, xpath, NULL)) != NULL){
+        _xpath_cache_hit++;
+        xpc = *(xpath_compiled **)val;
+        if (xpc != _xpath_lru){ /* Move first in LRU list */
+            DELQ(xpc, _xpath_lru, xpath_compiled *);
+            INSQ(xpc, _xpath_lru);
+        }
+        xpc->xpc_refcnt++;
+        *xpcp = xpc;
+        retval = 0;
+        goto done;
+    }
+#endif
+    _xpath_cache_miss++;
+    if (xpath_compiled_new(xpath, &xpc) < 0)
+        goto done;
+#ifdef XPATH_CACHE_SIZE
+    if (_xpath_cache_nr >= XPATH_CACHE_SIZE) /* Evict least recently used */
+        xpath_cache_rm(PREVQ(xpath_compiled *, _xpath_lru));
+    if (clicon_hash_add(_xpath_cache, xpath, &xpc, sizeof(xpc)) == NULL){
+        xpath_compiled_unref(xpc);
+        goto done;
+    }
+    INSQ(xpc, _xpath_lru);
+    xpc->xpc_cached = 1;
+    xpc->xpc_refcnt++;
+    _xpath_cache_nr++;
+#endif
+    *xpcp = xpc;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get XPath cache statistics
+ *
+ * @param[out]  nr      Number of cached XPaths
+ * @param[out]  hits    Number of lookups found in cache
+ * @param[out]  misses  Number of lookups that parsed the XPath
+ * @retval      0       OK
+ * @see XPATH_CACHE_SIZE
+ */
+int
+xpath_cache_stats(uint64_t *nr,
+                  uint64_t *hits,
+                  uint64_t *misses)
+{
+    if (nr){
+#ifdef XPATH_CACHE_SIZE
+        *nr = _xpath_cache_nr;
+#else
+        *nr = 0;
+#endif
+    }
+    if (hits)
+        *hits = _xpath_cache_hit;
+    if (misses)
+        *misses = _xpath_cache_miss;
+    return 0;
+}
+
+/*! Free all entries of the XPath cache
+ *
+ * Entries held by precompiled handles remain until the handles are freed
+ */
+void
+xpath_cache_exit(void)
+{
+#ifdef XPATH_CACHE_SIZE
+    while (_xpath_lru)
+        xpath_cache_rm(_xpath_lru);
+    if (_xpath_cache){
+        clicon_hash_free(_xpath_cache);
+        _xpath_cache = NULL;
+    }
+#endif
+}
+
+/*! Compile an XPath into a handle that can be evaluated repeatedly without parsing
+ *
+ * The handle shares the parsed tree with the XPath cache, and remains valid also if evicted.
+ * @param[in]  xpath  String with XPath 1.0 syntax
+ * @param[out] xpcp   Compiled XPath handle, free with xpath_compiled_free
  * @retval     0      OK
  * @retval    -1      Error
  * @code
- *   xp_ctx     *xc = NULL;
- *   if (xpath_vec_ctx(x, NULL, xpath, 0, &xc) < 0)
+ *   xpath_compiled *xpc = NULL;
+ *   if (xpath_compile("/ex:x/ex:y", &xpc) < 0)
  *     err;
- *   if (xc)
- *      ctx_free(xc);
+ *   x = xpath_first_compiled(xt, nsc, xpc);
+ *   xpath_compiled_free(xpc);
  * @endcode
+ * @see xpath_vec_ctx_compiled
  */
 int
-xpath_vec_ctx(cxobj      *xcur,
-              cvec       *nsc,
-              const char *xpath,
-              int         localonly,
-              xp_ctx    **xrp)
+xpath_compile(const char      *xpath,
+              xpath_compiled **xpcp)
+{
+    return xpath_cache_get(xpath, xpcp);
+}
+
+/*! Free compiled XPath handle
+ *
+ * @param[in]  xpc  Compiled XPath handle
+ * @retval     0    OK
+ * @see xpath_compile
+ */
+int
+xpath_compiled_free(xpath_compiled *xpc)
+{
+    if (xpc)
+        xpath_compiled_unref(xpc);
+    return 0;
+}
+
+/*! Get original XPath string of compiled XPath
+ *
+ * @param[in]  xpc  Compiled XPath handle
+ * @retval     str  XPath string
+ */
+char *
+xpath_compiled_str(xpath_compiled *xpc)
+{
+    return xpc->xpc_xpath;
+}
+
+/*! Get parsed XPath tree of compiled XPath
+ *
+ * @param[in]  xpc  Compiled XPath handle
+ * @retval     xs   XPath tree. Do not free
+ */
+xpath_tree *
+xpath_compiled_tree(xpath_compiled *xpc)
+{
+    return xpc->xpc_tree;
+}
+
+/*! Given XML tree and compiled XPath, eval it with limit and return XPath context
+ *
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpc    Compiled XPath
+ * @param[in]  localonly Skip prefix and namespace tests
+ * @param[in]  limit  Max number of nodes needed in result nodeset, 0 means no limit
+ * @param[out] xrp    Return XPath context
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xp_eval_limit
+ */
+static int
+xpath_vec_ctx_limit(cxobj          *xcur,
+                    cvec           *nsc,
+                    xpath_compiled *xpc,
+                    int             localonly,
+                    int             limit,
+                    xp_ctx        **xrp)
 {
     int         retval = -1;
-    xpath_tree *xptree = NULL;
     xp_ctx      xc = {0,};
 
-    clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpath);
-    if (xpath_parse(xpath, &xptree) < 0)
-        goto done;
+    clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpc->xpc_xpath);
     xc.xc_type = XT_NODESET;
     xc.xc_node = xcur;
     xc.xc_initial = xcur;
     if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
         goto done;
-    if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
+    /* Hold reference: a nested evaluation may evict the entry from the cache */
+    xpc->xpc_refcnt++;
+    if (xp_eval_limit(&xc, xpc->xpc_tree, nsc, localonly, limit, xrp) < 0){
+        xpath_compiled_unref(xpc);
         goto done;
+    }
+    xpath_compiled_unref(xpc);
     retval = 0;
  done:
     if (xc.xc_nodeset){
         free(xc.xc_nodeset);
         xc.xc_nodeset = NULL;
     }
-    if (xptree)
-        xpath_tree_free(xptree);
     return retval;
 }
 
+/*! Given XML tree and XPath string, eval it with limit and return XPath context
+ *
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath 1.0 syntax
+ * @param[in]  localonly Skip prefix and namespace tests
+ * @param[in]  limit  Max number of nodes needed in result nodeset, 0 means no limit
+ * @param[out] xrp    Return XPath context
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xpath_vec_ctx_str(cxobj      *xcur,
+                  cvec       *nsc,
+                  const char *xpath,
+                  int         localonly,
+                  int         limit,
+                  xp_ctx    **xrp)
+{
+    int             retval = -1;
+    xpath_compiled *xpc = NULL;
+
+    if (xpath_cache_get(xpath, &xpc) < 0)
+        goto done;
+    if (xpath_vec_ctx_limit(xcur, nsc, xpc, localonly, limit, xrp) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (xpc)
+        xpath_compiled_unref(xpc);
+    return retval;
+}
+
+/*! Given XML tree and compiled XPath, eval it and return XPath context
+ *
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpc    Compiled XPath
+ * @param[in]  localonly Skip prefix and namespace tests
+ * @param[out] xrp    Return XPath context
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xpath_vec_ctx
+ */
+int
+xpath_vec_ctx_compiled(cxobj          *xcur,
+                       cvec           *nsc,
+                       xpath_compiled *xpc,
+                       int             localonly,
+                       xp_ctx        **xrp)
+{
+    return xpath_vec_ctx_limit(xcur, nsc, xpc, localonly, 0, xrp);
+}
+
+/*! Compiled XPath nodeset function where only the first matching entry is returned
+ *
+ * Evaluation stops when the first node is found
+ * @param[in]  xcur      XML tree where to search
+ * @param[in]  nsc       External XML namespace context, or NULL
+ * @param[in]  xpc       Compiled XPath
+ * @retval     xml-tree  XML tree of first match
+ * @retval     NULL      Error or not found
+ * @see xpath_first
+ */
+cxobj *
+xpath_first_compiled(cxobj          *xcur,
+                     cvec           *nsc,
+                     xpath_compiled *xpc)
+{
+    cxobj     *cx = NULL;
+    xp_ctx    *xr = NULL;
+
+    if (xpath_vec_ctx_limit(xcur, nsc, xpc, 0, 1, &xr) < 0)
+        goto done;
+    if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
+        cx = xr->xc_nodeset[0];
+ done:
+    if (xr)
+        ctx_free(xr);
+    return cx;
+}
+
+/*! Compiled XPath that returns a vector of matches
+ *
+ * If result is not nodeset, return empty nodeset
+ * @param[in]  xcur     xml-tree where to search
+ * @param[in]  nsc      External XML namespace context, or NULL
+ * @param[in]  xpc      Compiled XPath
+ * @param[out] vec      vector of xml-trees. Vector must be free():d after use
+ * @param[out] veclen   returns length of vector in return value
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xpath_vec
+ */
+int
+xpath_vec_compiled(cxobj          *xcur,
+                   cvec           *nsc,
+                   xpath_compiled *xpc,
+                   cxobj        ***vec,
+                   size_t         *veclen)
+{
+    int        retval = -1;
+    xp_ctx    *xr = NULL;
+
+    *vec = NULL;
+    *veclen = 0;
+    if (xpath_vec_ctx_compiled(xcur, nsc, xpc, 0, &xr) < 0)
+        goto done;
+    if (xr && xr->xc_type == XT_NODESET){
+        *vec    = xr->xc_nodeset;
+        xr->xc_nodeset = NULL;
+        *veclen = xr->xc_size;
+    }
+    retval = 0;
+ done:
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
+/*! Compiled XPath that returns boolean
+ *
+ * Returns true if the nodeset is non-empty. Evaluation stops at the first node found.
+ * Intended for expressions evaluated on many XML nodes, such as YANG must and when
+ * @param[in]  xcur     xml-tree where to search
+ * @param[in]  nsc      External XML namespace context, or NULL
+ * @param[in]  xpc      Compiled XPath
+ * @retval     1        True
+ * @retval     0        False
+ * @retval    -1        Error
+ * @see xpath_vec_bool
+ * @see yang_xpath_compiled_get
+ */
+int
+xpath_vec_bool_compiled(cxobj          *xcur,
+                        cvec           *nsc,
+                        xpath_compiled *xpc)
+{
+    int        retval = -1;
+    xp_ctx    *xr = NULL;
+
+    if (xpath_vec_ctx_limit(xcur, nsc, xpc, 0, 1, &xr) < 0)
+        goto done;
+    if (xr)
+        retval = ctx2boolean(xr);
+ done:
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
+/*! Given XML tree and XPath, parse XPath, eval it and return XPath context,
+ *
+ * This is a raw form of XPath where you can do type conversion of the return
+ * value, etc, not just a nodeset.
+ * Parsed XPaths are cached, see XPATH_CACHE_SIZE
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPath 1.0 syntax
+ * @param[in]  localonly Skip prefix and namespace tests
+ * @param[out] xrp    Return XPath context
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   xp_ctx     *xc = NULL;
+ *   if (xpath_vec_ctx(x, NULL, xpath, 0, &xc) < 0)
+ *     err;
+ *   if (xc)
+ *      ctx_free(xc);
+ * @endcode
+ */
+int
+xpath_vec_ctx(cxobj      *xcur,
+              cvec       *nsc,
+              const char *xpath,
+              int         localonly,
+              xp_ctx    **xrp)
+{
+    return xpath_vec_ctx_str(xcur, nsc, xpath, localonly, 0, xrp);
+}
+
 /*! XPath nodeset function where only the first matching entry is returned
  *
  * @param[in]  xcur      XML tree where to search
@@ -676,6 +1194,7 @@ xpath_vec_ctx(cxobj      *xcur,
  *   }
  * @endcode
  * @note  the returned pointer points into the original tree so should not be freed after use.
+ * @note  evaluation stops when the first matching node is found
  * @note return value does not see difference between error and not found
  * @see also xpath_vec.
  */
@@ -707,7 +1226,7 @@ xpath_first(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
+    if (xpath_vec_ctx_str(xcur, nsc, xpath, 0, 1, &xr) < 0)
         goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
         cx = xr->xc_nodeset[0];
@@ -735,6 +1254,7 @@ xpath_first(cxobj      *xcur,
  *   }
  * @endcode
  * @note  the returned pointer points into the original tree so should not be freed after use.
+ * @note  evaluation stops when the first matching node is found
  * @note return value does not see difference between error and not found
  * @note Prefixes and namespaces are ignored so this is NOT according to standard
  * @see also xpath_first.
@@ -766,7 +1286,7 @@ xpath_first_localonly(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, NULL, xpath, 1, &xr) < 0)
+    if (xpath_vec_ctx_str(xcur, NULL, xpath, 1, 1, &xr) < 0)
         goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
         cx = xr->xc_nodeset[0];
@@ -967,7 +1487,8 @@ xpath_vec_bool(cxobj      *xcur,
         goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
+    /* A node-set is true if non-empty: one node is enough */
+    if (xpath_vec_ctx_str(xcur, nsc, xpath, 0, 1, &xr) < 0)
         goto done;
     if (xr)
         retval = ctx2boolean(xr);
@@ -84,6 +84,7 @@
 #include "clixon_debug.h"
 #include "clixon_yang_type.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_index.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_string.h"
@@ -153,8 +154,8 @@ nodetest_eval_namespace(cxobj      *x,
     name2 = xs->xs_s1;
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s %s", name1, name2);
     if (strcmp(name2, "*") != 0){
-        /* if name1 != name2 -> fail */
-        if (strcmp(name1, name2) != 0)
+        /* if name1 != name2 -> fail. Both are interned, see xp_new */
+        if (name1 != name2)
             goto fail;
     }
     /* get namespace of xml tree */
@@ -213,8 +214,8 @@ nodetest_eval_prefixonly(cxobj      *x,
     name2 = xs->xs_s1;
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s:%s %s:%s", prefix1, name1, prefix2, name2);
     if (strcmp(name2, "*") != 0){
-        /* if name1 != name2 -> fail */
-        if (strcmp(name1, name2) != 0)
+        /* if name1 != name2 -> fail. Both are interned, see xp_new */
+        if (name1 != name2)
             goto fail;
     }
     ret = clicon_strcmp(prefix1, prefix2);
@@ -253,8 +254,8 @@ nodetest_eval_localonly(cxobj      *x,
         retval = 1;
         goto done;
     }
-    /* Check name only */
-    if (strcmp(name1, name2) == 0){
+    /* Check name only, both are interned, see xp_new */
+    if (name1 == name2){
         retval = 1;
         goto done;
     }
@@ -313,6 +314,7 @@ nodetest_eval(cxobj      *x,
  * @param[in]  flags
  * @param[in]  nsc        XML Namespace context
  * @param[in]  localonly  Skip prefix and namespace tests (non-standard)
+ * @param[in]  limit      Stop descending when vector has this many nodes, 0 means no limit
  * @param[out] vec0
  * @param[out] vec0len
  * @retval     0          OK
@@ -325,6 +327,7 @@ nodetest_recursive(cxobj      *xn,
                    uint16_t    flags,
                    cvec       *nsc,
                    int         localonly,
+                   int         limit,
                    cxobj    ***vec0,
                    int        *vec0len)
 {
@@ -335,6 +338,8 @@ nodetest_recursive(cxobj      *xn,
 
     xsub = NULL;
     while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
+        if (limit && veclen >= limit)
+            break;
         if (nodetest_eval(xsub, nodetest, nsc, localonly) == 1){
             clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%x %x", flags, xml_flag(xsub, flags));
             if (flags==0x0 || xml_flag(xsub, flags))
@@ -342,7 +347,7 @@ nodetest_recursive(cxobj      *xn,
                     goto done;
             //      continue; /* Don't go deeper */
         }
-        if (nodetest_recursive(xsub, nodetest, node_type, flags, nsc, localonly, &vec, &veclen) < 0)
+        if (nodetest_recursive(xsub, nodetest, node_type, flags, nsc, localonly, limit, &vec, &veclen) < 0)
             goto done;
     }
     retval = 0;
@@ -352,12 +357,67 @@ nodetest_recursive(cxobj      *xn,
     return retval;
 }
 
+/*! Test descendant nodes, use descendant index if tree is indexed
+ *
+ * Same result as nodetest_recursive with element node type and no flags
+ * @param[in]  xn         Context node
+ * @param[in]  nodetest   XPath stack
+ * @param[in]  nsc        XML Namespace context
+ * @param[in]  localonly  Skip prefix and namespace tests (non-standard)
+ * @param[in]  limit      Stop when vector has this many nodes, 0 means no limit
+ * @param[out] vec0
+ * @param[out] vec0len
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see CLICON_XMLDB_DESCENDANT_INDEX
+ */
+static int
+nodetest_descendant(cxobj      *xn,
+                    xpath_tree *nodetest,
+                    cvec       *nsc,
+                    int         localonly,
+                    int         limit,
+                    cxobj    ***vec0,
+                    int        *vec0len)
+{
+    int     retval = -1;
+    cxobj **vec = NULL;
+    int     veclen = 0;
+    int     i;
+    int     ret;
+
+    if (nodetest != NULL && nodetest->xs_type == XP_NODE &&
+        strcmp(nodetest->xs_s1, "*") != 0){
+        if ((ret = xml_descendant_index_find(xn, nodetest->xs_s1, &vec, &veclen)) < 0)
+            goto done;
+        if (ret == 1){
+            for (i=0; i<veclen; i++){
+                if (limit && *vec0len >= limit)
+                    break;
+                if (nodetest_eval(vec[i], nodetest, nsc, localonly) == 1 &&
+                    cxvec_append(vec[i], vec0, vec0len) < 0)
+                    goto done;
+            }
+            goto ok;
+        }
+    }
+    if (nodetest_recursive(xn, nodetest, CX_ELMNT, 0x0, nsc, localonly, limit, vec0, vec0len) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (vec)
+        free(vec);
+    return retval;
+}
+
 /*! Evaluate xpath step rule of an XML tree
  *
  * @param[in]  xc0       Incoming context
  * @param[in]  xs        Parsed XPath node tree
  * @param[in]  nsc       XML Namespace context
  * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  limit     Max number of nodes needed in result nodeset, 0 means no limit
  * @param[out] xrp       Resulting context
  * @retval     0         OK
  * @retval    -1         Error
@@ -373,6 +433,7 @@ xp_eval_step(xp_ctx     *xc0,
              xpath_tree *xs,
              cvec       *nsc,
              int         localonly,
+             int         limit,
              xp_ctx    **xrp)
 {
     int         retval = -1;
@@ -385,10 +446,15 @@ xp_eval_step(xp_ctx     *xc0,
     xpath_tree *nodetest = xs->xs_c0;
     xp_ctx     *xc = NULL;
     int         ret;
+    int         steplimit = 0;
 
     /* Create new xc */
     if ((xc = ctx_dup(xc0)) == NULL)
         goto done;
+    /* Stop collecting nodes at limit only if there are no predicates that filter them */
+    if (xs->xs_c1 == NULL ||
+        (xs->xs_c1->xs_c0 == NULL && xs->xs_c1->xs_c1 == NULL))
+        steplimit = limit;
     switch (xs->xs_int){
     case A_ANCESTOR:
         break;
@@ -399,8 +465,15 @@ xp_eval_step(xp_ctx     *xc0,
     case A_CHILD:
         if (xc->xc_descendant){
             for (i=0; i<xc->xc_size; i++){
+                if (steplimit && veclen >= steplimit)
+                    break;
                 xv = xc->xc_nodeset[i];
-                if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+                /* Use descendant index for a single context node, eg root */
+                if (xc->xc_size == 1){
+                    if (nodetest_descendant(xv, nodetest, nsc, localonly, steplimit, &vec, &veclen) < 0)
+                        goto done;
+                }
+                else if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, steplimit, &vec, &veclen) < 0)
                     goto done;
             }
             xc->xc_descendant = 0;
@@ -412,13 +485,17 @@ xp_eval_step(xp_ctx     *xc0,
                 int     veclen0 = 0;
                 int     j;
 
+                if (steplimit && veclen >= steplimit)
+                    break;
                 xv = xc->xc_nodeset[i];
                 x = NULL;
                 if ((ret = xpath_optimize_check(xs, xv, &vec0, &veclen0)) < 0)
                     goto done;
                 if (ret == 1){
                     for (j=0; j<veclen0; j++){
-                        if (cxvec_append(vec0[0], &vec, &veclen) < 0)
+                        if (steplimit && veclen >= steplimit)
+                            break;
+                        if (cxvec_append(vec0[j], &vec, &veclen) < 0)
                             goto done;
                     }
                     if (vec0)
@@ -431,6 +508,8 @@ xp_eval_step(xp_ctx     *xc0,
                             nodetest_eval(x, nodetest, nsc, localonly) == 1){
                             if (cxvec_append(x, &vec, &veclen) < 0)
                                 goto done;
+                            if (steplimit && veclen >= steplimit)
+                                break;
                         }
                     }
                 }
@@ -442,8 +521,11 @@ xp_eval_step(xp_ctx     *xc0,
         break;
     case A_DESCENDANT_OR_SELF:
         for (i=0; i<xc->xc_size; i++){
+            if (steplimit && xc->xc_size + veclen >= steplimit)
+                break;
             xv = xc->xc_nodeset[i];
-            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly,
+                                   steplimit?steplimit-xc->xc_size:0, &vec, &veclen) < 0)
                 goto done;
         }
         for (i=0; i<veclen; i++){
@@ -458,8 +540,14 @@ xp_eval_step(xp_ctx     *xc0,
         break;
     case A_DESCENDANT:
         for (i=0; i<xc->xc_size; i++){
+            if (steplimit && veclen >= steplimit)
+                break;
             xv = xc->xc_nodeset[i];
-            if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+            if (xc->xc_size == 1){
+                if (nodetest_descendant(xv, xs->xs_c0, nsc, localonly, steplimit, &vec, &veclen) < 0)
+                    goto done;
+            }
+            else if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, steplimit, &vec, &veclen) < 0)
                 goto done;
         }
         ctx_nodeset_replace(xc, vec, veclen);
@@ -503,7 +591,7 @@ xp_eval_step(xp_ctx     *xc0,
         break;
     }
     if (xs->xs_c1){
-        if (xp_eval(xc, xs->xs_c1, nsc, localonly, xrp) < 0)
+        if (xp_eval_limit(xc, xs->xs_c1, nsc, localonly, limit, xrp) < 0)
             goto done;
     }
     else{
@@ -528,6 +616,7 @@ xp_eval_step(xp_ctx     *xc0,
  * @param[in]  xs      XPath node tree
  * @param[in]  nsc     XML Namespace context
  * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  limit   Max number of nodes needed in result nodeset, 0 means no limit
  * @param[out] xrp     Resulting context
  * @retval     0       OK
  * @retval    -1       Error
@@ -552,6 +641,7 @@ xp_eval_predicate(xp_ctx     *xc,
                   xpath_tree *xs,
                   cvec       *nsc,
                   int         localonly,
+                  int         limit,
                   xp_ctx    **xrp)
 {
     int      retval = -1;
@@ -563,7 +653,7 @@ xp_eval_predicate(xp_ctx     *xc,
     xp_ctx  *xcc = NULL;
 
     if (xs->xs_c0 != NULL){ /* eval previous predicates */
-        if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+        if (xp_eval_limit(xc, xs->xs_c0, nsc, localonly, xs->xs_c1?0:limit, &xr0) < 0)
             goto done;
     }
     else{ /* empty */
@@ -584,6 +674,9 @@ xp_eval_predicate(xp_ctx     *xc,
         xr1->xc_node = xc->xc_node;
         xr1->xc_initial = xc->xc_initial;
         for (i=0; i<xr0->xc_size; i++){
+            /* Filtering a node only depends on the node and its position */
+            if (limit && xr1->xc_size >= limit)
+                break;
             x = xr0->xc_nodeset[i];
             /* Create new context */
             if ((xcc = malloc(sizeof(*xcc))) == NULL){
@@ -599,7 +692,8 @@ xp_eval_predicate(xp_ctx     *xc,
              * evaluated with that node as the context node */
             if (cxvec_append(x, &xcc->xc_nodeset, &xcc->xc_size) < 0)
                 goto done;
-            if (xp_eval(xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
+            /* Result is converted to boolean if not a number, one node is enough */
+            if (xp_eval_limit(xcc, xs->xs_c1, nsc, localonly, 1, &xrc) < 0)
                 goto done;
             ctx_free(xcc);
             xcc = NULL;
@@ -1194,6 +1288,92 @@ xp_union(xp_ctx    *xc1,
     return retval;
 }
 
+/*! Skip single-child expression nodes without operator, eg relexpr -> addexpr
+ *
+ * @param[in]  xs  XPath node tree
+ * @retval     xs  First node that is not a single-child expression
+ */
+static xpath_tree *
+xp_skip_single(xpath_tree *xs)
+{
+    while (xs && xs->xs_c1 == NULL && xs->xs_c0 != NULL){
+        switch (xs->xs_type){
+        case XP_EXP:
+        case XP_AND:
+        case XP_RELEX:
+        case XP_ADD:
+        case XP_UNION:
+        case XP_PATHEXPR:
+        case XP_FILTEREXPR:
+        case XP_PRI0:
+            xs = xs->xs_c0;
+            break;
+        default:
+            return xs;
+        }
+    }
+    return xs;
+}
+
+/*! Evaluate existence tests: count(nodeset) > 0, count(nodeset) != 0 and count(nodeset) = 0
+ *
+ * Evaluate the nodeset until the first node is found instead of counting all nodes
+ * @param[in]  xc   Incoming context
+ * @param[in]  xs   XPath node tree of type XP_RELEX
+ * @param[in]  nsc  XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp  Resulting boolean context
+ * @retval     1    Existence test evaluated
+ * @retval     0    Not an existence test
+ * @retval    -1    Error
+ */
+static int
+xp_count_exists(xp_ctx     *xc,
+                xpath_tree *xs,
+                cvec       *nsc,
+                int         localonly,
+                xp_ctx    **xrp)
+{
+    int         retval = -1;
+    xpath_tree *xfn;
+    xpath_tree *xnr;
+    xp_ctx     *xr0 = NULL;
+    xp_ctx     *xr = NULL;
+
+    if (xs->xs_int != XO_GT && xs->xs_int != XO_NE && xs->xs_int != XO_EQ)
+        goto fail;
+    xfn = xp_skip_single(xs->xs_c0);
+    xnr = xp_skip_single(xs->xs_c1);
+    if (xfn == NULL || xfn->xs_type != XP_PRIME_FN || xfn->xs_s0 == NULL ||
+        xfn->xs_int != XPATHFN_COUNT ||
+        xfn->xs_c0 == NULL || xfn->xs_c0->xs_c0 == NULL)
+        goto fail;
+    if (xnr == NULL || xnr->xs_type != XP_PRIME_NR || xnr->xs_double != 0.0)
+        goto fail;
+    if (xp_eval_limit(xc, xfn->xs_c0->xs_c0, nsc, localonly, 1, &xr0) < 0)
+        goto done;
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xr, 0, sizeof(*xr));
+    xr->xc_initial = xc->xc_initial;
+    xr->xc_type = XT_BOOL;
+    if (xs->xs_int == XO_EQ)
+        xr->xc_bool = (xr0->xc_size == 0);
+    else
+        xr->xc_bool = (xr0->xc_size > 0);
+    *xrp = xr;
+    retval = 1;
+ done:
+    if (xr0)
+        ctx_free(xr0);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Evaluate an XPath on an XML tree
  *
  * The initial sequence of steps selects a set of nodes relative to a context node. 
@@ -1205,6 +1385,7 @@ xp_union(xp_ctx    *xc1,
  * @param[out] xrp  Resulting context
  * @retval     0    OK
  * @retval    -1    Error
+ * @see xp_eval_limit
  */
 int
 xp_eval(xp_ctx     *xc,
@@ -1212,6 +1393,34 @@ xp_eval(xp_ctx     *xc,
         cvec       *nsc,
         int         localonly,
         xp_ctx    **xrp)
+{
+    return xp_eval_limit(xc, xs, nsc, localonly, 0, xrp);
+}
+
+/*! Evaluate an XPath on an XML tree, stop when a number of result nodes are found
+ *
+ * The limit applies to a resulting nodeset only: other results are computed fully.
+ * The nodes found are the first nodes of the nodeset evaluated without limit.
+ * The limit is propagated to the last location step, and descending stops when enough
+ * nodes are found. Subexpressions converted to boolean are evaluated with limit 1, and the
+ * right operand of and/or is not evaluated if the left operand determines the result.
+ * @param[in]  xc    Incoming context
+ * @param[in]  xs    XPath node tree
+ * @param[in]  nsc   XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  limit Max number of nodes needed in result nodeset, 0 means no limit
+ * @param[out] xrp   Resulting context
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xpath_first  Uses limit 1
+ */
+int
+xp_eval_limit(xp_ctx     *xc,
+              xpath_tree *xs,
+              cvec       *nsc,
+              int         localonly,
+              int         limit,
+              xp_ctx    **xrp)
 {
     int        retval = -1;
     cxobj     *x;
@@ -1219,6 +1428,10 @@ xp_eval(xp_ctx     *xc,
     xp_ctx    *xr1 = NULL;
     xp_ctx    *xr2 = NULL;
     int        use_xr0 = 0; /* In 2nd child use transitively result of 1st child */
+    int        limit0 = 0;  /* Limit of first child */
+    int        limit1 = 0;  /* Limit of second child */
+    int        b;
+    int        ret;
 
     // ctx_print(stderr, xc, xpath_tree_int2str(xs->xs_type));
     /* Pre-actions before check first child c0
@@ -1245,13 +1458,21 @@ xp_eval(xp_ctx     *xc,
         if (xs->xs_int == A_DESCENDANT_OR_SELF)
             xc->xc_descendant = 1; /* XXX need to set to 0 in sub */
         break;
+    case XP_RELEX:
+        if (xs->xs_c1 == NULL)
+            break;
+        if ((ret = xp_count_exists(xc, xs, nsc, localonly, xrp)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
+        break;
     case XP_STEP:    /* XP_NODE is first argument -not called explicitly */
-        if (xp_eval_step(xc, xs, nsc, localonly, xrp) < 0)
+        if (xp_eval_step(xc, xs, nsc, localonly, limit, xrp) < 0)
             goto done;
         goto ok; /* Skip generic child traverse */
         break;
     case XP_PRED:
-        if (xp_eval_predicate(xc, xs, nsc, localonly, xrp) < 0)
+        if (xp_eval_predicate(xc, xs, nsc, localonly, limit, xrp) < 0)
             goto done;
         goto ok;
         break;
@@ -1373,10 +1594,22 @@ xp_eval(xp_ctx     *xc,
     default:
         break;
     }
+    /* Limits of children: if only one child, its result is the result.
+     * In a location path the second child (step) is the result.
+     * Operands of and/or are converted to boolean.
+     */
+    if (xs->xs_c1 == NULL)
+        limit0 = limit;
+    else if (xs->xs_type == XP_AND){
+        limit0 = 1;
+        limit1 = 1;
+    }
+    else if (xs->xs_type == XP_RELLOCPATH || xs->xs_type == XP_PATHEXPR)
+        limit1 = limit;
     /* Eval first child c0
      */
     if (xs->xs_c0){
-        if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+        if (xp_eval_limit(xc, xs->xs_c0, nsc, localonly, limit0, &xr0) < 0)
             goto done;
     }
     /* Actions between first and second child
@@ -1385,6 +1618,22 @@ xp_eval(xp_ctx     *xc,
     case XP_EXP:
         break;
     case XP_AND:
+        /* Short-circuit: the right operand is not evaluated if the left determines the result */
+        if (xs->xs_c1 && xr0){
+            if ((b = ctx2boolean(xr0)) < 0)
+                goto done;
+            if ((xs->xs_int == XO_AND && !b) ||
+                (xs->xs_int == XO_OR && b)){
+                if ((xr2 = malloc(sizeof(*xr2))) == NULL){
+                    clixon_err(OE_UNIX, errno, "malloc");
+                    goto done;
+                }
+                memset(xr2, 0, sizeof(*xr2));
+                xr2->xc_initial = xc->xc_initial;
+                xr2->xc_type = XT_BOOL;
+                xr2->xc_bool = b;
+            }
+        }
         break;
     case XP_RELEX: /* relexpr --> addexpr | relexpr relop addexpr */
         break;
@@ -1459,8 +1708,8 @@ xp_eval(xp_ctx     *xc,
     /* Eval second child c1
      * Note, some operators like locationpath, need transitive context (use_xr0)
      */
-    if (xs->xs_c1){
-        if (xp_eval(use_xr0?xr0:xc, xs->xs_c1, nsc, localonly, &xr1) < 0)
+    if (xs->xs_c1 && xr2 == NULL){
+        if (xp_eval_limit(use_xr0?xr0:xc, xs->xs_c1, nsc, localonly, limit1, &xr1) < 0)
             goto done;
         /* Actions after second child
          */
@@ -1516,4 +1765,4 @@ xp_eval(xp_ctx     *xc,
     if (xr0)
         ctx_free(xr0);
     return retval;
-} /* xp_eval */
+} /* xp_eval_limit */
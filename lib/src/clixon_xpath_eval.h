@@ -46,5 +46,6 @@ extern const map_str2int xpopmap[];
  * Prototypes
  */
 int xp_eval(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
+int xp_eval_limit(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, int limit, xp_ctx **xrp);
 
 #endif /* _CLIXON_XPATH_EVAL_H */
@@ -352,17 +352,13 @@ derived_from_one(char  *baseidentity,
     yang_stmt *yleaf;
     yang_stmt *ytype;
     yang_stmt *ybaseid;
+    yang_stmt *yid;
     yang_stmt *ymod;
-    cvec      *idrefvec; /* Derived identityref list: (module:id)**/
     char      *node = NULL;
     char      *prefix = NULL;
     char      *id = NULL;
-    cbuf      *cb = NULL;
-    char      *baseid = NULL;
+    int        ret;
 
-    /* Split baseidentity to get its id (w/o prefix) */
-    if (nodeid_split(baseidentity, NULL, &baseid) < 0)
-        goto done;
     if ((yleaf = xml_spec(xleaf)) == NULL)
         goto nomatch;
     if (yang_keyword_get(yleaf) != Y_LEAF && yang_keyword_get(yleaf) != Y_LEAF_LIST)
@@ -381,8 +377,6 @@ derived_from_one(char  *baseidentity,
     /* Just get the object corresponding to the base identity */
     if ((ybaseid = yang_find_identity_nsc(ys_spec(yleaf), baseidentity, nsc)) == NULL)
         goto nomatch;
-    /* Get its list of derived identities  */
-    idrefvec = yang_cvec_get(ybaseid);
     /* Get and split the leaf id reference */
     if ((node = xml_body(xleaf)) == NULL) /* It may not be empty */
         goto nomatch;
@@ -396,28 +390,19 @@ derived_from_one(char  *baseidentity,
     }
     if (ymod == NULL)
         goto nomatch;
+    if ((yid = yang_find(ymod, Y_IDENTITY, id)) == NULL)
+        goto nomatch;
     /* self special case, ie that the xleaf has a ref to itself */
-    if (self &&
-        ymod == ys_module(ybaseid) &&
-        strcmp(baseid, id) == 0){
+    if (self && yid == ybaseid)
         ; /* match */
-    }
     else {
-        /* Allocate cbuf */
-        if ((cb = cbuf_new()) == NULL){
-            clixon_err(OE_UNIX, errno, "cbuf_new");
+        if ((ret = yang_identity_derived(yid, ybaseid)) < 0)
             goto done;
-        }
-        cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
-        if (cvec_find(idrefvec, cbuf_get(cb)) == NULL)
+        if (ret == 0)
             goto nomatch;
     }
     retval = 1;
  done:
-    if (baseid)
-        free(baseid);
-    if (cb)
-        cbuf_free(cb);
     if (id)
         free(id);
     if (prefix)
@@ -1206,7 +1191,8 @@ xp_function_boolean(xp_ctx            *xc,
         clixon_err(OE_XML, EINVAL, "not expects but did not get one argument");
         goto done;
     }
-    if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0)
+    /* A node-set is true if non-empty: one node is enough */
+    if (xp_eval_limit(xc, xs->xs_c0, nsc, localonly, 1, &xr0) < 0)
         goto done;
     bool = ctx2boolean(xr0);
     if ((xr = malloc(sizeof(*xr))) == NULL){
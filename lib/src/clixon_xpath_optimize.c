@@ -34,6 +34,10 @@
 
  * Clixon XML XPath 1.0 according to https://www.w3.org/TR/xpath-10
  * See XPATH_LIST_OPTIMIZE
+ * Location steps on YANG lists and leaf-lists with equality predicates on keys are evaluated
+ * using binary search instead of a linear scan of all children, eg:
+ *   y[k1='a'][k2='b'], y[k2='b' and k1='a'], y[k1='a'] (prefix of keys), z[.='v'] (leaf-list)
+ * Every step of absolute and relative location paths is checked, eg a/y[k='3']/z[.='4']
  */
 
 #ifdef HAVE_CONFIG_H
@@ -71,20 +75,34 @@
 #include "clixon_xpath_optimize.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
-static xpath_tree *_xmtop = NULL; /* pattern match tree top */
-static xpath_tree *_xm = NULL;
-static xpath_tree *_xe = NULL;
 static int _optimize_enable = 1;
-static int _optimize_hits = 0;
+static int _optimize_hits = 0;   /* Steps evaluated using binary search */
+static int _optimize_misses = 0; /* Steps with predicates evaluated using linear scan */
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/* XXX development in clixon_xpath_eval */
+/*! Get and reset XPath list optimization statistics
+ *
+ * Counted per location step and context node
+ * @param[out]  hits    Number of steps evaluated using binary search
+ * @param[out]  misses  Number of steps with predicates that could not be optimized
+ * @retval      0       OK
+ */
 int
-xpath_list_optimize_stats(int *hits)
+xpath_list_optimize_stats(int *hits,
+                          int *misses)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    *hits = _optimize_hits;
+    if (hits)
+        *hits = _optimize_hits;
+    if (misses)
+        *misses = _optimize_misses;
     _optimize_hits = 0;
+    _optimize_misses = 0;
+#else
+    if (hits)
+        *hits = 0;
+    if (misses)
+        *misses = 0;
 #endif
     return 0;
 }
@@ -102,130 +120,250 @@ xpath_list_optimize_set(int enable)
     return 0;
 }
 
+/*! Free xpath optimize resources
+ *
+ * Predicates are matched directly on the XPath tree, there is no pattern tree to free
+ */
 void
 xpath_optimize_exit(void)
 {
-#ifdef XPATH_LIST_OPTIMIZE
-    if (_xmtop)
-        xpath_tree_free(_xmtop);
-#endif
 }
 
 #ifdef XPATH_LIST_OPTIMIZE
-/*! Initialize xpath module
+/*! Skip expression nodes with a single child and no operator
  *
- * XXX move to clixon_xpath.c 
- * @see loop_preds
+ * @param[in]  xs  XPath tree
+ * @retval     xs  First node with an operator, or a step or primary expression
  */
-int
-xpath_optimize_init(xpath_tree **xm,
-                    xpath_tree **xe)
+static xpath_tree *
+xpath_optimize_skip(xpath_tree *xs)
 {
-    int         retval = -1;
-    xpath_tree *xs;
+    while (xs && xs->xs_c0 && xs->xs_c1 == NULL){
+        switch (xs->xs_type){
+        case XP_EXP:
+        case XP_AND:
+        case XP_RELEX:
+        case XP_ADD:
+        case XP_UNION:
+        case XP_PATHEXPR:
+        case XP_LOCPATH:
+            break;
+        case XP_RELLOCPATH:
+            if (xs->xs_int == A_DESCENDANT_OR_SELF)
+                return xs;
+            break;
+        default:
+            return xs;
+        }
+        xs = xs->xs_c0;
+    }
+    return xs;
+}
 
-    if (_xm == NULL){
-        /* Initialize xpath-tree */
-        if (xpath_parse("_x[_y='_z']", &_xmtop) < 0)
-            goto done;
-        /* Go down two steps */
-        if ((_xm = xpath_tree_traverse(_xmtop, 0, 0, -1)) == NULL)
-            goto done;
-        /* get nodetest tree (_x) */
-        if ((xs = xpath_tree_traverse(_xm, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++;
-        /* get predicates [_y=_z][z=2] */
-        if ((xs = xpath_tree_traverse(_xm, 1, -1)) == NULL)
-            goto done;
-        xs->xs_match++;
-        /* get expression [_y=_z] */
-        if ((_xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
-            goto done;
-        /* get keyname (_y) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++; /* in loop_preds get name in xs_s1 XXX: leaf-list is different */
-        /* get keyval (_z) */
-        if ((xs = xpath_tree_traverse(_xe, 0, 0, 1, 0, 0, 0, 0, -1)) == NULL)
-            goto done;
-        xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
+/*! Check if step has no predicates
+ */
+static int
+xpath_optimize_nopred(xpath_tree *xs)
+{
+    return xs->xs_c1 == NULL ||
+        (xs->xs_c1->xs_c0 == NULL && xs->xs_c1->xs_c1 == NULL);
+}
+
+/*! Get name of child or self step in predicate equality: k or .
+ *
+ * @param[in]  xs    XPath tree
+ * @retval     name  Name of child node, or "." for self
+ * @retval     NULL  Not a single child or self step without predicates
+ */
+static char *
+xpath_optimize_name(xpath_tree *xs)
+{
+    xpath_tree *xn;
+
+    if ((xs = xpath_optimize_skip(xs)) == NULL ||
+        xs->xs_type != XP_STEP ||
+        !xpath_optimize_nopred(xs))
+        return NULL;
+    switch (xs->xs_int){
+    case A_SELF:
+        if (xs->xs_c0 != NULL)
+            return NULL;
+        return ".";
+    case A_CHILD:
+        if ((xn = xs->xs_c0) == NULL ||
+            xn->xs_type != XP_NODE ||
+            xn->xs_s1 == NULL ||
+            strcmp(xn->xs_s1, "*") == 0)
+            return NULL;
+        return xn->xs_s1;
+    default:
+        break;
     }
-    *xm = _xm;
-    *xe = _xe;
-    retval = 0;
- done:
-    return retval;
+    return NULL;
+}
+
+/*! Get literal value in predicate equality: 'v' or number
+ *
+ * @param[in]  xs    XPath tree
+ * @retval     val   Original string of literal
+ * @retval     NULL  Not a literal
+ */
+static char *
+xpath_optimize_value(xpath_tree *xs)
+{
+    if ((xs = xpath_optimize_skip(xs)) != NULL){
+        if (xs->xs_type == XP_FILTEREXPR && xs->xs_c1 == NULL)
+            xs = xs->xs_c0;
+        if (xs == NULL)
+            return NULL;
+        if (xs->xs_type == XP_PRIME_STR)
+            return xs->xs_s0;
+        if (xs->xs_type == XP_PRIME_NR)
+            return xs->xs_strnr;
+    }
+    return NULL;
 }
 
-/*! Recursive function to loop over all EXPR and pattern match them
+/*! Collect <name>=<value> equalities of a predicate expression
+ *
+ * Accepts k='v', 'v'=k, .='v', and conjunctions using "and" of these
+ * @param[in]  xs    XPath tree of predicate expression
+ * @param[out] cvk   Vector of <name>:<value> pairs
+ * @retval     1     All predicate terms are equalities, added to cvk
+ * @retval     0     Other predicate, no optimization
+ * @retval    -1     Error
+ */
+static int
+xpath_optimize_preds_expr(xpath_tree *xs,
+                          cvec       *cvk)
+{
+    int     ret;
+    char   *name;
+    char   *val;
+    cg_var *cvi;
+
+    if ((xs = xpath_optimize_skip(xs)) == NULL)
+        return 0;
+    if (xs->xs_type == XP_AND || xs->xs_type == XP_EXP){
+        if (xs->xs_int != XO_AND)
+            return 0;
+        if ((ret = xpath_optimize_preds_expr(xs->xs_c0, cvk)) != 1)
+            return ret;
+        return xpath_optimize_preds_expr(xs->xs_c1, cvk);
+    }
+    if (xs->xs_type != XP_RELEX || xs->xs_int != XO_EQ)
+        return 0;
+    if ((name = xpath_optimize_name(xs->xs_c0)) != NULL)
+        val = xpath_optimize_value(xs->xs_c1);
+    else if ((name = xpath_optimize_name(xs->xs_c1)) != NULL)
+        val = xpath_optimize_value(xs->xs_c0);
+    else
+        return 0;
+    if (val == NULL)
+        return 0;
+    if (cvec_find(cvk, name) != NULL) /* Same name twice */
+        return 0;
+    if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
+        clixon_err(OE_XML, errno, "cvec_add");
+        return -1;
+    }
+    if (cv_name_set(cvi, name) == NULL ||
+        cv_string_set(cvi, val) == NULL){
+        clixon_err(OE_XML, errno, "cv_string_set");
+        return -1;
+    }
+    return 1;
+}
+
+/*! Recursive function to loop over all predicates and collect equalities
  *
  * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
- * @param[out] cvk   Vector of <keyname>:<keyval> pairs
- * @retval     1     Match
- * @retval     0     No match
+ * @param[out] cvk   Vector of <name>:<value> pairs
+ * @retval     1     All predicates are equalities
+ * @retval     0     Other predicate, eg positional, no optimization
  * @retval    -1     Error
- * @see xpath_optimize_init
  */
 static int
 loop_preds(xpath_tree *xt,
-           xpath_tree *xepat,
            cvec       *cvk)
 {
-    int          retval = -1;
-    int          ret;
-    xpath_tree  *xe;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    cg_var      *cvi;
+    int ret;
 
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-        if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
+    if (xt->xs_type != XP_PRED)
+        return 0;
+    if (xt->xs_c0){
+        if ((ret = loop_preds(xt->xs_c0, cvk)) != 1)
+            return ret;
     }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-        if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
-            goto done;
-        if (ret == 0)
-            goto ok;
-        if (veclen != 2)
-            goto ok;
-        if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
-            clixon_err(OE_XML, errno, "cvec_add");
-            goto done;
+    if (xt->xs_c1 == NULL)
+        return 1;
+    return xpath_optimize_preds_expr(xt->xs_c1, cvk);
+}
+
+/*! Order predicate equalities as list keys
+ *
+ * The equalities must be the first keys of the list in any order (a prefix of keys), or a single
+ * explicit search index
+ * @param[in]  yc    YANG list
+ * @param[in]  cvk0  Vector of <name>:<value> pairs in predicate order
+ * @param[out] cvk   Vector of <name>:<value> pairs in key order
+ * @retval     1     OK, search can use binary search
+ * @retval     0     Not keys or index variable, no optimization
+ * @retval    -1     Error
+ */
+static int
+xpath_optimize_keys(yang_stmt *yc,
+                    cvec      *cvk0,
+                    cvec      *cvk)
+{
+    cvec      *cvv;
+    cg_var    *cvy = NULL;
+    cg_var    *cvi;
+#ifdef XML_EXPLICIT_INDEX
+    yang_stmt *yi;
+#endif
+
+    if ((cvv = yang_cvec_get(yc)) == NULL)
+        return 0;
+    while ((cvy = cvec_each(cvv, cvy)) != NULL) {
+        if ((cvi = cvec_find(cvk0, cv_string_get(cvy))) == NULL)
+            break;
+        if (cvec_append_var(cvk, cvi) == NULL){
+            clixon_err(OE_XML, errno, "cvec_append_var");
+            return -1;
         }
-        cv_name_set(cvi, vec[0]->xs_s1);
-        if (vec[1]->xs_type == XP_PRIME_NR)
-            cv_string_set(cvi, vec[1]->xs_strnr);
-        else
-            cv_string_set(cvi, vec[1]->xs_s0);
     }
-    retval = 1;
- done:
-    if (vec)
-        free(vec);
-    return retval;
- ok: /* no match, not special case */
-    retval = 0;
-    goto done;
+    if (cvec_len(cvk) == cvec_len(cvk0))
+        return 1;
+#ifdef XML_EXPLICIT_INDEX
+    if (cvec_len(cvk0) == 1 &&
+        (yi = yang_find_datanode(yc, cv_name_get(cvec_i(cvk0, 0)))) != NULL &&
+        yang_flag_get(yi, YANG_FLAG_INDEX) != 0){
+        cvec_reset(cvk);
+        if (cvec_append_var(cvk, cvec_i(cvk0, 0)) == NULL){
+            clixon_err(OE_XML, errno, "cvec_append_var");
+            return -1;
+        }
+        return 1;
+    }
+#endif
+    return 0;
 }
 
 /*! Pattern matching to find fastpath
  *
- * @param[in]  xt     XPath tree
+ * @param[in]  xt     XPath tree of type STEP
  * @param[in]  xv     XML base node
  * @param[out] xvec   Array of found nodes
- * @param[out] xlen   Len of xvec
- * @param[out] key
- * @param[out] keyval
  * @retval     1      Match
  * @retval     0      No match - use non-optimized lookup
  * @retval    -1      Error
  *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
+ *  y[k=3]             # list key: <name>[<keyname>=<keyval>]
+ *  y[k1=3][k2=4]      # several list keys in any order, also: y[k2=4 and k1=3]
+ *  y[k1=3]            # prefix of list keys: all entries with first key k1=3
+ *  y[i=5]             # explicit search index
+ *  z[.=5]             # leaf-list value
  */
 static int
 xpath_list_optimize_fn(xpath_tree  *xt,
@@ -233,85 +371,66 @@ xpath_list_optimize_fn(xpath_tree  *xt,
                        clixon_xvec *xvec)
 {
     int          retval = -1;
-    xpath_tree  *xm = NULL;
-    xpath_tree  *xem = NULL;
+    xpath_tree  *xn;
     char        *name;
     yang_stmt   *yp;
     yang_stmt   *yc;
-    cvec        *cvv = NULL;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    xpath_tree  *xtp;
     int          ret;
-    cvec        *cvk = NULL; /* vector of index keys */
-    cg_var      *cvi;
-    int          i;
-    yang_stmt   *ypp;
+    cvec        *cvk0 = NULL; /* vector of predicate equalities */
+    cvec        *cvk = NULL;  /* vector of index keys */
 
+    /* Only child steps with node name and predicates */
+    if (xt->xs_type != XP_STEP || xt->xs_int != A_CHILD ||
+        xpath_optimize_nopred(xt))
+        goto ok;
+    if ((xn = xt->xs_c0) == NULL || xn->xs_type != XP_NODE ||
+        (name = xn->xs_s1) == NULL || strcmp(name, "*") == 0)
+        goto ok;
     /* revert to non-optimized if no yang */
     if ((yp = xml_spec(xv)) == NULL)
         goto ok;
     /* or if not config data (state data should not be ordered) */
     if (yang_config_ancestor(yp) == 0)
         goto ok;
-    /* Check that there is no "outer" list. */
-    ypp = yp;
-    do {
-        if (yang_keyword_get(ypp) == Y_LIST)
-            goto ok;
-    } while((ypp = yang_parent_get(ypp)) != NULL);
-    /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
-     */
-    xpath_optimize_init(&xm, &xem);
-    /* Here is where pattern is checked for equality and where variable binding is made (if
-     * equal) */
-    if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
-        goto done;
-    if (ret == 0)
-        goto ok; /* no match */
-    if (veclen != 2)
+    if ((yc = yang_find_datanode(yp, name)) == NULL)
         goto ok;
-    name = vec[0]->xs_s1;
-    /* Extract variables */
-    if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
-#ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
-        if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
-#endif
-            goto ok;
-    /* Validate keys */
-    if ((cvv = yang_cvec_get(yc)) == NULL)
+    if (yang_keyword_get(yc) != Y_LIST && yang_keyword_get(yc) != Y_LEAF_LIST)
         goto ok;
-    xtp = vec[1];
-    if ((cvk = cvec_new(0)) == NULL){
+    if ((cvk0 = cvec_new(0)) == NULL ||
+        (cvk = cvec_new(0)) == NULL){
         clixon_err(OE_YANG, errno, "cvec_new");
         goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    if ((ret = loop_preds(xt->xs_c1, cvk0)) < 0)
         goto done;
     if (ret == 0)
-        goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
-        goto ok;
-    i = 0;
-    cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-        if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
-            goto ok;
-        i++;
+        goto miss;
+    if (yang_keyword_get(yc) == Y_LEAF_LIST){
+        if (cvec_len(cvk0) != 1 || strcmp(cv_name_get(cvec_i(cvk0, 0)), ".") != 0)
+            goto miss;
+        if (cvec_append_var(cvk, cvec_i(cvk0, 0)) == NULL){
+            clixon_err(OE_XML, errno, "cvec_append_var");
+            goto done;
+        }
+    }
+    else {
+        if ((ret = xpath_optimize_keys(yc, cvk0, cvk)) < 0)
+            goto done;
+        if (ret == 0)
+            goto miss;
     }
     /* Use 2a form since yc allready given to compute cvk */
     if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
         goto done;
     retval = 1; /* match */
  done:
-    if (vec)
-        free(vec);
+    if (cvk0)
+        cvec_free(cvk0);
     if (cvk)
         cvec_free(cvk);
     return retval;
+ miss: /* predicates but not on keys */
+    _optimize_misses++;
  ok: /* no match, not special case */
     retval = 0;
     goto done;
@@ -320,6 +439,10 @@ xpath_list_optimize_fn(xpath_tree  *xt,
 
 /*! Identify XPath special cases and if match, use binary search.
  *
+ * @param[in]  xs     XPath tree of type STEP
+ * @param[in]  xv     XML context node
+ * @param[out] xvec0  Array of found nodes
+ * @param[out] xlen0  Len of xvec0
  * @retval  1  Optimization made, special case, use x (found if != NULL)
  * @retval  0  Dont optimize: not special case, do normal processing
  * @retval -1  Error
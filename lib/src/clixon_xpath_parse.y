@@ -127,6 +127,7 @@
 #include "clixon_log.h"
 #include "clixon_debug.h"
 #include "clixon_map.h"
+#include "clixon_string.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_xpath_function.h"
@@ -184,7 +185,7 @@ xpath_parse_exit(clixon_xpath_yacc *xpy)
  * @param[in]  i0     step-> axis_type
  * @param[in]  numstr original string xs_double: numeric value 
  * @param[in]  s0     String 0 set if XP_PRIME_STR, XP_PRIME_FN, XP_NODE[_FN] PATHEXPRE prefix
- * @param[in]  s1     String 1 set if XP_NODE NAME (or "*")
+ * @param[in]  s1     String 1 set if XP_NODE NAME (or "*"), interned and freed
  * @param[in]  c0     Child 0
  * @param[in]  c1     Child 1
  */
@@ -216,7 +217,19 @@ xp_new(enum xp_type  type,
     else
         xs->xs_double = 0.0;
     xs->xs_s0  = s0;
-    xs->xs_s1  = s1;
+    if (type == XP_NODE && s1){ /* Node names are interned as XML names, see nodetest_eval */
+        if ((xs->xs_s1 = clixon_string_intern(s1)) == NULL){
+            if (s0)
+                free(s0);
+            free(s1);
+            free(xs);
+            xs = NULL;
+            goto done;
+        }
+        free(s1);
+    }
+    else
+        xs->xs_s1  = s1;
     xs->xs_c0  = c0;
     xs->xs_c1  = c1;
  done:
@@ -508,11 +521,11 @@ nametest    : ADDOP
                    $$=xp_new(XP_NODE,A_NAN,NULL, NULL, str, NULL, NULL);
                    _PARSE_DEBUG("nametest-> *"); }
             | NCNAME
-                  { $$=xp_new(XP_NODE,A_NAN,NULL, NULL, $1, NULL, NULL);
-                   _PARSE_DEBUG1("nametest-> name[%s]",$1); }
+                  { _PARSE_DEBUG1("nametest-> name[%s]",$1);
+                    $$=xp_new(XP_NODE,A_NAN,NULL, NULL, $1, NULL, NULL); }
             | NCNAME ':' NCNAME
-                  { $$=xp_new(XP_NODE,A_NAN,NULL, $1, $3, NULL, NULL);
-                    _PARSE_DEBUG2("nametest-> name[%s] : name[%s]", $1, $3); }
+                  { _PARSE_DEBUG2("nametest-> name[%s] : name[%s]", $1, $3);
+                    $$=xp_new(XP_NODE,A_NAN,NULL, $1, $3, NULL, NULL); }
             | NCNAME ':' '*'
                   { $$=xp_new(XP_NODE,A_NAN,NULL, $1, NULL, NULL, NULL);
                     _PARSE_DEBUG1("nametest-> name[%s] : *", $1); }
@@ -180,11 +180,15 @@ static const map_str2int ykmap[] = {
 static map_ptr2ptr *_yang_when_map = NULL;
 static map_ptr2ptr *_yang_mymodule_map = NULL;
 
+/* Reverse must/when and leafref dependencies, one entry per YANG spec, see yang_deps_get */
+static yang_deps *_yang_deps_list = NULL;
+
 /* See option CLICON_YANG_USE_ORIGINAL */
 static int _yang_use_orig = 0;
 
 /* Forward static */
 static int yang_type_cache_free(yang_type_cache *ycache);
+static int yang_xpath_cache_free(yang_xpath_cache *yx);
 
 /* Access functions
  */
@@ -635,6 +639,286 @@ yang_when_canonical_xpath_get(yang_stmt *ys,
     return retval;
 }
 
+/*! Get compiled XPath and namespace context of a must or when statement
+ *
+ * The XPath argument is parsed and the prefixes of the module imports are resolved
+ * once, the first time, typically when the YANG spec is populated, see ys_populate2.
+ * The result is cached in the statement and reused for every XML node instance.
+ * @param[in]  ys        Yang must or when statement
+ * @param[in]  canonical Translate to canonical prefixes (augment/uses "when"), see
+ *                       yang_when_canonical_xpath_get
+ * @param[out] xpcp      Compiled XPath, or NULL if canonical translation fails. Do not free
+ * @param[out] nscp      Namespace context. Do not free
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @code
+ *   xpath_compiled *xpc = NULL;
+ *   cvec           *nsc = NULL;
+ *   if (yang_xpath_compiled_get(ymust, 0, &xpc, &nsc) < 0)
+ *      err;
+ *   if ((ret = xpath_vec_bool_compiled(xt, nsc, xpc)) < 0)
+ *      err;
+ * @endcode
+ * @see xpath_vec_bool_compiled
+ */
+int
+yang_xpath_compiled_get(yang_stmt              *ys,
+                        int                     canonical,
+                        struct xpath_compiled **xpcp,
+                        cvec                  **nscp)
+{
+    int               retval = -1;
+    yang_xpath_cache *yx;
+    char             *cxpath = NULL;
+    int               ret;
+
+    if (ys->ys_keyword != Y_MUST && ys->ys_keyword != Y_WHEN){
+        clixon_err(OE_YANG, EINVAL, "Expected must or when statement: %s",
+                   yang_key2str(ys->ys_keyword));
+        goto done;
+    }
+    if ((yx = ys->ys_xpathcache) == NULL){
+        if ((yx = malloc(sizeof(*yx))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(yx, 0, sizeof(*yx));
+        ys->ys_xpathcache = yx;
+    }
+    if (yx->yx_nsc == NULL &&
+        xml_nsctx_yang(ys, &yx->yx_nsc) < 0)
+        goto done;
+    if (yx->yx_xpath == NULL &&
+        xpath_compile(yang_argument_get(ys), &yx->yx_xpath) < 0)
+        goto done;
+    if (canonical && yx->yx_cxpath == NULL){
+        if ((ret = xpath2canonical1(yang_argument_get(ys), yx->yx_nsc, ys_spec(ys), 1,
+                                    &cxpath, &yx->yx_cnsc, NULL)) < 0)
+            goto done;
+        if (ret == 1 &&
+            xpath_compile(cxpath, &yx->yx_cxpath) < 0)
+            goto done;
+    }
+    if (xpcp)
+        *xpcp = canonical ? yx->yx_cxpath : yx->yx_xpath;
+    if (nscp)
+        *nscp = canonical ? yx->yx_cnsc : yx->yx_nsc;
+    retval = 0;
+ done:
+    if (cxpath)
+        free(cxpath);
+    return retval;
+}
+
+/*! Free must/when xpath cache
+ *
+ * @param[in]  yx  Yang xpath cache
+ * @retval     0   OK
+ */
+static int
+yang_xpath_cache_free(yang_xpath_cache *yx)
+{
+    if (yx->yx_xpath)
+        xpath_compiled_free(yx->yx_xpath);
+    if (yx->yx_nsc)
+        cvec_free(yx->yx_nsc);
+    if (yx->yx_cxpath)
+        xpath_compiled_free(yx->yx_cxpath);
+    if (yx->yx_cnsc)
+        cvec_free(yx->yx_cnsc);
+    free(yx);
+    return 0;
+}
+
+/*! Find reverse dependencies of a YANG spec
+ *
+ * @param[in]  yspec  YANG spec
+ * @param[in]  create If not found, create it
+ * @retval     yd     Dependencies
+ * @retval     NULL   Not found, or error if create
+ */
+static yang_deps *
+yang_deps_find(yang_stmt *yspec,
+               int        create)
+{
+    yang_deps *yd;
+    int        i;
+
+    if ((yd = _yang_deps_list) != NULL){
+        do {
+            if (yd->yd_yspec == yspec)
+                return yd;
+            yd = NEXTQ(yang_deps *, yd);
+        } while (yd && yd != _yang_deps_list);
+    }
+    if (!create)
+        return NULL;
+    if ((yd = malloc(sizeof(*yd))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(yd, 0, sizeof(*yd));
+    yd->yd_yspec = yspec;
+    for (i=0; i<2; i++)
+        if ((yd->yd_hash[i] = clicon_hash_init()) == NULL){
+            if (i > 0)
+                clicon_hash_free(yd->yd_hash[0]);
+            free(yd);
+            return NULL;
+        }
+    ADDQ(yd, _yang_deps_list);
+    return yd;
+}
+
+/*! Free reverse dependencies of a YANG spec
+ *
+ * @param[in]  yd  Dependencies, removed from list
+ */
+static void
+yang_deps_free(yang_deps *yd)
+{
+    yang_depvec *dv;
+    char       **keys = NULL;
+    size_t       nkeys;
+    size_t       j;
+    int          i;
+
+    DELQ(yd, _yang_deps_list, yang_deps *);
+    for (i=0; i<2; i++){
+        if (clicon_hash_keys(yd->yd_hash[i], &keys, &nkeys) == 0){
+            for (j=0; j<nkeys; j++)
+                if ((dv = clicon_hash_value(yd->yd_hash[i], keys[j], NULL)) != NULL &&
+                    dv->dv_vec != NULL)
+                    free(dv->dv_vec);
+        }
+        if (keys){
+            free(keys);
+            keys = NULL;
+        }
+        clicon_hash_free(yd->yd_hash[i]);
+    }
+    free(yd);
+}
+
+/*! Add schema node to dependencies of a name, unless already added
+ *
+ * @param[in]  hash  Dependency hash
+ * @param[in]  name  Local name of node read by constraint, or "*" for any node
+ * @param[in]  ys    Schema node with constraint
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+yang_deps_add1(clicon_hash_t *hash,
+               const char    *name,
+               yang_stmt     *ys)
+{
+    yang_depvec  dv0 = {NULL, 0};
+    yang_depvec *dv;
+    yang_stmt  **vec;
+    int          i;
+
+    if ((dv = clicon_hash_value(hash, name, NULL)) == NULL){
+        if (clicon_hash_add(hash, name, &dv0, sizeof(dv0)) == NULL)
+            return -1;
+        if ((dv = clicon_hash_value(hash, name, NULL)) == NULL)
+            return -1;
+    }
+    for (i=0; i<dv->dv_len; i++)
+        if (dv->dv_vec[i] == ys)
+            return 0;
+    if ((vec = realloc(dv->dv_vec, (dv->dv_len+1)*sizeof(yang_stmt *))) == NULL){
+        clixon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    vec[dv->dv_len++] = ys;
+    dv->dv_vec = vec;
+    return 0;
+}
+
+/*! Add schema node as dependent of the nodes read by the XPath of one of its constraints
+ *
+ * @param[in]  ys    Schema (data) node with must/when or leafref
+ * @param[in]  kind  YANG_DEPS_CHANGE or YANG_DEPS_DELETE
+ * @param[in]  xpt   Parsed XPath of constraint, or NULL if it could not be parsed: any node
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+yang_deps_add(yang_stmt  *ys,
+              int         kind,
+              xpath_tree *xpt)
+{
+    int        retval = -1;
+    yang_deps *yd;
+    cvec      *names = NULL;
+    cg_var    *cv;
+    int        any = 0;
+
+    if ((yd = yang_deps_find(ys_spec(ys), 1)) == NULL)
+        goto done;
+    if ((names = cvec_new(0)) == NULL){
+        clixon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    if (xpt == NULL)
+        any = 1;
+    else if (xpath_tree_names(xpt, names, &any) < 0)
+        goto done;
+    if (any){
+        if (yang_deps_add1(yd->yd_hash[kind], "*", ys) < 0)
+            goto done;
+    }
+    else {
+        cv = NULL;
+        while ((cv = cvec_each(names, cv)) != NULL)
+            if (yang_deps_add1(yd->yd_hash[kind], cv_name_get(cv), ys) < 0)
+                goto done;
+    }
+    retval = 0;
+ done:
+    if (names)
+        cvec_free(names);
+    return retval;
+}
+
+/*! Get schema nodes with constraints that read nodes with a given name
+ *
+ * The dependencies are local names only, ie a constraint reading "ex:a" also depends on
+ * nodes named "a" in other namespaces.
+ * @param[in]  yspec  YANG spec
+ * @param[in]  kind   YANG_DEPS_CHANGE or YANG_DEPS_DELETE
+ * @param[in]  name   Local name of a changed node, or "*" for constraints that may read any node
+ * @param[out] vecp   Vector of schema nodes with must/when or leafref. Do not free
+ * @param[out] lenp   Length of vector, 0 if none
+ * @retval     0      OK
+ * @code
+ *   yang_stmt **vec;
+ *   int         len;
+ *   yang_deps_get(yspec, YANG_DEPS_CHANGE, xml_name(x), &vec, &len);
+ * @endcode
+ * @see xml_yang_validate_all_diff
+ */
+int
+yang_deps_get(yang_stmt   *yspec,
+              int          kind,
+              const char  *name,
+              yang_stmt ***vecp,
+              int         *lenp)
+{
+    yang_deps   *yd;
+    yang_depvec *dv;
+
+    *vecp = NULL;
+    *lenp = 0;
+    if ((yd = yang_deps_find(yspec, 0)) != NULL &&
+        (dv = clicon_hash_value(yd->yd_hash[kind], name, NULL)) != NULL){
+        *vecp = dv->dv_vec;
+        *lenp = dv->dv_len;
+    }
+    return 0;
+}
+
 /*! Get yang filename for error/debug purpose (only modules)
  *
  * @param[in]  ys       Yang statement
@@ -1053,6 +1337,7 @@ ys_free1(yang_stmt *ys,
     rpc_callback_t *rc;
     cg_var         *cv;
     cvec           *cvv;
+    yang_deps      *yd;
 
     if ((cv = ys->ys_cv) != NULL){
         ys->ys_cv = NULL;
@@ -1085,6 +1370,21 @@ ys_free1(yang_stmt *ys,
             ys->ys_typecache = NULL;
         }
         break;
+    case Y_MUST:
+    case Y_WHEN:
+        if (ys->ys_xpathcache){
+            yang_xpath_cache_free(ys->ys_xpathcache);
+            ys->ys_xpathcache = NULL;
+        }
+        break;
+    case Y_IDENTITY:
+        if (ys->ys_identity){
+            if (ys->ys_identity->yi_bases)
+                free(ys->ys_identity->yi_bases);
+            free(ys->ys_identity);
+            ys->ys_identity = NULL;
+        }
+        break;
     case Y_MODULE:
     case Y_SUBMODULE:
         if (ys->ys_filename)
@@ -1096,12 +1396,14 @@ ys_free1(yang_stmt *ys,
             xml_free(ys->ys_nopres_cache);
         break;
 #endif
-#ifdef OPTIMIZE_YSPEC_NAMESPACE
     case Y_SPEC:
+#ifdef OPTIMIZE_YSPEC_NAMESPACE
         if (ys->ys_nscache)
             free(ys->ys_nscache);
-        break;
 #endif
+        if ((yd = yang_deps_find(ys, 0)) != NULL)
+            yang_deps_free(yd);
+        break;
     default:
         break;
     }
@@ -1353,6 +1655,13 @@ ys_cp_one(yang_stmt *ynew,
         if (yang_typecache_get(yold)) /* Dont copy type cache, use only original */
             yang_typecache_set(ynew, NULL);
         break;
+    case Y_MUST:
+    case Y_WHEN: /* Dont copy xpath cache, namespace context depends on location */
+        ynew->ys_xpathcache = NULL;
+        break;
+    case Y_IDENTITY: /* Dont copy identifier, use only original */
+        ynew->ys_identity = NULL;
+        break;
 #ifdef OPTIMIZE_NO_PRESENCE_CONTAINER
     case Y_CONTAINER:
         yold->ys_nopres_cache = NULL;
@@ -3260,6 +3569,158 @@ ys_populate_identity(clixon_handle h,
     return retval;
 }
 
+/*! Set bits of base identities of an identity, transitively
+ *
+ * @param[in]     ys    Yang identity
+ * @param[in,out] yi    Identity derivation whose base bitset is set
+ */
+static void
+yang_identity_bases(yang_stmt     *ys,
+                    yang_identity *yi)
+{
+    yang_stmt     *yc;
+    yang_stmt     *ybaseid;
+    yang_identity *yb;
+    int            inext;
+
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL) {
+        if (yc->ys_keyword != Y_BASE)
+            continue;
+        /* Unknown bases are detected in ys_populate_identity */
+        if ((ybaseid = yang_find_identity(ys, yang_argument_get(yc))) == NULL ||
+            (yb = ybaseid->ys_identity) == NULL)
+            continue;
+        if (yi->yi_bases[yb->yi_id/64] & ((uint64_t)1 << (yb->yi_id%64)))
+            continue;
+        yi->yi_bases[yb->yi_id/64] |= ((uint64_t)1 << (yb->yi_id%64));
+        yang_identity_bases(ybaseid, yi);
+    }
+}
+
+/*! Assign identifiers to all identities of a YANG spec and compute their base bitsets
+ *
+ * Each identity gets a dense identifier, and a bitset of the identifiers of the
+ * identities it is derived from. Thereafter checking if an identity is derived from
+ * another is a bit test, see yang_identity_derived.
+ * All identities of the YANG spec are indexed, also of modules loaded earlier, since
+ * a new module may derive from their identities.
+ * @param[in]  yspec  YANG spec
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see ys_populate_identity  which creates the derived identity list
+ */
+int
+yang_identity_index(yang_stmt *yspec)
+{
+    int            retval = -1;
+    yang_stmt     *ymod;
+    yang_stmt     *ys;
+    yang_identity *yi;
+    uint32_t       nr = 0;
+    uint32_t       len;
+    int            inext;
+    int            inext2;
+
+    /* 1. Assign identifiers */
+    inext = 0;
+    while ((ymod = yn_iter(yspec, &inext)) != NULL) {
+        if (ymod->ys_keyword != Y_MODULE && ymod->ys_keyword != Y_SUBMODULE)
+            continue;
+        inext2 = 0;
+        while ((ys = yn_iter(ymod, &inext2)) != NULL) {
+            if (ys->ys_keyword != Y_IDENTITY)
+                continue;
+            if ((yi = ys->ys_identity) == NULL){
+                if ((yi = malloc(sizeof(*yi))) == NULL){
+                    clixon_err(OE_UNIX, errno, "malloc");
+                    goto done;
+                }
+                memset(yi, 0, sizeof(*yi));
+                ys->ys_identity = yi;
+            }
+            yi->yi_id = nr++;
+        }
+    }
+    /* 2. Compute base bitsets */
+    len = (nr + 63) / 64;
+    inext = 0;
+    while ((ymod = yn_iter(yspec, &inext)) != NULL) {
+        if (ymod->ys_keyword != Y_MODULE && ymod->ys_keyword != Y_SUBMODULE)
+            continue;
+        inext2 = 0;
+        while ((ys = yn_iter(ymod, &inext2)) != NULL) {
+            if (ys->ys_keyword != Y_IDENTITY)
+                continue;
+            yi = ys->ys_identity;
+            if (yi->yi_len != len){
+                if (yi->yi_bases)
+                    free(yi->yi_bases);
+                if ((yi->yi_bases = calloc(len, sizeof(uint64_t))) == NULL){
+                    clixon_err(OE_UNIX, errno, "calloc");
+                    yi->yi_len = 0;
+                    goto done;
+                }
+                yi->yi_len = len;
+            }
+            else
+                memset(yi->yi_bases, 0, len*sizeof(uint64_t));
+            yang_identity_bases(ys, yi);
+        }
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if an identity is derived from another identity
+ *
+ * Uses the base bitset if both identities are indexed, otherwise the derived identity
+ * list of the base identity.
+ * @param[in]  yid    Yang identity
+ * @param[in]  ybase  Yang base identity
+ * @retval     1      yid is derived from ybase
+ * @retval     0      yid is not derived from ybase, or yid is ybase
+ * @retval    -1      Error
+ * @see yang_identity_index
+ */
+int
+yang_identity_derived(yang_stmt *yid,
+                      yang_stmt *ybase)
+{
+    int            retval = -1;
+    yang_identity *yi;
+    yang_identity *yb;
+    yang_stmt     *ymod;
+    cbuf          *cb = NULL;
+
+    if (yid->ys_keyword != Y_IDENTITY || ybase->ys_keyword != Y_IDENTITY){
+        clixon_err(OE_YANG, EINVAL, "Expected identity statements");
+        goto done;
+    }
+    if ((yi = yid->ys_identity) != NULL &&
+        (yb = ybase->ys_identity) != NULL &&
+        yb->yi_id/64 < yi->yi_len){
+        retval = (yi->yi_bases[yb->yi_id/64] & ((uint64_t)1 << (yb->yi_id%64))) != 0;
+        goto done;
+    }
+    /* Not indexed: derived identity list is on the form <module>:<id> */
+    if ((ymod = ys_module(yid)) == NULL){
+        clixon_err(OE_YANG, ENOENT, "No module found");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s:%s", yang_argument_get(ymod), yang_argument_get(yid));
+    retval = cvec_find(yang_cvec_get(ybase), cbuf_get(cb)) != NULL;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Return 1 if feature is enabled, 0 if not using the populated yang tree
  *
  * @param[in] yspec   yang specification
@@ -3579,6 +4040,126 @@ ys_populate(yang_stmt    *ys,
     return retval;
 }
 
+/*! Add dependencies of leafref paths of a type, also in unions
+ *
+ * @param[in]  ys       Yang leaf or leaf-list
+ * @param[in]  yrestype Resolved type
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+ys_populate_deps_type(yang_stmt *ys,
+                      yang_stmt *yrestype)
+{
+    int         retval = -1;
+    char       *restype;
+    char       *path_arg;
+    yang_stmt  *ypath;
+    yang_stmt  *ytsub;
+    yang_stmt  *ytype;
+    xpath_tree *xpt = NULL;
+    int         inext;
+
+    restype = yrestype?yang_argument_get(yrestype):NULL;
+    if (restype == NULL)
+        ;
+    else if (strcmp(restype, "leafref") == 0){
+        if ((ypath = yang_find(yrestype, Y_PATH, NULL)) != NULL &&
+            (path_arg = yang_argument_get(ypath)) != NULL){
+            /* Parse error is reported by validation, then depend on any node */
+            if (xpath_parse(path_arg, &xpt) < 0){
+                clixon_log(NULL, LOG_WARNING, "%s: leafref path %s: %s",
+                           __FUNCTION__, path_arg, clixon_err_reason());
+                clixon_err_reset();
+                xpt = NULL;
+            }
+            /* Without predicates, only removed targets can invalidate a leafref */
+            if (yang_deps_add(ys, (xpt == NULL || strpbrk(path_arg, "[("))?YANG_DEPS_CHANGE:YANG_DEPS_DELETE,
+                              xpt) < 0)
+                goto done;
+        }
+    }
+    else if (strcmp(restype, "union") == 0){
+        inext = 0;
+        while ((ytsub = yn_iter(yrestype, &inext)) != NULL){
+            if (yang_keyword_get(ytsub) != Y_TYPE)
+                continue;
+            if (yang_type_resolve(ys, ys, ytsub, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+                goto done;
+            if (ys_populate_deps_type(ys, ytype) < 0)
+                goto done;
+        }
+    }
+    retval = 0;
+ done:
+    if (xpt)
+        xpath_tree_free(xpt);
+    return retval;
+}
+
+/*! Compile XPath of must or when statement at YANG load, errors are not fatal
+ *
+ * An XPath that cannot be compiled, eg using an unimplemented function, is logged and
+ * its cache is left empty. Validation then compiles it on use and reports the error.
+ * @param[in]  ys    Yang must or when statement
+ * @param[out] xptp  Parsed XPath tree, or NULL if it cannot be compiled. Do not free
+ * @retval     0     OK
+ * @see yang_xpath_compiled_get
+ */
+static int
+ys_populate_xpath(yang_stmt   *ys,
+                  xpath_tree **xptp)
+{
+    xpath_compiled *xpc = NULL;
+
+    *xptp = NULL;
+    if (yang_xpath_compiled_get(ys, 0, &xpc, NULL) < 0){
+        clixon_log(NULL, LOG_WARNING, "%s: %s %s: %s", __FUNCTION__,
+                   yang_key2str(ys->ys_keyword), yang_argument_get(ys), clixon_err_reason());
+        clixon_err_reset();
+        return 0;
+    }
+    if (xpc)
+        *xptp = xpath_compiled_tree(xpc);
+    return 0;
+}
+
+/*! Add reverse dependencies of must/when and leafref constraints of a data node
+ *
+ * Must and when statements of the node itself are added when they are compiled
+ * @param[in]  h    Clixon handle
+ * @param[in]  ys   Yang data node
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see yang_deps_get
+ */
+static int
+ys_populate_deps(clixon_handle h,
+                 yang_stmt    *ys)
+{
+    int             retval = -1;
+    yang_stmt      *ywhen;
+    yang_stmt      *yrestype = NULL;
+    xpath_tree     *xpt;
+
+    /* when of augment or uses */
+    if ((ywhen = yang_when_get(h, ys)) != NULL){
+        if (ys_populate_xpath(ywhen, &xpt) < 0)
+            goto done;
+        if (yang_deps_add(ys, YANG_DEPS_CHANGE, xpt) < 0)
+            goto done;
+    }
+    if (ys->ys_keyword == Y_LEAF || ys->ys_keyword == Y_LEAF_LIST){
+        if (yang_type_get(ys, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+            goto done;
+        if (ys_populate_deps_type(ys, yrestype) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Run after grouping expand and augment
  *
  * Run in yang_apply but also other places
@@ -3593,10 +4174,12 @@ int
 ys_populate2(yang_stmt    *ys,
              void         *arg)
 {
-    int           retval = -1;
-    clixon_handle h = (clixon_handle)arg;
-    cg_var       *cv;
-    int           ret;
+    int             retval = -1;
+    clixon_handle   h = (clixon_handle)arg;
+    cg_var         *cv;
+    yang_stmt      *yp;
+    xpath_tree     *xpt;
+    int             ret;
 
     switch(ys->ys_keyword){
     case Y_AUGMENT:
@@ -3609,6 +4192,14 @@ ys_populate2(yang_stmt    *ys,
         if (ys_populate_leaf(h, ys) < 0)
             goto done;
         break;
+    case Y_MUST:
+    case Y_WHEN: /* Compile xpath once, instead of for every XML node instance */
+        if (ys_populate_xpath(ys, &xpt) < 0)
+            goto done;
+        if ((yp = yang_parent_get(ys)) != NULL && yang_datanode(yp) &&
+            yang_deps_add(yp, YANG_DEPS_CHANGE, xpt) < 0)
+            goto done;
+        break;
     case Y_MANDATORY: /* call yang_mandatory() to check if set */
     case Y_CONFIG:
     case Y_REQUIRE_INSTANCE:
@@ -3622,6 +4213,8 @@ ys_populate2(yang_stmt    *ys,
     default:
         break;
     }
+    if (yang_datanode(ys) && ys_populate_deps(h, ys) < 0)
+        goto done;
     /* RFC 8528 Yang schema mount  flag for optimization */
     if ((ret = yang_schema_mount_point0(ys)) < 0)
         goto done;
@@ -4725,6 +5318,8 @@ yang_exit(clixon_handle h)
         free(_yang_mymodule_map);
         _yang_mymodule_map = NULL;
     }
+    while (_yang_deps_list != NULL)
+        yang_deps_free(_yang_deps_list);
     if ((ymounts = clixon_yang_mounts_get(h)) != NULL){
         ys_free(ymounts);
     }
@@ -60,6 +60,52 @@ struct yang_type_cache{
 };
 typedef struct yang_type_cache yang_type_cache;
 
+/*! Yang must/when cache. Compiled XPath argument and namespace context
+ *
+ * Created at YANG load (or first use) and reused for every XML node instance
+ * @see yang_xpath_compiled_get
+ */
+struct yang_xpath_cache{
+    struct xpath_compiled *yx_xpath;  /* Compiled XPath argument */
+    cvec                  *yx_nsc;    /* Namespace context of module imports */
+    struct xpath_compiled *yx_cxpath; /* Y_WHEN: compiled canonical XPath argument */
+    cvec                  *yx_cnsc;   /* Y_WHEN: canonical namespace context */
+};
+typedef struct yang_xpath_cache yang_xpath_cache;
+
+/*! Schema nodes whose constraints read nodes with a given name, see yang_deps
+ */
+struct yang_depvec{
+    yang_stmt **dv_vec;  /* Vector of schema nodes */
+    int         dv_len;  /* Length of vector */
+};
+typedef struct yang_depvec yang_depvec;
+
+/*! Reverse dependencies of must/when and leafref constraints of a YANG spec
+ *
+ * Maps local names of nodes read by the XPath of a constraint to the schema nodes
+ * with the constraint. Created when the YANG spec is populated, one per YANG spec
+ * @see yang_deps_get
+ */
+struct yang_deps{
+    qelem_t        yd_qelem;   /* List of dependencies of all YANG specs */
+    yang_stmt     *yd_yspec;   /* YANG spec */
+    clicon_hash_t *yd_hash[2]; /* YANG_DEPS_CHANGE/_DELETE: name -> yang_depvec */
+};
+typedef struct yang_deps yang_deps;
+
+/*! Identity derivation, dense identifier and bitset of base identities
+ *
+ * Created for all identities of a YANG spec when it is populated
+ * @see yang_identity_index
+ */
+struct yang_identity{
+    uint32_t  yi_id;    /* Dense identifier of identity in its YANG spec */
+    uint32_t  yi_len;   /* Number of 64-bit words in yi_bases */
+    uint64_t *yi_bases; /* Bitset of identifiers of base identities, transitively */
+};
+typedef struct yang_identity yang_identity;
+
 /*! yang statement 
  *
  * This is an internal type, not exposed in the API
@@ -113,6 +159,8 @@ struct yang_stmt {
         rpc_callback_t  *ysu_action_cb; /* Y_ACTION: Action callback list*/
         char            *ysu_filename;  /* Y_MODULE/Y_SUBMODULE: For debug/errors: filename */
         yang_type_cache *ysu_typecache; /* Y_TYPE: cache all typedef data except unions */
+        yang_xpath_cache *ysu_xpathcache; /* Y_MUST/Y_WHEN: compiled xpath argument */
+        yang_identity   *ysu_identity;  /* Y_IDENTITY: identifier and base bitset */
 #ifdef OPTIMIZE_YSPEC_NAMESPACE
         map_str2ptr     *ysu_nscache;   /* Y_SPEC: namespace to module cache */
 #endif
@@ -126,6 +174,8 @@ struct yang_stmt {
 #define ys_action_cb      u.ysu_action_cb
 #define ys_filename       u.ysu_filename
 #define ys_typecache      u.ysu_typecache
+#define ys_xpathcache     u.ysu_xpathcache
+#define ys_identity       u.ysu_identity
 #ifdef OPTIMIZE_YSPEC_NAMESPACE
 #define ys_nscache        u.ysu_nscache
 #endif
@@ -1642,6 +1642,9 @@ yang_parse_post(clixon_handle h,
     for (i=0; i<ylen; i++)
         if (yang_cardinality(h, ylist[i], yang_argument_get(ylist[i])) < 0)
             goto done;
+    /* 12. Index identities of all modules for identityref checks */
+    if (yang_identity_index(yspec) < 0)
+        goto done;
     retval = 0;
  done:
     if (ylist)
@@ -0,0 +1,149 @@
+#!/usr/bin/env bash
+# Commit diff skipping equal subtrees using cached subtree digests, see xml_digest
+# The example backend plugin logs transaction vectors to a file (-- -t)
+# Running is edited directly so that candidate edit marks are invalid and a full diff is made
+# Check that changes in deep subtrees are found and that equal subtrees are skipped:
+# 1. Change deep leaf in one of several lists
+# 2. Change a leaf and then restore it: equal content
+# 3. Remove and re-add a list entry: equal content in new nodes
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+flog=$dir/backend.log
+touch $flog
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container x{
+        list y{
+            key a;
+            leaf a{
+                type int32;
+            }
+            leaf b{
+                type int32;
+            }
+            container c{
+                list d{
+                    key e;
+                    leaf e{
+                        type int32;
+                    }
+                    leaf f{
+                        type string;
+                    }
+                }
+            }
+        }
+    }
+}
+EOF
+
+# Edit datastore
+# 1: datastore
+# 2: config
+function editdb()
+{
+    db=$1
+    config=$2
+
+    new "edit $db"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><$db/></target><config><x xmlns=\"urn:example:clixon\">$config</x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+# Commit and return transaction log of the commit in $trans
+function commit()
+{
+    l0=$(cat $flog | wc -l)
+
+    new "commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    trans=$(tail -n +$((l0+1)) $flog | grep "main_commit ")
+}
+
+new "test params: -f $cfg -l f$flog -- -t"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -l f$flog -- -t"
+    start_backend -s init -f $cfg -l f$flog -- -t
+fi
+
+new "wait backend"
+wait_backend
+
+Y1="<y><a>1</a><b>1</b><c><d><e>1</e><f>x</f></d><d><e>2</e><f>y</f></d></c></y>"
+Y2="<y><a>2</a><b>2</b><c><d><e>1</e><f>x</f></d><d><e>2</e><f>y</f></d></c></y>"
+
+editdb candidate "$Y1$Y2"
+commit
+
+new "1. change deep leaf"
+editdb running "<y><a>3</a><b>3</b></y>"
+editdb candidate "<y><a>2</a><c><d><e>2</e><f>z</f></d></c></y>"
+commit
+
+new "check change f and del y in running only"
+expectpart "$trans" 0 "main_commit change: <f>y</f><f>z</f>" "main_commit del: <y><a>3</a>" --not-- "add:"
+
+new "2. change and restore leaf"
+editdb running "<y><a>3</a><b>3</b></y>"
+editdb candidate "<y><a>1</a><c><d><e>1</e><f>w</f></d></c></y>"
+editdb candidate "<y><a>1</a><c><d><e>1</e><f>x</f></d></c></y>"
+commit
+
+new "check del y in running only"
+expectpart "$trans" 0 "main_commit del: <y><a>3</a>" --not-- "add:" "change:"
+
+new "3. remove and re-add list entry"
+editdb running "<y><a>3</a><b>3</b></y>"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y nc:operation=\"remove\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><a>1</a></y></x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+editdb candidate "$Y1"
+commit
+
+new "check del y in running only"
+expectpart "$trans" 0 "main_commit del: <y><a>3</a>" --not-- "add:" "change:"
+
+new "get-config running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\">$Y1<y><a>2</a><b>2</b><c><d><e>1</e><f>x</f></d><d><e>2</e><f>z</f></d></c></y></x></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
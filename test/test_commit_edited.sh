@@ -0,0 +1,137 @@
+#!/usr/bin/env bash
+# Incremental commit diff using candidate edit marks, see xml_diff_edited
+# The example backend plugin logs transaction vectors to a file (-- -t)
+# Check that the logged add/del/change vectors are the same as with a full diff:
+# 1. Edit candidate after commit: only edited subtrees are compared
+# 2. Edit running directly: candidate edit marks are invalid, full diff
+# 3. Copy-config to candidate: candidate edit marks are invalid, full diff
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+flog=$dir/backend.log
+touch $flog
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container x{
+        list y{
+            key a;
+            leaf a{
+                type int32;
+            }
+            leaf b{
+                type int32;
+            }
+        }
+    }
+}
+EOF
+
+# Edit datastore
+# 1: datastore
+# 2: config
+function editdb()
+{
+    db=$1
+    config=$2
+
+    new "edit $db"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><$db/></target><config><x xmlns=\"urn:example:clixon\">$config</x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+# Commit and return transaction log of the commit in $trans
+function commit()
+{
+    l0=$(cat $flog | wc -l)
+
+    new "commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    trans=$(tail -n +$((l0+1)) $flog | grep "main_commit ")
+}
+
+new "test params: -f $cfg -l f$flog -- -t"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -l f$flog -- -t"
+    start_backend -s init -f $cfg -l f$flog -- -t
+fi
+
+new "wait backend"
+wait_backend
+
+editdb candidate "<y><a>1</a><b>1</b></y><y><a>2</a><b>2</b></y>"
+commit
+
+new "1. edit candidate after commit"
+editdb candidate "<y><a>2</a><b>3</b></y>"
+commit
+
+new "check change b"
+expectpart "$trans" 0 "main_commit change: <b>2</b><b>3</b>" --not-- "add:" "del:"
+
+new "2. edit running directly"
+editdb running "<y><a>3</a><b>3</b></y>"
+editdb candidate "<y><a>1</a><b>5</b></y>"
+commit
+
+new "check change b and del y in running only"
+expectpart "$trans" 0 "main_commit change: <b>1</b><b>5</b>" "main_commit del: <y><a>3</a>" --not-- "add:"
+
+new "3. copy-config running to startup"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><copy-config><source><running/></source><target><startup/></target></copy-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+editdb running "<y><a>4</a><b>4</b></y>"
+
+new "copy-config startup to candidate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><copy-config><source><startup/></source><target><candidate/></target></copy-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+editdb candidate "<y><a>2</a><b>6</b></y>"
+commit
+
+new "check change b and del y in running only"
+expectpart "$trans" 0 "main_commit change: <b>3</b><b>6</b>" "main_commit del: <y><a>4</a>" --not-- "add:"
+
+new "get-config running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>5</b></y><y><a>2</a><b>6</b></y></x></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,156 @@
+#!/usr/bin/env bash
+# Binary datastore format test, see CLICON_XMLDB_FORMAT = binary
+# - Datastore saved in binary and loaded on restart
+# - Changed YANG: binary datastore is loaded unbound and re-bound
+# - Changed YANG without revision bump (list key): loaded unbound and sorted by new key
+# - XML datastore is loaded when changing format to binary
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_FORMAT>binary</CLICON_XMLDB_FORMAT>
+</clixon-config>
+EOF
+
+# Create yang with an optional extra leaf
+# 1: extra leaf
+# 2: list key (default name)
+function testyang()
+{
+    extra=$1
+    key=${2:-name}
+    cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key $key;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+EOF
+    if [ -n "$extra" ]; then
+        cat <<EOF >> $fyang
+            leaf $extra{
+                type string;
+            }
+EOF
+    fi
+    cat <<EOF >> $fyang
+        }
+    }
+}
+EOF
+}
+
+# Restart backend and check running
+# 1: expected config
+function testrestart()
+{
+    expect=$1
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        stop_backend -f $cfg
+        new "start backend -s running -f $cfg"
+        start_backend -s running -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf get-config running"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$expect</data></rpc-reply>"
+}
+
+CONFIG="<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>2</value></parameter><parameter><name>b</name><value>1</value></parameter></table>"
+# Same config sorted by value
+CONFIG2="<table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>1</value></parameter><parameter><name>a</name><value>2</value></parameter></table>"
+
+testyang
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "edit candidate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$CONFIG</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "running_db is binary"
+sudo chmod 666 $dir/running_db
+expectpart "$(head -c 7 $dir/running_db)" 0 "CLXNBIN"
+
+new "restart with binary running"
+testrestart "$CONFIG"
+
+new "change yang"
+testyang extra
+
+new "restart with changed yang"
+testrestart "$CONFIG"
+
+# Module text changes but not its revision: digest must differ so that the file is
+# not loaded as bound and sorted by name
+new "change list key without revision bump"
+testyang extra value
+
+new "restart with changed key, sorted by value"
+testrestart "$CONFIG2"
+
+new "XML running_db"
+sudo rm -f $dir/running_db
+cat <<EOF > $dir/running_db
+<config>$CONFIG</config>
+EOF
+
+new "restart with XML running"
+testrestart "$CONFIG2"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
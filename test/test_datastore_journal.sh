@@ -0,0 +1,159 @@
+#!/usr/bin/env bash
+# Datastore journal test, see CLICON_XMLDB_JOURNAL
+# Edits are appended to <db>_journal instead of rewriting <db>_db
+# - The journal is copied along with the datastore file on commit (copy), not compacted
+# - The journal is replayed after a backend crash
+# - A truncated trailing journal record is discarded
+# - A rejected journal record fails startup
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_JOURNAL>true</CLICON_XMLDB_JOURNAL>
+  <CLICON_XMLDB_JOURNAL_CHECKPOINT>0</CLICON_XMLDB_JOURNAL_CHECKPOINT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "edit candidate a"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "candidate journal exists"
+if [ ! -s $dir/candidate_journal ]; then
+    err "$dir/candidate_journal" "not found"
+fi
+
+new "candidate_db not rewritten"
+sudo chmod 666 $dir/candidate_db
+expectpart "$(cat $dir/candidate_db)" 0 --not-- "<name>a</name>"
+
+new "netconf get-config candidate"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></data></rpc-reply>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "candidate journal not compacted"
+if [ ! -s $dir/candidate_journal ]; then
+    err "$dir/candidate_journal" "not found"
+fi
+
+new "running journal copied"
+if [ ! -s $dir/running_journal ]; then
+    err "$dir/running_journal" "not found"
+fi
+
+new "running_db not rewritten"
+sudo chmod 666 $dir/running_db
+expectpart "$(cat $dir/running_db)" 0 --not-- "<name>a</name>"
+
+new "netconf get-config running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></data></rpc-reply>"
+
+new "edit running b"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><running/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>2</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "delete running a"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><running/></target><config><table xmlns=\"urn:example:clixon\"><parameter nc:operation=\"delete\" xmlns:nc=\"${BASENS}\"><name>a</name></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "running journal exists"
+if [ ! -s $dir/running_journal ]; then
+    err "$dir/running_journal" "not found"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "crash backend"
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    sudo kill -9 $pid
+
+    new "append truncated record to running journal"
+    sudo chmod 666 $dir/running_journal
+    echo -n "100 merge
+<config><table xmlns=\"urn:example:clixon\"><parameter><name>c</name>" >> $dir/running_journal
+
+    new "start backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf get-config running after crash"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>2</value></parameter></table></data></rpc-reply>"
+
+new "edit running c"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><running/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>c</name><value>3</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "crash backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    sudo kill -9 $pid
+
+    new "append rejected record to running journal"
+    rec="<config><table xmlns=\"urn:example:clixon\"><xxx>1</xxx></table></config>"
+    sudo chmod 666 $dir/running_journal
+    echo "${#rec} merge
+$rec" >> $dir/running_journal
+
+    new "start backend with rejected journal record fails"
+    expectpart "$(sudo $clixon_backend -1 -s running -f $cfg -l o 2>&1)" 255 "Journal record rejected"
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
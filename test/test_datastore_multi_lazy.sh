@@ -0,0 +1,197 @@
+#!/usr/bin/env bash
+# Datastore split test with lazy loading of split files, see CLICON_XMLDB_MULTI_LAZY
+# Create several mount-points, each in its own split file, commit and restart.
+# Split files are then loaded on access. A small memory limit makes the backend
+# unload split subtrees between requests, check that they are loaded again and that
+# edits of loaded and unloaded subtrees are written correctly
+# Split files that cannot be loaded make requests fail
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fyang1=$dir/clixon-mount1.yang
+
+# Number of mount-points / split files
+: ${nr:=10}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${dir}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_LIBRARY>true</CLICON_YANG_LIBRARY>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_MULTI>true</CLICON_XMLDB_MULTI>
+  <CLICON_XMLDB_MULTI_LAZY>true</CLICON_XMLDB_MULTI_LAZY>
+  <CLICON_XMLDB_MULTI_LAZY_MAX>1</CLICON_XMLDB_MULTI_LAZY_MAX>
+  <CLICON_YANG_SCHEMA_MOUNT>true</CLICON_YANG_SCHEMA_MOUNT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  import ietf-yang-schema-mount {
+    prefix yangmnt;
+  }
+  import clixon-lib {
+    prefix cl;
+  }
+  container top{
+    list mylist{
+      key name;
+      leaf name{
+        type string;
+      }
+      container root{
+         presence "Otherwise root is not visible";
+         yangmnt:mount-point "mylabel"{
+            description "Root for other yang models";
+         }
+         cl:xmldb-split{
+           description "Multi-XMLDB: split datastore here";
+         }
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $fyang1
+module clixon-mount1{
+   yang-version 1.1;
+   namespace "urn:example:mount1";
+   prefix m1;
+   container mount1{
+      list mylist1{
+         key name1;
+         leaf name1{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Restart backend from running
+function restart()
+{
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        stop_backend -f $cfg
+        new "start backend -s running -f $cfg -- -m clixon-mount1 -M urn:example:mount1"
+        start_backend -s running -f $cfg -- -m clixon-mount1 -M urn:example:mount1
+    fi
+
+    new "wait backend"
+    wait_backend
+}
+
+CONFIG=""
+for (( i=0; i<$nr; i++ )); do
+    CONFIG="$CONFIG<mylist><name>x$i</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>y$i</name1></mylist1></mount1></root></mylist>"
+done
+CONFIG="<top xmlns=\"urn:example:clixon\">$CONFIG</top>"
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -m clixon-mount1 -M urn:example:mount1"
+    start_backend -s init -f $cfg -- -m clixon-mount1 -M urn:example:mount1
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add mountpoints"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\">$(for (( i=0; i<$nr; i++ )); do echo -n "<mylist><name>x$i</name><root/></mylist>"; done)</top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Add data to mountpoints"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$CONFIG</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit 2"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Check number of split files"
+sudo chmod 755 $dir/running.d
+n=$(ls $dir/running.d/*.xml | grep -v "/0.xml" | wc -l)
+if [ $n -ne $nr ]; then
+    err "$nr" "$n"
+fi
+
+new "Restart"
+restart
+
+new "netconf get-config running x3 after restart"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='x3']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:clixon\"><mylist><name>x3</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>y3</name1></mylist1></mount1></root></mylist></top></data></rpc-reply>"
+
+new "netconf get-config running after restart"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$CONFIG</data></rpc-reply>"
+
+new "netconf get-config running again after unload"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data>$CONFIG</data></rpc-reply>"
+
+new "Edit data of mountpoint x5"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><top xmlns=\"urn:example:clixon\"><mylist><name>x5</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>z5</name1></mylist1></mount1></root></mylist></top></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit 3"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Restart"
+restart
+
+new "netconf get-config running x5 after restart"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='x5']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:clixon\"><mylist><name>x5</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>y5</name1></mylist1><mylist1><name1>z5</name1></mylist1></mount1></root></mylist></top></data></rpc-reply>"
+
+new "netconf get-config running x4 after restart"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:top/ex:mylist[ex:name='x4']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><top xmlns=\"urn:example:clixon\"><mylist><name>x4</name><root><mount1 xmlns=\"urn:example:mount1\"><mylist1><name1>y4</name1></mylist1></mount1></root></mylist></top></data></rpc-reply>"
+
+new "Restart"
+restart
+
+new "Corrupt split files"
+for f in $(ls $dir/running.d/*.xml | grep -v "/0.xml"); do
+    echo "<mount1" | sudo tee $f > /dev/null
+done
+
+new "netconf get-config running with corrupt split files fails"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "<rpc-reply $DEFAULTNS><rpc-error>" ""
+
+new "netconf validate with corrupt split files fails"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<rpc-reply $DEFAULTNS><rpc-error>" ""
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+unset nr
+
+new "endtest"
+endtest
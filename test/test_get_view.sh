@@ -0,0 +1,200 @@
+#!/usr/bin/env bash
+# get-config replies made from a read-only view of the datastore cache, see clixon_xml2cbuf_view
+# XPath filter, depth, with-defaults and NACM are applied when printing the reply
+# Last, split files are loaded lazily, the view should not print link attributes
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    import ietf-netconf-acm {
+        prefix nacm;
+    }
+    import clixon-lib {
+        prefix cl;
+    }
+    container table{
+        list parameter{
+            key name;
+            leaf name{
+                type string;
+            }
+            leaf value{
+                type string;
+            }
+            leaf dflt{
+                type string;
+                default "d";
+            }
+        }
+        container np{
+            leaf x{
+                type string;
+                default "x";
+            }
+        }
+    }
+    container other{
+        cl:xmldb-split{
+            description "Split datastore here if CLICON_XMLDB_MULTI";
+        }
+        leaf value{
+            type string;
+        }
+    }
+}
+EOF
+
+# Limited group: parameter b is denied, other parameters are permitted, read-default deny
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>deny</read-default>
+     <write-default>deny</write-default>
+     <exec-default>permit</exec-default>
+     $NGROUPS
+     <rule-list>
+       <name>limited-acl</name>
+       <group>limited</group>
+       <rule>
+         <name>deny-b</name>
+         <module-name>*</module-name>
+         <access-operations>read</access-operations>
+         <path xmlns:ex="urn:example:clixon">/ex:table/ex:parameter[ex:name='b']</path>
+         <action>deny</action>
+       </rule>
+       <rule>
+         <name>permit-parameter</name>
+         <module-name>*</module-name>
+         <access-operations>read</access-operations>
+         <path xmlns:ex="urn:example:clixon">/ex:table/ex:parameter</path>
+         <action>permit</action>
+       </rule>
+     </rule-list>
+     $NADMIN
+   </nacm>
+   <table xmlns="urn:example:clixon">
+     <parameter><name>a</name><value>1</value></parameter>
+     <parameter><name>b</name><value>2</value></parameter>
+   </table>
+   <other xmlns="urn:example:clixon">
+     <value>99</value>
+   </other>
+</${DATASTORE_TOP}>
+EOF
+
+PA="<parameter><name>a</name><value>1</value></parameter>"
+PB="<parameter><name>b</name><value>2</value></parameter>"
+FILTER="<filter type=\"xpath\" select=\"/ex:table\" xmlns:ex=\"urn:example:clixon\"/>"
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "admin get-config table"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source>$FILTER</get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\">$PA$PB</table></data></rpc-reply>"
+
+new "admin get-config leaf: ancestors and list keys"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='b']/ex:value\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\">$PB</table></data></rpc-reply>"
+
+new "admin get-config no match"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='c']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "admin get-config report-all"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source>$FILTER<with-defaults xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults\">report-all</with-defaults></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value><dflt>d</dflt></parameter><parameter><name>b</name><value>2</value><dflt>d</dflt></parameter><np><x>x</x></np></table></data></rpc-reply>"
+
+new "admin get-config depth 1"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config cl:depth=\"1\" xmlns:cl=\"http://clicon.org/lib\"><source><running/></source>$FILTER</get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"></table></data></rpc-reply>"
+
+new "limited get-config: parameter b denied, other not permitted"
+expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\">$PA</table></data></rpc-reply>"
+
+new "limited get-config other"
+expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:other\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "guest get-config: read-default deny"
+expecteof_netconf "$clixon_netconf -U guest -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "get-config running unchanged"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source>$FILTER</get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\">$PA$PB</table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+# Lazy loading of split files
+sed -i "s|</clixon-config>|  <CLICON_XMLDB_MULTI>true</CLICON_XMLDB_MULTI>\n  <CLICON_XMLDB_MULTI_LAZY>true</CLICON_XMLDB_MULTI_LAZY>\n</clixon-config>|" $cfg
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg with split files"
+    start_backend -s startup -f $cfg
+
+    new "wait backend"
+    wait_backend
+
+    new "Kill backend"
+    stop_backend -f $cfg
+
+    new "start backend -s running -f $cfg with lazy split files"
+    start_backend -s running -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "admin get-config lazy split node without link attribute"
+expecteof_netconf "$clixon_netconf -U andy -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:other\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><other xmlns=\"urn:example:clixon\"><value>99</value></other></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
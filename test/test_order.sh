@@ -315,6 +315,17 @@ for s in int uint; do
     done
 done
 
+for t in 8 16 32 64; do
+    type=int$t
+    new "put leaf-list $type negative (-1,-10)"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><types xmlns=\"urn:example:order\">
+<my$type>-1</my$type><my$type>-10</my$type>
+</types></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "check leaf-list $type order (-10,-1,1,2,10)"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/exo:types/exo:my$type\" xmlns:exo=\"urn:example:order\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><types xmlns=\"urn:example:order\"><my$type>-10</my$type><my$type>-1</my$type><my$type>1</my$type><my$type>2</my$type><my$type>10</my$type></types></data></rpc-reply>"
+done
+
 new "netconf validate ints"
 expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
 
@@ -101,8 +101,17 @@ function testrun(){
     fi
     objects=$(echo "$res" | $clixon_util_xpath -p "/rpc-reply/global/xmlnr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
 
+    slabs=$(echo "$res" | $clixon_util_xpath -p "/rpc-reply/global/xmlslabnr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
+    slabsize=$(echo "$res" | $clixon_util_xpath -p "/rpc-reply/global/xmlslabsize" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
+    internnr=$(echo "$res" | $clixon_util_xpath -p "/rpc-reply/global/internnr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
+    internsize=$(echo "$res" | $clixon_util_xpath -p "/rpc-reply/global/internsize" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
+
     echo "Total"
     echo "   objects: $objects"
+    echo "   slabs: $slabs"
+    echo "   slab mem: $slabsize" | awk '{print $1, $2, $3/1000000 "M"}'
+    echo "   interned strings: $internnr"
+    echo "   interned mem: $internsize" | awk '{print $1, $2, $3/1000000 "M"}'
 
 #
     if [ -f /proc/$pid/statm ]; then     # This only works on Linux 
@@ -118,10 +127,11 @@ function testrun(){
         if [ "$resdb0" = "$resdb" ]; then
             err1 "nodeset:0:" "$resdb0"
         fi
-        echo -n "   objects: "
-        echo $resdb | $clixon_util_xpath -p "datastore/nr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}'
-        echo -n "   mem: "
-        echo $resdb | $clixon_util_xpath -p "datastore/size" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}' | awk '{print $1/1000000 "M"}'
+        nrdb=$(echo $resdb | $clixon_util_xpath -p "datastore/nr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
+        szdb=$(echo $resdb | $clixon_util_xpath -p "datastore/size" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
+        echo "   objects: $nrdb"
+        echo "   mem: $szdb" | awk '{print $1, $2/1000000 "M"}'
+        echo "   bytes/object: $nrdb $szdb" | awk '{ if ($2 > 0) printf "%s %.1f\n", $1, $3/$2; else print $1, "-" }'
     done
     if [ $BE -ne 0 ]; then
         new "Kill backend"
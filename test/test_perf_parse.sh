@@ -0,0 +1,82 @@
+#!/usr/bin/env bash
+# Parse throughput test: XML and JSON file ingestion in MB/s
+# Files are read in large blocks and parsed in place, see clicon_file_read
+# Also xml_body access rate, bodies are stored inline in the XML node when short
+# stdin is redirected from the file so that it is read as a regular file
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xml:="clixon_util_xml"}
+: ${clixon_util_json:="clixon_util_json"}
+: ${clixon_util_xpath:="clixon_util_xpath"}
+
+# Number of list entries in file
+: ${perfnr:=100000}
+
+fxml=$dir/large.xml
+fjson=$dir/large.json
+
+# Parse file and print throughput
+# 1: command
+# 2: file
+function parserate()
+{
+    cmd=$1
+    file=$2
+
+    TIMEFORMAT=%R
+    t=$( { time $cmd < $file > /dev/null; } 2>&1 )
+    r=$?
+    if [ $r -ne 0 ]; then
+        err "0" "$r"
+    fi
+    size=$(stat -c %s $file)
+    echo "$size bytes in $t s" | awk '{ if ($4 > 0) printf "%.1f MB/s\n", $1/1048576/$4; else print "-" }'
+}
+
+# Access all bodies of file with XPath and print bodies per second, parse time excluded
+# Each list entry has two bodies compared by the predicate
+function bodyrate()
+{
+    TIMEFORMAT=%R
+    t0=$( { time $clixon_util_xml < $fxml > /dev/null; } 2>&1 )
+    t1=$( { time $clixon_util_xpath -f $fxml -p "count(/x/y[a!=b])" > $dir/count.txt; } 2>&1 )
+    r=$?
+    if [ $r -ne 0 ]; then
+        err "0" "$r"
+    fi
+    expectpart "$(cat $dir/count.txt)" 0 "number:$perfnr"
+    echo "$perfnr $t0 $t1" | awk '{ if ($3 > $2) printf "%.0f bodies/s\n", 2*$1/($3-$2); else print "-" }'
+}
+
+new "generate large file $fxml"
+echo -n "<x>" > $fxml
+for (( i=0; i<$perfnr; i++ )); do
+    echo "<y><a>$i</a><b>value$i</b></y>"
+done >> $fxml
+echo "</x>" >> $fxml
+
+new "generate large file $fjson"
+echo -n '{"x":{"y":[' > $fjson
+for (( i=0; i<$perfnr; i++ )); do
+    if [ $i -ne 0 ]; then
+        echo ","
+    fi
+    echo -n "{\"a\":\"$i\",\"b\":\"value$i\"}"
+done >> $fjson
+echo "]}}" >> $fjson
+
+new "xml parse large file"
+parserate "$clixon_util_xml" $fxml
+
+new "json parse large file"
+parserate "$clixon_util_json" $fjson
+
+new "xml body access"
+bodyrate
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,120 @@
+#!/usr/bin/env bash
+# Sort and insert performance of large lists, see XML_SORTKEY
+# List entries are compared using cached normalized sort keys.
+# Undefine XML_SORTKEY in include/clixon_custom.h to compare with key value comparisons.
+# 1. Startup with list entries in reverse order: binds and sorts all entries
+# 2. Insert entries in a large list: binary search for each new entry
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list/leaf-list entries in file
+: ${perfnr:=1000000}
+
+# Number of entries inserted in large list
+: ${perfreq:=1000}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/scaling.yang
+sx=$dir/sx.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+     list y {
+       key "a b";
+       leaf a {
+         type string;
+       }
+       leaf b {
+         type int32;
+       }
+       leaf c {
+         type string;
+       }
+     }
+     leaf-list z {
+       type uint32;
+     }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+fi
+
+new "generate startup config ($sx) with $perfnr entries in reverse order"
+echo -n "<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\">" > $sx
+for (( i=$perfnr; i>0; i-- )); do
+    echo "<y><a>k$((i%100))</a><b>$i</b><c>$i</c></y><z>$i</z>"
+done >> $sx
+echo "</x></${DATASTORE_TOP}>" >> $sx
+
+sdb=$dir/startup_db
+cp $sx $sdb
+
+new "Startup and sort $perfnr entries"
+# Run once and exit
+{ time -p sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+if [ $BE -ne 0 ]; then
+    cp $sx $sdb
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Insert $perfreq entries in $perfnr entries"
+config="<x xmlns=\"urn:example:clixon\">"
+for (( i=0; i<$perfreq; i++ )); do
+    config="$config<y><a>k$i</a><b>-$i</b></y><z>$((perfnr+i+1))</z>"
+done
+config="$config</x>"
+{ time -p expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$config</config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" ; } 2>&1 | awk '/real/ {print $2}'
+
+new "Get single entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='k1'][ex:b='-1']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>k1</a><b>-1</b></y></x></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+unset perfnr
+unset perfreq
+
+new "endtest"
+endtest
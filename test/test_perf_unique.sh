@@ -0,0 +1,141 @@
+#!/usr/bin/env bash
+# Validation performance of a large list with two unique statements
+# Keys and unique values are checked using hash sets of value tuples.
+# 1. Startup with a large list: validates keys and both unique constraints
+# 2. Validate large candidate, with and without CLICON_VALIDATE_INCREMENTAL
+# 3. Add duplicates of each unique constraint and check they are detected
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in file
+: ${perfnr:=1000000}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/scaling.yang
+sx=$dir/sx.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+     list y {
+       key "a";
+       unique "b c";
+       unique "d";
+       leaf a {
+         type string;
+       }
+       leaf b {
+         type string;
+       }
+       leaf c {
+         type uint32;
+       }
+       leaf d {
+         type string;
+       }
+     }
+   }
+}
+EOF
+
+# Create config
+# 1: CLICON_VALIDATE_INCREMENTAL
+function mkcfg()
+{
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_VALIDATE_INCREMENTAL>$1</CLICON_VALIDATE_INCREMENTAL>
+</clixon-config>
+EOF
+}
+
+new "generate startup config ($sx) with $perfnr entries"
+echo -n "<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\">" > $sx
+for (( i=0; i<$perfnr; i++ )); do
+    echo "<y><a>k$i</a><b>b$((i%100))</b><c>$i</c><d>d$i</d></y>"
+done >> $sx
+echo "</x></${DATASTORE_TOP}>" >> $sx
+
+sdb=$dir/startup_db
+
+for incr in false true; do
+    mkcfg $incr
+
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+    fi
+
+    cp $sx $sdb
+    new "Startup and validate $perfnr entries"
+    # Run once and exit
+    { time -p sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+    if [ $BE -ne 0 ]; then
+        cp $sx $sdb
+        new "start backend -s startup -f $cfg"
+        start_backend -s startup -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "add entry, incremental:$incr"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>new</a><b>new</b><c>0</c><d>new</d></y></x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "validate $perfnr entries, incremental:$incr"
+    { time -p expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" ; } 2>&1 | awk '/real/ {print $2}'
+
+    new "add duplicate of unique b c"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>dup</a><b>b7</b><c>7</c></y></x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "validate fails on unique b c"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/x/y\[a=\"k7\"\]/b</non-unique><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/x/y\[a=\"k7\"\]/c</non-unique></error-info></rpc-error></rpc-reply>"
+
+    new "discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "add duplicate of unique d"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>dup</a><d>d9</d></y></x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "validate fails on unique d"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/x/y\[a=\"k9\"\]/d</non-unique></error-info></rpc-error></rpc-reply>"
+
+    new "discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+done
+
+rm -rf $dir
+
+unset perfnr
+
+new "endtest"
+endtest
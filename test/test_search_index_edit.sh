@@ -0,0 +1,187 @@
+#!/usr/bin/env bash
+# Explicit search index maintained by datastore edits
+# A non-key list leaf is registered with cc:search_index
+# Add, change, remove leafs and list entries, check xpath lookups on the index variable
+# The example backend verifies index consistency of candidate and running on validate (-- -I)
+# It also re-parses the target from text syntax, which appends key leafs with values,
+# and verifies the index of a list whose key is an index variable
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    import clixon-config {
+        prefix cc;
+    }
+    container x{
+        list y{
+            key k;
+            leaf k{
+                type string;
+            }
+            leaf i{
+                description "explicit index variable";
+                type int32;
+                cc:search_index;
+            }
+        }
+        list z{
+            key n;
+            leaf n{
+                description "key that is also explicit index variable";
+                type int32;
+                cc:search_index;
+            }
+            leaf v{
+                type string;
+            }
+        }
+    }
+}
+EOF
+
+# Get entries of index value in datastore
+# 1: datastore
+# 2: index value
+# 3: expected entries
+function getindex()
+{
+    db=$1
+    i=$2
+    expect=$3
+
+    new "get-config $db i=$i"
+    if [ -z "$expect" ]; then
+        reply="<data/>"
+    else
+        reply="<data><x xmlns=\"urn:example:clixon\">$expect</x></data>"
+    fi
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><$db/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:i='$i']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS>$reply</rpc-reply>"
+}
+
+# Edit candidate and validate, which verifies search indexes
+# 1: config
+function editdb()
+{
+    config=$1
+
+    new "edit candidate"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\" xmlns:nc=\"${BASENS}\">$config</x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "validate"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+new "test params: -f $cfg -- -I"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -I"
+    start_backend -s init -f $cfg -- -I
+fi
+
+new "wait backend"
+wait_backend
+
+editdb "<y><k>a</k><i>3</i></y><y><k>b</k><i>1</i></y><y><k>c</k><i>2</i></y><y><k>d</k><i>3</i></y><y><k>e</k></y>"
+
+getindex candidate 3 "<y><k>a</k><i>3</i></y><y><k>d</k><i>3</i></y>"
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+getindex running 1 "<y><k>b</k><i>1</i></y>"
+
+new "change index value"
+editdb "<y><k>a</k><i>5</i></y>"
+
+getindex candidate 3 "<y><k>d</k><i>3</i></y>"
+getindex candidate 5 "<y><k>a</k><i>5</i></y>"
+
+new "add index leaf to existing entry"
+editdb "<y><k>e</k><i>2</i></y>"
+
+getindex candidate 2 "<y><k>c</k><i>2</i></y><y><k>e</k><i>2</i></y>"
+
+new "remove index leaf"
+editdb "<y><k>c</k><i nc:operation=\"remove\"/></y>"
+
+getindex candidate 2 "<y><k>e</k><i>2</i></y>"
+
+new "delete list entry"
+editdb "<y nc:operation=\"delete\"><k>d</k></y>"
+
+getindex candidate 3 ""
+
+new "commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+getindex running 5 "<y><k>a</k><i>5</i></y>"
+getindex running 2 "<y><k>e</k><i>2</i></y>"
+
+new "replace list"
+editdb "<y nc:operation=\"replace\"><k>b</k><i>5</i></y>"
+
+getindex candidate 5 "<y><k>a</k><i>5</i></y><y><k>b</k><i>5</i></y>"
+getindex candidate 1 ""
+
+new "discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+getindex candidate 1 "<y><k>b</k><i>1</i></y>"
+
+new "validate after discard"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "indexed key list"
+editdb "<z><n>3</n><v>c</v></z><z><n>1</n><v>a</v></z><z><n>2</n><v>b</v></z>"
+
+new "get-config indexed key"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:z[ex:n='2']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><z><n>2</n><v>b</v></z></x></data></rpc-reply>"
+
+new "commit indexed key list"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "delete indexed key entry"
+editdb "<z nc:operation=\"delete\"><n>1</n></z>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -435,6 +435,31 @@ expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -l o -p "/descendant-or-self::
 new "find bbb with 3 ccc children using count"
 expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -l o -p "(/bbb[count(ccc)=3])")" 0 "<bbb x=\"hello\"><ccc>foo</ccc><ccc>42</ccc><ccc>bar</ccc></bbb>"
 
+# Existence tests stop evaluating when first node is found
+new "xpath count(/bbb/ccc)>0"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -p "count(/bbb/ccc)>0")" 0 "bool:true$"
+
+new "xpath count(/bbb/ddd)!=0"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -p "count(/bbb/ddd)!=0")" 0 "bool:false$"
+
+new "xpath count(//ddd)=0"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -p "count(//ddd)=0")" 0 "bool:true$"
+
+new "xpath count(/bbb/ccc)>1 is not an existence test"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -p "count(/bbb/ccc)>1")" 0 "bool:true$"
+
+new "xpath boolean(//ccc)"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -p "boolean(//ccc)")" 0 "bool:true$"
+
+new "xpath not(//ddd) and //ccc"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -p "not(//ddd) and //ccc")" 0 "bool:true$"
+
+new "xpath //ddd and //ccc"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -p "//ddd and //ccc")" 0 "bool:false$"
+
+new "xpath predicate existence keeps all matches"
+expectpart "$($clixon_util_xpath -D $DBG -f $xml3 -p "/bbb[ccc]")" 0 "nodeset:0:<bbb x=\"hello\"><ccc>foo</ccc><ccc>42</ccc><ccc>bar</ccc></bbb>1:<bbb x=\"bye\"><ccc>99</ccc><ccc>foo</ccc></bbb>"
+
 # Negative
 
 new "xpath dontexist"
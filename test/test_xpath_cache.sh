@@ -0,0 +1,114 @@
+#!/usr/bin/env bash
+# XPath cache of parsed XPath trees, see XPATH_CACHE_SIZE
+# Evaluate the same XPath filters repeatedly, check results and that cache hits increase
+# in the stats rpc
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xpath:="clixon_util_xpath"}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container x{
+        list y{
+            key k;
+            leaf k{
+                type string;
+            }
+            leaf v{
+                type int32;
+            }
+        }
+    }
+}
+EOF
+
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+   <x xmlns="urn:example:clixon">
+     <y><k>a</k><v>1</v></y>
+     <y><k>b</k><v>2</v></y>
+     <y><k>c</k><v>2</v></y>
+   </x>
+</${DATASTORE_TOP}>
+EOF
+
+# Get XPath cache hits from stats rpc
+function cachehits()
+{
+    rpc=$(chunked_framing "<rpc $DEFAULTNS><stats $LIBNS/></rpc>")
+    res=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg)
+    echo "$res" | $clixon_util_xpath -p "/rpc-reply/global/xpathcachehit" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}'
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "get cache hits"
+hits0=$(cachehits)
+if [ -z "$hits0" ]; then
+    err "xpathcachehit" "$hits0"
+fi
+
+for i in 1 2 3; do
+    new "get-config key filter $i"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:k='b']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><k>b</k><v>2</v></y></x></data></rpc-reply>"
+
+    new "get-config non-key filter $i"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:v=2]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><k>b</k><v>2</v></y><y><k>c</k><v>2</v></y></x></data></rpc-reply>"
+done
+
+new "check cache hits increased"
+hits1=$(cachehits)
+if [ -z "$hits1" ] || [ $hits1 -le $hits0 ]; then
+    err "xpathcachehit > $hits0" "$hits1"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
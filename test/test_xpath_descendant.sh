@@ -0,0 +1,165 @@
+#!/usr/bin/env bash
+# XPath descendant steps (//name) using the descendant index, see CLICON_XMLDB_DESCENDANT_INDEX
+# Check results of // filters after startup and after adding and deleting nodes,
+# namespaces of nodes with same name, and that the index is shown in the stats rpc
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xpath:="clixon_util_xpath"}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+fyang2=$dir/clixon-other.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$dir</CLICON_YANG_MAIN_DIR>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_DESCENDANT_INDEX>true</CLICON_XMLDB_DESCENDANT_INDEX>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container c{
+        list a{
+            key name;
+            leaf name{
+                type string;
+            }
+            container d{
+                leaf v{
+                    type string;
+                }
+            }
+        }
+        leaf v{
+            type string;
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fyang2
+module clixon-other{
+    yang-version 1.1;
+    namespace "urn:example:other";
+    prefix oth;
+    container o{
+        leaf v{
+            type string;
+        }
+    }
+}
+EOF
+
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+   <c xmlns="urn:example:clixon">
+     <a><name>x</name><d><v>1</v></d></a>
+     <a><name>y</name><d><v>2</v></d></a>
+     <v>0</v>
+   </c>
+   <o xmlns="urn:example:other"><v>9</v></o>
+</${DATASTORE_TOP}>
+EOF
+
+# Get-config with xpath filter
+# 1: datastore
+# 2: xpath
+# 3: expected data
+function getxpath()
+{
+    db=$1
+    xpath=$2
+    expect=$3
+
+    new "get-config $db $xpath"
+    if [ -z "$expect" ]; then
+        reply="<data/>"
+    else
+        reply="<data>$expect</data>"
+    fi
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><$db/></source><filter type=\"xpath\" select=\"$xpath\" xmlns:ex=\"urn:example:clixon\" xmlns:oth=\"urn:example:other\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS>$reply</rpc-reply>"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+getxpath running "//ex:v" "<c xmlns=\"urn:example:clixon\"><a><name>x</name><d><v>1</v></d></a><a><name>y</name><d><v>2</v></d></a><v>0</v></c>"
+
+getxpath running "//oth:v" "<o xmlns=\"urn:example:other\"><v>9</v></o>"
+
+getxpath running "/ex:c//ex:d" "<c xmlns=\"urn:example:clixon\"><a><name>x</name><d><v>1</v></d></a><a><name>y</name><d><v>2</v></d></a></c>"
+
+getxpath running "//ex:d[ex:v='2']" "<c xmlns=\"urn:example:clixon\"><a><name>y</name><d><v>2</v></d></a></c>"
+
+getxpath running "//ex:nonexist" ""
+
+new "add list entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><name>z</name><d><v>3</v></d></a></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "delete list entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><a nc:operation=\"delete\"><name>x</name></a></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+getxpath candidate "//ex:d" "<c xmlns=\"urn:example:clixon\"><a><name>y</name><d><v>2</v></d></a><a><name>z</name><d><v>3</v></d></a></c>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+getxpath running "//ex:d" "<c xmlns=\"urn:example:clixon\"><a><name>y</name><d><v>2</v></d></a><a><name>z</name><d><v>3</v></d></a></c>"
+
+new "delete container"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><o xmlns=\"urn:example:other\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\" nc:operation=\"delete\"/></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+getxpath candidate "//oth:v" ""
+
+getxpath running "//oth:v" "<o xmlns=\"urn:example:other\"><v>9</v></o>"
+
+new "check descendant index in stats"
+rpc=$(chunked_framing "<rpc $DEFAULTNS><stats $LIBNS/></rpc>")
+res=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg)
+nr=$(echo "$res" | $clixon_util_xpath -p "/rpc-reply/datastores/datastore[name='running']/indexnr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
+if [ -z "$nr" ] || [ $nr -eq 0 ]; then
+    err "indexnr > 0" "$nr"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,176 @@
+#!/usr/bin/env bash
+# XPath list optimization using binary search, see XPATH_LIST_OPTIMIZE
+# Key predicates on every step of hierarchical paths, multiple keys in any order,
+# conjunctions, prefix of keys, leaf-list values and non-key predicates (not optimized)
+# Prefix of keys in ordered-by user list where matching entries are not adjacent
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container c{
+        list a{
+            key name;
+            leaf name{
+                type string;
+            }
+            list b{
+                key "k1 k2";
+                leaf k1{
+                    type string;
+                }
+                leaf k2{
+                    type int32;
+                }
+                leaf v{
+                    type string;
+                }
+                leaf-list ll{
+                    type string;
+                }
+            }
+        }
+        leaf-list z{
+            type int32;
+        }
+        list u{
+            key "k1 k2";
+            ordered-by user;
+            leaf k1{
+                type string;
+            }
+            leaf k2{
+                type int32;
+            }
+        }
+    }
+}
+EOF
+
+XP1="<b><k1>p</k1><k2>1</k2><v>w</v></b>"
+XP2="<b><k1>p</k1><k2>2</k2></b>"
+XQ1="<b><k1>q</k1><k2>1</k2><ll>m</ll><ll>n</ll></b>"
+YP1="<b><k1>p</k1><k2>1</k2></b>"
+UP1="<u><k1>p</k1><k2>1</k2></u>"
+UQ1="<u><k1>q</k1><k2>1</k2></u>"
+UP2="<u><k1>p</k1><k2>2</k2></u>"
+
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+   <c xmlns="urn:example:clixon">
+     <a><name>y</name>$YP1</a>
+     <a><name>x</name>$XQ1$XP1$XP2</a>
+     <z>5</z><z>3</z><z>4</z>
+     $UP2$UQ1$UP1
+   </c>
+</${DATASTORE_TOP}>
+EOF
+
+# Get-config with xpath filter
+# 1: xpath
+# 2: expected data
+function getxpath()
+{
+    xpath=$1
+    expect=$2
+
+    new "get-config $xpath"
+    if [ -z "$expect" ]; then
+        reply="<data/>"
+    else
+        reply="<data><c xmlns=\"urn:example:clixon\">$expect</c></data>"
+    fi
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"$xpath\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS>$reply</rpc-reply>"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+getxpath "/ex:c/ex:a[ex:name='x']/ex:b[ex:k1='p'][ex:k2='2']" "<a><name>x</name>$XP2</a>"
+
+getxpath "/ex:c/ex:a[ex:name='x']/ex:b[ex:k2=2][ex:k1='p']" "<a><name>x</name>$XP2</a>"
+
+getxpath "/ex:c/ex:a[ex:name='x']/ex:b[ex:k1='p' and ex:k2=2]" "<a><name>x</name>$XP2</a>"
+
+getxpath "/ex:c/ex:a[ex:name='x']/ex:b['p'=ex:k1 and 2=ex:k2]" "<a><name>x</name>$XP2</a>"
+
+getxpath "/ex:c/ex:a[ex:name='x']/ex:b[ex:k1='p' or ex:k2=2]" "<a><name>x</name>$XP1$XP2</a>"
+
+# Prefix of keys
+getxpath "/ex:c/ex:a[ex:name='x']/ex:b[ex:k1='p']" "<a><name>x</name>$XP1$XP2</a>"
+
+# Second key only is not a prefix
+getxpath "/ex:c/ex:a[ex:name='x']/ex:b[ex:k2=1]" "<a><name>x</name>$XP1$XQ1</a>"
+
+# Inner list in all entries of outer list
+getxpath "/ex:c/ex:a/ex:b[ex:k1='p'][ex:k2=1]" "<a><name>x</name>$XP1</a><a><name>y</name>$YP1</a>"
+
+getxpath "/ex:c/ex:a[ex:name='z']/ex:b[ex:k1='p']" ""
+
+getxpath "/ex:c/ex:a[ex:name='x']/ex:b[ex:k1='p'][ex:k2=3]" ""
+
+# Non-key predicate
+getxpath "/ex:c/ex:a/ex:b[ex:v='w']" "<a><name>x</name>$XP1</a>"
+
+# Leaf-lists
+getxpath "/ex:c/ex:z[.='3']" "<z>3</z>"
+
+getxpath "/ex:c/ex:z[.=6]" ""
+
+getxpath "/ex:c/ex:a[ex:name='x']/ex:b[ex:k1='q'][ex:k2=1]/ex:ll[.='n']" "<a><name>x</name><b><k1>q</k1><k2>1</k2><ll>n</ll></b></a>"
+
+# Ordered-by user: all prefix matches in user order
+getxpath "/ex:c/ex:u[ex:k1='p']" "$UP2$UP1"
+
+getxpath "/ex:c/ex:u[ex:k1='p'][ex:k2=1]" "$UP1"
+
+getxpath "/ex:c/ex:u[ex:k1='q']" "$UQ1"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest